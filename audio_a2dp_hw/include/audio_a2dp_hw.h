@@ -94,6 +94,7 @@ typedef enum {
   A2DP_CTRL_GET_PRESENTATION_POSITION,
   A2DP_CTRL_CMD_STREAM_OPEN,
   A2DP_CTRL_GET_SINK_LATENCY,
+  A2DP_CTRL_GET_SHM_RING,
 } tA2DP_CTRL_CMD;
 
 typedef enum {
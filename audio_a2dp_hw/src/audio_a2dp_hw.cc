@@ -56,6 +56,7 @@
 #include "osi/include/hash_map_utils.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
+#include "osi/include/shm_ring.h"
 #include "osi/include/socket_utils/sockets.h"
 
 #include "audio_a2dp_hw.h"
@@ -150,6 +151,10 @@ struct a2dp_stream_common {
   struct a2dp_config cfg;
   a2dp_state_t state;
   tA2DP_LATENCY sink_latency;
+  bool use_ring;             // request a shared memory ring on start
+  shm_ring_t* ring;          // replaces the data socket for audio data
+  shm_ring_t* retired_ring;  // released while out_write was using it
+  bool ring_writing;         // out_write is writing to |ring| unlocked
 };
 
 struct a2dp_stream_out {
@@ -399,6 +404,34 @@ static int skt_write(int fd, const void* p, size_t len) {
   return (int)count;
 }
 
+// Writes |len| bytes to the shared memory |ring|, waiting for the stack to
+// drain it when it is full. The wait ends early if the data socket |fd| hangs
+// up. Returns the number of bytes written, or -1 in case of failure.
+static int shm_write(shm_ring_t* ring, int fd, const void* p, size_t len) {
+  FNLOG();
+
+  ts_log("shm_write", len, NULL);
+
+  size_t count = 0;
+  while (count < len) {
+    size_t written = shm_ring_write(ring, p, len - count);
+    count += written;
+    p = (const uint8_t*)p + written;
+    if (count == len) break;
+
+    int ret = shm_ring_wait_writable(ring, len - count, SOCK_SEND_TIMEOUT_MS,
+                                     fd);
+    if (ret == 0) {
+      WARN("write timeout exceeded, sent %zu bytes", count);
+      return -1;
+    } else if (ret < 0) {
+      ERROR("write failed, ring closed after %zu bytes", count);
+      return -1;
+    }
+  }
+  return (int)count;
+}
+
 static int skt_disconnect(int fd) {
   INFO("fd %d", fd);
 
@@ -551,6 +584,77 @@ static int a2dp_command(struct a2dp_stream_common* common, tA2DP_CTRL_CMD cmd) {
   return 0;
 }
 
+// Asks the stack for a shared memory ring to write audio data to instead of
+// the data socket. The ACK carries the file descriptors of the ring. On any
+// failure the data socket is used as before.
+static void a2dp_get_shm_ring(struct a2dp_stream_common* common) {
+  char cmd = A2DP_CTRL_GET_SHM_RING;
+  char ack = A2DP_CTRL_ACK_UNKNOWN;
+  int fds[SHM_RING_NUM_FDS];
+  size_t num_fds = 0;
+
+  INFO("A2DP COMMAND %s",
+       audio_a2dp_hw_dump_ctrl_event(A2DP_CTRL_GET_SHM_RING));
+
+  if (common->ctrl_fd == AUDIO_SKT_DISCONNECTED) return;
+
+  ssize_t ret;
+  OSI_NO_INTR(ret = send(common->ctrl_fd, &cmd, 1, MSG_NOSIGNAL));
+  if (ret == -1) {
+    ERROR("cmd failed (%s)", strerror(errno));
+    skt_disconnect(common->ctrl_fd);
+    common->ctrl_fd = AUDIO_SKT_DISCONNECTED;
+    return;
+  }
+
+  struct iovec iov;
+  iov.iov_base = &ack;
+  iov.iov_len = 1;
+  char control[CMSG_SPACE(sizeof(fds))];
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+
+  OSI_NO_INTR(ret = recvmsg(common->ctrl_fd, &msg,
+                            MSG_NOSIGNAL | MSG_CMSG_CLOEXEC));
+  if (ret <= 0) {
+    ERROR("A2DP COMMAND %s: no ACK",
+          audio_a2dp_hw_dump_ctrl_event(A2DP_CTRL_GET_SHM_RING));
+    skt_disconnect(common->ctrl_fd);
+    common->ctrl_fd = AUDIO_SKT_DISCONNECTED;
+    return;
+  }
+
+  for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL;
+       cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+      continue;
+    size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    for (size_t i = 0; i < count; i++) {
+      int fd;
+      memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+      if (num_fds < SHM_RING_NUM_FDS)
+        fds[num_fds++] = fd;
+      else
+        close(fd);
+    }
+  }
+
+  INFO("A2DP COMMAND %s DONE STATUS %d (%zu fds)",
+       audio_a2dp_hw_dump_ctrl_event(A2DP_CTRL_GET_SHM_RING), ack, num_fds);
+
+  if (ack == A2DP_CTRL_ACK_SUCCESS && num_fds == SHM_RING_NUM_FDS)
+    common->ring = shm_ring_attach(fds);
+
+  if (common->ring == NULL) {
+    for (size_t i = 0; i < num_fds; i++) close(fds[i]);
+    INFO("shared memory ring not available, using the data socket");
+  }
+}
+
 static int check_a2dp_stream_started(struct a2dp_stream_out *out) {
   if (a2dp_command(&out->common, A2DP_CTRL_CMD_CHECK_STREAM_STARTED) < 0) {
     INFO("Btif not in stream state");
@@ -918,15 +1022,40 @@ static void a2dp_stream_common_init(struct a2dp_stream_common* common) {
   /* manages max capacity of socket pipe */
   common->buffer_sz = AUDIO_STREAM_OUTPUT_BUFFER_SZ;
   common->sink_latency = A2DP_DEFAULT_SINK_LATENCY;
+
+  common->use_ring = false;
+  common->ring = NULL;
+  common->retired_ring = NULL;
+  common->ring_writing = false;
 }
 
 static void a2dp_stream_common_destroy(struct a2dp_stream_common* common) {
   FNLOG();
 
+  shm_ring_free(common->ring);
+  common->ring = NULL;
+  shm_ring_free(common->retired_ring);
+  common->retired_ring = NULL;
+
   delete common->mutex;
   common->mutex = NULL;
 }
 
+// Releases the shared memory ring along with the data socket. If out_write is
+// blocked on the ring, the ring is closed to wake it up and freed by out_write
+// once it returns.
+static void a2dp_release_shm_ring(struct a2dp_stream_common* common) {
+  if (common->ring == NULL) return;
+
+  if (common->ring_writing && common->retired_ring == NULL) {
+    shm_ring_close(common->ring);
+    common->retired_ring = common->ring;
+  } else {
+    shm_ring_free(common->ring);
+  }
+  common->ring = NULL;
+}
+
 static int start_audio_datapath(struct a2dp_stream_common* common) {
   INFO("state %d", common->state);
 
@@ -968,6 +1097,10 @@ static int start_audio_datapath(struct a2dp_stream_common* common) {
 
   /* connect socket if not yet connected */
   if (common->audio_fd == AUDIO_SKT_DISCONNECTED) {
+    /* attach to the ring first so that no data goes through the socket */
+    if (common->use_ring && common->ring == NULL && a2dp_status == 0)
+      a2dp_get_shm_ring(common);
+
     ERROR("Try opening data socket");
     common->audio_fd = skt_connect(A2DP_DATA_PATH, common->buffer_sz);
     if (common->audio_fd < 0) {
@@ -1019,6 +1152,7 @@ static int stop_audio_datapath(struct a2dp_stream_common* common) {
   /* disconnect audio path */
   skt_disconnect(common->audio_fd);
   common->audio_fd = AUDIO_SKT_DISCONNECTED;
+  a2dp_release_shm_ring(common);
 
   return 0;
 }
@@ -1047,6 +1181,7 @@ static int suspend_audio_datapath(struct a2dp_stream_common* common,
   skt_disconnect(common->audio_fd);
 
   common->audio_fd = AUDIO_SKT_DISCONNECTED;
+  a2dp_release_shm_ring(common);
   return 0;
 }
 
@@ -1064,6 +1199,7 @@ static ssize_t out_write(struct audio_stream_out* stream, const void* buffer,
   char trace_buf[512];
   #endif
   size_t write_bytes = bytes;
+  shm_ring_t* ring;
 
   DEBUG("write %zu bytes (fd %d)", bytes, out->common.audio_fd);
 
@@ -1106,6 +1242,8 @@ static ssize_t out_write(struct audio_stream_out* stream, const void* buffer,
           out->common.audio_fd);
   }
 
+  ring = out->common.ring;
+  out->common.ring_writing = true;
   lock.unlock();
   #ifdef BT_AUDIO_SYSTRACE_LOG
   snprintf(trace_buf, 32, "out_write:");
@@ -1114,7 +1252,10 @@ static ssize_t out_write(struct audio_stream_out* stream, const void* buffer,
       ATRACE_BEGIN(trace_buf);
   }
   #endif
-  sent = skt_write(out->common.audio_fd, buffer, write_bytes);
+  if (ring != NULL)
+    sent = shm_write(ring, out->common.audio_fd, buffer, write_bytes);
+  else
+    sent = skt_write(out->common.audio_fd, buffer, write_bytes);
   #ifdef BT_AUDIO_SYSTRACE_LOG
   if (PERF_SYSTRACE)
   {
@@ -1122,6 +1263,9 @@ static ssize_t out_write(struct audio_stream_out* stream, const void* buffer,
   }
   #endif
   lock.lock();
+  out->common.ring_writing = false;
+  shm_ring_free(out->common.retired_ring);
+  out->common.retired_ring = NULL;
 
   if (sent == -1) {
     if (property_get("persist.vendor.bt.a2dp.hal.implementation", a2dp_hal_imp, "false") &&
@@ -1132,6 +1276,7 @@ static ssize_t out_write(struct audio_stream_out* stream, const void* buffer,
 
     skt_disconnect(out->common.audio_fd);
     out->common.audio_fd = AUDIO_SKT_DISCONNECTED;
+    a2dp_release_shm_ring(&out->common);
     if ((out->common.state != AUDIO_A2DP_STATE_SUSPENDED) &&
             (out->common.state != AUDIO_A2DP_STATE_STOPPING)) {
       out->common.state = AUDIO_A2DP_STATE_STOPPED;
@@ -1781,6 +1926,7 @@ static int adev_open_output_stream(struct audio_hw_device* dev,
 
   /* initialize a2dp specifics */
   a2dp_stream_common_init(&out->common);
+  out->common.use_ring = true;
 
   // Make sure we always have the feeding parameters configured
   btav_a2dp_codec_config_t codec_config;
@@ -41,6 +41,7 @@ const char* audio_a2dp_hw_dump_ctrl_event(tA2DP_CTRL_CMD event) {
     CASE_RETURN_STR(A2DP_CTRL_GET_SINK_LATENCY)
     CASE_RETURN_STR(A2DP_CTRL_CMD_STREAM_OPEN)
     CASE_RETURN_STR(A2DP_CTRL_GET_PRESENTATION_POSITION)
+    CASE_RETURN_STR(A2DP_CTRL_GET_SHM_RING)
   }
 
   return "UNKNOWN A2DP_CTRL_CMD";
@@ -27,10 +27,15 @@
 
 #include "bt_target.h"
 
+#include <dirent.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
+#include <algorithm>
 #include <sstream>
 
 #include "bt_common.h"
@@ -41,10 +46,12 @@
 #include "btm_int.h"
 #include "database.h"
 #include "database_builder.h"
+#include "osi/include/crc32.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
 #include "sdp_api.h"
 #include "sdpdefs.h"
+#include "stack/crypto_toolbox/crypto_toolbox.h"
 #include "utl.h"
 
 using base::StringPrintf;
@@ -75,8 +82,12 @@ static void bta_gattc_explore_srvc_finished(uint16_t conn_id,
 
 #define BTA_GATT_SDP_DB_SIZE 4096
 
-#define GATT_CACHE_PREFIX "/data/misc/bluetooth/gatt_cache_"
-#define GATT_CACHE_VERSION 5
+#define GATT_CACHE_DIR "/data/misc/bluetooth/"
+#define GATT_CACHE_FILE_NAME "gatt_cache_"
+#define GATT_CACHE_PREFIX GATT_CACHE_DIR GATT_CACHE_FILE_NAME
+#define GATT_HASH_PREFIX GATT_CACHE_DIR "gatt_hash_"
+#define GATT_CACHE_VERSION 6
+#define GATT_HASH_FILE_MAGIC 0x48544147 /* "GATH" */
 
 static void bta_gattc_generate_cache_file_name(char* buffer, size_t buffer_len,
                                                const RawAddress& bda) {
@@ -85,6 +96,14 @@ static void bta_gattc_generate_cache_file_name(char* buffer, size_t buffer_len,
            bda.address[4], bda.address[5]);
 }
 
+static void bta_gattc_generate_hash_file_name(char* buffer, size_t buffer_len,
+                                              const Octet16& hash) {
+  int len = snprintf(buffer, buffer_len, "%s", GATT_HASH_PREFIX);
+  for (uint8_t b : hash) {
+    len += snprintf(buffer + len, buffer_len - len, "%02x", b);
+  }
+}
+
 /*****************************************************************************
  *  Constants and data types
  ****************************************************************************/
@@ -94,6 +113,29 @@ typedef struct {
   uint16_t sdp_conn_id;
 } tBTA_GATTC_CB_DATA;
 
+/* Contents of the per-device cache file: the hash of the server database,
+ * which names the file the database itself is stored in. Devices exposing
+ * the same database share that file. */
+typedef struct {
+  uint16_t version;
+  uint16_t reserved;
+  Octet16 hash;
+} tBTA_GATTC_CACHE_LINK;
+
+/* Header of a database file. It is followed by |num_attr| StoredAttribute
+ * records, which are deserialized in place from a read-only mapping. */
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t num_attr;
+  uint32_t checksum; /* CRC-32 of the records */
+  uint32_t reserved;
+  Octet16 hash;
+} tBTA_GATTC_CACHE_HDR;
+
+static_assert(sizeof(tBTA_GATTC_CACHE_HDR) % alignof(StoredAttribute) == 0,
+              "records following the cache header would be misaligned");
+
 #if (BTA_GATT_DEBUG == TRUE)
 /* utility functions */
 
@@ -714,61 +756,260 @@ void bta_gattc_get_gatt_db(uint16_t conn_id, uint16_t start_handle,
 
 /*******************************************************************************
  *
- * Function         bta_gattc_cache_load
+ * Function         bta_gattc_database_hash
  *
- * Description      Load GATT cache from storage for server.
+ * Description      Identify a server database by its contents, so that all
+ *                  devices exposing the same database share one cache file.
+ *                  Computed like the GATT Database Hash, with AES-CMAC and a
+ *                  zero key, over the handle, type and value of each
+ *                  declaration and the handle and type of each descriptor.
+ *
+ * Parameter        attr: attributes of the database.
+ *
+ * Returns          the hash of the database.
+ *
+ ******************************************************************************/
+static Octet16 bta_gattc_database_hash(
+    const std::vector<StoredAttribute>& attr) {
+  std::vector<uint8_t> msg;
+  msg.reserve(attr.size() * sizeof(StoredAttribute));
+
+  auto put16 = [&msg](uint16_t value) {
+    msg.push_back(value & 0xff);
+    msg.push_back(value >> 8);
+  };
+  auto put_uuid = [&msg](const Uuid& uuid) {
+    Uuid::UUID128Bit uuid128 = uuid.To128BitLE();
+    msg.insert(msg.end(), uuid128.begin(), uuid128.end());
+  };
+
+  for (const StoredAttribute& a : attr) {
+    put16(a.handle);
+    put_uuid(a.type);
+
+    uint16_t type = a.type.Is16Bit() ? a.type.As16Bit() : 0;
+    if (type == GATT_UUID_PRI_SERVICE || type == GATT_UUID_SEC_SERVICE) {
+      put_uuid(a.value.service.uuid);
+      put16(a.value.service.end_handle);
+    } else if (type == GATT_UUID_INCLUDE_SERVICE) {
+      put16(a.value.included_service.handle);
+      put16(a.value.included_service.end_handle);
+      put_uuid(a.value.included_service.uuid);
+    } else if (type == GATT_UUID_CHAR_DECLARE) {
+      msg.push_back(a.value.characteristic.properties);
+      put16(a.value.characteristic.value_handle);
+      put_uuid(a.value.characteristic.uuid);
+    }
+  }
+
+  /* aes_cmac() takes at most 64KiB and stages its input on the stack, so
+   * larger databases are hashed in chunks, each keyed with the previous
+   * result. */
+  constexpr size_t kChunkSize = 0x4000;
+  Octet16 hash{};
+  size_t offset = 0;
+  do {
+    size_t len = std::min(kChunkSize, msg.size() - offset);
+    hash = crypto_toolbox::aes_cmac(hash, msg.data() + offset, len);
+    offset += len;
+  } while (offset < msg.size());
+
+  return hash;
+}
+
+/* Read the database hash a per-device cache file |fname| refers to. */
+static bool bta_gattc_read_cache_link(const char* fname, Octet16* p_hash) {
+  FILE* fd = fopen(fname, "rb");
+  if (!fd) return false;
+
+  tBTA_GATTC_CACHE_LINK link;
+  bool success = (fread(&link, sizeof(link), 1, fd) == 1);
+  fclose(fd);
+
+  if (!success) {
+    LOG(ERROR) << __func__ << ": can't read GATT cache file: " << fname;
+    return false;
+  }
+
+  if (link.version != GATT_CACHE_VERSION) {
+    LOG(ERROR) << __func__ << ": wrong GATT cache version: " << fname;
+    return false;
+  }
+
+  *p_hash = link.hash;
+  return true;
+}
+
+/* Return true if any per-device cache file still refers to |hash|. */
+static bool bta_gattc_hash_in_use(const Octet16& hash) {
+  DIR* dir = opendir(GATT_CACHE_DIR);
+  if (!dir) return false;
+
+  bool in_use = false;
+  struct dirent* entry;
+  while (!in_use && (entry = readdir(dir)) != NULL) {
+    if (strncmp(entry->d_name, GATT_CACHE_FILE_NAME,
+                strlen(GATT_CACHE_FILE_NAME)) != 0)
+      continue;
+
+    std::string fname = std::string(GATT_CACHE_DIR) + entry->d_name;
+    Octet16 link_hash;
+    if (bta_gattc_read_cache_link(fname.c_str(), &link_hash) &&
+        link_hash == hash)
+      in_use = true;
+  }
+
+  closedir(dir);
+  return in_use;
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_gattc_hash_load
+ *
+ * Description      Map the database file for |hash|, verify it and build the
+ *                  database straight from the mapped records. A corrupted file
+ *                  is removed, so that it is written again after discovery.
+ *
+ * Parameter        hash: hash of the database to load.
+ *                  p_db: database to fill.
  *
- * Parameter        p_clcb: pointer to server clcb, that will
- *                          be filled from storage
  * Returns          true on success, false otherwise
  *
  ******************************************************************************/
-bool bta_gattc_cache_load(tBTA_GATTC_CLCB* p_clcb) {
+static bool bta_gattc_hash_load(const Octet16& hash, gatt::Database* p_db) {
   char fname[255] = {0};
-  bta_gattc_generate_cache_file_name(fname, sizeof(fname),
-                                     p_clcb->p_srcb->server_bda);
+  bta_gattc_generate_hash_file_name(fname, sizeof(fname), hash);
 
-  FILE* fd = fopen(fname, "rb");
-  if (!fd) {
+  int fd = open(fname, O_RDONLY);
+  if (fd == INVALID_FD) {
     LOG(ERROR) << __func__ << ": can't open GATT cache file " << fname
                << " for reading, error: " << strerror(errno);
     return false;
   }
 
-  uint16_t cache_ver = 0;
-  bool success = false;
-  uint16_t num_attr = 0;
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      (size_t)st.st_size < sizeof(tBTA_GATTC_CACHE_HDR)) {
+    LOG(ERROR) << __func__ << ": truncated GATT cache file: " << fname;
+    close(fd);
+    unlink(fname);
+    return false;
+  }
 
-  if (fread(&cache_ver, sizeof(uint16_t), 1, fd) != 1) {
-    LOG(ERROR) << __func__ << ": can't read GATT cache version from: " << fname;
-    goto done;
+  size_t file_size = st.st_size;
+  void* map = mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    LOG(ERROR) << __func__ << ": can't map GATT cache file " << fname
+               << ", error: " << strerror(errno);
+    return false;
   }
 
-  if (cache_ver != GATT_CACHE_VERSION) {
-    LOG(ERROR) << __func__ << ": wrong GATT cache version: " << fname;
-    goto done;
+  const tBTA_GATTC_CACHE_HDR* hdr = (const tBTA_GATTC_CACHE_HDR*)map;
+  const StoredAttribute* attr = (const StoredAttribute*)(hdr + 1);
+  size_t attr_size = hdr->num_attr * sizeof(StoredAttribute);
+  bool success = false;
+
+  if (hdr->magic != GATT_HASH_FILE_MAGIC ||
+      hdr->version != GATT_CACHE_VERSION || hdr->hash != hash ||
+      file_size != sizeof(tBTA_GATTC_CACHE_HDR) + attr_size) {
+    LOG(ERROR) << __func__ << ": malformed GATT cache file: " << fname;
+  } else if (crc32_compute(attr, attr_size) != hdr->checksum) {
+    LOG(ERROR) << __func__ << ": GATT cache checksum mismatch: " << fname;
+  } else {
+    *p_db = gatt::Database::Deserialize(attr, hdr->num_attr, &success);
   }
 
-  if (fread(&num_attr, sizeof(uint16_t), 1, fd) != 1) {
+  munmap(map, file_size);
+  if (!success) unlink(fname);
+  return success;
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_gattc_hash_write
+ *
+ * Description      Store the database file for |hash|, unless another device
+ *                  exposing the same database already did.
+ *
+ * Parameter        hash: hash of the database.
+ *                  attr: attributes to save.
+ *
+ * Returns          true if the database file is available.
+ *
+ ******************************************************************************/
+static bool bta_gattc_hash_write(const Octet16& hash,
+                                 const std::vector<StoredAttribute>& attr) {
+  char fname[255] = {0};
+  bta_gattc_generate_hash_file_name(fname, sizeof(fname), hash);
+
+  if (access(fname, F_OK) == 0) return true;
+
+  tBTA_GATTC_CACHE_HDR hdr;
+  memset(&hdr, 0, sizeof(hdr));
+  hdr.magic = GATT_HASH_FILE_MAGIC;
+  hdr.version = GATT_CACHE_VERSION;
+  hdr.num_attr = attr.size();
+  hdr.checksum = crc32_compute(
+      attr.data(), attr.size() * sizeof(StoredAttribute));
+  hdr.hash = hash;
+
+  /* Written under a temporary name and renamed, so that a reader never maps
+   * a partially written file. */
+  std::string tmp_fname = std::string(fname) + ".tmp";
+  FILE* fd = fopen(tmp_fname.c_str(), "wb");
+  if (!fd) {
     LOG(ERROR) << __func__
-               << ": can't read number of GATT attributes: " << fname;
-    goto done;
+               << ": can't open GATT cache file for writing: " << tmp_fname;
+    return false;
   }
 
-  {
-    std::vector<StoredAttribute> attr(num_attr);
+  bool success =
+      (fwrite(&hdr, sizeof(hdr), 1, fd) == 1) &&
+      (fwrite(attr.data(), sizeof(StoredAttribute), attr.size(), fd) ==
+       attr.size());
+  success = (fclose(fd) == 0) && success;
 
-    if (fread(attr.data(), sizeof(StoredAttribute), num_attr, fd) != num_attr) {
-      LOG(ERROR) << __func__ << "s: can't read GATT attributes: " << fname;
-      goto done;
-    }
+  if (!success) {
+    LOG(ERROR) << __func__ << ": can't write GATT cache file: " << tmp_fname;
+    unlink(tmp_fname.c_str());
+    return false;
+  }
 
-    p_clcb->p_srcb->gatt_database = gatt::Database::Deserialize(attr, &success);
+  if (rename(tmp_fname.c_str(), fname) != 0) {
+    LOG(ERROR) << __func__ << ": can't rename GATT cache file " << tmp_fname
+               << ", error: " << strerror(errno);
+    unlink(tmp_fname.c_str());
+    return false;
   }
 
-done:
-  fclose(fd);
-  return success;
+  return true;
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_gattc_cache_load
+ *
+ * Description      Load GATT cache from storage for server.
+ *
+ * Parameter        p_clcb: pointer to server clcb, that will
+ *                          be filled from storage
+ * Returns          true on success, false otherwise
+ *
+ ******************************************************************************/
+bool bta_gattc_cache_load(tBTA_GATTC_CLCB* p_clcb) {
+  char fname[255] = {0};
+  bta_gattc_generate_cache_file_name(fname, sizeof(fname),
+                                     p_clcb->p_srcb->server_bda);
+
+  Octet16 hash;
+  if (!bta_gattc_read_cache_link(fname, &hash)) {
+    LOG(ERROR) << __func__ << ": can't load GATT cache file " << fname;
+    return false;
+  }
+
+  return bta_gattc_hash_load(hash, &p_clcb->p_srcb->gatt_database);
 }
 
 /*******************************************************************************
@@ -785,6 +1026,9 @@ done:
  ******************************************************************************/
 static void bta_gattc_cache_write(const RawAddress& server_bda,
                                   const std::vector<StoredAttribute>& attr) {
+  Octet16 hash = bta_gattc_database_hash(attr);
+  if (!bta_gattc_hash_write(hash, attr)) return;
+
   char fname[255] = {0};
   bta_gattc_generate_cache_file_name(fname, sizeof(fname), server_bda);
 
@@ -795,25 +1039,12 @@ static void bta_gattc_cache_write(const RawAddress& server_bda,
     return;
   }
 
-  uint16_t cache_ver = GATT_CACHE_VERSION;
-  if (fwrite(&cache_ver, sizeof(uint16_t), 1, fd) != 1) {
-    LOG(ERROR) << __func__ << ": can't write GATT cache version: " << fname;
-    fclose(fd);
-    return;
-  }
-
-  uint16_t num_attr = attr.size();
-  if (fwrite(&num_attr, sizeof(uint16_t), 1, fd) != 1) {
-    LOG(ERROR) << __func__
-               << ": can't write GATT cache attribute count: " << fname;
-    fclose(fd);
-    return;
-  }
-
-  if (fwrite(attr.data(), sizeof(StoredAttribute), num_attr, fd) != num_attr) {
-    LOG(ERROR) << __func__ << ": can't write GATT cache attributes: " << fname;
-    fclose(fd);
-    return;
+  tBTA_GATTC_CACHE_LINK link;
+  memset(&link, 0, sizeof(link));
+  link.version = GATT_CACHE_VERSION;
+  link.hash = hash;
+  if (fwrite(&link, sizeof(link), 1, fd) != 1) {
+    LOG(ERROR) << __func__ << ": can't write GATT cache file: " << fname;
   }
 
   fclose(fd);
@@ -835,5 +1066,14 @@ void bta_gattc_cache_reset(const RawAddress& server_bda) {
   VLOG(1) << __func__;
   char fname[255] = {0};
   bta_gattc_generate_cache_file_name(fname, sizeof(fname), server_bda);
+
+  Octet16 hash;
+  bool has_hash = bta_gattc_read_cache_link(fname, &hash);
   unlink(fname);
+
+  /* the database file goes once no other device refers to it */
+  if (has_hash && !bta_gattc_hash_in_use(hash)) {
+    bta_gattc_generate_hash_file_name(fname, sizeof(fname), hash);
+    unlink(fname);
+  }
 }
@@ -117,13 +117,14 @@ std::vector<StoredAttribute> Database::Serialize() const {
   return nv_attr;
 }
 
-Database Database::Deserialize(const std::vector<StoredAttribute>& nv_attr,
+Database Database::Deserialize(const StoredAttribute* nv_attr, size_t count,
                                bool* success) {
   // clear reallocating
   Database result;
-  auto it = nv_attr.cbegin();
+  const StoredAttribute* it = nv_attr;
+  const StoredAttribute* end = nv_attr + count;
 
-  for (; it != nv_attr.cend(); ++it) {
+  for (; it != end; ++it) {
     const auto& attr = *it;
     if (attr.type != PRIMARY_SERVICE && attr.type != SECONDARY_SERVICE) break;
     result.services.emplace_back(
@@ -134,7 +135,7 @@ Database Database::Deserialize(const std::vector<StoredAttribute>& nv_attr,
   }
 
   auto current_service_it = result.services.begin();
-  for (; it != nv_attr.cend(); it++) {
+  for (; it != end; it++) {
     const auto& attr = *it;
 
     // go to the service this attribute belongs to; attributes are stored in
@@ -174,6 +175,11 @@ Database Database::Deserialize(const std::vector<StoredAttribute>& nv_attr,
                          .uuid = attr.value.characteristic.uuid});
 
     } else {
+      if (current_service_it->characteristics.empty()) {
+        LOG(ERROR) << __func__ << ": Descriptor outside of characteristic!";
+        *success = false;
+        return result;
+      }
       current_service_it->characteristics.back().descriptors.emplace_back(
           Descriptor{.handle = attr.handle, .uuid = attr.type});
     }
@@ -111,7 +111,14 @@ class Database {
   std::vector<gatt::StoredAttribute> Serialize() const;
 
   static Database Deserialize(const std::vector<gatt::StoredAttribute>& nv_attr,
-                              bool* success);
+                              bool* success) {
+    return Deserialize(nv_attr.data(), nv_attr.size(), success);
+  }
+
+  /* Same as above, but reads |count| attributes in place, i.e. straight out
+   * of a mapped cache file. */
+  static Database Deserialize(const gatt::StoredAttribute* nv_attr,
+                              size_t count, bool* success);
 
   friend class DatabaseBuilder;
 
@@ -66,6 +66,11 @@ bool btif_storage_get_hearing_aid_prop(
 constexpr uint8_t CODEC_G722_16KHZ = 0x01;
 constexpr uint8_t CODEC_G722_24KHZ = 0x02;
 
+// Largest audio packet per channel: 20ms at 24kHz. G.722 packs two samples in
+// one byte.
+constexpr int MAX_PCM_SAMPLES_PER_PACKET = 24 * HA_INTERVAL_20_MS;
+constexpr int MAX_G722_BYTES_PER_PACKET = MAX_PCM_SAMPLES_PER_PACKET / 2;
+
 // audio control point opcodes
 constexpr uint8_t CONTROL_POINT_OP_START = 0x01;
 constexpr uint8_t CONTROL_POINT_OP_STOP = 0x02;
@@ -131,6 +136,7 @@ class HearingDevices {
     if (FindByAddress(device.address) != nullptr) return;
 
     devices.push_back(device);
+    InvalidateAudioRoute();
   }
 
   void Remove(const RawAddress& address) {
@@ -141,6 +147,7 @@ class HearingDevices {
       }
 
       it = devices.erase(it);
+      InvalidateAudioRoute();
       return;
     }
   }
@@ -206,7 +213,36 @@ class HearingDevices {
 
   size_t size() { return (devices.size()); }
 
+  // Returns the left and right devices accepting audio, or nullptr. The lookup
+  // is cached until InvalidateAudioRoute() is called.
+  void GetAudioRoute(HearingDevice** left, HearingDevice** right) {
+    if (!audio_route_valid) {
+      audio_left = nullptr;
+      audio_right = nullptr;
+      for (auto& device : devices) {
+        if (!device.accepting_audio) continue;
+
+        if (device.isLeft())
+          audio_left = &device;
+        else
+          audio_right = &device;
+      }
+      audio_route_valid = true;
+    }
+    *left = audio_left;
+    *right = audio_right;
+  }
+
+  // Must be called when |devices| changes, or when the side or accepting_audio
+  // of a device changes.
+  void InvalidateAudioRoute() { audio_route_valid = false; }
+
   std::vector<HearingDevice> devices;
+
+ private:
+  bool audio_route_valid = false;
+  HearingDevice* audio_left = nullptr;
+  HearingDevice* audio_right = nullptr;
 };
 
 static void write_rpt_ctl_cfg_cb(uint16_t conn_id, tGATT_STATUS status,
@@ -220,6 +256,12 @@ static void write_rpt_ctl_cfg_cb(uint16_t conn_id, tGATT_STATUS status,
 g722_encode_state_t* encoder_state_left = nullptr;
 g722_encode_state_t* encoder_state_right = nullptr;
 
+// Per channel PCM and G.722 data of the packet being encoded
+alignas(64) int16_t pcm_left[MAX_PCM_SAMPLES_PER_PACKET];
+alignas(64) int16_t pcm_right[MAX_PCM_SAMPLES_PER_PACKET];
+alignas(64) uint8_t encoded_left[MAX_G722_BYTES_PER_PACKET];
+alignas(64) uint8_t encoded_right[MAX_G722_BYTES_PER_PACKET];
+
 inline void encoder_state_init() {
   if (encoder_state_left != nullptr) {
     LOG(WARNING) << __func__ << ": encoder already initialized";
@@ -781,6 +823,7 @@ class HearingAidImpl : public HearingAid {
     uint8_t capabilities;
     STREAM_TO_UINT8(capabilities, p);
     hearingDevice->capabilities = capabilities;
+    hearingDevices.InvalidateAudioRoute();
     bool side = capabilities & CAPABILITY_SIDE;
     bool standalone = capabilities & CAPABILITY_BINAURAL;
     VLOG(2) << __func__ << " capabilities: " << (side ? "right" : "left")
@@ -982,6 +1025,7 @@ class HearingAidImpl : public HearingAid {
     }
 
     hearingDevice->accepting_audio = true;
+    hearingDevices.InvalidateAudioRoute();
     LOG(INFO) << __func__ << ": address=" << address
               << ", hi_sync_id=" << loghex(hearingDevice->hi_sync_id)
               << ", codec_in_use=" << loghex(codec_in_use)
@@ -1151,18 +1195,9 @@ class HearingAidImpl : public HearingAid {
     if (num_samples % 2 != 0)
       LOG(FATAL) << "num_samples is not even: " << num_samples;
 
-    // TODO: we should cache left/right and current state, instad of recomputing
-    // it for each packet, 100 times a second.
-    HearingDevice* left = nullptr;
-    HearingDevice* right = nullptr;
-    for (auto& device : hearingDevices.devices) {
-      if (!device.accepting_audio) continue;
-
-      if (device.isLeft())
-        left = &device;
-      else
-        right = &device;
-    }
+    HearingDevice* left;
+    HearingDevice* right;
+    hearingDevices.GetAudioRoute(&left, &right);
 
     if (left == nullptr && right == nullptr) {
       HearingAidAudioSource::Stop();
@@ -1172,31 +1207,23 @@ class HearingAidImpl : public HearingAid {
       return;
     }
 
-    std::vector<uint16_t> chan_left;
-    std::vector<uint16_t> chan_right;
-    if (left == nullptr || right == nullptr) {
-      for (int i = 0; i < num_samples; i++) {
-        const uint8_t* sample = data.data() + i * 4;
+    if (num_samples > MAX_PCM_SAMPLES_PER_PACKET)
+      LOG(FATAL) << "num_samples is too large: " << num_samples;
 
+    const uint8_t* sample = data.data();
+    const int16_t* chan_left = pcm_left;
+    const int16_t* chan_right = pcm_right;
+    if (left == nullptr || right == nullptr) {
+      for (int i = 0; i < num_samples; i++, sample += 4) {
         int16_t left = (int16_t)((*(sample + 1) << 8) + *sample) >> 1;
-
-        sample += 2;
-        int16_t right = (int16_t)((*(sample + 1) << 8) + *sample) >> 1;
-
-        int32_t mono_data = (int32_t)((left + right) >> 1);
-        chan_left.push_back(uint16_t(mono_data));
-        chan_right.push_back(uint16_t(mono_data));
+        int16_t right = (int16_t)((*(sample + 3) << 8) + *(sample + 2)) >> 1;
+        pcm_left[i] = (int16_t)((left + right) >> 1);
       }
+      chan_right = pcm_left;
     } else {
-      for (int i = 0; i < num_samples; i++) {
-        const uint8_t* sample = data.data() + i * 4;
-
-        uint16_t left = (int16_t)((*(sample + 1) << 8) + *sample) >> 1;
-        chan_left.push_back(left);
-
-        sample += 2;
-        uint16_t right = (int16_t)((*(sample + 1) << 8) + *sample) >> 1;
-        chan_right.push_back(right);
+      for (int i = 0; i < num_samples; i++, sample += 4) {
+        pcm_left[i] = (int16_t)((*(sample + 1) << 8) + *sample) >> 1;
+        pcm_right[i] = (int16_t)((*(sample + 3) << 8) + *(sample + 2)) >> 1;
       }
     }
 
@@ -1204,23 +1231,24 @@ class HearingAidImpl : public HearingAid {
 
     // divide encoded data into packets, add header, send.
 
-    // TODO: make those buffers static and global to prevent constant
-    // reallocations
-    // TODO: this should basically fit the encoded data, tune the size later
-    std::vector<uint8_t> encoded_data_left;
-    if (left) {
-      // TODO: instead of a magic number, we need to figure out the correct
-      // buffer size
-      encoded_data_left.resize(4000);
-      int encoded_size = 0;
-      if (chan_left.size() > 0) {
-          encoded_size = g722_encode(encoder_state_left, encoded_data_left.data(),
-                      (const int16_t*)chan_left.data(), chan_left.size());
-      } else {
-        LOG(ERROR) << "Error: No chan_left data to encode";
-      }
-      encoded_data_left.resize(encoded_size);
+    if (num_samples == 0) LOG(ERROR) << "Error: No audio data to encode";
+
+    // Both sides are encoded in one pass, which shares the work between the
+    // two channels.
+    size_t encoded_data_size;
+    if (left && right) {
+      encoded_data_size = g722_encode_stereo(
+          encoder_state_left, encoder_state_right, encoded_left, encoded_right,
+          chan_left, chan_right, num_samples);
+    } else if (left) {
+      encoded_data_size =
+          g722_encode(encoder_state_left, encoded_left, chan_left, num_samples);
+    } else {
+      encoded_data_size = g722_encode(encoder_state_right, encoded_right,
+                                      chan_right, num_samples);
+    }
 
+    if (left) {
       uint16_t cid = GAP_ConnGetL2CAPCid(left->gap_handle);
       uint16_t packets_to_flush = L2CA_FlushChannel(cid, L2CAP_FLUSH_CHANS_GET);
       if (packets_to_flush) {
@@ -1235,20 +1263,7 @@ class HearingAidImpl : public HearingAid {
       check_and_do_rssi_read(left);
     }
 
-    std::vector<uint8_t> encoded_data_right;
     if (right) {
-      // TODO: instead of a magic number, we need to figure out the correct
-      // buffer size
-      encoded_data_right.resize(4000);
-      int encoded_size = 0;
-      if (chan_right.size() > 0) {
-          encoded_size = g722_encode(encoder_state_right, encoded_data_right.data(),
-                      (const int16_t*)chan_right.data(), chan_right.size());
-      } else {
-        LOG(ERROR) << "Error: No chan_right data to encode";
-      }
-      encoded_data_right.resize(encoded_size);
-
       uint16_t cid = GAP_ConnGetL2CAPCid(right->gap_handle);
       uint16_t packets_to_flush = L2CA_FlushChannel(cid, L2CAP_FLUSH_CHANS_GET);
       if (packets_to_flush) {
@@ -1263,20 +1278,17 @@ class HearingAidImpl : public HearingAid {
       check_and_do_rssi_read(right);
     }
 
-    size_t encoded_data_size =
-        std::max(encoded_data_left.size(), encoded_data_right.size());
-
     uint16_t packet_size =
         CalcCompressedAudioPacketSize(codec_in_use, default_data_interval_ms);
 
     for (size_t i = 0; i < encoded_data_size; i += packet_size) {
       if (left) {
         left->audio_stats.packet_send_count++;
-        SendAudio(encoded_data_left.data() + i, packet_size, left);
+        SendAudio(encoded_left + i, packet_size, left);
       }
       if (right) {
         right->audio_stats.packet_send_count++;
-        SendAudio(encoded_data_right.data() + i, packet_size, right);
+        SendAudio(encoded_right + i, packet_size, right);
       }
       seq_counter++;
     }
@@ -1334,6 +1346,7 @@ class HearingAidImpl : public HearingAid {
                   << ", accepting_audio=" << hearingDevice->accepting_audio;
 
         hearingDevice->accepting_audio = false;
+        hearingDevices.InvalidateAudioRoute();
         hearingDevice->gap_handle = 0;
         hearingDevice->playback_started = false;
         hearingDevice->command_acked = false;
@@ -1540,6 +1553,7 @@ class HearingAidImpl : public HearingAid {
     }
 
     hearingDevice->accepting_audio = false;
+    hearingDevices.InvalidateAudioRoute();
     LOG(INFO) << __func__ << ": device=" << hearingDevice->address
               << ", playback_started=" << hearingDevice->playback_started;
     hearingDevice->playback_started = false;
@@ -1566,6 +1580,7 @@ class HearingAidImpl : public HearingAid {
     }
 
     hearingDevices.devices.clear();
+    hearingDevices.InvalidateAudioRoute();
 
     encoder_state_release();
   }
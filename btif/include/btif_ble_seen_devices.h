@@ -0,0 +1,100 @@
+/*
+ * Copyright 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BTIF_BLE_SEEN_DEVICES_H_
+#define BTIF_BLE_SEEN_DEVICES_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "raw_address.h"
+
+// Devices reported by LE scans.
+//
+// For every device the table remembers the device and address types last
+// written to btif_storage, so that advertising reports which change neither
+// are not written again, and the last report forwarded to the scanner
+// clients, so that repeats of it within the coalescing window can be dropped.
+// The table is bounded: once full, the least recently seen device makes room
+// for a new one.
+//
+// The table is not thread safe. The scanner only uses it on the JNI thread.
+class BleSeenDevices {
+ public:
+  static constexpr size_t kDefaultMaxDevices = 1024;
+
+  struct Device {
+    // The types last written to btif_storage, valid if |stored| is set.
+    bool stored = false;
+    uint8_t device_type = 0;
+    uint8_t addr_type = 0;
+
+    // Set once the advertised name of the device has been looked at.
+    bool name_checked = false;
+
+    // The last report forwarded to the scanner clients.
+    bool forwarded = false;
+    uint64_t forwarded_ms = 0;
+    uint16_t evt_type = 0;
+    std::vector<uint8_t> data;
+  };
+
+  explicit BleSeenDevices(size_t max_devices = kDefaultMaxDevices);
+
+  // Sets the window within which an unchanged report of a device is not
+  // forwarded again. 0, the default, forwards every report.
+  void SetCoalesceWindow(uint64_t window_ms) { coalesce_window_ms_ = window_ms; }
+
+  // Returns the entry of |bd_addr|, adding a new one if the device has not
+  // been seen. The entry stays valid until the next call that adds a device.
+  Device* Get(const RawAddress& bd_addr);
+
+  // Returns true if |device| changed from what was written to btif_storage,
+  // and records |device_type| and |addr_type| as written: the caller is
+  // expected to write them.
+  static bool UpdateStoredTypes(Device* device, uint8_t device_type,
+                                uint8_t addr_type);
+
+  // Returns true if a report of |device| received at |now_ms| is to be
+  // forwarded to the scanner clients, and records it as the last one
+  // forwarded if so.
+  bool ShouldForward(Device* device, uint16_t evt_type,
+                     const std::vector<uint8_t>& data, uint64_t now_ms);
+
+  // Drops |bd_addr| from the table, so that its next report is written
+  // through to btif_storage and forwarded.
+  void Remove(const RawAddress& bd_addr);
+
+  void Clear();
+
+  size_t Size() const { return devices_.size(); }
+
+ private:
+  using DeviceList = std::list<std::pair<RawAddress, Device>>;
+
+  size_t max_devices_;
+  uint64_t coalesce_window_ms_;
+
+  // Most recently seen first.
+  DeviceList devices_;
+  std::unordered_map<RawAddress, DeviceList::iterator> index_;
+};
+
+#endif  // BTIF_BLE_SEEN_DEVICES_H_
@@ -32,4 +32,9 @@ extern const btgatt_server_interface_t btgattServerInterface;
 
 BleAdvertiserInterface* get_ble_advertiser_instance();
 BleScannerInterface* get_ble_scanner_instance();
+
+/* Forgets what the scanner wrote to storage for |bd_addr|, so that the next
+ * advertising report of the device is written through again. Must be called
+ * on the JNI thread. */
+void btif_ble_scanner_forget_device(const RawAddress& bd_addr);
 #endif
@@ -63,6 +63,7 @@
 #include "btif_api.h"
 #include "btif_bqr.h"
 #include "btif_config.h"
+#include "btif_sock_rfc.h"
 #include "device/include/controller.h"
 #include "btif_debug.h"
 #include "btif_storage.h"
@@ -71,11 +72,13 @@
 #include "btsnoop_mem.h"
 #include "common/address_obfuscator.h"
 #include "device/include/interop.h"
+#include "hci_layer.h"
 #include "osi/include/alarm.h"
 #include "osi/include/allocation_tracker.h"
 #include "osi/include/log.h"
 #include "osi/include/metrics.h"
 #include "osi/include/osi.h"
+#include "osi/include/pool_allocator.h"
 #include "osi/include/wakelock.h"
 #include "stack/gatt/connection_manager.h"
 #include "stack_manager.h"
@@ -345,13 +348,16 @@ static void dump(int fd, const char** arguments) {
   btif_debug_bond_event_dump(fd);
   btif_debug_a2dp_dump(fd);
   btif_debug_config_dump(fd);
+  btsock_rfc_debug_dump(fd);
 #if (BT_IOT_LOGGING_ENABLED == TRUE)
   device_debug_iot_config_dump(fd);
 #endif
   BTA_HfClientDumpStatistics(fd);
   wakelock_debug_dump(fd);
   osi_allocator_debug_dump(fd);
+  pool_allocator_debug_dump(fd);
   alarm_debug_dump(fd);
+  hci_layer_debug_dump(fd);
   HearingAid::DebugDump(fd);
   connection_manager::dump(fd);
   bluetooth::bqr::DebugDump(fd);
@@ -96,6 +96,24 @@ void btif_a2dp_control_cleanup(void) {
   UIPC_Close(UIPC_CH_ID_ALL);
 }
 
+/* Shares the audio data ring with the audio HAL, passing its file descriptors
+ * along with the ACK. The HAL keeps writing to the data socket if the ring
+ * cannot be set up.
+ */
+static void btif_a2dp_send_shm_ring(void) {
+  uint8_t ack = A2DP_CTRL_ACK_SUCCESS;
+
+  if (UIPC_OpenShmRing(UIPC_CH_ID_AV_AUDIO, AUDIO_STREAM_OUTPUT_BUFFER_SZ) &&
+      UIPC_SendShmRing(UIPC_CH_ID_AV_CTRL, UIPC_CH_ID_AV_AUDIO, &ack,
+                       sizeof(ack))) {
+    return;
+  }
+
+  APPL_TRACE_WARNING("%s: audio data ring not available", __func__);
+  ack = A2DP_CTRL_ACK_UNSUPPORTED;
+  UIPC_Send(UIPC_CH_ID_AV_CTRL, 0, &ack, sizeof(ack));
+}
+
 static void btif_a2dp_recv_ctrl_data(void) {
   tA2DP_CTRL_CMD cmd = A2DP_CTRL_CMD_NONE;
   int n;
@@ -305,6 +323,10 @@ static void btif_a2dp_recv_ctrl_data(void) {
         break;
       }
 
+      case A2DP_CTRL_GET_SHM_RING:
+        btif_a2dp_send_shm_ring();
+        break;
+
       default:
         if (a2dp_cmd_pending != A2DP_CTRL_CMD_NONE)
         {
@@ -659,6 +681,11 @@ static void btif_a2dp_recv_ctrl_data(void) {
         break;
       }
 
+      case A2DP_CTRL_GET_SHM_RING:
+        a2dp_cmd_pending = A2DP_CTRL_CMD_NONE;
+        btif_a2dp_send_shm_ring();
+        break;
+
       default:
         APPL_TRACE_ERROR("%s: UNSUPPORTED CMD (%d)", __func__, cmd);
         btif_a2dp_command_ack(A2DP_CTRL_ACK_FAILURE);
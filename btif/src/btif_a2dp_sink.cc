@@ -351,14 +351,11 @@ static void btif_a2dp_sink_audio_handle_start_decoding(void) {
 
 static void btif_a2dp_sink_handle_inc_media(tBT_SBC_HDR* p_msg) {
   uint8_t* sbc_start_frame = ((uint8_t*)(p_msg + 1) + p_msg->offset + 1);
-  int count;
-  uint32_t pcmBytes, availPcmBytes;
-  int16_t* pcmDataPointer =
-      btif_a2dp_sink_pcm_data; /* Will be overwritten on next packet receipt */
+  uint8_t frames_decoded;
+  uint32_t pcmBytes = sizeof(btif_a2dp_sink_pcm_data);
   OI_STATUS status;
   int num_sbc_frames = p_msg->num_frames_to_be_processed;
   uint32_t sbc_frame_len = p_msg->len - 1;
-  availPcmBytes = sizeof(btif_a2dp_sink_pcm_data);
 
   if ((btif_av_get_peer_sep() == AVDT_TSEP_SNK) ||
       (btif_a2dp_sink_cb.rx_flush)) {
@@ -369,26 +366,22 @@ static void btif_a2dp_sink_handle_inc_media(tBT_SBC_HDR* p_msg) {
   APPL_TRACE_DEBUG("%s Number of SBC frames %d, frame_len %d", __func__,
                    num_sbc_frames, sbc_frame_len);
 
-  for (count = 0; count < num_sbc_frames && sbc_frame_len != 0; count++) {
-    pcmBytes = availPcmBytes;
-    status = OI_CODEC_SBC_DecodeFrame(
-        &btif_a2dp_sink_context, (const OI_BYTE**)&sbc_start_frame,
-        (uint32_t*)&sbc_frame_len, (int16_t*)pcmDataPointer,
-        (uint32_t*)&pcmBytes);
-    if (!OI_SUCCESS(status)) {
-      APPL_TRACE_ERROR("%s: Decoding failure: %d", __func__, status);
-      break;
-    }
-    availPcmBytes -= pcmBytes;
-    pcmDataPointer += pcmBytes / 2;
-    p_msg->offset += (p_msg->len - 1) - sbc_frame_len;
-    p_msg->len = sbc_frame_len + 1;
+  /* All frames of the packet go to btif_a2dp_sink_pcm_data, which is
+   * overwritten on next packet receipt */
+  status = OI_CODEC_SBC_DecodeFrames(
+      &btif_a2dp_sink_context, (const OI_BYTE**)&sbc_start_frame,
+      &sbc_frame_len, btif_a2dp_sink_pcm_data, &pcmBytes,
+      (uint8_t)num_sbc_frames, &frames_decoded);
+  if (!OI_SUCCESS(status)) {
+    APPL_TRACE_ERROR("%s: Decoding failure: %d after %d frames", __func__,
+                     status, frames_decoded);
   }
+  p_msg->offset += (p_msg->len - 1) - sbc_frame_len;
+  p_msg->len = sbc_frame_len + 1;
 
 #ifndef OS_GENERIC
-  BtifAvrcpAudioTrackWriteData(
-      btif_a2dp_sink_cb.audio_track, (void*)btif_a2dp_sink_pcm_data,
-      (sizeof(btif_a2dp_sink_pcm_data) - availPcmBytes));
+  BtifAvrcpAudioTrackWriteData(btif_a2dp_sink_cb.audio_track,
+                               (void*)btif_a2dp_sink_pcm_data, pcmBytes);
 #endif
 }
 
@@ -25,6 +25,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <algorithm>
 #include <unordered_set>
 #include "device/include/controller.h"
 
@@ -37,12 +38,15 @@
 #include "bta_api.h"
 #include "bta_closure_api.h"
 #include "bta_gatt_api.h"
+#include "btif_ble_seen_devices.h"
 #include "btif_config.h"
 #include "btif_dm.h"
 #include "btif_gatt.h"
 #include "btif_gatt_util.h"
 #include "btif_storage.h"
 #include "osi/include/log.h"
+#include "osi/include/properties.h"
+#include "osi/include/time.h"
 #include "vendor_api.h"
 #include "stack_manager.h"
 
@@ -66,29 +70,18 @@ extern const btgatt_callbacks_t* bt_gatt_callbacks;
 
 namespace {
 
-// all access to this variable should be done on the jni thread
-std::set<RawAddress> remote_bdaddr_cache;
-std::queue<RawAddress> remote_bdaddr_cache_ordered;
-const size_t remote_bdaddr_cache_max_size = 1024;
-
-void btif_address_cache_add(const RawAddress& p_bda, uint8_t addr_type) {
-  // Remove the oldest entries
-  while (remote_bdaddr_cache.size() >= remote_bdaddr_cache_max_size) {
-    const RawAddress& raw_address = remote_bdaddr_cache_ordered.front();
-    remote_bdaddr_cache.erase(raw_address);
-    remote_bdaddr_cache_ordered.pop();
-  }
-  remote_bdaddr_cache.insert(p_bda);
-  remote_bdaddr_cache_ordered.push(p_bda);
-}
+// Window within which unchanged advertising reports of a device are not
+// forwarded to the scanner clients again, 0 to forward every report.
+#define SCAN_COALESCE_WINDOW_PROPERTY \
+  "persist.bluetooth.le_scan.coalesce_window_ms"
 
-bool btif_address_cache_find(const RawAddress& p_bda) {
-  return (remote_bdaddr_cache.find(p_bda) != remote_bdaddr_cache.end());
-}
+// all access to this variable should be done on the jni thread
+BleSeenDevices seen_devices;
 
-void btif_address_cache_init(void) {
-  remote_bdaddr_cache.clear();
-  remote_bdaddr_cache_ordered = {};
+void btif_seen_devices_init(void) {
+  seen_devices.Clear();
+  seen_devices.SetCoalesceWindow(
+      std::max(0, osi_property_get_int32(SCAN_COALESCE_WINDOW_PROPERTY, 0)));
 }
 
 void bta_batch_scan_threshold_cb(tBTM_BLE_REF_VALUE ref_value) {
@@ -121,38 +114,47 @@ void bta_scan_results_cb_impl(RawAddress bd_addr, tBT_DEVICE_TYPE device_type,
         value, BT_EIR_SHORTENED_LOCAL_NAME_TYPE, &remote_name_len);
   }
 
-  if ((addr_type != BLE_ADDR_RANDOM) || (p_eir_remote_name)) {
-    if (!btif_address_cache_find(bd_addr)) {
-      btif_address_cache_add(bd_addr, addr_type);
-
-      if (p_eir_remote_name) {
-        if (remote_name_len > BD_NAME_LEN + 1 ||
-            (remote_name_len == BD_NAME_LEN + 1 &&
-             p_eir_remote_name[BD_NAME_LEN] != '\0')) {
-          LOG_INFO(LOG_TAG,
-                   "%s dropping invalid packet - device name too long: %d",
-                   __func__, remote_name_len);
-          return;
-        }
-
-        bt_bdname_t bdname;
-        memcpy(bdname.name, p_eir_remote_name, remote_name_len);
-        if (remote_name_len < BD_NAME_LEN + 1)
-          bdname.name[remote_name_len] = '\0';
-
-        LOG_VERBOSE(LOG_TAG, "%s BLE device name=%s len=%d dev_type=%d",
-                    __func__, bdname.name, remote_name_len, device_type);
-        btif_dm_update_ble_remote_properties(bd_addr, bdname.name, device_type);
+  BleSeenDevices::Device* device = seen_devices.Get(bd_addr);
+
+  if (!device->name_checked &&
+      ((addr_type != BLE_ADDR_RANDOM) || (p_eir_remote_name))) {
+    device->name_checked = true;
+
+    if (p_eir_remote_name) {
+      if (remote_name_len > BD_NAME_LEN + 1 ||
+          (remote_name_len == BD_NAME_LEN + 1 &&
+           p_eir_remote_name[BD_NAME_LEN] != '\0')) {
+        LOG_INFO(LOG_TAG,
+                 "%s dropping invalid packet - device name too long: %d",
+                 __func__, remote_name_len);
+        return;
       }
+
+      bt_bdname_t bdname;
+      memcpy(bdname.name, p_eir_remote_name, remote_name_len);
+      if (remote_name_len < BD_NAME_LEN + 1)
+        bdname.name[remote_name_len] = '\0';
+
+      LOG_VERBOSE(LOG_TAG, "%s BLE device name=%s len=%d dev_type=%d",
+                  __func__, bdname.name, remote_name_len, device_type);
+      btif_dm_update_ble_remote_properties(bd_addr, bdname.name, device_type);
     }
   }
 
-  dev_type = (bt_device_type_t)device_type;
-  BTIF_STORAGE_FILL_PROPERTY(&properties, BT_PROPERTY_TYPE_OF_DEVICE,
-                             sizeof(dev_type), &dev_type);
-  btif_storage_set_remote_device_property(&(bd_addr), &properties);
+  // Only write through to storage what the reports change.
+  if (BleSeenDevices::UpdateStoredTypes(device, device_type, addr_type)) {
+    dev_type = (bt_device_type_t)device_type;
+    BTIF_STORAGE_FILL_PROPERTY(&properties, BT_PROPERTY_TYPE_OF_DEVICE,
+                               sizeof(dev_type), &dev_type);
+    btif_storage_set_remote_device_property(&(bd_addr), &properties);
+
+    btif_storage_set_remote_addr_type(&bd_addr, addr_type);
+  }
+
+  if (!seen_devices.ShouldForward(device, ble_evt_type, value,
+                                  time_get_os_boottime_ms()))
+    return;
 
-  btif_storage_set_remote_addr_type(&bd_addr, addr_type);
   HAL_CBACK(bt_gatt_callbacks, scanner->scan_result_cb, ble_evt_type, addr_type,
             &bd_addr, ble_primary_phy, ble_secondary_phy, ble_advertising_sid,
             ble_tx_power, rssi, ble_periodic_adv_int, std::move(value));
@@ -234,7 +236,7 @@ class BleScannerInterfaceImpl : public BleScannerInterface {
             return;
           }
 
-          btif_address_cache_init();
+          btif_seen_devices_init();
           do_in_bta_thread(
               FROM_HERE, Bind(&BTA_DmBleObserve, true, 0, bta_scan_results_cb));
         },
@@ -352,6 +354,10 @@ BleScannerInterface* btLeScannerInstance = nullptr;
 
 }  // namespace
 
+void btif_ble_scanner_forget_device(const RawAddress& bd_addr) {
+  seen_devices.Remove(bd_addr);
+}
+
 BleScannerInterface* get_ble_scanner_instance() {
   if (btLeScannerInstance == nullptr)
     btLeScannerInstance = new BleScannerInterfaceImpl();
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "btif_ble_seen_devices.h"
+
+#include <base/logging.h>
+
+BleSeenDevices::BleSeenDevices(size_t max_devices)
+    : max_devices_(max_devices), coalesce_window_ms_(0) {
+  CHECK(max_devices_ > 0);
+}
+
+BleSeenDevices::Device* BleSeenDevices::Get(const RawAddress& bd_addr) {
+  auto it = index_.find(bd_addr);
+  if (it != index_.end()) {
+    // Keep the devices still in range at the front.
+    devices_.splice(devices_.begin(), devices_, it->second);
+    return &it->second->second;
+  }
+
+  if (devices_.size() >= max_devices_) {
+    index_.erase(devices_.back().first);
+    devices_.pop_back();
+  }
+
+  devices_.emplace_front(bd_addr, Device());
+  index_[bd_addr] = devices_.begin();
+  return &devices_.front().second;
+}
+
+bool BleSeenDevices::UpdateStoredTypes(Device* device, uint8_t device_type,
+                                       uint8_t addr_type) {
+  if (device->stored && device->device_type == device_type &&
+      device->addr_type == addr_type)
+    return false;
+
+  device->stored = true;
+  device->device_type = device_type;
+  device->addr_type = addr_type;
+  return true;
+}
+
+bool BleSeenDevices::ShouldForward(Device* device, uint16_t evt_type,
+                                   const std::vector<uint8_t>& data,
+                                   uint64_t now_ms) {
+  if (coalesce_window_ms_ != 0 && device->forwarded &&
+      now_ms - device->forwarded_ms < coalesce_window_ms_ &&
+      device->evt_type == evt_type && device->data == data)
+    return false;
+
+  device->forwarded = true;
+  device->forwarded_ms = now_ms;
+  device->evt_type = evt_type;
+  // Only compared against while coalescing.
+  if (coalesce_window_ms_ != 0) device->data = data;
+  return true;
+}
+
+void BleSeenDevices::Remove(const RawAddress& bd_addr) {
+  auto it = index_.find(bd_addr);
+  if (it == index_.end()) return;
+
+  devices_.erase(it->second);
+  index_.erase(it);
+}
+
+void BleSeenDevices::Clear() {
+  devices_.clear();
+  index_.clear();
+}
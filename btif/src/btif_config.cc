@@ -42,6 +42,7 @@
 #include "osi/include/allocator.h"
 #include "osi/include/compat.h"
 #include "osi/include/config.h"
+#include "osi/include/config_journal.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
 #include "osi/include/properties.h"
@@ -62,17 +63,24 @@ using bluetooth::common::AddressObfuscator;
 #if defined(OS_GENERIC)
 static const char* CONFIG_FILE_PATH = "bt_config.conf";
 static const char* CONFIG_BACKUP_PATH = "bt_config.bak";
+static const char* CONFIG_JOURNAL_PATH = "bt_config.journal";
 static const char* CONFIG_LEGACY_FILE_PATH = "bt_config.xml";
 #else   // !defined(OS_GENERIC)
 static const char* CONFIG_FILE_PATH = "/data/misc/bluedroid/bt_config.conf";
 static const char* CONFIG_BACKUP_PATH = "/data/misc/bluedroid/bt_config.bak";
+static const char* CONFIG_JOURNAL_PATH =
+    "/data/misc/bluedroid/bt_config.journal";
 static const char* CONFIG_LEGACY_FILE_PATH =
     "/data/misc/bluedroid/bt_config.xml";
 #endif  // defined(OS_GENERIC)
 static const period_ms_t CONFIG_SETTLE_PERIOD_MS = 3000;
+// Changes are appended to the journal once settled; the whole config file is
+// only rewritten once the journal grows past this size, or on shutdown.
+static const size_t CONFIG_JOURNAL_COMPACT_SIZE = 64 * 1024;
 
 static void timer_config_save_cb(void* data);
 static void btif_config_write(uint16_t event, char* p_param);
+static void btif_config_persist(bool compact);
 static bool is_factory_reset(void);
 static void delete_config_files(void);
 static void btif_config_remove_unpaired(config_t* config);
@@ -161,6 +169,22 @@ static void read_or_set_metrics_salt() {
 static std::recursive_mutex config_lock;  // protects operations on |config|.
 static alarm_t* config_timer;
 
+// Records the changes made to |config| since it was last saved. Changes are
+// recorded with |config_lock| held, so the journal sees them in the order
+// they were made, but it is only written to with |config_write_lock| held.
+static config_journal_t* config_journal;
+static std::mutex config_write_lock;  // serializes writes to the files.
+
+// Records the current value of |key| in |section|, or its removal, in the
+// journal. Must be called with |config_lock| held, right after the change.
+static void btif_config_journal_key(const char* section, const char* key) {
+  const char* value = config_get_string(config, section, key, NULL);
+  if (value)
+    config_journal_set(config_journal, section, key, value);
+  else
+    config_journal_remove_key(config_journal, section, key);
+}
+
 // Module lifecycle functions
 
 static future_t* init(void) {
@@ -201,6 +225,13 @@ static future_t* init(void) {
     goto error;
   }
 
+  // Apply the changes made since the config file was last saved.
+  config_journal = config_journal_open(CONFIG_JOURNAL_PATH, config);
+  if (!config_journal) {
+    LOG_ERROR(LOG_TAG, "%s unable to open config journal.", __func__);
+    goto error;
+  }
+
   if (!file_source.empty())
     config_set_string(config, INFO_SECTION, FILE_SOURCE, file_source.c_str());
 
@@ -244,8 +275,10 @@ static future_t* init(void) {
 
 error:
   alarm_free(config_timer);
+  config_journal_free(config_journal);
   config_free(config);
   config_timer = NULL;
+  config_journal = NULL;
   config = NULL;
   btif_config_source = NOT_LOADED;
   return future_new_immediate(FUTURE_FAIL);
@@ -276,6 +309,8 @@ static future_t* clean_up(void) {
   config_timer = NULL;
 
   std::unique_lock<std::recursive_mutex> lock(config_lock);
+  config_journal_free(config_journal);
+  config_journal = NULL;
   config_free(config);
   config = NULL;
   return future_new_immediate(FUTURE_SUCCESS);
@@ -352,6 +387,7 @@ bool btif_config_set_int(const char* section, const char* key, int value) {
 
   std::unique_lock<std::recursive_mutex> lock(config_lock);
   config_set_int(config, section, key, value);
+  btif_config_journal_key(section, key);
 
   return true;
 }
@@ -363,6 +399,7 @@ bool btif_config_set_uint16(const char* section, const char* key, uint16_t value
 
   std::unique_lock<std::recursive_mutex> lock(config_lock);
   config_set_uint16(config, section, key, value);
+  btif_config_journal_key(section, key);
 
   return true;
 }
@@ -375,6 +412,7 @@ bool btif_config_set_uint64(const char* section, const char* key,
 
   std::unique_lock<std::recursive_mutex> lock(config_lock);
   config_set_uint64(config, section, key, value);
+  btif_config_journal_key(section, key);
 
   return true;
 }
@@ -408,6 +446,7 @@ bool btif_config_set_str(const char* section, const char* key,
 
   std::unique_lock<std::recursive_mutex> lock(config_lock);
   config_set_string(config, section, key, value);
+  btif_config_journal_key(section, key);
   return true;
 }
 
@@ -473,6 +512,7 @@ bool btif_config_set_bin(const char* section, const char* key,
   {
     std::unique_lock<std::recursive_mutex> lock(config_lock);
     config_set_string(config, section, key, str);
+    btif_config_journal_key(section, key);
   }
 
   osi_free(str);
@@ -510,7 +550,9 @@ bool btif_config_remove(const char* section, const char* key) {
   CHECK(key != NULL);
 
   std::unique_lock<std::recursive_mutex> lock(config_lock);
-  return config_remove_key(config, section, key);
+  bool ret = config_remove_key(config, section, key);
+  if (ret) config_journal_remove_key(config_journal, section, key);
+  return ret;
 }
 
 void btif_config_save(void) {
@@ -525,7 +567,7 @@ void btif_config_flush(void) {
   CHECK(config_timer != NULL);
 
   alarm_cancel(config_timer);
-  btif_config_write(0, NULL);
+  btif_config_persist(true);
 }
 
 bool btif_config_clear(void) {
@@ -534,6 +576,7 @@ bool btif_config_clear(void) {
 
   alarm_cancel(config_timer);
 
+  std::unique_lock<std::mutex> write_lock(config_write_lock);
   std::unique_lock<std::recursive_mutex> lock(config_lock);
   config_free(config);
 
@@ -541,6 +584,12 @@ bool btif_config_clear(void) {
   if (config == NULL) return false;
 
   bool ret = config_save(config, CONFIG_FILE_PATH);
+  if (ret) {
+    // Drop the committed changes, and the pending ones by committing them
+    // first: they were all made to the config that was just cleared.
+    config_journal_commit(config_journal);
+    ret = config_journal_reset(config_journal);
+  }
   btif_config_source = RESET;
   return ret;
 }
@@ -554,18 +603,39 @@ static void timer_config_save_cb(UNUSED_ATTR void* data) {
 
 static void btif_config_write(UNUSED_ATTR uint16_t event,
                               UNUSED_ATTR char* p_param) {
+  btif_config_persist(false);
+}
+
+// Appends the changes made since the last write to the journal. When
+// |compact| is true, or the journal has grown too large, also saves a
+// snapshot of |config| to the config file and empties the journal.
+//
+// Neither the disk writes nor the syncs are done with |config_lock| held, so
+// they never delay readers or writers of the config; only taking the snapshot
+// does. The order of the steps makes any crash recoverable: the journal holds
+// every change up to the snapshot until the snapshot is safely on disk, and
+// replaying it over the snapshot changes nothing.
+static void btif_config_persist(bool compact) {
   CHECK(config != NULL);
   CHECK(config_timer != NULL);
 
-  std::unique_lock<std::recursive_mutex> lock(config_lock);
-  rename(CONFIG_FILE_PATH, CONFIG_BACKUP_PATH);
-  config_t* config_paired = config_new_clone(config);
+  std::unique_lock<std::mutex> write_lock(config_write_lock);
+  if (!config_journal_commit(config_journal)) compact = true;
+  if (!compact &&
+      config_journal_size(config_journal) < CONFIG_JOURNAL_COMPACT_SIZE)
+    return;
 
-  if (config_paired != NULL) {
-    btif_config_remove_unpaired(config_paired);
-    config_save(config_paired, CONFIG_FILE_PATH);
-    config_free(config_paired);
+  config_t* config_paired;
+  {
+    std::unique_lock<std::recursive_mutex> lock(config_lock);
+    config_paired = config_new_clone(config);
   }
+
+  btif_config_remove_unpaired(config_paired);
+  rename(CONFIG_FILE_PATH, CONFIG_BACKUP_PATH);
+  if (config_save(config_paired, CONFIG_FILE_PATH))
+    config_journal_reset(config_journal);
+  config_free(config_paired);
 }
 
 static void btif_config_remove_unpaired(config_t* conf) {
@@ -632,6 +702,9 @@ void btif_debug_config_dump(int fd) {
   dprintf(fd, "  File created/tagged: %s\n", btif_config_time_created);
   dprintf(fd, "  File source: %s\n",
           config_get_string(config, INFO_SECTION, FILE_SOURCE, "Original"));
+  if (config_journal)
+    dprintf(fd, "  Journal size: %zu bytes\n",
+            config_journal_size(config_journal));
 }
 
 static void btif_config_remove_restricted(config_t* config) {
@@ -658,5 +731,6 @@ static bool is_factory_reset(void) {
 static void delete_config_files(void) {
   remove(CONFIG_FILE_PATH);
   remove(CONFIG_BACKUP_PATH);
+  remove(CONFIG_JOURNAL_PATH);
   osi_property_set("persist.bluetooth.factoryreset", "false");
 }
@@ -79,6 +79,7 @@
 #include "hardware/vendor.h"
 
 #include <hardware/bluetooth.h>
+#include <hardware/bt_gatt.h>
 #include <hardware/bt_hearing_aid.h>
 
 #include "advertise_data_parser.h"
@@ -90,6 +91,7 @@
 #include "btif_config.h"
 #include "btif_dm.h"
 #include "btif_av.h"
+#include "btif_gatt.h"
 #include "btif_hf.h"
 #include "btif_hd.h"
 #include "btif_hh.h"
@@ -682,6 +684,10 @@ void bond_state_changed(bt_status_t status, const RawAddress& bd_addr,
   auto tmp = bd_addr;
   HAL_CBACK(bt_hal_cbacks, bond_state_changed_cb, status, &tmp, state);
 
+  // Bonding stores the device and unbonding removes it: have the scanner
+  // write its types through again on the next advertising report.
+  btif_ble_scanner_forget_device(bd_addr);
+
   if (state == BT_BOND_STATE_BONDING ||
       (state == BT_BOND_STATE_BONDED && pairing_cb.sdp_attempts > 0)) {
     // Save state for the device is bonding or SDP.
@@ -50,7 +50,10 @@ static void btsock_request_max_tx_data_length(const RawAddress& bd_addr);
 
 static void btsock_signaled(int fd, int type, int flags, uint32_t user_id);
 
+// RFCOMM and L2CAP sockets are polled on threads of their own, so that busy
+// sockets of one type don't delay the signals of the other.
 static std::atomic_int thread_handle{-1};
+static std::atomic_int l2cap_thread_handle{-1};
 static thread_t* thread;
 
 btsock_interface_t* btif_sock_get_interface(void) {
@@ -65,6 +68,7 @@ btsock_interface_t* btif_sock_get_interface(void) {
 
 bt_status_t btif_sock_init(uid_set_t* uid_set) {
   CHECK(thread_handle == -1);
+  CHECK(l2cap_thread_handle == -1);
   CHECK(thread == NULL);
 
   bt_status_t status;
@@ -82,7 +86,14 @@ bt_status_t btif_sock_init(uid_set_t* uid_set) {
     goto error;
   }
 
-  status = btsock_l2cap_init(thread_handle, uid_set);
+  l2cap_thread_handle = btsock_thread_create(btsock_signaled, NULL);
+  if (l2cap_thread_handle == -1) {
+    LOG_ERROR(LOG_TAG, "%s unable to create L2CAP btsock_thread.", __func__);
+    btsock_rfc_cleanup();
+    goto error;
+  }
+
+  status = btsock_l2cap_init(l2cap_thread_handle, uid_set);
   if (status != BT_STATUS_SUCCESS) {
     LOG_ERROR(LOG_TAG, "%s error initializing L2CAP sockets: %d", __func__,
               status);
@@ -111,6 +122,8 @@ error:;
   thread = NULL;
   if (thread_handle != -1) btsock_thread_exit(thread_handle);
   thread_handle = -1;
+  if (l2cap_thread_handle != -1) btsock_thread_exit(l2cap_thread_handle);
+  l2cap_thread_handle = -1;
   uid_set = NULL;
   return BT_STATUS_FAIL;
 }
@@ -120,6 +133,7 @@ void btif_sock_cleanup(void) {
   if (std::atomic_exchange(&thread_handle, -1) == -1) return;
 
   btsock_thread_exit(saved_handle);
+  btsock_thread_exit(std::atomic_exchange(&l2cap_thread_handle, -1));
   btsock_rfc_cleanup();
   btsock_sco_cleanup();
   btsock_l2cap_cleanup();
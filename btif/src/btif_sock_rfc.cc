@@ -21,11 +21,13 @@
 #include <base/logging.h>
 #include <errno.h>
 #include <features.h>
+#include <inttypes.h>
 #include <pthread.h>
 #include <string.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include <mutex>
@@ -52,6 +54,7 @@
 #include "osi/include/list.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
+#include "osi/include/time.h"
 #include "port_api.h"
 #include "sdp_api.h"
 #include <hardware/vendor_socket.h>
@@ -73,6 +76,9 @@ using bluetooth::Uuid;
 // Maximum number of devices we can have an RFCOMM connection with.
 #define MAX_RFC_SESSION 7
 
+// Maximum number of queued buffers written to the app with one writev().
+#define MAX_RFC_WRITEV_BUFS 16
+
 typedef struct {
   int outgoing_congest : 1;
   int pending_sdp_request : 1;
@@ -82,6 +88,15 @@ typedef struct {
   int closing : 1;
 } flags_t;
 
+// Data path counters, reported by btsock_rfc_debug_dump().
+typedef struct {
+  uint64_t start_ms;   // When the connection was established
+  uint64_t tx_bytes;   // Bytes read from the app and sent to the peer
+  uint64_t tx_reads;   // System calls made to read them
+  uint64_t rx_bytes;   // Bytes received from the peer and written to the app
+  uint64_t rx_writes;  // System calls made to write them
+} rfc_stats_t;
+
 typedef struct {
   flags_t f;
   uint32_t id;  // Non-zero indicates a valid (in-use) slot.
@@ -103,6 +118,7 @@ typedef struct {
   int rfc_port_handle;
   int role;
   list_t* incoming_queue;
+  rfc_stats_t stats;
 } rfc_slot_t;
 
 static rfc_slot_t rfc_slots[MAX_RFC_CHANNEL];
@@ -235,6 +251,7 @@ static rfc_slot_t* alloc_rfc_slot(const RawAddress* addr, const char* name,
 
   slot->id = rfc_slot_id;
   slot->f.server = server;
+  memset(&slot->stats, 0, sizeof(slot->stats));
 
   return slot;
 }
@@ -518,6 +535,7 @@ static uint32_t on_srv_rfc_connect(tBTA_JV_RFCOMM_SRV_OPEN* p_open,
                           accept_rs->app_fd, p_open->mtu);
   accept_rs->app_fd =
       INVALID_FD;  // Ownership of the application fd has been transferred.
+  accept_rs->stats.start_ms = time_get_os_boottime_ms();
   return srv_rs->id;
 }
 
@@ -536,6 +554,7 @@ static void on_cli_rfc_connect(tBTA_JV_RFCOMM_OPEN* p_open, uint32_t id) {
   LOG_DEBUG(LOG_TAG, "%s  mtu = %d ", __func__,p_open->mtu);
   if (send_app_connect_signal(slot->fd, &slot->addr, slot->scn, 0, -1, p_open->mtu)) {
     slot->f.connected = true;
+    slot->stats.start_ms = time_get_os_boottime_ms();
   } else {
     LOG_ERROR(LOG_TAG, "%s unable to send connect completion signal to caller.",
               __func__);
@@ -756,12 +775,12 @@ typedef enum {
   SENT_ALL,
 } sent_status_t;
 
-static sent_status_t send_data_to_app(int fd, BT_HDR* p_buf) {
+static sent_status_t send_data_to_app(rfc_slot_t* slot, BT_HDR* p_buf) {
   if (p_buf->len == 0) return SENT_ALL;
 
   ssize_t sent;
-  OSI_NO_INTR(
-      sent = send(fd, p_buf->data + p_buf->offset, p_buf->len, MSG_DONTWAIT));
+  OSI_NO_INTR(sent = send(slot->fd, p_buf->data + p_buf->offset, p_buf->len,
+                          MSG_DONTWAIT));
 
   if (sent == -1) {
     if (errno == EAGAIN || errno == EWOULDBLOCK) return SENT_NONE;
@@ -772,6 +791,9 @@ static sent_status_t send_data_to_app(int fd, BT_HDR* p_buf) {
 
   if (sent == 0) return SENT_FAILED;
 
+  slot->stats.rx_bytes += sent;
+  slot->stats.rx_writes++;
+
   if (sent == p_buf->len) return SENT_ALL;
 
   p_buf->offset += sent;
@@ -779,10 +801,58 @@ static sent_status_t send_data_to_app(int fd, BT_HDR* p_buf) {
   return SENT_PARTIAL;
 }
 
-static bool flush_incoming_que_on_wr_signal(rfc_slot_t* slot) {
+// Writes as many buffers from the front of the incoming queue as the app
+// socket takes with a single writev(), removing those sent in full.
+static sent_status_t send_queue_to_app(rfc_slot_t* slot) {
+  struct iovec iov[MAX_RFC_WRITEV_BUFS];
+  int count = 0;
+  for (const list_node_t* node = list_begin(slot->incoming_queue);
+       node != list_end(slot->incoming_queue) && count < MAX_RFC_WRITEV_BUFS;
+       node = list_next(node)) {
+    BT_HDR* p_buf = (BT_HDR*)list_node(node);
+    iov[count].iov_base = p_buf->data + p_buf->offset;
+    iov[count].iov_len = p_buf->len;
+    count++;
+  }
+  if (count == 0) return SENT_ALL;
+
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = iov;
+  msg.msg_iovlen = count;
+
+  ssize_t sent;
+  OSI_NO_INTR(sent = sendmsg(slot->fd, &msg, MSG_DONTWAIT));
+
+  if (sent == -1) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK) return SENT_NONE;
+    LOG_ERROR(LOG_TAG, "%s error writing RFCOMM data back to app: %s", __func__,
+              strerror(errno));
+    return SENT_FAILED;
+  }
+
+  slot->stats.rx_bytes += sent;
+  slot->stats.rx_writes++;
+
   while (!list_is_empty(slot->incoming_queue)) {
     BT_HDR* p_buf = (BT_HDR*)list_front(slot->incoming_queue);
-    switch (send_data_to_app(slot->fd, p_buf)) {
+    if (sent < p_buf->len) {
+      if (sent == 0) break;
+      p_buf->offset += sent;
+      p_buf->len -= sent;
+      return SENT_PARTIAL;
+    }
+    sent -= p_buf->len;
+    list_remove(slot->incoming_queue, p_buf);
+    if (--count == 0) break;
+  }
+
+  return list_is_empty(slot->incoming_queue) ? SENT_ALL : SENT_PARTIAL;
+}
+
+static bool flush_incoming_que_on_wr_signal(rfc_slot_t* slot) {
+  while (!list_is_empty(slot->incoming_queue)) {
+    switch (send_queue_to_app(slot)) {
       case SENT_NONE:
       case SENT_PARTIAL:
         // monitor the fd to get callback when app is ready to receive data
@@ -791,11 +861,9 @@ static bool flush_incoming_que_on_wr_signal(rfc_slot_t* slot) {
         return true;
 
       case SENT_ALL:
-        list_remove(slot->incoming_queue, p_buf);
         break;
 
       case SENT_FAILED:
-        list_remove(slot->incoming_queue, p_buf);
         return false;
     }
   }
@@ -864,7 +932,7 @@ int bta_co_rfc_data_incoming(uint32_t id, BT_HDR* p_buf) {
   bytes_rx = p_buf->len;
 
   if (list_is_empty(slot->incoming_queue)) {
-    switch (send_data_to_app(slot->fd, p_buf)) {
+    switch (send_data_to_app(slot, p_buf)) {
       case SENT_NONE:
       case SENT_PARTIAL:
         list_append(slot->incoming_queue, p_buf);
@@ -923,9 +991,64 @@ int bta_co_rfc_data_outgoing(uint32_t id, uint8_t* buf, uint16_t size) {
     return false;
   }
 
+  slot->stats.tx_bytes += received;
+  slot->stats.tx_reads++;
   return true;
 }
 
+int bta_co_rfc_data_outgoing_iov(uint32_t id, const struct iovec* iov,
+                                 int count) {
+  std::unique_lock<std::recursive_mutex> lock(slot_lock);
+  rfc_slot_t* slot = find_rfc_slot_by_id(id);
+  if (!slot) return false;
+
+  ssize_t size = 0;
+  for (int i = 0; i < count; i++) size += iov[i].iov_len;
+
+  // The stack only asks for data bta_co_rfc_data_outgoing_size() reported as
+  // pending, so a single readv() fills every buffer.
+  ssize_t received;
+  OSI_NO_INTR(received = readv(slot->fd, iov, count));
+
+  if (received != size) {
+    LOG_ERROR(LOG_TAG, "%s error receiving RFCOMM data from app: %s", __func__,
+              strerror(errno));
+    cleanup_rfc_slot(slot);
+    return false;
+  }
+
+  slot->stats.tx_bytes += received;
+  slot->stats.tx_reads++;
+  return true;
+}
+
+void btsock_rfc_debug_dump(int fd) {
+  std::unique_lock<std::recursive_mutex> lock(slot_lock);
+  dprintf(fd, "\nRFCOMM Sockets:\n");
+  uint64_t now_ms = time_get_os_boottime_ms();
+  for (size_t i = 0; i < ARRAY_SIZE(rfc_slots); ++i) {
+    const rfc_slot_t* slot = &rfc_slots[i];
+    if (!slot->id || !slot->f.connected) continue;
+
+    const rfc_stats_t* stats = &slot->stats;
+    uint64_t elapsed_ms = now_ms - stats->start_ms;
+    dprintf(fd, "  %s channel %d (slot %u, %s)\n",
+            slot->addr.ToString().c_str(), slot->scn, slot->id,
+            slot->f.server ? "server" : "client");
+    dprintf(fd,
+            "    TX: %" PRIu64 " bytes in %" PRIu64 " reads, %" PRIu64
+            " bytes/s\n",
+            stats->tx_bytes, stats->tx_reads,
+            elapsed_ms ? stats->tx_bytes * 1000 / elapsed_ms : 0);
+    dprintf(fd,
+            "    RX: %" PRIu64 " bytes in %" PRIu64 " writes, %" PRIu64
+            " bytes/s, %zu buffers queued\n",
+            stats->rx_bytes, stats->rx_writes,
+            elapsed_ms ? stats->rx_bytes * 1000 / elapsed_ms : 0,
+            list_length(slot->incoming_queue));
+  }
+}
+
 static rfc_slot_t* find_rfc_slot_by_scn(int scn)
 {
     int i;
@@ -38,8 +38,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/poll.h>
-#include <sys/select.h>
+#include <sys/epoll.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <sys/un.h>
@@ -49,6 +48,7 @@
 
 #include <mutex>
 #include <string>
+#include <unordered_map>
 
 #include "bta_api.h"
 #include "btif_common.h"
@@ -65,29 +65,31 @@
   } while (0)
 
 #define MAX_THREAD 8
-#define MAX_POLL 64
-#define POLL_EXCEPTION_EVENTS (POLLHUP | POLLRDHUP | POLLERR | POLLNVAL)
-#define IS_EXCEPTION(e) ((e)&POLL_EXCEPTION_EVENTS)
-#define IS_READ(e) ((e)&POLLIN)
-#define IS_WRITE(e) ((e)&POLLOUT)
+// Maximum number of events handled per epoll_wait() call. More pending
+// events are returned by the next call.
+#define MAX_EVENTS 64
+#define EPOLL_EXCEPTION_EVENTS (EPOLLHUP | EPOLLRDHUP | EPOLLERR)
+#define IS_EXCEPTION(e) ((e)&EPOLL_EXCEPTION_EVENTS)
+#define IS_READ(e) ((e)&EPOLLIN)
+#define IS_WRITE(e) ((e)&EPOLLOUT)
 /*cmd executes in socket poll thread */
 #define CMD_WAKEUP 1
 #define CMD_EXIT 2
-#define CMD_ADD_FD 3
 #define CMD_REMOVE_FD 4
 #define CMD_USER_PRIVATE 5
 
 typedef struct {
-  struct pollfd pfd;
   uint32_t user_id;
   int type;
   int flags;
 } poll_slot_t;
 typedef struct {
   int cmd_fdr, cmd_fdw;
-  int poll_count;
-  poll_slot_t ps[MAX_POLL];
-  int psi[MAX_POLL];  // index of poll slot
+  int epoll_fd;
+  // Monitored fds, by fd. Fds are armed from any thread and signaled in the
+  // poll thread, so the map is protected by |lock|.
+  std::unordered_map<int, poll_slot_t> ps;
+  std::mutex lock;
   pthread_t thread_id;
   btsock_signaled_cb callback;
   btsock_cmd_cb cmd_callback;
@@ -98,8 +100,8 @@ static thread_slot_t ts[MAX_THREAD];
 static void* sock_poll_thread(void* arg);
 static inline void close_cmd_fd(int h);
 
-static inline void add_poll(int h, int fd, int type, int flags,
-                            uint32_t user_id);
+static void add_poll(int h, int fd, int type, int flags, uint32_t user_id);
+static void remove_poll(int h, int fd);
 
 static std::recursive_mutex thread_slot_lock;
 
@@ -128,7 +130,7 @@ static inline int create_thread(void* (*start_routine)(void*), void* arg,
   pthread_setschedparam(*thread_id, policy, &param);
   return ret;
 }
-static void init_poll(int cmd_fd);
+static bool init_poll(int cmd_fd);
 static int alloc_thread_slot() {
   std::unique_lock<std::recursive_mutex> lock(thread_slot_lock);
   int i;
@@ -146,6 +148,11 @@ static int alloc_thread_slot() {
 static void free_thread_slot(int h) {
   if (0 <= h && h < MAX_THREAD) {
     close_cmd_fd(h);
+    if (ts[h].epoll_fd != -1) {
+      close(ts[h].epoll_fd);
+      ts[h].epoll_fd = -1;
+    }
+    ts[h].ps.clear();
     ts[h].used = 0;
   } else
     APPL_TRACE_ERROR("invalid thread handle:%d", h);
@@ -158,9 +165,9 @@ int btsock_thread_init() {
     int h;
     for (h = 0; h < MAX_THREAD; h++) {
       ts[h].cmd_fdr = ts[h].cmd_fdw = -1;
+      ts[h].epoll_fd = -1;
       ts[h].used = 0;
       ts[h].thread_id = -1;
-      ts[h].poll_count = 0;
       ts[h].callback = NULL;
       ts[h].cmd_callback = NULL;
     }
@@ -173,7 +180,12 @@ int btsock_thread_create(btsock_signaled_cb callback,
   int h = alloc_thread_slot();
   APPL_TRACE_DEBUG("alloc_thread_slot ret:%d", h);
   if (h >= 0) {
-    init_poll(h);
+    if (!init_poll(h)) {
+      free_thread_slot(h);
+      return -1;
+    }
+    ts[h].callback = callback;
+    ts[h].cmd_callback = cmd_callback;
     pthread_t thread;
     int status = create_thread(sock_poll_thread, (void*)(uintptr_t)h, &thread);
     if (status) {
@@ -184,23 +196,29 @@ int btsock_thread_create(btsock_signaled_cb callback,
 
     ts[h].thread_id = thread;
     APPL_TRACE_DEBUG("h:%d, thread id:%d", h, ts[h].thread_id);
-    ts[h].callback = callback;
-    ts[h].cmd_callback = cmd_callback;
   }
   return h;
 }
 
-/* create dummy socket pair used to wake up select loop */
-static inline void init_cmd_fd(int h) {
+/* create dummy socket pair used to wake up the poll loop */
+static inline bool init_cmd_fd(int h) {
   asrt(ts[h].cmd_fdr == -1 && ts[h].cmd_fdw == -1);
   if (socketpair(AF_UNIX, SOCK_STREAM, 0, &ts[h].cmd_fdr) < 0) {
     APPL_TRACE_ERROR("socketpair failed: %s", strerror(errno));
-    return;
+    return false;
   }
   APPL_TRACE_DEBUG("h:%d, cmd_fdr:%d, cmd_fdw:%d", h, ts[h].cmd_fdr,
                    ts[h].cmd_fdw);
-  // add the cmd fd for read & write
-  add_poll(h, ts[h].cmd_fdr, 0, SOCK_THREAD_FD_RD, 0);
+  // The cmd fd is monitored for reads for as long as the thread runs.
+  struct epoll_event event;
+  memset(&event, 0, sizeof(event));
+  event.events = EPOLLIN;
+  event.data.fd = ts[h].cmd_fdr;
+  if (epoll_ctl(ts[h].epoll_fd, EPOLL_CTL_ADD, ts[h].cmd_fdr, &event) < 0) {
+    APPL_TRACE_ERROR("epoll_ctl cmd fd failed: %s", strerror(errno));
+    return false;
+  }
+  return true;
 }
 static inline void close_cmd_fd(int h) {
   if (ts[h].cmd_fdr != -1) {
@@ -224,29 +242,17 @@ int btsock_thread_add_fd(int h, int fd, int type, int flags, uint32_t user_id) {
     APPL_TRACE_ERROR("invalid bt thread handle:%d", h);
     return false;
   }
-  if (ts[h].cmd_fdw == -1) {
+  if (ts[h].epoll_fd == -1) {
     APPL_TRACE_ERROR(
-        "cmd socket is not created. socket thread may not initialized");
+        "epoll fd is not created. socket thread may not initialized");
     return false;
   }
-  if (flags & SOCK_THREAD_ADD_FD_SYNC) {
-    // must executed in socket poll thread
-    if (ts[h].thread_id == pthread_self()) {
-      // cleanup one-time flags
-      flags &= ~SOCK_THREAD_ADD_FD_SYNC;
-      add_poll(h, fd, type, flags, user_id);
-      return true;
-    }
-    APPL_TRACE_DEBUG(
-        "THREAD_ADD_FD_SYNC is not called in poll thread, fallback to async");
-  }
-  sock_cmd_t cmd = {CMD_ADD_FD, fd, type, flags, user_id};
+  // Fds are armed directly with epoll_ctl() from the calling thread, so the
+  // fd is always monitored by the time this returns.
+  flags &= ~SOCK_THREAD_ADD_FD_SYNC;
   APPL_TRACE_DEBUG("adding fd:%d, flags:0x%x", fd, flags);
-
-  ssize_t ret;
-  OSI_NO_INTR(ret = send(ts[h].cmd_fdw, &cmd, sizeof(cmd), 0));
-
-  return ret == sizeof(cmd);
+  add_poll(h, fd, type, flags, user_id);
+  return true;
 }
 
 bool btsock_thread_remove_fd_and_close(int thread_handle, int fd) {
@@ -259,6 +265,8 @@ bool btsock_thread_remove_fd_and_close(int thread_handle, int fd) {
     return false;
   }
 
+  // Closed in the poll thread, so that the fd is not closed under a callback
+  // signaling it.
   sock_cmd_t cmd = {CMD_REMOVE_FD, fd, 0, 0, 0};
 
   ssize_t ret;
@@ -266,7 +274,6 @@ bool btsock_thread_remove_fd_and_close(int thread_handle, int fd) {
 
   return ret == sizeof(cmd);
 }
-
 int btsock_thread_post_cmd(int h, int type, const unsigned char* data, int size,
                            uint32_t user_id) {
   if (h < 0 || h >= MAX_THREAD) {
@@ -340,76 +347,74 @@ int btsock_thread_exit(int h) {
   }
   return false;
 }
-static void init_poll(int h) {
-  int i;
-  ts[h].poll_count = 0;
+static bool init_poll(int h) {
   ts[h].thread_id = -1;
   ts[h].callback = NULL;
   ts[h].cmd_callback = NULL;
-  for (i = 0; i < MAX_POLL; i++) {
-    ts[h].ps[i].pfd.fd = -1;
-    ts[h].psi[i] = -1;
+  ts[h].ps.clear();
+  ts[h].epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (ts[h].epoll_fd == -1) {
+    APPL_TRACE_ERROR("epoll_create1 failed: %s", strerror(errno));
+    return false;
   }
-  init_cmd_fd(h);
-}
-static inline unsigned int flags2pevents(int flags) {
-  unsigned int pevents = 0;
-  if (flags & SOCK_THREAD_FD_WR) pevents |= POLLOUT;
-  if (flags & SOCK_THREAD_FD_RD) pevents |= POLLIN;
-  pevents |= POLL_EXCEPTION_EVENTS;
-  return pevents;
+  return init_cmd_fd(h);
 }
 
-static inline void set_poll(poll_slot_t* ps, int fd, int type, int flags,
-                            uint32_t user_id) {
-  ps->pfd.fd = fd;
-  ps->user_id = user_id;
-  if (ps->type != 0 && ps->type != type)
-    APPL_TRACE_ERROR(
-        "poll socket type should not changed! type was:%d, type now:%d",
-        ps->type, type);
-  ps->type = type;
-  ps->flags = flags;
-  ps->pfd.events = flags2pevents(flags);
-  ps->pfd.revents = 0;
+// Fds are registered with EPOLLONESHOT: once an fd is signaled, the kernel
+// stops monitoring it until the poll thread re-arms it with the flags that
+// were not signaled. Like with poll(), a flag is reported once and must be
+// added again with btsock_thread_add_fd() to be monitored again.
+static inline uint32_t flags2events(int flags) {
+  uint32_t events = EPOLLONESHOT | EPOLLRDHUP;
+  if (flags & SOCK_THREAD_FD_WR) events |= EPOLLOUT;
+  if (flags & SOCK_THREAD_FD_RD) events |= EPOLLIN;
+  return events;
 }
-static inline void add_poll(int h, int fd, int type, int flags,
-                            uint32_t user_id) {
-  asrt(fd != -1);
-  int i;
-  int empty = -1;
-  poll_slot_t* ps = ts[h].ps;
 
-  for (i = 0; i < MAX_POLL; i++) {
-    if (ps[i].pfd.fd == fd) {
-      asrt(ts[h].poll_count < MAX_POLL);
+// Must be called with ts[h].lock held.
+static void arm_poll(int h, int fd, int flags, bool registered) {
+  struct epoll_event event;
+  memset(&event, 0, sizeof(event));
+  event.events = flags2events(flags);
+  event.data.fd = fd;
+
+  int ret = epoll_ctl(ts[h].epoll_fd, registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD,
+                      fd, &event);
+  // A closed fd leaves the epoll set by itself, so the fd number of a slot
+  // may have been reused by a new, unregistered file; and an fd may already
+  // be registered by the time a racing add is processed.
+  if (ret == -1 && errno == ENOENT)
+    ret = epoll_ctl(ts[h].epoll_fd, EPOLL_CTL_ADD, fd, &event);
+  else if (ret == -1 && errno == EEXIST)
+    ret = epoll_ctl(ts[h].epoll_fd, EPOLL_CTL_MOD, fd, &event);
+  if (ret == -1)
+    APPL_TRACE_ERROR("epoll_ctl fd:%d failed: %s", fd, strerror(errno));
+}
 
-      set_poll(&ps[i], fd, type, flags | ps[i].flags, user_id);
-      return;
-    } else if (empty < 0 && ps[i].pfd.fd == -1)
-      empty = i;
-  }
-  if (empty >= 0) {
-    asrt(ts[h].poll_count < MAX_POLL);
-    set_poll(&ps[empty], fd, type, flags, user_id);
-    ++ts[h].poll_count;
-    return;
+static void add_poll(int h, int fd, int type, int flags, uint32_t user_id) {
+  asrt(fd != -1);
+  std::lock_guard<std::mutex> lock(ts[h].lock);
+  auto it = ts[h].ps.find(fd);
+  bool registered = it != ts[h].ps.end();
+  if (registered && it->second.user_id == user_id) {
+    poll_slot_t* ps = &it->second;
+    if (ps->type != 0 && ps->type != type)
+      APPL_TRACE_ERROR(
+          "poll socket type should not changed! type was:%d, type now:%d",
+          ps->type, type);
+    flags |= ps->flags;
   }
-  APPL_TRACE_ERROR("exceeded max poll slot:%d!", MAX_POLL);
+  // Otherwise the slot is new, or left over from a closed fd whose number
+  // was reused by another socket.
+  ts[h].ps[fd] = {user_id, type, flags};
+  arm_poll(h, fd, flags, registered);
 }
-static inline void remove_poll(int h, poll_slot_t* ps, int flags) {
-  if (flags == ps->flags) {
-    // all monitored events signaled. To remove it, just clear the slot
-    --ts[h].poll_count;
-    memset(ps, 0, sizeof(*ps));
-    ps->pfd.fd = -1;
-  } else {
-    // one read or one write monitor event signaled, removed the accordding bit
-    ps->flags &= ~flags;
-    // update the poll events mask
-    ps->pfd.events = flags2pevents(ps->flags);
-  }
+
+static void remove_poll(int h, int fd) {
+  std::lock_guard<std::mutex> lock(ts[h].lock);
+  if (ts[h].ps.erase(fd)) epoll_ctl(ts[h].epoll_fd, EPOLL_CTL_DEL, fd, NULL);
 }
+
 static int process_cmd_sock(int h) {
   sock_cmd_t cmd = {-1, 0, 0, 0, 0};
   int fd = ts[h].cmd_fdr;
@@ -423,17 +428,8 @@ static int process_cmd_sock(int h) {
   }
   APPL_TRACE_DEBUG("cmd.id:%d", cmd.id);
   switch (cmd.id) {
-    case CMD_ADD_FD:
-      add_poll(h, cmd.fd, cmd.type, cmd.flags, cmd.user_id);
-      break;
     case CMD_REMOVE_FD:
-      for (int i = 1; i < MAX_POLL; ++i) {
-        poll_slot_t* poll_slot = &ts[h].ps[i];
-        if (poll_slot->pfd.fd == cmd.fd) {
-          remove_poll(h, poll_slot, poll_slot->flags);
-          break;
-        }
-      }
+      remove_poll(h, cmd.fd);
       close(cmd.fd);
       break;
     case CMD_WAKEUP:
@@ -452,107 +448,84 @@ static int process_cmd_sock(int h) {
   return true;
 }
 
-static void print_events(short events) {
+static void print_events(uint32_t events) {
   std::string flags("");
-  if ((events)&POLLIN) flags += " POLLIN";
-  if ((events)&POLLPRI) flags += " POLLPRI";
-  if ((events)&POLLOUT) flags += " POLLOUT";
-  if ((events)&POLLERR) flags += " POLLERR";
-  if ((events)&POLLHUP) flags += " POLLHUP ";
-  if ((events)&POLLNVAL) flags += " POLLNVAL";
-  if ((events)&POLLRDHUP) flags += " POLLRDHUP";
+  if ((events)&EPOLLIN) flags += " EPOLLIN";
+  if ((events)&EPOLLPRI) flags += " EPOLLPRI";
+  if ((events)&EPOLLOUT) flags += " EPOLLOUT";
+  if ((events)&EPOLLERR) flags += " EPOLLERR";
+  if ((events)&EPOLLHUP) flags += " EPOLLHUP ";
+  if ((events)&EPOLLRDHUP) flags += " EPOLLRDHUP";
   APPL_TRACE_DEBUG("print poll event:%x = %s", (events), flags.c_str());
 }
 
-static void process_data_sock(int h, struct pollfd* pfds, int count) {
-  asrt(count <= ts[h].poll_count);
-  int i;
-  for (i = 1; i < ts[h].poll_count; i++) {
-    if (pfds[i].revents) {
-      int ps_i = ts[h].psi[i];
-      if(ts[h].ps[ps_i].pfd.fd <= 0) {
-        APPL_TRACE_ERROR("%s: Socket fd is not open", __FUNCTION__);
-        return;
-      }
-      asrt(pfds[i].fd == ts[h].ps[ps_i].pfd.fd);
-      uint32_t user_id = ts[h].ps[ps_i].user_id;
-      int type = ts[h].ps[ps_i].type;
-      int flags = 0;
-      print_events(pfds[i].revents);
-      if (IS_READ(pfds[i].revents)) {
+static void process_data_sock(int h, const struct epoll_event* events,
+                              int count) {
+  for (int i = 0; i < count; i++) {
+    int fd = events[i].data.fd;
+    if (fd == ts[h].cmd_fdr) continue;
+
+    uint32_t user_id;
+    int type;
+    int flags = 0;
+    {
+      std::lock_guard<std::mutex> lock(ts[h].lock);
+      auto it = ts[h].ps.find(fd);
+      // Removed while the event was pending.
+      if (it == ts[h].ps.end()) continue;
+      poll_slot_t* ps = &it->second;
+      user_id = ps->user_id;
+      type = ps->type;
+      print_events(events[i].events);
+      if (IS_READ(events[i].events) && (ps->flags & SOCK_THREAD_FD_RD)) {
         flags |= SOCK_THREAD_FD_RD;
       }
-      if (IS_WRITE(pfds[i].revents)) {
+      if (IS_WRITE(events[i].events) && (ps->flags & SOCK_THREAD_FD_WR)) {
         flags |= SOCK_THREAD_FD_WR;
       }
-      if (IS_EXCEPTION(pfds[i].revents)) {
+      if (IS_EXCEPTION(events[i].events)) {
         flags |= SOCK_THREAD_FD_EXCEPTION;
         // remove the whole slot not flags
-        remove_poll(h, &ts[h].ps[ps_i], ts[h].ps[ps_i].flags);
-      } else if (flags)
-        remove_poll(h, &ts[h].ps[ps_i],
-                    flags);  // remove the monitor flags that already processed
-      if (flags) ts[h].callback(pfds[i].fd, type, flags, user_id);
+        ts[h].ps.erase(it);
+        epoll_ctl(ts[h].epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+      } else if (flags == ps->flags) {
+        // all monitored events signaled, stop monitoring the fd
+        ts[h].ps.erase(it);
+        epoll_ctl(ts[h].epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+      } else {
+        // remove the monitor flags that are being processed, and keep
+        // monitoring the others
+        ps->flags &= ~flags;
+        arm_poll(h, fd, ps->flags, true);
+      }
     }
+    if (flags) ts[h].callback(fd, type, flags, user_id);
   }
 }
 
-static void prepare_poll_fds(int h, struct pollfd* pfds) {
-  int count = 0;
-  int ps_i = 0;
-  int pfd_i = 0;
-  asrt(ts[h].poll_count <= MAX_POLL);
-  memset(pfds, 0, sizeof(pfds[0]) * ts[h].poll_count);
-  while (count < ts[h].poll_count) {
-    if (ps_i >= MAX_POLL) {
-      APPL_TRACE_ERROR(
-          "exceed max poll range, ps_i:%d, MAX_POLL:%d, count:%d, "
-          "ts[h].poll_count:%d",
-          ps_i, MAX_POLL, count, ts[h].poll_count);
-      return;
-    }
-    if (ts[h].ps[ps_i].pfd.fd >= 0 && pfd_i < MAX_POLL) {
-      pfds[pfd_i] = ts[h].ps[ps_i].pfd;
-      ts[h].psi[pfd_i] = ps_i;
-      count++;
-      pfd_i++;
-    }
-    ps_i++;
-  }
-}
 static void* sock_poll_thread(void* arg) {
-  struct pollfd pfds[MAX_POLL];
-  memset(pfds, 0, sizeof(pfds));
+  struct epoll_event events[MAX_EVENTS];
   int h = (intptr_t)arg;
 
   prctl(PR_SET_NAME, (unsigned long)"btif_sock_poll", 0, 0, 0);
   for (;;) {
-    prepare_poll_fds(h, pfds);
     int ret;
-    OSI_NO_INTR(ret = poll(pfds, ts[h].poll_count, -1));
+    OSI_NO_INTR(ret = epoll_wait(ts[h].epoll_fd, events, MAX_EVENTS, -1));
     if (ret == -1) {
-      APPL_TRACE_ERROR("poll ret -1, exit the thread, errno:%d, err:%s", errno,
-                       strerror(errno));
+      APPL_TRACE_ERROR("epoll_wait ret -1, exit the thread, errno:%d, err:%s",
+                       errno, strerror(errno));
       break;
     }
-    if (ret != 0) {
-      int need_process_data_fd = true;
-      if (pfds[0].revents)  // cmd fd always is the first one
-      {
-        asrt(pfds[0].fd == ts[h].cmd_fdr);
-        if (!process_cmd_sock(h)) {
-          APPL_TRACE_DEBUG("h:%d, process_cmd_sock return false, exit...", h);
-          break;
-        }
-        if (ret == 1)
-          need_process_data_fd = false;
-        else
-          ret--;  // exclude the cmd fd
-      }
-      if (need_process_data_fd) process_data_sock(h, pfds, ret);
-    } else {
-      APPL_TRACE_DEBUG("no data, select ret: %d", ret)
-    };
+    // Commands go first, as they may remove fds signaled in this batch.
+    bool cmd_signaled = false;
+    for (int i = 0; i < ret; i++) {
+      if (events[i].data.fd == ts[h].cmd_fdr) cmd_signaled = true;
+    }
+    if (cmd_signaled && !process_cmd_sock(h)) {
+      APPL_TRACE_DEBUG("h:%d, process_cmd_sock return false, exit...", h);
+      break;
+    }
+    process_data_sock(h, events, ret);
   }
   APPL_TRACE_DEBUG("socket poll thread exiting, h:%d", h);
   return 0;
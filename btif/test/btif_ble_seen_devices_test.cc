@@ -0,0 +1,120 @@
+/*
+ * Copyright 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "btif/include/btif_ble_seen_devices.h"
+
+namespace {
+
+RawAddress make_address(int i) {
+  RawAddress addr = {{0x00, 0x11, 0x22, 0x00, 0x00, 0x00}};
+  addr.address[4] = i >> 8;
+  addr.address[5] = i;
+  return addr;
+}
+
+const std::vector<uint8_t> kData = {0x02, 0x01, 0x06};
+const std::vector<uint8_t> kOtherData = {0x02, 0x01, 0x1a};
+
+}  // namespace
+
+TEST(BleSeenDevicesTest, get_returns_same_entry) {
+  BleSeenDevices devices;
+  BleSeenDevices::Device* device = devices.Get(make_address(1));
+  device->name_checked = true;
+  EXPECT_EQ(device, devices.Get(make_address(1)));
+  EXPECT_TRUE(devices.Get(make_address(1))->name_checked);
+  EXPECT_NE(device, devices.Get(make_address(2)));
+  EXPECT_EQ(2u, devices.Size());
+}
+
+TEST(BleSeenDevicesTest, update_stored_types) {
+  BleSeenDevices devices;
+  BleSeenDevices::Device* device = devices.Get(make_address(1));
+
+  EXPECT_TRUE(BleSeenDevices::UpdateStoredTypes(device, 2, 0));
+  EXPECT_FALSE(BleSeenDevices::UpdateStoredTypes(device, 2, 0));
+  // A change of either type is written through.
+  EXPECT_TRUE(BleSeenDevices::UpdateStoredTypes(device, 3, 0));
+  EXPECT_TRUE(BleSeenDevices::UpdateStoredTypes(device, 3, 1));
+  EXPECT_FALSE(BleSeenDevices::UpdateStoredTypes(device, 3, 1));
+}
+
+TEST(BleSeenDevicesTest, forward_all_without_coalesce_window) {
+  BleSeenDevices devices;
+  BleSeenDevices::Device* device = devices.Get(make_address(1));
+  for (uint64_t now_ms = 0; now_ms < 10; now_ms++)
+    EXPECT_TRUE(devices.ShouldForward(device, 0x13, kData, now_ms));
+}
+
+TEST(BleSeenDevicesTest, coalesce_unchanged_reports) {
+  BleSeenDevices devices;
+  devices.SetCoalesceWindow(100);
+  BleSeenDevices::Device* device = devices.Get(make_address(1));
+
+  EXPECT_TRUE(devices.ShouldForward(device, 0x13, kData, 1000));
+  EXPECT_FALSE(devices.ShouldForward(device, 0x13, kData, 1050));
+  EXPECT_FALSE(devices.ShouldForward(device, 0x13, kData, 1099));
+
+  // A change of data or event type is forwarded within the window.
+  EXPECT_TRUE(devices.ShouldForward(device, 0x13, kOtherData, 1099));
+  EXPECT_TRUE(devices.ShouldForward(device, 0x1b, kOtherData, 1099));
+
+  // The window starts over with the last report forwarded.
+  EXPECT_FALSE(devices.ShouldForward(device, 0x1b, kOtherData, 1198));
+  EXPECT_TRUE(devices.ShouldForward(device, 0x1b, kOtherData, 1199));
+}
+
+TEST(BleSeenDevicesTest, evict_least_recently_seen) {
+  BleSeenDevices devices;
+  const int max = BleSeenDevices::kDefaultMaxDevices;
+  for (int i = 0; i < max; i++)
+    BleSeenDevices::UpdateStoredTypes(devices.Get(make_address(i)), 2, 0);
+  EXPECT_EQ((size_t)max, devices.Size());
+
+  // Seeing device 0 again makes device 1 the least recently seen.
+  devices.Get(make_address(0));
+  devices.Get(make_address(max));
+  EXPECT_EQ((size_t)max, devices.Size());
+
+  EXPECT_FALSE(
+      BleSeenDevices::UpdateStoredTypes(devices.Get(make_address(0)), 2, 0));
+  EXPECT_TRUE(
+      BleSeenDevices::UpdateStoredTypes(devices.Get(make_address(1)), 2, 0));
+  EXPECT_EQ((size_t)max, devices.Size());
+}
+
+TEST(BleSeenDevicesTest, remove) {
+  BleSeenDevices devices;
+  devices.SetCoalesceWindow(100);
+  BleSeenDevices::Device* device = devices.Get(make_address(1));
+  BleSeenDevices::UpdateStoredTypes(device, 2, 0);
+  devices.ShouldForward(device, 0x13, kData, 1000);
+  devices.Get(make_address(2));
+
+  devices.Remove(make_address(1));
+  devices.Remove(make_address(3));
+  EXPECT_EQ(1u, devices.Size());
+
+  // The next report of a removed device is written through and forwarded.
+  device = devices.Get(make_address(1));
+  EXPECT_TRUE(BleSeenDevices::UpdateStoredTypes(device, 2, 0));
+  EXPECT_TRUE(devices.ShouldForward(device, 0x13, kData, 1001));
+  EXPECT_EQ(2u, devices.Size());
+}
@@ -0,0 +1,193 @@
+/******************************************************************************
+ *
+ *  Copyright 2018 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+#include <gtest/gtest.h>
+
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include "btif/include/btif_sock_thread.h"
+#include "internal_include/bt_trace.h"
+
+uint8_t appl_trace_level = 0;
+
+void LogMsg(uint32_t trace_set_mask, const char* fmt_str, ...) {}
+
+static const int kNumSockets = 500;
+static const int kTimeoutMs = 5000;
+
+static std::mutex sLock;
+static std::condition_variable sSignaled;
+static std::vector<int> sFlags;  // Flags signaled, indexed by user id
+static int sCallbacks;
+
+static void signaled_cb(int fd, int type, int flags, uint32_t user_id) {
+  std::lock_guard<std::mutex> lock(sLock);
+  sFlags[user_id] |= flags;
+  sCallbacks++;
+  sSignaled.notify_all();
+}
+
+class BtifSockThreadTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // Two fds per socket pair, plus a few for the thread itself.
+    struct rlimit limit;
+    ASSERT_EQ(0, getrlimit(RLIMIT_NOFILE, &limit));
+    if (limit.rlim_cur < 2 * kNumSockets + 64) {
+      limit.rlim_cur = limit.rlim_max;
+      ASSERT_EQ(0, setrlimit(RLIMIT_NOFILE, &limit));
+    }
+
+    sFlags.assign(kNumSockets, 0);
+    sCallbacks = 0;
+    for (int i = 0; i < kNumSockets; i++) {
+      int fds[2];
+      ASSERT_EQ(0, socketpair(AF_LOCAL, SOCK_STREAM, 0, fds));
+      our_fds_.push_back(fds[0]);
+      app_fds_.push_back(fds[1]);
+    }
+
+    btsock_thread_init();
+    handle_ = btsock_thread_create(signaled_cb, NULL);
+    ASSERT_GE(handle_, 0);
+  }
+
+  void TearDown() override {
+    btsock_thread_exit(handle_);
+    for (int fd : our_fds_) close(fd);
+    for (int fd : app_fds_)
+      if (fd != -1) close(fd);
+  }
+
+  // Waits until |count| callbacks in total were made.
+  bool wait_for_callbacks(int count) {
+    std::unique_lock<std::mutex> lock(sLock);
+    return sSignaled.wait_for(lock, std::chrono::milliseconds(kTimeoutMs),
+                              [count] { return sCallbacks >= count; });
+  }
+
+  int callbacks() {
+    std::lock_guard<std::mutex> lock(sLock);
+    return sCallbacks;
+  }
+
+  int flags(int user_id) {
+    std::lock_guard<std::mutex> lock(sLock);
+    return sFlags[user_id];
+  }
+
+  int handle_ = -1;
+  std::vector<int> our_fds_;
+  std::vector<int> app_fds_;
+};
+
+TEST_F(BtifSockThreadTest, read_signaled_for_all_sockets) {
+  for (int i = 0; i < kNumSockets; i++)
+    ASSERT_TRUE(btsock_thread_add_fd(handle_, our_fds_[i], BTSOCK_RFCOMM,
+                                     SOCK_THREAD_FD_RD, i));
+  for (int i = 0; i < kNumSockets; i++)
+    ASSERT_EQ(1, write(app_fds_[i], "x", 1));
+
+  ASSERT_TRUE(wait_for_callbacks(kNumSockets));
+  for (int i = 0; i < kNumSockets; i++)
+    EXPECT_EQ(SOCK_THREAD_FD_RD, flags(i)) << "socket " << i;
+}
+
+TEST_F(BtifSockThreadTest, read_signaled_once_until_added_again) {
+  for (int i = 0; i < kNumSockets; i++) {
+    btsock_thread_add_fd(handle_, our_fds_[i], BTSOCK_RFCOMM,
+                         SOCK_THREAD_FD_RD, i);
+    write(app_fds_[i], "x", 1);
+  }
+  ASSERT_TRUE(wait_for_callbacks(kNumSockets));
+
+  // The data was not read, but the fds are no longer monitored.
+  btsock_thread_wakeup(handle_);
+  usleep(100 * 1000);
+  EXPECT_EQ(kNumSockets, callbacks());
+
+  for (int i = 0; i < kNumSockets; i++)
+    btsock_thread_add_fd(handle_, our_fds_[i], BTSOCK_RFCOMM,
+                         SOCK_THREAD_FD_RD, i);
+  ASSERT_TRUE(wait_for_callbacks(2 * kNumSockets));
+}
+
+TEST_F(BtifSockThreadTest, write_signaled_read_kept) {
+  for (int i = 0; i < kNumSockets; i++) {
+    btsock_thread_add_fd(handle_, our_fds_[i], BTSOCK_RFCOMM,
+                         SOCK_THREAD_FD_RD, i);
+    btsock_thread_add_fd(handle_, our_fds_[i], BTSOCK_RFCOMM,
+                         SOCK_THREAD_FD_WR, i);
+  }
+  ASSERT_TRUE(wait_for_callbacks(kNumSockets));
+  for (int i = 0; i < kNumSockets; i++)
+    EXPECT_EQ(SOCK_THREAD_FD_WR, flags(i)) << "socket " << i;
+
+  // Reads are still monitored after the writes were signaled.
+  for (int i = 0; i < kNumSockets; i++) write(app_fds_[i], "x", 1);
+  ASSERT_TRUE(wait_for_callbacks(2 * kNumSockets));
+  for (int i = 0; i < kNumSockets; i++)
+    EXPECT_EQ(SOCK_THREAD_FD_RD | SOCK_THREAD_FD_WR, flags(i))
+        << "socket " << i;
+}
+
+TEST_F(BtifSockThreadTest, exception_signaled_on_peer_close) {
+  for (int i = 0; i < kNumSockets; i++)
+    btsock_thread_add_fd(handle_, our_fds_[i], BTSOCK_RFCOMM,
+                         SOCK_THREAD_FD_RD, i);
+  for (int i = 0; i < kNumSockets; i++) {
+    close(app_fds_[i]);
+    app_fds_[i] = -1;
+  }
+
+  ASSERT_TRUE(wait_for_callbacks(kNumSockets));
+  for (int i = 0; i < kNumSockets; i++)
+    EXPECT_TRUE(flags(i) & SOCK_THREAD_FD_EXCEPTION) << "socket " << i;
+}
+
+TEST_F(BtifSockThreadTest, removed_fd_not_signaled) {
+  for (int i = 0; i < kNumSockets; i++)
+    btsock_thread_add_fd(handle_, our_fds_[i], BTSOCK_RFCOMM,
+                         SOCK_THREAD_FD_RD, i);
+  for (int i = 0; i < kNumSockets; i += 2) {
+    ASSERT_TRUE(btsock_thread_remove_fd_and_close(handle_, our_fds_[i]));
+    our_fds_[i] = -1;
+  }
+  // Wait for the poll thread to close the removed fds.
+  for (int i = 0; i < kNumSockets; i += 2) {
+    struct pollfd pfd = {app_fds_[i], POLLIN, 0};
+    ASSERT_EQ(1, poll(&pfd, 1, kTimeoutMs));
+    EXPECT_TRUE(pfd.revents & POLLHUP);
+  }
+  for (int i = 1; i < kNumSockets; i += 2) write(app_fds_[i], "x", 1);
+
+  ASSERT_TRUE(wait_for_callbacks(kNumSockets / 2));
+  usleep(100 * 1000);
+  EXPECT_EQ(kNumSockets / 2, callbacks());
+  for (int i = 0; i < kNumSockets; i++)
+    EXPECT_EQ(i % 2 ? SOCK_THREAD_FD_RD : 0, flags(i)) << "socket " << i;
+  our_fds_.erase(std::remove(our_fds_.begin(), our_fds_.end(), -1),
+                 our_fds_.end());
+}
@@ -0,0 +1,132 @@
+/*
+ * Copyright 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <base/logging.h>
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+
+#include "stack/btm/btm_ble_adv_cache.h"
+
+using ::benchmark::State;
+
+#define NUM_ADVERTISERS 200
+#define NUM_REPORTS 20000
+// Reports from other devices received between an advertisement and its scan
+// response.
+#define MAX_SCAN_RSP_DELAY 48
+
+namespace {
+
+// One advertising report as btm_ble_process_adv_pkt_cont() sees it.
+struct Report {
+  RawAddress bd_addr;
+  bool is_start;     // Scannable advertisement, data is set
+  bool is_complete;  // Scan response or non scannable advertisement
+  std::vector<uint8_t> data;
+};
+
+std::vector<Report> trace;
+
+// Active scanning near many advertisers: half of them are scannable and
+// answer the scan request after a random number of other reports, the others
+// send non scannable advertisements that are complete on their own.
+void generate_trace() {
+  std::mt19937 rng(1);
+  std::vector<RawAddress> addrs(NUM_ADVERTISERS);
+  for (RawAddress& addr : addrs)
+    for (int j = 0; j < 6; j++) addr.address[j] = rng();
+
+  std::vector<uint8_t> adv = {0x02, 0x01, 0x06, 0x1b, 0xff};
+  adv.resize(31, 0x5a);
+  std::vector<uint8_t> scan_rsp = {0x1e, 0x09};
+  scan_rsp.resize(31, 'n');
+
+  trace.assign(NUM_REPORTS, Report());
+  std::vector<bool> used(NUM_REPORTS, false);
+  size_t next = 0;
+  while (next < NUM_REPORTS) {
+    if (used[next]) {
+      next++;
+      continue;
+    }
+    int advertiser = rng() % NUM_ADVERTISERS;
+    Report& report = trace[next];
+    used[next] = true;
+    report.bd_addr = addrs[advertiser];
+    report.data = adv;
+    if (advertiser % 2 == 0) {
+      report.is_complete = true;
+      continue;
+    }
+
+    report.is_start = true;
+    size_t rsp = next + 1 + rng() % MAX_SCAN_RSP_DELAY;
+    while (rsp < NUM_REPORTS && used[rsp]) rsp++;
+    if (rsp >= NUM_REPORTS) continue;
+    used[rsp] = true;
+    trace[rsp].bd_addr = addrs[advertiser];
+    trace[rsp].is_complete = true;
+    trace[rsp].data = scan_rsp;
+  }
+}
+
+}  // namespace
+
+// Replays the trace through a cache of |state.range(0)| devices. The
+// counters give the share of scannable devices whose scan response found
+// their advertisement still cached.
+static void BM_AdvertisingCacheReassembly(State& state) {
+  if (trace.empty()) generate_trace();
+
+  AdvertisingCache cache(state.range(0));
+  size_t completed = 0;
+  size_t scan_responses = 0;
+  while (state.KeepRunning()) {
+    for (const Report& report : trace) {
+      const std::vector<uint8_t>& data =
+          report.is_start
+              ? cache.Set(0, report.bd_addr, report.data.data(),
+                          report.data.size())
+              : cache.Append(0, report.bd_addr, report.data.data(),
+                             report.data.size());
+      if (!report.is_complete) continue;
+
+      if (data.size() > report.data.size()) completed++;
+      if (report.data[1] == 0x09) scan_responses++;
+      cache.Clear(0, report.bd_addr);
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * trace.size());
+  state.counters["reassembled"] =
+      scan_responses ? (double)completed / scan_responses : 0;
+  state.counters["evictions"] =
+      (double)cache.GetEvictions() / state.iterations();
+}
+BENCHMARK(BM_AdvertisingCacheReassembly)->Arg(8)->Arg(32)->Arg(128);
+
+int main(int argc, char** argv) {
+  // Disable LOG() output from libchrome
+  logging::LoggingSettings log_settings;
+  log_settings.logging_dest = logging::LoggingDestination::LOG_NONE;
+  CHECK(logging::InitLogging(log_settings)) << "Failed to set up logging";
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
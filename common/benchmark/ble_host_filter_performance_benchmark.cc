@@ -0,0 +1,158 @@
+/*
+ * Copyright 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <base/logging.h>
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+
+#include "btm_ble_api.h"
+#include "stack/btm/btm_ble_host_filter.h"
+
+using ::benchmark::State;
+using bluetooth::Uuid;
+
+#define NUM_ADVERTISERS 600
+#define NUM_REPORTS 20000
+
+namespace {
+
+struct Report {
+  RawAddress bd_addr;
+  int8_t rssi;
+  std::vector<uint8_t> data;
+};
+
+std::vector<Report> trace;
+std::vector<RawAddress> addrs;
+
+// Advertisers of a crowded venue: iBeacons, Eddystone beacons and named
+// devices, each with a distinct payload.
+void generate_trace() {
+  std::mt19937 rng(1);
+  std::vector<Report> advertisers(NUM_ADVERTISERS);
+  for (int i = 0; i < NUM_ADVERTISERS; i++) {
+    Report& adv = advertisers[i];
+    for (int j = 0; j < 6; j++) adv.bd_addr.address[j] = rng();
+    addrs.push_back(adv.bd_addr);
+    adv.data = {0x02, 0x01, 0x06};
+    switch (i % 3) {
+      case 0: /* iBeacon, proximity UUID picked from 16 */
+        adv.data.insert(adv.data.end(), {0x1a, 0xff, 0x4c, 0x00, 0x02, 0x15});
+        adv.data.push_back(i % 16);
+        for (int j = 0; j < 20; j++) adv.data.push_back(rng());
+        break;
+      case 1: /* Eddystone UID, namespace picked from 16 */
+        adv.data.insert(adv.data.end(),
+                        {0x03, 0x03, 0xaa, 0xfe, 0x17, 0x16, 0xaa, 0xfe, 0x00});
+        adv.data.push_back(i % 16);
+        for (int j = 0; j < 19; j++) adv.data.push_back(rng());
+        break;
+      case 2: /* Named device with a service UUID */
+        adv.data.insert(adv.data.end(), {0x03, 0x03, 0x0d, 0x18, 0x08, 0x09,
+                                         'D', 'e', 'v', 'i', 'c', 'e'});
+        adv.data.push_back('0' + i % 16);
+        break;
+    }
+  }
+
+  for (int i = 0; i < NUM_REPORTS; i++) {
+    Report report = advertisers[rng() % NUM_ADVERTISERS];
+    report.rssi = -40 - rng() % 60;
+    trace.push_back(report);
+  }
+}
+
+ApcfCommand command(uint8_t type) {
+  ApcfCommand cmd = {};
+  cmd.type = type;
+  cmd.address = RawAddress::kEmpty;
+  cmd.uuid = Uuid::kEmpty;
+  cmd.uuid_mask = Uuid::kEmpty;
+  return cmd;
+}
+
+// Scan filters of applications looking for their own devices, cycling
+// through the kinds of advertisers of the trace.
+void set_up_filters(HostAdvFilter* filter, int num_filters) {
+  for (int i = 0; i < num_filters; i++) {
+    ApcfCommand cmd;
+    uint16_t feat_seln;
+    switch (i % 4) {
+      case 0:
+        cmd = command(BTM_BLE_PF_MANU_DATA);
+        cmd.company = 0x004c;
+        cmd.data = {0x02, 0x15, (uint8_t)(i % 16)};
+        cmd.data_mask = {0xff, 0xff, 0xff};
+        break;
+      case 1:
+        cmd = command(BTM_BLE_PF_SRVC_DATA_PATTERN);
+        cmd.data = {0xaa, 0xfe, 0x00, (uint8_t)(i % 16)};
+        cmd.data_mask = {0xff, 0xff, 0xff, 0xff};
+        break;
+      case 2:
+        cmd = command(BTM_BLE_PF_LOCAL_NAME);
+        cmd.name = {'D', 'e', 'v', 'i', 'c', 'e', (uint8_t)('0' + i % 16)};
+        break;
+      case 3:
+        cmd = command(BTM_BLE_PF_ADDR_FILTER);
+        cmd.address = addrs[i % NUM_ADVERTISERS];
+        break;
+    }
+    feat_seln = 1 << cmd.type;
+    filter->AddConditions(i, {cmd});
+    filter->Select(i, feat_seln, 0, BTM_BLE_PF_LOGIC_AND, -128);
+  }
+}
+
+}  // namespace
+
+// Filters every report of the trace with |state.range(0)| filters selected,
+// or with filtering disabled for 0.
+static void BM_HostAdvFilter(State& state) {
+  if (trace.empty()) generate_trace();
+
+  int num_filters = state.range(0);
+  HostAdvFilter filter(32);
+  set_up_filters(&filter, num_filters);
+  filter.SetEnabled(num_filters > 0);
+
+  size_t delivered = 0;
+  while (state.KeepRunning()) {
+    for (const Report& report : trace) {
+      if (filter.Matches(report.bd_addr, report.rssi, report.data.data(),
+                         report.data.size()))
+        delivered++;
+    }
+  }
+
+  double reports = state.iterations() * trace.size();
+  state.SetItemsProcessed(reports);
+  state.counters["delivered"] = delivered / reports;
+}
+BENCHMARK(BM_HostAdvFilter)->Arg(0)->Arg(1)->Arg(8)->Arg(32);
+
+int main(int argc, char** argv) {
+  // Disable LOG() output from libchrome
+  logging::LoggingSettings log_settings;
+  log_settings.logging_dest = logging::LoggingDestination::LOG_NONE;
+  CHECK(logging::InitLogging(log_settings)) << "Failed to set up logging";
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
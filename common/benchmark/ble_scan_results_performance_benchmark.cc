@@ -0,0 +1,187 @@
+/*
+ * Copyright 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <base/logging.h>
+#include <benchmark/benchmark.h>
+#include <mutex>
+#include <random>
+#include <vector>
+
+#include "bt_types.h"
+#include "btif_ble_seen_devices.h"
+#include "osi/include/config.h"
+
+using ::benchmark::State;
+
+#define NUM_BEACONS 600
+#define ADV_INTERVAL_MS 100
+#define STORM_DURATION_MS 10000
+// One beacon in ten changes its payload every second, like Eddystone TLM.
+#define CHANGING_BEACON_RATIO 10
+#define COALESCE_WINDOW_MS 1000
+
+namespace {
+
+// One advertising report, in the order the controller delivered them.
+struct Report {
+  RawAddress bd_addr;
+  uint8_t device_type;
+  uint8_t addr_type;
+  uint16_t evt_type;
+  uint64_t time_ms;
+  std::vector<uint8_t> data;
+};
+
+std::vector<Report> beacon_storm;
+
+// Beacons as seen in a crowded venue: most of them use a non-resolvable
+// random address and a fixed manufacturer specific payload, the others are
+// named devices with a public address.
+void generate_beacon_storm() {
+  std::mt19937 rng(1);
+  std::vector<Report> beacons;
+  for (int i = 0; i < NUM_BEACONS; i++) {
+    Report beacon;
+    for (int j = 0; j < 6; j++) beacon.bd_addr.address[j] = rng();
+    beacon.device_type = BT_DEVICE_TYPE_BLE;
+    if (i % 5 == 0) {
+      beacon.addr_type = BLE_ADDR_PUBLIC;
+      beacon.evt_type = 0x0013; /* connectable scannable legacy */
+      beacon.data = {0x02, 0x01, 0x06, 0x08, 0x09, 'B', 'e', 'a', 'c', 'o', 'n',
+                     static_cast<uint8_t>('0' + i % 10)};
+    } else {
+      beacon.bd_addr.address[0] &= 0x3f;
+      beacon.addr_type = BLE_ADDR_RANDOM;
+      beacon.evt_type = 0x0010; /* non connectable legacy */
+      beacon.data = {0x02, 0x01, 0x06, 0x1a, 0xff, 0x4c, 0x00, 0x02, 0x15};
+      for (int j = 0; j < 21; j++) beacon.data.push_back(rng());
+    }
+    beacons.push_back(beacon);
+  }
+
+  std::vector<uint64_t> next_ms(NUM_BEACONS);
+  for (int i = 0; i < NUM_BEACONS; i++) next_ms[i] = rng() % ADV_INTERVAL_MS;
+
+  // Replay the advertising events in time order, advDelay included.
+  beacon_storm.clear();
+  for (uint64_t now = 0; now < STORM_DURATION_MS; now++) {
+    for (int i = 0; i < NUM_BEACONS; i++) {
+      if (next_ms[i] != now) continue;
+      next_ms[i] += ADV_INTERVAL_MS + rng() % 10;
+
+      Report report = beacons[i];
+      report.time_ms = now;
+      if (i % CHANGING_BEACON_RATIO == 0)
+        report.data.back() = static_cast<uint8_t>(now / 1000);
+      beacon_storm.push_back(report);
+    }
+  }
+}
+
+// The part of btif_storage_set_remote_device_property() and
+// btif_storage_set_remote_addr_type() that runs for every call, without the
+// journal write and the save timer.
+config_t* config;
+std::recursive_mutex config_lock;
+
+void store_device(const Report& report) {
+  std::string addrstr = report.bd_addr.ToString();
+  std::unique_lock<std::recursive_mutex> lock(config_lock);
+  config_set_int(config, addrstr.c_str(), "DevType", report.device_type);
+  config_set_int(config, addrstr.c_str(), "AddrType", report.addr_type);
+}
+
+class BM_BleScanResults : public ::benchmark::Fixture {
+ protected:
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+    if (beacon_storm.empty()) generate_beacon_storm();
+    config = config_new_empty();
+  }
+
+  void TearDown(State& st) override {
+    config_free(config);
+    config = NULL;
+    ::benchmark::Fixture::TearDown(st);
+  }
+
+  void ReplayStorm(State& state, uint64_t coalesce_window_ms) {
+    size_t stored = 0;
+    size_t forwarded = 0;
+    BleSeenDevices seen_devices;
+    seen_devices.SetCoalesceWindow(coalesce_window_ms);
+    while (state.KeepRunning()) {
+      seen_devices.Clear();
+      for (const Report& report : beacon_storm) {
+        BleSeenDevices::Device* device = seen_devices.Get(report.bd_addr);
+        if (BleSeenDevices::UpdateStoredTypes(device, report.device_type,
+                                              report.addr_type)) {
+          store_device(report);
+          stored++;
+        }
+        if (seen_devices.ShouldForward(device, report.evt_type, report.data,
+                                       report.time_ms))
+          forwarded++;
+      }
+    }
+    SetCounters(state, stored, forwarded);
+  }
+
+  void SetCounters(State& state, size_t stored, size_t forwarded) {
+    double reports = state.iterations() * beacon_storm.size();
+    state.SetItemsProcessed(reports);
+    state.counters["stored"] = stored / reports;
+    state.counters["forwarded"] = forwarded / reports;
+  }
+};
+
+}  // namespace
+
+// Every report written to storage and forwarded, as before the seen devices
+// table.
+BENCHMARK_DEFINE_F(BM_BleScanResults, StoreEveryReport)(State& state) {
+  size_t stored = 0;
+  while (state.KeepRunning()) {
+    for (const Report& report : beacon_storm) {
+      store_device(report);
+      stored++;
+    }
+  }
+  SetCounters(state, stored, stored);
+}
+BENCHMARK_REGISTER_F(BM_BleScanResults, StoreEveryReport);
+
+BENCHMARK_DEFINE_F(BM_BleScanResults, SeenDevices)(State& state) {
+  ReplayStorm(state, 0);
+}
+BENCHMARK_REGISTER_F(BM_BleScanResults, SeenDevices);
+
+BENCHMARK_DEFINE_F(BM_BleScanResults, SeenDevicesCoalesced)(State& state) {
+  ReplayStorm(state, COALESCE_WINDOW_MS);
+}
+BENCHMARK_REGISTER_F(BM_BleScanResults, SeenDevicesCoalesced);
+
+int main(int argc, char** argv) {
+  // Disable LOG() output from libchrome
+  logging::LoggingSettings log_settings;
+  log_settings.logging_dest = logging::LoggingDestination::LOG_NONE;
+  CHECK(logging::InitLogging(log_settings)) << "Failed to set up logging";
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
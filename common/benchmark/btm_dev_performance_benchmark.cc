@@ -0,0 +1,169 @@
+/*
+ * Copyright 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <base/logging.h>
+#include <benchmark/benchmark.h>
+
+#include "bt_types.h"
+#include "btm_api.h"
+#include "btm_int.h"
+#include "device/include/controller.h"
+#include "osi/include/allocator.h"
+#include "osi/include/list.h"
+
+using ::benchmark::State;
+
+#define NUM_DEV_RECS 1000
+#define NUM_CONNECTED 16
+#define FIRST_HANDLE 0x0001
+
+tBTM_CB btm_cb;
+
+// The security database is measured on its own: everything it calls outside
+// of btm_dev.cc is replaced. No record resolves a random address, so the
+// lookups that miss walk the whole list.
+bool btm_ble_addr_resolvable(const RawAddress& rpa,
+                             tBTM_SEC_DEV_REC* p_dev_rec) {
+  return false;
+}
+void btm_sec_clear_ble_keys(tBTM_SEC_DEV_REC* p_dev_rec) {}
+uint16_t BTM_GetHCIConnHandle(const RawAddress& remote_bda,
+                              tBT_TRANSPORT transport) {
+  return BTM_SEC_INVALID_HANDLE;
+}
+tBTM_INQ_INFO* BTM_InqDbRead(const RawAddress& p_bda) { return NULL; }
+bool BTM_IsAclConnectionUp(const RawAddress& remote_bda,
+                           tBT_TRANSPORT transport) {
+  return false;
+}
+tBTM_STATUS BTM_DeleteStoredLinkKey(const RawAddress* bd_addr,
+                                    tBTM_CMPL_CB* p_cb) {
+  return BTM_SUCCESS;
+}
+bool btm_is_sco_active_by_bdaddr(const RawAddress& remote_bda) {
+  return false;
+}
+const controller_t* controller_get_interface() { return NULL; }
+
+static RawAddress dev_rec_address(int i) {
+  RawAddress bd_addr;
+  bd_addr.address[0] = 0x00;
+  bd_addr.address[1] = 0x1b;
+  bd_addr.address[2] = 0xdc;
+  bd_addr.address[3] = 0x00;
+  bd_addr.address[4] = (uint8_t)(i >> 8);
+  bd_addr.address[5] = (uint8_t)i;
+  return bd_addr;
+}
+
+class BM_BtmDev : public ::benchmark::Fixture {
+ protected:
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+    btm_cb.sec_dev_rec = list_new(osi_free);
+    btm_sec_clear_dev_rec_index();
+
+    // Paired devices as BTM_SecAddDevice restores them, the last few of them
+    // connected. They are appended directly so that the benchmark does not
+    // depend on BTM_SEC_MAX_DEVICE_RECORDS.
+    for (int i = 0; i < NUM_DEV_RECS; i++) {
+      tBTM_SEC_DEV_REC* p_dev_rec =
+          (tBTM_SEC_DEV_REC*)osi_calloc(sizeof(tBTM_SEC_DEV_REC));
+      list_append(btm_cb.sec_dev_rec, p_dev_rec);
+      p_dev_rec->sec_flags = BTM_SEC_IN_USE | BTM_SEC_LINK_KEY_KNOWN;
+      p_dev_rec->bd_addr = dev_rec_address(i);
+      p_dev_rec->hci_handle = BTM_SEC_INVALID_HANDLE;
+      p_dev_rec->ble_hci_handle = BTM_SEC_INVALID_HANDLE;
+      if (i >= NUM_DEV_RECS - NUM_CONNECTED)
+        p_dev_rec->hci_handle = FIRST_HANDLE + NUM_DEV_RECS - 1 - i;
+      btm_sec_index_dev_rec(p_dev_rec);
+    }
+  }
+
+  void TearDown(State& st) override {
+    list_free(btm_cb.sec_dev_rec);
+    btm_cb.sec_dev_rec = NULL;
+    btm_sec_clear_dev_rec_index();
+    ::benchmark::Fixture::TearDown(st);
+  }
+};
+
+// Encryption Change and Disconnection Complete: the record of a connected
+// device is looked up by handle.
+BENCHMARK_DEFINE_F(BM_BtmDev, FindByHandle)(State& state) {
+  int i = 0;
+  while (state.KeepRunning()) {
+    tBTM_SEC_DEV_REC* p_dev_rec =
+        btm_find_dev_by_handle(FIRST_HANDLE + i++ % NUM_CONNECTED);
+    CHECK(p_dev_rec != NULL);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_REGISTER_F(BM_BtmDev, FindByHandle);
+
+// Link Key Request and friends: the record of a known device is looked up by
+// address.
+BENCHMARK_DEFINE_F(BM_BtmDev, FindByAddress)(State& state) {
+  int i = 0;
+  while (state.KeepRunning()) {
+    tBTM_SEC_DEV_REC* p_dev_rec =
+        btm_find_dev(dev_rec_address(i++ * 7 % NUM_DEV_RECS));
+    CHECK(p_dev_rec != NULL);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_REGISTER_F(BM_BtmDev, FindByAddress);
+
+// A device never seen before still costs a full walk of the list.
+BENCHMARK_DEFINE_F(BM_BtmDev, FindUnknownAddress)(State& state) {
+  RawAddress bd_addr = dev_rec_address(NUM_DEV_RECS + 1);
+  while (state.KeepRunning()) {
+    CHECK(btm_find_dev(bd_addr) == NULL);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_REGISTER_F(BM_BtmDev, FindUnknownAddress);
+
+// The lookups made for one round of link events on each connected device:
+// Link Key Request, Encryption Change, Read Remote Features and
+// Disconnection Complete.
+BENCHMARK_DEFINE_F(BM_BtmDev, EventRound)(State& state) {
+  while (state.KeepRunning()) {
+    for (int i = 0; i < NUM_CONNECTED; i++) {
+      uint16_t handle = FIRST_HANDLE + i;
+      tBTM_SEC_DEV_REC* p_dev_rec =
+          btm_find_dev(dev_rec_address(NUM_DEV_RECS - 1 - i));
+      CHECK(p_dev_rec != NULL);
+      CHECK(btm_find_dev_by_handle(handle) == p_dev_rec);
+      CHECK(btm_find_dev_by_handle(handle) == p_dev_rec);
+      CHECK(btm_find_dev_by_handle(handle) == p_dev_rec);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * NUM_CONNECTED * 4);
+}
+BENCHMARK_REGISTER_F(BM_BtmDev, EventRound);
+
+int main(int argc, char** argv) {
+  // Disable LOG() output from libchrome
+  logging::LoggingSettings log_settings;
+  log_settings.logging_dest = logging::LoggingDestination::LOG_NONE;
+  CHECK(logging::InitLogging(log_settings)) << "Failed to set up logging";
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <base/logging.h>
+#include <benchmark/benchmark.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+#include "osi/include/config.h"
+
+using ::benchmark::State;
+
+#define NUM_DEVICES 500
+
+static const char* kConfigFile = "/tmp/config_performance_benchmark.conf";
+
+static std::string device_address(int i) {
+  char address[18];
+  snprintf(address, sizeof(address), "00:1a:7d:%02x:%02x:%02x",
+           (i >> 16) & 0xff, (i >> 8) & 0xff, i & 0xff);
+  return address;
+}
+
+// Writes a bt_config.conf with an adapter section and |NUM_DEVICES| bonded
+// devices carrying the keys btif_config typically stores for each.
+static void write_config_file() {
+  FILE* fp = fopen(kConfigFile, "wt");
+  CHECK(fp != nullptr);
+
+  fprintf(fp, "[Info]\nFileSource = Empty\n");
+  fprintf(fp, "TimeCreated = 2018-01-01 00:00:00\n");
+  fprintf(fp, "\n[Adapter]\nAddress = 22:22:9a:bc:de:f0\nName = Bench\n");
+  fprintf(fp, "ScanMode = 0\nDiscoveryTimeout = 120\n");
+
+  for (int i = 0; i < NUM_DEVICES; i++) {
+    fprintf(fp, "\n[%s]\n", device_address(i).c_str());
+    fprintf(fp, "Timestamp = %d\n", 1500000000 + i);
+    fprintf(fp, "Name = Device %d\n", i);
+    fprintf(fp, "DevClass = 2360344\nDevType = 1\nAddrType = 0\n");
+    fprintf(fp, "Manufacturer = 29\nLmpVer = 8\nLmpSubVer = 4865\n");
+    fprintf(fp, "Service = 0000110b-0000-1000-8000-00805f9b34fb ");
+    fprintf(fp, "0000110e-0000-1000-8000-00805f9b34fb\n");
+    fprintf(fp, "LinkKeyType = 5\nPinLength = 0\n");
+    fprintf(fp, "LinkKey = %032x\n", i);
+  }
+
+  fclose(fp);
+}
+
+class BM_Config : public ::benchmark::Fixture {
+ protected:
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+    write_config_file();
+    config_ = config_new(kConfigFile);
+    CHECK(config_ != nullptr);
+    for (int i = 0; i < NUM_DEVICES; i++) {
+      addresses_.push_back(device_address(i));
+    }
+  }
+
+  void TearDown(State& st) override {
+    config_free(config_);
+    config_ = nullptr;
+    addresses_.clear();
+    unlink(kConfigFile);
+    ::benchmark::Fixture::TearDown(st);
+  }
+
+  config_t* config_ = nullptr;
+  std::vector<std::string> addresses_;
+};
+
+// Parsing the whole file, as done at stack startup.
+BENCHMARK_F(BM_Config, load)(State& state) {
+  for (auto _ : state) {
+    config_t* config = config_new(kConfigFile);
+    CHECK(config != nullptr);
+    config_free(config);
+  }
+};
+
+// The per-device lookups done when a bonded device connects.
+BENCHMARK_F(BM_Config, lookup_bonded_device)(State& state) {
+  for (auto _ : state) {
+    for (const std::string& address : addresses_) {
+      const char* section = address.c_str();
+      benchmark::DoNotOptimize(config_has_section(config_, section));
+      benchmark::DoNotOptimize(
+          config_get_string(config_, section, "LinkKey", nullptr));
+      benchmark::DoNotOptimize(config_get_int(config_, section, "DevType", 0));
+      benchmark::DoNotOptimize(
+          config_get_string(config_, section, "Name", nullptr));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * NUM_DEVICES);
+};
+
+// Updating an existing key, as done on every connection.
+BENCHMARK_F(BM_Config, update_timestamp)(State& state) {
+  int timestamp = 0;
+  for (auto _ : state) {
+    for (const std::string& address : addresses_) {
+      config_set_int(config_, address.c_str(), "Timestamp", timestamp++);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * NUM_DEVICES);
+};
+
+// The copy taken by btif_config_write before each save.
+BENCHMARK_F(BM_Config, clone)(State& state) {
+  for (auto _ : state) {
+    config_free(config_new_clone(config_));
+  }
+};
+
+int main(int argc, char** argv) {
+  // Disable LOG() output from libchrome
+  logging::LoggingSettings log_settings;
+  log_settings.logging_dest = logging::LoggingDestination::LOG_NONE;
+  CHECK(logging::InitLogging(log_settings)) << "Failed to set up logging";
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
@@ -0,0 +1,152 @@
+/*
+ * Copyright 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <base/logging.h>
+#include <benchmark/benchmark.h>
+#include <math.h>
+#include <vector>
+
+#include "embdrv/g722/g722_enc_dec.h"
+
+using ::benchmark::State;
+
+// Each iteration encodes one second of 16 kHz stereo audio, in 20 ms packets
+// as the hearing aid profile sends it: the time per iteration is the CPU time
+// per second of audio.
+#define SAMPLE_RATE 16000
+#define PACKET_SAMPLES (SAMPLE_RATE * 20 / 1000)
+#define PACKETS_PER_SECOND (SAMPLE_RATE / PACKET_SAMPLES)
+
+// Interleaved 16 bit stereo PCM, as read from the audio HAL: a chirp and a
+// tone per channel with some noise.
+static std::vector<uint8_t> make_corpus() {
+  std::vector<uint8_t> pcm(4 * SAMPLE_RATE);
+  uint32_t seed = 1;
+  for (int i = 0; i < SAMPLE_RATE; i++) {
+    double t = (double)i / SAMPLE_RATE;
+    seed = seed * 1103515245 + 12345;
+    int noise = (int)((seed >> 16) & 0x7FF) - 0x400;
+    int16_t left = (int16_t)(12000 * sin(2 * M_PI * 300 * t * (1 + t)) +
+                             6000 * sin(2 * M_PI * 3100 * t) + noise);
+    int16_t right = (int16_t)(12000 * sin(2 * M_PI * 500 * t * (1 + t)) +
+                              6000 * sin(2 * M_PI * 5300 * t) - noise);
+    pcm[4 * i] = left & 0xff;
+    pcm[4 * i + 1] = (left >> 8) & 0xff;
+    pcm[4 * i + 2] = right & 0xff;
+    pcm[4 * i + 3] = (right >> 8) & 0xff;
+  }
+  return pcm;
+}
+
+class BM_G722Encoder : public ::benchmark::Fixture {
+ protected:
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+    corpus_ = make_corpus();
+    left_ = g722_encode_init(nullptr, 64000, G722_PACKED);
+    right_ = g722_encode_init(nullptr, 64000, G722_PACKED);
+  }
+
+  void TearDown(State& st) override {
+    g722_encode_release(left_);
+    g722_encode_release(right_);
+    ::benchmark::Fixture::TearDown(st);
+  }
+
+  std::vector<uint8_t> corpus_;
+  g722_encode_state_t* left_;
+  g722_encode_state_t* right_;
+};
+
+// Each packet is split into freshly allocated channel vectors, and each
+// channel is encoded on its own into a freshly allocated output vector.
+BENCHMARK_F(BM_G722Encoder, stereo_per_channel)(State& state) {
+  for (auto _ : state) {
+    for (int p = 0; p < PACKETS_PER_SECOND; p++) {
+      const uint8_t* data = corpus_.data() + 4 * PACKET_SAMPLES * p;
+      std::vector<uint16_t> chan_left;
+      std::vector<uint16_t> chan_right;
+      for (int i = 0; i < PACKET_SAMPLES; i++) {
+        const uint8_t* sample = data + i * 4;
+        chan_left.push_back((int16_t)((sample[1] << 8) + sample[0]) >> 1);
+        chan_right.push_back((int16_t)((sample[3] << 8) + sample[2]) >> 1);
+      }
+      std::vector<uint8_t> encoded_left(4000);
+      std::vector<uint8_t> encoded_right(4000);
+      g722_encode(left_, encoded_left.data(),
+                  (const int16_t*)chan_left.data(), chan_left.size());
+      g722_encode(right_, encoded_right.data(),
+                  (const int16_t*)chan_right.data(), chan_right.size());
+      benchmark::DoNotOptimize(encoded_left.data());
+      benchmark::DoNotOptimize(encoded_right.data());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * SAMPLE_RATE);
+}
+
+// Each packet is split into preallocated buffers, and both channels are
+// encoded in one pass.
+BENCHMARK_F(BM_G722Encoder, stereo_one_pass)(State& state) {
+  alignas(64) int16_t chan_left[PACKET_SAMPLES];
+  alignas(64) int16_t chan_right[PACKET_SAMPLES];
+  alignas(64) uint8_t encoded_left[PACKET_SAMPLES / 2];
+  alignas(64) uint8_t encoded_right[PACKET_SAMPLES / 2];
+  for (auto _ : state) {
+    for (int p = 0; p < PACKETS_PER_SECOND; p++) {
+      const uint8_t* sample = corpus_.data() + 4 * PACKET_SAMPLES * p;
+      for (int i = 0; i < PACKET_SAMPLES; i++, sample += 4) {
+        chan_left[i] = (int16_t)((sample[1] << 8) + sample[0]) >> 1;
+        chan_right[i] = (int16_t)((sample[3] << 8) + sample[2]) >> 1;
+      }
+      g722_encode_stereo(left_, right_, encoded_left, encoded_right,
+                         chan_left, chan_right, PACKET_SAMPLES);
+      benchmark::DoNotOptimize(encoded_left);
+      benchmark::DoNotOptimize(encoded_right);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * SAMPLE_RATE);
+}
+
+// A single hearing aid: the packet is downmixed to mono and encoded once.
+BENCHMARK_F(BM_G722Encoder, mono)(State& state) {
+  alignas(64) int16_t chan[PACKET_SAMPLES];
+  alignas(64) uint8_t encoded[PACKET_SAMPLES / 2];
+  for (auto _ : state) {
+    for (int p = 0; p < PACKETS_PER_SECOND; p++) {
+      const uint8_t* sample = corpus_.data() + 4 * PACKET_SAMPLES * p;
+      for (int i = 0; i < PACKET_SAMPLES; i++, sample += 4) {
+        int16_t left = (int16_t)((sample[1] << 8) + sample[0]) >> 1;
+        int16_t right = (int16_t)((sample[3] << 8) + sample[2]) >> 1;
+        chan[i] = (int16_t)((left + right) >> 1);
+      }
+      g722_encode(left_, encoded, chan, PACKET_SAMPLES);
+      benchmark::DoNotOptimize(encoded);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * SAMPLE_RATE);
+}
+
+int main(int argc, char** argv) {
+  // Disable LOG() output from libchrome
+  logging::LoggingSettings log_settings;
+  log_settings.logging_dest = logging::LoggingDestination::LOG_NONE;
+  CHECK(logging::InitLogging(log_settings)) << "Failed to set up logging";
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
@@ -0,0 +1,266 @@
+/*
+ * Copyright 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <base/logging.h>
+#include <benchmark/benchmark.h>
+#include <list>
+#include <memory>
+#include <vector>
+
+#include "bt_types.h"
+#include "btm_api.h"
+#include "btm_ble_int.h"
+#include "l2c_api.h"
+#include "osi/include/allocator.h"
+#include "sdp_api.h"
+#include "stack/gatt/connection_manager.h"
+#include "stack/gatt/gatt_int.h"
+
+using ::benchmark::State;
+using bluetooth::Uuid;
+
+#define NUM_SERVICES 10
+#define NUM_CHARACTERISTICS 16
+#define BENCH_GATT_IF 1
+#define BENCH_MTU 517
+
+// Each service holds its declaration, a declaration and value per
+// characteristic and one descriptor per characteristic: 49 attributes, so
+// ten services make a database of about 500 attributes.
+#define ATTRS_PER_SERVICE (1 + 3 * NUM_CHARACTERISTICS)
+
+tGATT_CB gatt_cb;
+
+// The layers below GATT are replaced so that only the server database and
+// request handling are measured. Responses are dropped instead of being
+// handed to L2CAP.
+BT_HDR* attp_build_sr_msg(tGATT_TCB& tcb, uint8_t op_code,
+                          tGATT_SR_MSG* p_msg) {
+  return (BT_HDR*)osi_calloc(sizeof(BT_HDR) + BENCH_MTU + L2CAP_MIN_OFFSET);
+}
+tGATT_STATUS attp_send_sr_msg(tGATT_TCB& tcb, BT_HDR* p_msg) {
+  osi_free(p_msg);
+  return GATT_SUCCESS;
+}
+tGATT_STATUS attp_send_cl_msg(tGATT_TCB& tcb, tGATT_CLCB* p_clcb,
+                              uint8_t op_code, tGATT_CL_MSG* p_msg) {
+  return GATT_SUCCESS;
+}
+bool BTM_GetSecurityFlagsByTransport(const RawAddress& bd_addr,
+                                     uint8_t* p_sec_flags,
+                                     tBT_TRANSPORT transport) {
+  *p_sec_flags = 0;
+  return true;
+}
+uint8_t btm_ble_read_sec_key_size(const RawAddress& bd_addr) { return 16; }
+bool l2cble_set_fixed_channel_tx_data_length(const RawAddress& remote_bda,
+                                             uint16_t fix_cid,
+                                             uint16_t tx_mtu) {
+  return true;
+}
+uint32_t SDP_CreateRecord(void) { return 0; }
+bool SDP_AddAttribute(uint32_t handle, uint16_t attr_id, uint8_t attr_type,
+                      uint32_t attr_len, uint8_t* p_val) {
+  return true;
+}
+bool SDP_AddUuidSequence(uint32_t handle, uint16_t attr_id, uint16_t num_uuids,
+                         uint16_t* p_uuids) {
+  return true;
+}
+bool SDP_AddProtocolList(uint32_t handle, uint16_t num_elem,
+                         tSDP_PROTOCOL_ELEM* p_elem_list) {
+  return true;
+}
+bool SDP_AddServiceClassIdList(uint32_t handle, uint16_t num_services,
+                               uint16_t* p_service_uuids) {
+  return true;
+}
+namespace connection_manager {
+bool background_connect_remove(tAPP_ID app_id, const RawAddress& address) {
+  return true;
+}
+bool direct_connect_remove(tAPP_ID app_id, const RawAddress& address) {
+  return true;
+}
+}  // namespace connection_manager
+bool gatt_disconnect(tGATT_TCB* p_tcb) { return true; }
+void gatt_update_app_use_link_flag(tGATT_IF gatt_if, tGATT_TCB* p_tcb,
+                                   bool is_add, bool check_acl_link) {}
+void gatt_set_ch_state(tGATT_TCB* p_tcb, tGATT_CH_STATE ch_state) {}
+tGATT_CH_STATE gatt_get_ch_state(tGATT_TCB* p_tcb) { return GATT_CH_OPEN; }
+void gatt_act_discovery(tGATT_CLCB* p_clcb) {}
+tGATT_STATUS GATTS_HandleValueIndication(uint16_t conn_id, uint16_t attr_handle,
+                                         uint16_t val_len, uint8_t* p_val) {
+  return GATT_SUCCESS;
+}
+
+static void request_cb(uint16_t conn_id, uint32_t trans_id,
+                       tGATTS_REQ_TYPE type, tGATTS_DATA* p_data) {}
+
+static Uuid characteristic_uuid(int i) {
+  return Uuid::From16Bit(0xA000 + i);
+}
+
+class BM_GattServer : public ::benchmark::Fixture {
+ protected:
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+
+    gatt_cb.srv_list_info = new std::list<tGATT_SRV_LIST_ELEM>();
+    tGATT_REG& reg = gatt_cb.cl_rcb[BENCH_GATT_IF - 1];
+    reg.in_use = true;
+    reg.gatt_if = BENCH_GATT_IF;
+    reg.app_cb.p_req_cb = request_cb;
+
+    tcb_ = &gatt_cb.tcb[0];
+    tcb_->in_use = true;
+    tcb_->tcb_idx = 0;
+    tcb_->payload_size = BENCH_MTU;
+    tcb_->transport = BT_TRANSPORT_LE;
+
+    uint16_t s_hdl = 1;
+    for (int i = 0; i < NUM_SERVICES; i++) {
+      dbs_.emplace_back(new tGATT_SVC_DB());
+      tGATT_SVC_DB& db = *dbs_.back();
+      gatts_init_service_db(db, Uuid::From16Bit(0x1800 + i), true, s_hdl,
+                            ATTRS_PER_SERVICE);
+      for (int j = 0; j < NUM_CHARACTERISTICS; j++) {
+        uint16_t handle = gatts_add_characteristic(
+            db, GATT_PERM_READ, GATT_CHAR_PROP_BIT_READ,
+            characteristic_uuid(j));
+        value_handles_.push_back(handle);
+        gatts_add_char_descr(db, GATT_PERM_READ, Uuid::From16Bit(0x2901));
+      }
+
+      tGATT_SRV_LIST_ELEM elem;
+      elem.p_db = &db;
+      elem.gatt_if = BENCH_GATT_IF;
+      elem.s_hdl = s_hdl;
+      elem.e_hdl = s_hdl + ATTRS_PER_SERVICE - 1;
+      elem.type = GATT_UUID_PRI_SERVICE;
+      elem.is_primary = true;
+      elem.sdp_handle = 0;
+      gatt_cb.srv_list_info->push_back(elem);
+
+      s_hdl += ATTRS_PER_SERVICE;
+    }
+    last_handle_ = s_hdl - 1;
+  }
+
+  void TearDown(State& st) override {
+    delete gatt_cb.srv_list_info;
+    gatt_cb.srv_list_info = nullptr;
+    dbs_.clear();
+    value_handles_.clear();
+    gatt_cb.cl_rcb[BENCH_GATT_IF - 1] = {};
+    ::benchmark::Fixture::TearDown(st);
+  }
+
+  // Sends |len| bytes of request PDU |op_code| from the peer, and answers any
+  // read the server forwarded to the application, as the upper layers do.
+  void handle_request(uint8_t op_code, uint8_t* p_data, uint16_t len) {
+    gatt_server_handle_client_req(*tcb_, op_code, len, p_data);
+    if (tcb_->sr_cmd.op_code != 0) {
+      tGATTS_RSP rsp;
+      memset(&rsp, 0, sizeof(rsp));
+      rsp.attr_value.handle = tcb_->sr_cmd.handle;
+      rsp.attr_value.len = 2;
+      gatt_sr_process_app_rsp(*tcb_, BENCH_GATT_IF, tcb_->sr_cmd.trans_id,
+                              tcb_->sr_cmd.op_code, GATT_SUCCESS, &rsp);
+    }
+  }
+
+  tGATT_TCB* tcb_ = nullptr;
+  std::vector<std::unique_ptr<tGATT_SVC_DB>> dbs_;
+  std::vector<uint16_t> value_handles_;
+  uint16_t last_handle_ = 0;
+};
+
+// Read Request on every characteristic value in the database.
+BENCHMARK_F(BM_GattServer, read)(State& state) {
+  for (auto _ : state) {
+    for (uint16_t handle : value_handles_) {
+      uint8_t pdu[2];
+      uint8_t* p = pdu;
+      UINT16_TO_STREAM(p, handle);
+      handle_request(GATT_REQ_READ, pdu, sizeof(pdu));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * value_handles_.size());
+}
+
+// Read By Type Request for each characteristic UUID over the whole handle
+// range, as done by a client reading a characteristic by UUID.
+BENCHMARK_F(BM_GattServer, read_by_type)(State& state) {
+  for (auto _ : state) {
+    for (int i = 0; i < NUM_CHARACTERISTICS; i++) {
+      uint8_t pdu[6];
+      uint8_t* p = pdu;
+      UINT16_TO_STREAM(p, 0x0001);
+      UINT16_TO_STREAM(p, last_handle_);
+      UINT16_TO_STREAM(p, 0xA000 + i);
+      handle_request(GATT_REQ_READ_BY_TYPE, pdu, sizeof(pdu));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * NUM_CHARACTERISTICS);
+}
+
+// Characteristic discovery: Read By Type on the characteristic declaration
+// UUID, continuing from the last handle returned until the end of the
+// database.
+BENCHMARK_F(BM_GattServer, discover_characteristics)(State& state) {
+  int requests = 0;
+  for (auto _ : state) {
+    for (const tGATT_SRV_LIST_ELEM& el : *gatt_cb.srv_list_info) {
+      for (uint16_t handle = el.s_hdl; handle <= el.e_hdl; handle += 3) {
+        uint8_t pdu[6];
+        uint8_t* p = pdu;
+        UINT16_TO_STREAM(p, handle);
+        UINT16_TO_STREAM(p, el.e_hdl);
+        UINT16_TO_STREAM(p, GATT_UUID_CHAR_DECLARE);
+        handle_request(GATT_REQ_READ_BY_TYPE, pdu, sizeof(pdu));
+        requests++;
+      }
+    }
+  }
+  state.SetItemsProcessed(requests);
+}
+
+// Descriptor discovery: Find Information on the range of each characteristic.
+BENCHMARK_F(BM_GattServer, find_info)(State& state) {
+  for (auto _ : state) {
+    for (uint16_t handle : value_handles_) {
+      uint8_t pdu[4];
+      uint8_t* p = pdu;
+      UINT16_TO_STREAM(p, handle + 1);
+      UINT16_TO_STREAM(p, handle + 1);
+      handle_request(GATT_REQ_FIND_INFO, pdu, sizeof(pdu));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * value_handles_.size());
+}
+
+int main(int argc, char** argv) {
+  // Disable LOG() output from libchrome
+  logging::LoggingSettings log_settings;
+  log_settings.logging_dest = logging::LoggingDestination::LOG_NONE;
+  CHECK(logging::InitLogging(log_settings)) << "Failed to set up logging";
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <base/logging.h>
+#include <benchmark/benchmark.h>
+#include <vector>
+
+#include "stack/l2cap/l2c_fcs.h"
+
+using ::benchmark::State;
+
+// Frame sizes from a short S-frame up to a full 1021-byte ERTM I-frame.
+static void FrameSizes(::benchmark::internal::Benchmark* b) {
+  for (int size : {8, 64, 339, 1021}) b->Arg(size);
+}
+
+static std::vector<uint8_t> make_frame(size_t size) {
+  std::vector<uint8_t> frame(size);
+  for (size_t i = 0; i < size; i++) frame[i] = i * 31 + 7;
+  return frame;
+}
+
+static void BM_FcsBytewise(State& state) {
+  std::vector<uint8_t> frame = make_frame(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        l2c_fcs_crc16_bytewise(0, frame.data(), frame.size()));
+  }
+  state.SetBytesProcessed(state.iterations() * frame.size());
+}
+BENCHMARK(BM_FcsBytewise)->Apply(FrameSizes);
+
+static void BM_FcsSliceBy8(State& state) {
+  std::vector<uint8_t> frame = make_frame(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(l2c_fcs_crc16(0, frame.data(), frame.size()));
+  }
+  state.SetBytesProcessed(state.iterations() * frame.size());
+}
+BENCHMARK(BM_FcsSliceBy8)->Apply(FrameSizes);
+
+int main(int argc, char** argv) {
+  // Disable LOG() output from libchrome
+  logging::LoggingSettings log_settings;
+  log_settings.logging_dest = logging::LoggingDestination::LOG_NONE;
+  CHECK(logging::InitLogging(log_settings)) << "Failed to set up logging";
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
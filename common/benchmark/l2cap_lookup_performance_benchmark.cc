@@ -0,0 +1,226 @@
+/*
+ * Copyright 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <base/logging.h>
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+
+#include "bt_types.h"
+#include "btm_api.h"
+#include "btm_ble_api.h"
+#include "btm_int.h"
+#include "device/include/controller.h"
+#include "hci/include/btsnoop.h"
+#include "hcimsgs.h"
+#include "l2c_api.h"
+#include "l2c_int.h"
+#include "osi/include/allocator.h"
+
+using ::benchmark::State;
+
+#define NUM_LINKS 64
+#define CHANNELS_PER_LINK 2
+#define NUM_PACKETS 4096
+#define MAX_NOCP_HANDLES 4
+
+tL2C_CB l2cb;
+
+// Only the link and channel lookups of l2c_utils.cc are measured. Everything
+// the rest of the file calls is replaced.
+tBTM_SEC_DEV_REC* btm_find_dev(const RawAddress& bd_addr) { return NULL; }
+tBTM_INQ_INFO* BTM_InqDbRead(const RawAddress& p_bda) { return NULL; }
+tBTM_STATUS BTM_SwitchRole(const RawAddress& remote_bd_addr, uint8_t new_role,
+                           tBTM_CMPL_CB* p_cb) {
+  return BTM_SUCCESS;
+}
+void L2CA_FreeLePSM(uint16_t psm) {}
+void BTM_ReadDevInfo(const RawAddress& remote_bda, tBT_DEVICE_TYPE* p_dev_type,
+                     tBLE_ADDR_TYPE* p_addr_type) {}
+void btm_acl_removed(const RawAddress& bda, tBT_TRANSPORT transport) {}
+void l2c_csm_execute(tL2C_CCB* p_ccb, uint16_t event, void* p_data) {}
+void l2c_fcr_cleanup(tL2C_CCB* p_ccb) {}
+uint16_t BTM_GetNumAclLinks(void) { return NUM_LINKS; }
+tBTM_STATUS btm_sec_disconnect(uint16_t handle, uint8_t reason) {
+  return BTM_SUCCESS;
+}
+void btm_remove_sco_links(const RawAddress& bda) {}
+uint8_t* BTM_ReadLocalFeatures(void) { return NULL; }
+void btsnd_hcic_disconnect(uint16_t handle, uint8_t reason) {}
+const btsnoop_t* btsnoop_get_interface(void) { return NULL; }
+void l2c_lcb_timer_timeout(void* data) {}
+void btsnd_hcic_create_conn(const RawAddress& dest, uint16_t packet_types,
+                            uint8_t page_scan_rep_mode, uint8_t page_scan_mode,
+                            uint16_t clock_offset, uint8_t allow_switch) {}
+bool l2c_link_hci_disc_comp(uint16_t handle, uint8_t reason) { return true; }
+uint16_t btm_get_max_packet_size(const RawAddress& addr) { return 0; }
+const controller_t* controller_get_interface() { return NULL; }
+void l2c_link_check_send_pkts(tL2C_LCB* p_lcb, tL2C_CCB* p_ccb, BT_HDR* p_buf) {
+}
+void BTM_VendorSpecificCommand(uint16_t opcode, uint8_t param_len,
+                               uint8_t* p_param_buf, tBTM_VSC_CMPL_CB* p_cb) {}
+void btm_acl_update_busy_level(tBTM_BLI_EVENT event) {}
+uint8_t btm_sec_clr_service_by_psm(uint16_t psm) { return 0; }
+bool l2c_fcr_is_flow_controlled(tL2C_CCB* p_ccb) { return false; }
+void l2c_link_adjust_allocation(void) {}
+bool btm_is_sco_active_by_bdaddr(const RawAddress& remote_bda) {
+  return false;
+}
+void l2c_fcr_adj_our_rsp_options(tL2C_CCB* p_ccb, tL2CAP_CFG_INFO* p_cfg) {}
+void l2c_info_resp_timer_timeout(void* data) {}
+uint8_t l2c_fcr_process_peer_cfg_req(tL2C_CCB* p_ccb, tL2CAP_CFG_INFO* p_cfg) {
+  return 0;
+}
+void btm_sec_clr_temp_auth_service(const RawAddress& bda) {}
+BT_HDR* l2c_fcr_get_next_xmit_sdu_seg(tL2C_CCB* p_ccb,
+                                      uint16_t max_packet_length) {
+  return NULL;
+}
+BT_HDR* l2c_lcc_get_next_xmit_sdu_seg(tL2C_CCB* p_ccb,
+                                      uint16_t max_packet_length) {
+  return NULL;
+}
+void l2c_ble_link_adjust_allocation(void) {}
+bool l2cble_create_conn(tL2C_LCB* p_lcb) { return false; }
+void l2c_link_adjust_chnl_allocation(void) {}
+void btsnd_hcic_write_auto_flush_tout(uint16_t handle, uint16_t timeout) {}
+
+// One received ACL packet or one Number Of Completed Packets event.
+struct TraceEntry {
+  bool nocp;
+  uint8_t num_handles;
+  uint16_t handles[MAX_NOCP_HANDLES];
+  uint16_t cid;
+};
+
+class BM_L2capLookup : public ::benchmark::Fixture {
+ protected:
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+    memset(&l2cb, 0, sizeof(l2cb));
+    l2cb.max_links = NUM_LINKS;
+    l2cb.max_channels = NUM_LINKS * CHANNELS_PER_LINK;
+    l2cb.lcb_pool = static_cast<tL2C_LCB*>(
+        osi_calloc(l2cb.max_links * sizeof(tL2C_LCB)));
+    l2cb.ccb_pool = static_cast<tL2C_CCB*>(
+        osi_calloc(l2cb.max_channels * sizeof(tL2C_CCB)));
+    l2cb.lcb_by_handle =
+        static_cast<uint8_t*>(osi_calloc(HCI_DATA_HANDLE_MASK + 1));
+
+    // Controllers hand out handles sparsely; half of the links are LE.
+    std::mt19937 rng(1);
+    std::vector<uint16_t> handles;
+    for (int i = 0; i < NUM_LINKS; i++) {
+      tL2C_LCB* p_lcb = &l2cb.lcb_pool[i];
+      p_lcb->in_use = true;
+      p_lcb->handle = HCI_INVALID_HANDLE;
+      p_lcb->transport = (i & 1) ? BT_TRANSPORT_LE : BT_TRANSPORT_BR_EDR;
+      p_lcb->link_state = LST_CONNECTED;
+      uint16_t handle = 0x0001 + i * 0x20 + (rng() & 0x1f);
+      l2cu_set_lcb_handle(p_lcb, handle);
+      handles.push_back(handle);
+
+      for (int j = 0; j < CHANNELS_PER_LINK; j++) {
+        tL2C_CCB* p_ccb = &l2cb.ccb_pool[i * CHANNELS_PER_LINK + j];
+        p_ccb->in_use = true;
+        p_ccb->p_lcb = p_lcb;
+        p_ccb->local_cid =
+            L2CAP_BASE_APPL_CID + i * CHANNELS_PER_LINK + j;
+      }
+    }
+
+    // Mixed traffic: mostly data on the dynamic channels, some ATT and
+    // signalling on the fixed ones and a completed packets event for every
+    // four packets, naming one to four links.
+    trace_.clear();
+    for (int i = 0; i < NUM_PACKETS; i++) {
+      TraceEntry entry = {};
+      int link = rng() % NUM_LINKS;
+      if (i % 5 == 4) {
+        entry.nocp = true;
+        entry.num_handles = 1 + rng() % MAX_NOCP_HANDLES;
+        for (int j = 0; j < entry.num_handles; j++)
+          entry.handles[j] = handles[(link + j) % NUM_LINKS];
+      } else {
+        entry.num_handles = 1;
+        entry.handles[0] = handles[link];
+        if (rng() % 4 == 0)
+          entry.cid = (link & 1) ? L2CAP_ATT_CID : L2CAP_SIGNALLING_CID;
+        else
+          entry.cid = L2CAP_BASE_APPL_CID + link * CHANNELS_PER_LINK +
+                      rng() % CHANNELS_PER_LINK;
+      }
+      trace_.push_back(entry);
+    }
+  }
+
+  void TearDown(State& st) override {
+    osi_free_and_reset((void**)&l2cb.lcb_pool);
+    osi_free_and_reset((void**)&l2cb.ccb_pool);
+    osi_free_and_reset((void**)&l2cb.lcb_by_handle);
+    ::benchmark::Fixture::TearDown(st);
+  }
+
+  std::vector<TraceEntry> trace_;
+};
+
+// The lookups l2c_rcv_acl_data and l2c_link_process_num_completed_pkts make
+// for each entry of the trace.
+BENCHMARK_DEFINE_F(BM_L2capLookup, ReplayAclTraffic)(State& state) {
+  uint32_t completed = 0;
+  while (state.KeepRunning()) {
+    for (const TraceEntry& entry : trace_) {
+      if (entry.nocp) {
+        for (int i = 0; i < entry.num_handles; i++) {
+          tL2C_LCB* p_lcb = l2cu_find_lcb_by_handle(entry.handles[i]);
+          CHECK(p_lcb != NULL);
+          completed++;
+        }
+        continue;
+      }
+
+      tL2C_LCB* p_lcb = l2cu_find_lcb_by_handle(entry.handles[0]);
+      CHECK(p_lcb != NULL);
+      if (entry.cid >= L2CAP_BASE_APPL_CID)
+        CHECK(l2cu_find_ccb_by_cid(p_lcb, entry.cid) != NULL);
+    }
+  }
+  benchmark::DoNotOptimize(completed);
+  state.SetItemsProcessed(state.iterations() * trace_.size());
+}
+BENCHMARK_REGISTER_F(BM_L2capLookup, ReplayAclTraffic);
+
+// Packets for a handle that has no link, as seen for SCO and for data that
+// arrives ahead of its Connection Complete event.
+BENCHMARK_DEFINE_F(BM_L2capLookup, UnknownHandle)(State& state) {
+  while (state.KeepRunning()) {
+    CHECK(l2cu_find_lcb_by_handle(0x0eff) == NULL);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_REGISTER_F(BM_L2capLookup, UnknownHandle);
+
+int main(int argc, char** argv) {
+  // Disable LOG() output from libchrome
+  logging::LoggingSettings log_settings;
+  log_settings.logging_dest = logging::LoggingDestination::LOG_NONE;
+  CHECK(logging::InitLogging(log_settings)) << "Failed to set up logging";
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
@@ -0,0 +1,171 @@
+/*
+ * Copyright 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <base/logging.h>
+#include <benchmark/benchmark.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <vector>
+
+using ::benchmark::State;
+
+// The PAN data path moves Ethernet frames between the TAP driver and BNEP
+// buffers. A non-blocking SOCK_SEQPACKET socketpair stands in for the TAP
+// fd: like the driver, it returns one frame per read and takes one frame per
+// write. Buffers are freed once the Ethernet header is split off, as BNEP
+// does once a frame is sent.
+
+#define FRAME_SIZE 1514  // Full size Ethernet frame, header included
+#define ETH_HDR_SIZE 14
+#define FRAMES_PER_ITERATION 64
+#define BUF_HDR_SIZE 8        // sizeof(BT_HDR)
+#define BUF_OFFSET 30         // PAN_MINIMUM_OFFSET
+#define BUF_SIZE (4096 + 16)  // PAN_BUF_SIZE
+#define MAX_PKT_WRITE_LEN 2000
+
+class BM_PanTap : public ::benchmark::Fixture {
+ protected:
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+    CHECK(socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds_) == 0);
+    int size = 4 * FRAMES_PER_ITERATION * FRAME_SIZE;
+    setsockopt(fds_[0], SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+    setsockopt(fds_[1], SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    fcntl(fds_[1], F_SETFL, fcntl(fds_[1], F_GETFL, 0) | O_NONBLOCK);
+    frame_.assign(FRAME_SIZE, 0x5a);
+  }
+
+  void TearDown(State& st) override {
+    close(fds_[0]);
+    close(fds_[1]);
+    ::benchmark::Fixture::TearDown(st);
+  }
+
+  // Queues a burst of frames on the TAP stand-in.
+  void queue_frames() {
+    for (int i = 0; i < FRAMES_PER_ITERATION; i++)
+      CHECK(write(fds_[0], frame_.data(), FRAME_SIZE) == FRAME_SIZE);
+  }
+
+  // Hands the frame in |buf| to the stand-in for BNEP.
+  int forward(uint8_t* buf, uint16_t len) {
+    uint8_t hdr[ETH_HDR_SIZE];
+    memcpy(hdr, buf + BUF_HDR_SIZE + BUF_OFFSET, ETH_HDR_SIZE);
+    benchmark::DoNotOptimize(hdr);
+    free(buf);
+    return len - ETH_HDR_SIZE;
+  }
+
+  int fds_[2];
+  std::vector<uint8_t> frame_;
+};
+
+// Each frame is read into a staging packet, copied into a buffer, and the
+// fd is polled before reading the next one.
+BENCHMARK_F(BM_PanTap, tap_to_bnep_staged)(State& state) {
+  uint8_t congest_packet[1600];
+  for (auto _ : state) {
+    queue_frames();
+    for (int i = 0; i < FRAMES_PER_ITERATION; i++) {
+      uint8_t* buf = (uint8_t*)malloc(BUF_SIZE);
+      ssize_t ret = read(fds_[1], congest_packet, sizeof(congest_packet));
+      CHECK(ret == FRAME_SIZE);
+      memcpy(buf + BUF_HDR_SIZE + BUF_OFFSET, congest_packet, ret);
+      forward(buf, ret);
+
+      struct pollfd ufd = {fds_[1], POLLIN, 0};
+      if (poll(&ufd, 1, 0) <= 0) break;
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * FRAMES_PER_ITERATION *
+                          FRAME_SIZE);
+}
+
+// Each frame is read straight into its buffer, until the fd would block.
+BENCHMARK_F(BM_PanTap, tap_to_bnep_direct)(State& state) {
+  for (auto _ : state) {
+    queue_frames();
+    for (;;) {
+      uint8_t* buf = (uint8_t*)malloc(BUF_SIZE);
+      ssize_t ret = read(fds_[1], buf + BUF_HDR_SIZE + BUF_OFFSET,
+                         BUF_SIZE - BUF_HDR_SIZE - BUF_OFFSET);
+      if (ret <= 0) {
+        CHECK(errno == EAGAIN);
+        free(buf);
+        break;
+      }
+      forward(buf, ret);
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * FRAMES_PER_ITERATION *
+                          FRAME_SIZE);
+}
+
+// Each BNEP payload is copied behind its Ethernet header before the write.
+BENCHMARK_F(BM_PanTap, bnep_to_tap_copied)(State& state) {
+  uint8_t drain[FRAME_SIZE];
+  for (auto _ : state) {
+    for (int i = 0; i < FRAMES_PER_ITERATION; i++) {
+      char packet[MAX_PKT_WRITE_LEN + ETH_HDR_SIZE];
+      memcpy(packet, frame_.data(), ETH_HDR_SIZE);
+      memcpy(packet + ETH_HDR_SIZE, frame_.data() + ETH_HDR_SIZE,
+             FRAME_SIZE - ETH_HDR_SIZE);
+      CHECK(write(fds_[0], packet, FRAME_SIZE) == FRAME_SIZE);
+    }
+    for (int i = 0; i < FRAMES_PER_ITERATION; i++)
+      CHECK(read(fds_[1], drain, sizeof(drain)) == FRAME_SIZE);
+  }
+  state.SetBytesProcessed(state.iterations() * FRAMES_PER_ITERATION *
+                          FRAME_SIZE);
+}
+
+// The Ethernet header and the BNEP payload are gathered by the write.
+BENCHMARK_F(BM_PanTap, bnep_to_tap_gathered)(State& state) {
+  uint8_t drain[FRAME_SIZE];
+  for (auto _ : state) {
+    for (int i = 0; i < FRAMES_PER_ITERATION; i++) {
+      struct iovec iov[2];
+      iov[0].iov_base = frame_.data();
+      iov[0].iov_len = ETH_HDR_SIZE;
+      iov[1].iov_base = frame_.data() + ETH_HDR_SIZE;
+      iov[1].iov_len = FRAME_SIZE - ETH_HDR_SIZE;
+      CHECK(writev(fds_[0], iov, 2) == FRAME_SIZE);
+    }
+    for (int i = 0; i < FRAMES_PER_ITERATION; i++)
+      CHECK(read(fds_[1], drain, sizeof(drain)) == FRAME_SIZE);
+  }
+  state.SetBytesProcessed(state.iterations() * FRAMES_PER_ITERATION *
+                          FRAME_SIZE);
+}
+
+int main(int argc, char** argv) {
+  // Disable LOG() output from libchrome
+  logging::LoggingSettings log_settings;
+  log_settings.logging_dest = logging::LoggingDestination::LOG_NONE;
+  CHECK(logging::InitLogging(log_settings)) << "Failed to set up logging";
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
@@ -0,0 +1,149 @@
+/*
+ * Copyright 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <base/logging.h>
+#include <benchmark/benchmark.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <vector>
+
+using ::benchmark::State;
+
+// The RFCOMM socket data path moves data between the app's end of a local
+// socketpair and BT_HDR buffers of one RFCOMM frame each. These benchmarks
+// compare copying a frame per system call with moving a batch of frames per
+// readv()/writev(), over a loopback socketpair.
+
+// Default RFCOMM frame payload for an L2CAP MTU of 1000 bytes.
+#define FRAME_SIZE 990
+// Frames filled by PORT_WriteDataCO with one read (PORT_TX_CO_BATCH).
+#define TX_BATCH 8
+// Queued frames written to the app with one writev (MAX_RFC_WRITEV_BUFS).
+#define RX_BATCH 16
+
+class BM_RfcommSocket : public ::benchmark::Fixture {
+ protected:
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+    CHECK(socketpair(AF_LOCAL, SOCK_STREAM, 0, fds_) == 0);
+    int size = 4 * RX_BATCH * FRAME_SIZE;
+    setsockopt(fds_[0], SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+    setsockopt(fds_[1], SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    frames_.assign(RX_BATCH, std::vector<uint8_t>(FRAME_SIZE, 0x5a));
+    sink_.resize(RX_BATCH * FRAME_SIZE);
+  }
+
+  void TearDown(State& st) override {
+    close(fds_[0]);
+    close(fds_[1]);
+    ::benchmark::Fixture::TearDown(st);
+  }
+
+  // Writes |frames| frames to fds_[0], |batch| per system call, and drains
+  // them from fds_[1] in one go.
+  void write_frames(int frames, int batch) {
+    struct iovec iov[RX_BATCH];
+    for (int i = 0; i < frames; i += batch) {
+      int count = 0;
+      for (; count < batch && i + count < frames; count++) {
+        iov[count].iov_base = frames_[count].data();
+        iov[count].iov_len = FRAME_SIZE;
+      }
+      if (count == 1) {
+        CHECK(write(fds_[0], iov[0].iov_base, FRAME_SIZE) == FRAME_SIZE);
+      } else {
+        CHECK(writev(fds_[0], iov, count) == count * FRAME_SIZE);
+      }
+    }
+    drain(fds_[1], frames * FRAME_SIZE);
+  }
+
+  // Fills |frames| frames from fds_[1], |batch| per system call, after the
+  // data was written to fds_[0] in one go.
+  void read_frames(int frames, int batch) {
+    fill(fds_[0], frames * FRAME_SIZE);
+    struct iovec iov[RX_BATCH];
+    for (int i = 0; i < frames; i += batch) {
+      int count = 0;
+      for (; count < batch && i + count < frames; count++) {
+        iov[count].iov_base = frames_[count].data();
+        iov[count].iov_len = FRAME_SIZE;
+      }
+      if (count == 1) {
+        CHECK(read(fds_[1], iov[0].iov_base, FRAME_SIZE) == FRAME_SIZE);
+      } else {
+        CHECK(readv(fds_[1], iov, count) == count * FRAME_SIZE);
+      }
+    }
+  }
+
+  void drain(int fd, size_t len) {
+    while (len) {
+      ssize_t ret = read(fd, sink_.data(), std::min(len, sink_.size()));
+      CHECK(ret > 0);
+      len -= ret;
+    }
+  }
+
+  void fill(int fd, size_t len) {
+    while (len) {
+      ssize_t ret = write(fd, sink_.data(), std::min(len, sink_.size()));
+      CHECK(ret > 0);
+      len -= ret;
+    }
+  }
+
+  int fds_[2];
+  std::vector<std::vector<uint8_t>> frames_;
+  std::vector<uint8_t> sink_;
+};
+
+// Outgoing data: the app's bytes are read into TX_BATCH frames.
+BENCHMARK_F(BM_RfcommSocket, app_to_stack_read_per_frame)(State& state) {
+  for (auto _ : state) read_frames(TX_BATCH, 1);
+  state.SetBytesProcessed(state.iterations() * TX_BATCH * FRAME_SIZE);
+}
+
+BENCHMARK_F(BM_RfcommSocket, app_to_stack_readv)(State& state) {
+  for (auto _ : state) read_frames(TX_BATCH, TX_BATCH);
+  state.SetBytesProcessed(state.iterations() * TX_BATCH * FRAME_SIZE);
+}
+
+// Incoming data: RX_BATCH queued frames are written to the app.
+BENCHMARK_F(BM_RfcommSocket, stack_to_app_write_per_frame)(State& state) {
+  for (auto _ : state) write_frames(RX_BATCH, 1);
+  state.SetBytesProcessed(state.iterations() * RX_BATCH * FRAME_SIZE);
+}
+
+BENCHMARK_F(BM_RfcommSocket, stack_to_app_writev)(State& state) {
+  for (auto _ : state) write_frames(RX_BATCH, RX_BATCH);
+  state.SetBytesProcessed(state.iterations() * RX_BATCH * FRAME_SIZE);
+}
+
+int main(int argc, char** argv) {
+  // Disable LOG() output from libchrome
+  logging::LoggingSettings log_settings;
+  log_settings.logging_dest = logging::LoggingDestination::LOG_NONE;
+  CHECK(logging::InitLogging(log_settings)) << "Failed to set up logging";
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
@@ -0,0 +1,172 @@
+/*
+ * Copyright 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <base/logging.h>
+#include <benchmark/benchmark.h>
+#include <string.h>
+#include <random>
+#include <vector>
+
+#include "stack/btm/btm_ble_rpa_cache.h"
+#include "stack/crypto_toolbox/crypto_toolbox.h"
+
+using ::benchmark::State;
+
+#define NUM_IRKS 200
+#define NUM_IN_RANGE 40
+#define NUM_UNKNOWN 40
+#define NUM_REPORTS 2000
+
+namespace {
+
+std::vector<tBTM_SEC_DEV_REC> records;
+std::vector<RawAddress> trace;
+
+RawAddress make_rpa(const Octet16& irk, std::mt19937& rng) {
+  uint8_t prand[3] = {(uint8_t)rng(), (uint8_t)rng(),
+                      (uint8_t)((rng() & 0x3f) | 0x40)};
+  Octet16 hash = crypto_toolbox::aes_128(irk, prand, 3);
+
+  RawAddress rpa;
+  rpa.address[0] = prand[2];
+  rpa.address[1] = prand[1];
+  rpa.address[2] = prand[0];
+  rpa.address[3] = hash[2];
+  rpa.address[4] = hash[1];
+  rpa.address[5] = hash[0];
+  return rpa;
+}
+
+// Advertisements of the bonded devices in range and of as many unknown
+// devices, each advertising on its own private address.
+void generate_trace() {
+  std::mt19937 rng(1);
+  records.resize(NUM_IRKS);
+  for (tBTM_SEC_DEV_REC& rec : records) {
+    memset(&rec.ble, 0, sizeof(rec.ble));
+    for (uint8_t& b : rec.ble.keys.irk) b = rng();
+  }
+
+  std::vector<RawAddress> advertisers;
+  for (int i = 0; i < NUM_IN_RANGE; i++)
+    advertisers.push_back(
+        make_rpa(records[rng() % NUM_IRKS].ble.keys.irk, rng));
+  for (int i = 0; i < NUM_UNKNOWN; i++) {
+    Octet16 irk;
+    for (uint8_t& b : irk) b = rng();
+    advertisers.push_back(make_rpa(irk, rng));
+  }
+
+  for (int i = 0; i < NUM_REPORTS; i++)
+    trace.push_back(advertisers[rng() % advertisers.size()]);
+}
+
+bool rpa_matches_hash(const RawAddress& rpa, const Octet16& x) {
+  return x[0] == rpa.address[5] && x[1] == rpa.address[4] &&
+         x[2] == rpa.address[3];
+}
+
+// Expanding the IRK for every record tried, as before the key schedules.
+tBTM_SEC_DEV_REC* resolve_legacy(const RawAddress& rpa) {
+  uint8_t rand[3] = {rpa.address[2], rpa.address[1], rpa.address[0]};
+  for (tBTM_SEC_DEV_REC& rec : records) {
+    Octet16 x = crypto_toolbox::aes_128(rec.ble.keys.irk, rand, 3);
+    if (rpa_matches_hash(rpa, x)) return &rec;
+  }
+  return nullptr;
+}
+
+// The way rpa_matches_irk() does now.
+tBTM_SEC_DEV_REC* resolve_key_schedule(const RawAddress& rpa) {
+  uint8_t rand[3] = {rpa.address[2], rpa.address[1], rpa.address[0]};
+  for (tBTM_SEC_DEV_REC& rec : records) {
+    tBTM_SEC_BLE* p_ble = &rec.ble;
+    if (!p_ble->irk_ksch_valid || p_ble->irk_ksch_key != p_ble->keys.irk) {
+      crypto_toolbox::aes_128_set_key(p_ble->keys.irk, &p_ble->irk_ksch);
+      p_ble->irk_ksch_key = p_ble->keys.irk;
+      p_ble->irk_ksch_valid = true;
+    }
+    Octet16 x = crypto_toolbox::aes_128(p_ble->irk_ksch, rand, 3);
+    if (rpa_matches_hash(rpa, x)) return &rec;
+  }
+  return nullptr;
+}
+
+void report(State& state, size_t resolved) {
+  double reports = state.iterations() * trace.size();
+  state.SetItemsProcessed(reports);
+  state.counters["resolved"] = resolved / reports;
+}
+
+}  // namespace
+
+static void BM_ResolveLegacy(State& state) {
+  if (trace.empty()) generate_trace();
+
+  size_t resolved = 0;
+  while (state.KeepRunning()) {
+    for (const RawAddress& rpa : trace)
+      if (resolve_legacy(rpa)) resolved++;
+  }
+  report(state, resolved);
+}
+BENCHMARK(BM_ResolveLegacy);
+
+static void BM_ResolveKeySchedule(State& state) {
+  if (trace.empty()) generate_trace();
+
+  size_t resolved = 0;
+  while (state.KeepRunning()) {
+    for (const RawAddress& rpa : trace)
+      if (resolve_key_schedule(rpa)) resolved++;
+  }
+  report(state, resolved);
+}
+BENCHMARK(BM_ResolveKeySchedule);
+
+// With the cache in front, as btm_ble_resolve_random_addr() does, all
+// reports arriving within its lifetime.
+static void BM_ResolveCached(State& state) {
+  if (trace.empty()) generate_trace();
+
+  size_t resolved = 0;
+  uint64_t now_ms = 0;
+  while (state.KeepRunning()) {
+    RpaResolutionCache cache;
+    for (const RawAddress& rpa : trace) {
+      tBTM_SEC_DEV_REC* p_dev_rec = nullptr;
+      if (!cache.Get(rpa, now_ms, &p_dev_rec)) {
+        p_dev_rec = resolve_key_schedule(rpa);
+        cache.Put(rpa, now_ms, p_dev_rec);
+      }
+      if (p_dev_rec) resolved++;
+    }
+  }
+  report(state, resolved);
+}
+BENCHMARK(BM_ResolveCached);
+
+int main(int argc, char** argv) {
+  // Disable LOG() output from libchrome
+  logging::LoggingSettings log_settings;
+  log_settings.logging_dest = logging::LoggingDestination::LOG_NONE;
+  CHECK(logging::InitLogging(log_settings)) << "Failed to set up logging";
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
@@ -0,0 +1,174 @@
+/*
+ * Copyright 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <base/logging.h>
+#include <benchmark/benchmark.h>
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+#include "embdrv/sbc/decoder/include/oi_codec_sbc.h"
+#include "embdrv/sbc/encoder/include/sbc_encoder.h"
+
+using ::benchmark::State;
+
+// One second of 44.1 kHz audio is decoded per iteration.
+#define CORPUS_SAMPLES 44100
+#define MAX_FRAME_SIZE 512
+// Frames per media packet, as sent by most sources over a 2-DH5 link.
+#define FRAMES_PER_PACKET 5
+
+// Stereo PCM mixing two tones per channel with some noise, so that every
+// subband carries energy and the scale factors and bit allocation vary from
+// frame to frame as they would with music.
+static std::vector<int16_t> make_corpus() {
+  std::vector<int16_t> pcm(2 * CORPUS_SAMPLES);
+  uint32_t seed = 1;
+  for (int i = 0; i < CORPUS_SAMPLES; i++) {
+    double t = (double)i / 44100;
+    seed = seed * 1103515245 + 12345;
+    int noise = (int)((seed >> 16) & 0x7FF) - 0x400;
+    pcm[2 * i] = (int16_t)(9000 * sin(2 * M_PI * 440 * t) +
+                           5000 * sin(2 * M_PI * 5300 * t) + noise);
+    pcm[2 * i + 1] = (int16_t)(9000 * sin(2 * M_PI * 660 * t) +
+                               5000 * sin(2 * M_PI * 12100 * t) - noise);
+  }
+  return pcm;
+}
+
+class BM_SbcDecoder : public ::benchmark::Fixture {
+ protected:
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+    corpus_ = make_corpus();
+    pcm_.resize(FRAMES_PER_PACKET * SBC_MAX_SAMPLES_PER_FRAME *
+                SBC_MAX_CHANNELS);
+  }
+
+  // Encodes the corpus into |packets_|, FRAMES_PER_PACKET frames each, at
+  // |bit_rate| kbps.
+  void encode(int16_t channel_mode, int16_t subbands, int16_t blocks,
+              uint16_t bit_rate) {
+    SBC_ENC_PARAMS params;
+    memset(&params, 0, sizeof(params));
+    params.s16SamplingFreq = SBC_sf44100;
+    params.s16ChannelMode = channel_mode;
+    params.s16NumOfSubBands = subbands;
+    params.s16NumOfChannels = (channel_mode == SBC_MONO) ? 1 : 2;
+    params.s16NumOfBlocks = blocks;
+    params.s16AllocationMethod = SBC_LOUDNESS;
+    params.u16BitRate = bit_rate;
+    SBC_Encoder_Init(&params);
+
+    size_t frame_samples = subbands * blocks * params.s16NumOfChannels;
+    size_t num_frames = corpus_.size() / frame_samples;
+    int16_t* pcm = corpus_.data();
+    uint8_t output[MAX_FRAME_SIZE];
+    packets_.clear();
+    for (size_t i = 0; i < num_frames; i++) {
+      if (i % FRAMES_PER_PACKET == 0) packets_.emplace_back();
+      uint32_t len = SBC_Encode(&params, pcm, output);
+      packets_.back().insert(packets_.back().end(), output, output + len);
+      pcm += frame_samples;
+    }
+    num_frames_ = num_frames;
+  }
+
+  // Decodes every packet one frame at a time, into interleaved stereo as the
+  // A2DP sink does.
+  void decode_frames(State& state) {
+    for (auto _ : state) {
+      CHECK(OI_SUCCESS(OI_CODEC_SBC_DecoderReset(
+          &context_, context_data_, sizeof(context_data_), 2, 2, false)));
+      for (const auto& packet : packets_) {
+        const OI_BYTE* data = packet.data();
+        uint32_t bytes = packet.size();
+        int16_t* pcm = pcm_.data();
+        uint32_t avail = pcm_.size() * sizeof(int16_t);
+        while (bytes) {
+          uint32_t pcm_bytes = avail;
+          CHECK(OI_SUCCESS(OI_CODEC_SBC_DecodeFrame(&context_, &data, &bytes,
+                                                    pcm, &pcm_bytes)));
+          pcm += pcm_bytes / sizeof(int16_t);
+          avail -= pcm_bytes;
+        }
+        benchmark::DoNotOptimize(pcm_.data());
+      }
+    }
+    state.SetItemsProcessed(state.iterations() * num_frames_);
+  }
+
+  // Decodes every packet with a single OI_CODEC_SBC_DecodeFrames call.
+  void decode_packets(State& state) {
+    for (auto _ : state) {
+      CHECK(OI_SUCCESS(OI_CODEC_SBC_DecoderReset(
+          &context_, context_data_, sizeof(context_data_), 2, 2, false)));
+      for (const auto& packet : packets_) {
+        const OI_BYTE* data = packet.data();
+        uint32_t bytes = packet.size();
+        uint32_t pcm_bytes = pcm_.size() * sizeof(int16_t);
+        uint8_t decoded;
+        CHECK(OI_SUCCESS(OI_CODEC_SBC_DecodeFrames(
+            &context_, &data, &bytes, pcm_.data(), &pcm_bytes,
+            FRAMES_PER_PACKET, &decoded)));
+        benchmark::DoNotOptimize(pcm_.data());
+      }
+    }
+    state.SetItemsProcessed(state.iterations() * num_frames_);
+  }
+
+  std::vector<int16_t> corpus_;
+  std::vector<std::vector<uint8_t>> packets_;
+  size_t num_frames_ = 0;
+  std::vector<int16_t> pcm_;
+  OI_CODEC_SBC_DECODER_CONTEXT context_;
+  uint32_t context_data_[CODEC_DATA_WORDS(2, SBC_CODEC_FAST_FILTER_BUFFERS)];
+};
+
+// High quality joint stereo, as negotiated with most sources (328 kbps).
+BENCHMARK_F(BM_SbcDecoder, joint_stereo_8_subbands_per_frame)(State& state) {
+  encode(SBC_JOINT_STEREO, SUB_BANDS_8, SBC_BLOCK_3, 328);
+  decode_frames(state);
+}
+
+BENCHMARK_F(BM_SbcDecoder, joint_stereo_8_subbands_per_packet)(State& state) {
+  encode(SBC_JOINT_STEREO, SUB_BANDS_8, SBC_BLOCK_3, 328);
+  decode_packets(state);
+}
+
+// Mono with 8 subbands, at the bit rate of a mono headset.
+BENCHMARK_F(BM_SbcDecoder, mono_8_subbands_per_packet)(State& state) {
+  encode(SBC_MONO, SUB_BANDS_8, SBC_BLOCK_3, 128);
+  decode_packets(state);
+}
+
+// Mono with 4 subbands, the smallest configuration.
+BENCHMARK_F(BM_SbcDecoder, mono_4_subbands_per_packet)(State& state) {
+  encode(SBC_MONO, SUB_BANDS_4, SBC_BLOCK_1, 128);
+  decode_packets(state);
+}
+
+int main(int argc, char** argv) {
+  // Disable LOG() output from libchrome
+  logging::LoggingSettings log_settings;
+  log_settings.logging_dest = logging::LoggingDestination::LOG_NONE;
+  CHECK(logging::InitLogging(log_settings)) << "Failed to set up logging";
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <base/logging.h>
+#include <benchmark/benchmark.h>
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+#include "embdrv/sbc/encoder/include/sbc_encoder.h"
+
+using ::benchmark::State;
+
+// One second of 44.1 kHz audio is encoded per iteration.
+#define CORPUS_SAMPLES 44100
+#define MAX_FRAME_SIZE 512
+
+// Stereo PCM mixing two tones per channel with some noise, so that every
+// subband carries energy and the scale factors and bit allocation vary from
+// frame to frame as they would with music.
+static std::vector<int16_t> make_corpus() {
+  std::vector<int16_t> pcm(2 * CORPUS_SAMPLES);
+  uint32_t seed = 1;
+  for (int i = 0; i < CORPUS_SAMPLES; i++) {
+    double t = (double)i / 44100;
+    seed = seed * 1103515245 + 12345;
+    int noise = (int)((seed >> 16) & 0x7FF) - 0x400;
+    pcm[2 * i] = (int16_t)(9000 * sin(2 * M_PI * 440 * t) +
+                           5000 * sin(2 * M_PI * 5300 * t) + noise);
+    pcm[2 * i + 1] = (int16_t)(9000 * sin(2 * M_PI * 660 * t) +
+                               5000 * sin(2 * M_PI * 12100 * t) - noise);
+  }
+  return pcm;
+}
+
+class BM_SbcEncoder : public ::benchmark::Fixture {
+ protected:
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+    corpus_ = make_corpus();
+  }
+
+  // Encodes the corpus one frame at a time, as the A2DP SBC encoder does, at
+  // |bit_rate| kbps. SBC_Encoder_Init derives the bitpool from it.
+  void encode(State& state, int16_t channel_mode, int16_t subbands,
+              int16_t blocks, uint16_t bit_rate) {
+    SBC_ENC_PARAMS params;
+    memset(&params, 0, sizeof(params));
+    params.s16SamplingFreq = SBC_sf44100;
+    params.s16ChannelMode = channel_mode;
+    params.s16NumOfSubBands = subbands;
+    params.s16NumOfChannels = (channel_mode == SBC_MONO) ? 1 : 2;
+    params.s16NumOfBlocks = blocks;
+    params.s16AllocationMethod = SBC_LOUDNESS;
+    params.u16BitRate = bit_rate;
+    SBC_Encoder_Init(&params);
+
+    size_t frame_samples = subbands * blocks * params.s16NumOfChannels;
+    size_t num_frames = corpus_.size() / frame_samples;
+    uint8_t output[MAX_FRAME_SIZE];
+    for (auto _ : state) {
+      int16_t* pcm = corpus_.data();
+      for (size_t i = 0; i < num_frames; i++) {
+        benchmark::DoNotOptimize(SBC_Encode(&params, pcm, output));
+        pcm += frame_samples;
+      }
+    }
+    state.SetItemsProcessed(state.iterations() * num_frames);
+  }
+
+  std::vector<int16_t> corpus_;
+};
+
+// High quality joint stereo, as negotiated with most headsets (328 kbps).
+BENCHMARK_F(BM_SbcEncoder, joint_stereo_8_subbands)(State& state) {
+  encode(state, SBC_JOINT_STEREO, SUB_BANDS_8, SBC_BLOCK_3, 328);
+}
+
+// Dual channel, as used by some TWS earbuds.
+BENCHMARK_F(BM_SbcEncoder, dual_channel_8_subbands)(State& state) {
+  encode(state, SBC_DUAL, SUB_BANDS_8, SBC_BLOCK_3, 328);
+}
+
+// Mono with 4 subbands, the smallest configuration.
+BENCHMARK_F(BM_SbcEncoder, mono_4_subbands)(State& state) {
+  encode(state, SBC_MONO, SUB_BANDS_4, SBC_BLOCK_1, 128);
+}
+
+int main(int argc, char** argv) {
+  // Disable LOG() output from libchrome
+  logging::LoggingSettings log_settings;
+  log_settings.logging_dest = logging::LoggingDestination::LOG_NONE;
+  CHECK(logging::InitLogging(log_settings)) << "Failed to set up logging";
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <base/logging.h>
+#include <benchmark/benchmark.h>
+#include <string.h>
+#include <random>
+
+#include "stack/smp/p_256_ecc_pp.h"
+
+using ::benchmark::State;
+
+namespace {
+
+// The two point multiplications of LE Secure Connections pairing: the local
+// public key from the private key, and the DHKey from the peer public key.
+struct PairingKeys {
+  uint32_t private_key[KEY_LENGTH_DWORDS_P256];
+  Point peer_public_key;
+};
+
+PairingKeys generate_keys() {
+  std::mt19937 rng(1);
+  PairingKeys keys;
+  uint32_t peer_private_key[KEY_LENGTH_DWORDS_P256];
+  for (int i = 0; i < KEY_LENGTH_DWORDS_P256; i++) {
+    keys.private_key[i] = rng();
+    peer_private_key[i] = rng();
+  }
+
+  p_256_init_curve(KEY_LENGTH_DWORDS_P256);
+  ECC_PointMult_Base(&keys.peer_public_key, peer_private_key);
+  return keys;
+}
+
+}  // namespace
+
+static void BM_PublicKeyBinNaf(State& state) {
+  PairingKeys keys = generate_keys();
+  Point q;
+  while (state.KeepRunning()) {
+    uint32_t n[KEY_LENGTH_DWORDS_P256];
+    memcpy(n, keys.private_key, sizeof(n));
+    ECC_PointMult_Bin_NAF(&q, &curve_p256.G, n, KEY_LENGTH_DWORDS_P256);
+    benchmark::DoNotOptimize(q);
+  }
+}
+BENCHMARK(BM_PublicKeyBinNaf);
+
+static void BM_PublicKeyBase(State& state) {
+  PairingKeys keys = generate_keys();
+  Point q;
+  while (state.KeepRunning()) {
+    ECC_PointMult_Base(&q, keys.private_key);
+    benchmark::DoNotOptimize(q);
+  }
+}
+BENCHMARK(BM_PublicKeyBase);
+
+static void BM_DhKeyBinNaf(State& state) {
+  PairingKeys keys = generate_keys();
+  Point q;
+  while (state.KeepRunning()) {
+    uint32_t n[KEY_LENGTH_DWORDS_P256];
+    memcpy(n, keys.private_key, sizeof(n));
+    Point p = keys.peer_public_key;
+    ECC_PointMult_Bin_NAF(&q, &p, n, KEY_LENGTH_DWORDS_P256);
+    benchmark::DoNotOptimize(q);
+  }
+}
+BENCHMARK(BM_DhKeyBinNaf);
+
+static void BM_DhKeyWindow(State& state) {
+  PairingKeys keys = generate_keys();
+  Point q;
+  while (state.KeepRunning()) {
+    ECC_PointMult_Window(&q, &keys.peer_public_key, keys.private_key);
+    benchmark::DoNotOptimize(q);
+  }
+}
+BENCHMARK(BM_DhKeyWindow);
+
+int main(int argc, char** argv) {
+  // Disable LOG() output from libchrome
+  logging::LoggingSettings log_settings;
+  log_settings.logging_dest = logging::LoggingDestination::LOG_NONE;
+  CHECK(logging::InitLogging(log_settings)) << "Failed to set up logging";
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
@@ -32,6 +32,7 @@ using bluetooth::common::ExecutionBarrier;
 using bluetooth::common::MessageLoopThread;
 
 #define NUM_MESSAGES_TO_SEND 100000
+#define RING_QUEUE_CAPACITY 1024
 
 volatile static int g_counter = 0;
 static std::unique_ptr<ExecutionBarrier> g_counter_barrier = nullptr;
@@ -308,6 +309,71 @@ BENCHMARK_F(BM_OsiReactorThread, sequential_execution_using_reactor)
   }
 };
 
+// Same as BM_OsiReactorThread, but with the message queue backed by the
+// lock-free ring instead of the locked list, for a side-by-side comparison.
+class BM_OsiReactorThreadRingQueue : public BM_OsiReactorThread {
+ protected:
+  void SetUp(State& st) override {
+    BM_OsiReactorThread::SetUp(st);
+    fixed_queue_free(bt_msg_queue_, nullptr);
+    bt_msg_queue_ = fixed_queue_new_ring(RING_QUEUE_CAPACITY);
+  }
+};
+
+BENCHMARK_F(BM_OsiReactorThreadRingQueue, batch_enque_dequeue_using_reactor)
+(State& state) {
+  fixed_queue_register_dequeue(bt_msg_queue_, thread_get_reactor(thread_),
+                               callback_batch, nullptr);
+  for (auto _ : state) {
+    g_counter = 0;
+    g_counter_barrier = std::make_unique<ExecutionBarrier>();
+    for (int i = 0; i < NUM_MESSAGES_TO_SEND; i++) {
+      fixed_queue_enqueue(bt_msg_queue_, (void*)&g_counter);
+    }
+    g_counter_barrier->WaitForExecution();
+  }
+};
+
+BENCHMARK_F(BM_OsiReactorThreadRingQueue, sequential_execution_using_reactor)
+(State& state) {
+  fixed_queue_register_dequeue(bt_msg_queue_, thread_get_reactor(thread_),
+                               callback_sequential_queue, nullptr);
+  for (auto _ : state) {
+    for (int i = 0; i < NUM_MESSAGES_TO_SEND; i++) {
+      g_counter_barrier = std::make_unique<ExecutionBarrier>();
+      fixed_queue_enqueue(bt_msg_queue_, (void*)&g_counter);
+      g_counter_barrier->WaitForExecution();
+    }
+  }
+};
+
+// Per-message cost of the queue itself, without any thread hop.
+static void BM_FixedQueueEnqueueDequeue(State& state, fixed_queue_t* queue) {
+  void* batch[RING_QUEUE_CAPACITY];
+  for (auto _ : state) {
+    for (int i = 0; i < RING_QUEUE_CAPACITY; i++) {
+      fixed_queue_enqueue(queue, (void*)&g_counter);
+    }
+    if (state.range(0)) {
+      fixed_queue_dequeue_all(queue, batch, RING_QUEUE_CAPACITY);
+    } else {
+      for (int i = 0; i < RING_QUEUE_CAPACITY; i++) fixed_queue_dequeue(queue);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * RING_QUEUE_CAPACITY);
+  fixed_queue_free(queue, nullptr);
+}
+
+static void BM_FixedQueueList(State& state) {
+  BM_FixedQueueEnqueueDequeue(state, fixed_queue_new(SIZE_MAX));
+}
+BENCHMARK(BM_FixedQueueList)->Arg(0)->Arg(1);
+
+static void BM_FixedQueueRing(State& state) {
+  BM_FixedQueueEnqueueDequeue(state, fixed_queue_new_ring(RING_QUEUE_CAPACITY));
+}
+BENCHMARK(BM_FixedQueueRing)->Arg(0)->Arg(1);
+
 class BM_MessageLooopThread : public BM_ThreadPerformance {
  protected:
   void SetUp(State& st) override {
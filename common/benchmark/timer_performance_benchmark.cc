@@ -0,0 +1,139 @@
+/*
+ * Copyright 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <base/logging.h>
+#include <base/message_loop/message_loop.h>
+#include <benchmark/benchmark.h>
+#include <hardware/bluetooth.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/execution_barrier.h"
+#include "osi/include/alarm.h"
+#include "osi/include/wakelock.h"
+
+using ::benchmark::State;
+using bluetooth::common::ExecutionBarrier;
+
+#define NUM_ALARMS 10000
+#define MAX_ALARM_INTERVAL_MS 3600000
+
+// None of the alarms below are dispatched on a message loop.
+base::MessageLoop* get_message_loop() { return nullptr; }
+
+// Short alarms hold a wakelock; make it a no-op so this runs on a host.
+static int acquire_wake_lock_cb(const char* lock_name) {
+  return BT_STATUS_SUCCESS;
+}
+static int release_wake_lock_cb(const char* lock_name) {
+  return BT_STATUS_SUCCESS;
+}
+static bt_os_callouts_t g_wakelock_callouts = {
+    sizeof(bt_os_callouts_t), NULL, acquire_wake_lock_cb, release_wake_lock_cb};
+
+static std::atomic<int> g_expired_count(0);
+static std::unique_ptr<ExecutionBarrier> g_expired_barrier = nullptr;
+
+static void never_called_cb(void* data) { CHECK(false) << "alarm expired"; }
+
+static void counting_cb(void* data) {
+  if (++g_expired_count == NUM_ALARMS) g_expired_barrier->NotifyFinished();
+}
+
+class BM_Alarm : public ::benchmark::Fixture {
+ protected:
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+    for (int i = 0; i < NUM_ALARMS; i++) {
+      alarms_.push_back(
+          alarm_new(("timer_performance_benchmark." + std::to_string(i))
+                        .c_str()));
+    }
+  }
+
+  void TearDown(State& st) override {
+    for (alarm_t* alarm : alarms_) alarm_free(alarm);
+    alarms_.clear();
+    alarm_cleanup();
+    ::benchmark::Fixture::TearDown(st);
+  }
+
+  // Deadlines spread over an hour so every level of the timer wheel is used.
+  static period_ms_t interval_for(int i) {
+    return 1000 + ((period_ms_t)i * 7919) % MAX_ALARM_INTERVAL_MS;
+  }
+
+  std::vector<alarm_t*> alarms_;
+};
+
+// Arms all alarms, then cancels them in a different order.
+BENCHMARK_F(BM_Alarm, arm_cancel)(State& state) {
+  for (auto _ : state) {
+    for (int i = 0; i < NUM_ALARMS; i++) {
+      alarm_set(alarms_[i], interval_for(i), never_called_cb, nullptr);
+    }
+    for (int i = 0; i < NUM_ALARMS; i++) {
+      alarm_cancel(alarms_[(i * 7) % NUM_ALARMS]);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * NUM_ALARMS * 2);
+};
+
+// Re-arms every alarm while all of them are pending, as protocol timers
+// restarted on each received packet do.
+BENCHMARK_F(BM_Alarm, rearm_pending)(State& state) {
+  for (int i = 0; i < NUM_ALARMS; i++) {
+    alarm_set(alarms_[i], interval_for(i), never_called_cb, nullptr);
+  }
+  for (auto _ : state) {
+    for (int i = 0; i < NUM_ALARMS; i++) {
+      alarm_set(alarms_[i], interval_for(NUM_ALARMS - i), never_called_cb,
+                nullptr);
+    }
+  }
+  for (alarm_t* alarm : alarms_) alarm_cancel(alarm);
+  state.SetItemsProcessed(state.iterations() * NUM_ALARMS);
+};
+
+// Arms all alarms within a few milliseconds of each other and waits for every
+// callback, measuring the expiry dispatch path.
+BENCHMARK_F(BM_Alarm, expire_all)(State& state) {
+  for (auto _ : state) {
+    g_expired_count = 0;
+    g_expired_barrier = std::make_unique<ExecutionBarrier>();
+    for (int i = 0; i < NUM_ALARMS; i++) {
+      alarm_set(alarms_[i], 10 + (i % 8), counting_cb, nullptr);
+    }
+    g_expired_barrier->WaitForExecution();
+  }
+  g_expired_barrier.reset(nullptr);
+  state.SetItemsProcessed(state.iterations() * NUM_ALARMS);
+};
+
+int main(int argc, char** argv) {
+  // Disable LOG() output from libchrome
+  logging::LoggingSettings log_settings;
+  log_settings.logging_dest = logging::LoggingDestination::LOG_NONE;
+  CHECK(logging::InitLogging(log_settings)) << "Failed to set up logging";
+  wakelock_set_os_callouts(&g_wakelock_callouts);
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
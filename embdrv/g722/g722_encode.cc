@@ -42,6 +42,22 @@
 #define PACKED_OUTPUT   (0)
 #define BITS_PER_SAMPLE (8)
 
+/* Run the transmit QMF, and the ADPCM of the two channels of
+   g722_encode_stereo(), on the vector unit through the compiler's generic
+   vectors. The output is bit-exact with the scalar code. */
+#if !defined(G722_SIMD_ENCODE)
+#if defined(__GNUC__)
+#define G722_SIMD_ENCODE (1)
+#else
+#define G722_SIMD_ENCODE (0)
+#endif
+#endif
+
+/* Sample pairs run through the QMF at once */
+#define QMF_CHUNK       (64)
+/* Sample pairs per QMF vector */
+#define QMF_LANES       (4)
+
 #ifndef BUILD_FEATURE_G722_USE_INTRINSIC_SAT
 static __inline int16_t saturate(int32_t amp)
 {
@@ -268,171 +284,558 @@ static int16_t ihp[3] = {0, 3, 2};
 static int16_t wh[3] = {0, -214, 798};
 static int16_t rh2[4] = {2, 1, 2, 1};
 
-int g722_encode(g722_encode_state_t *s, uint8_t g722_data[],
-                       const int16_t amp[], int len)
+/* Blocks 1L to 3L, from the low band error signal to the next step size.
+   Returns the low band code, and its inverse quantized value in *dlow. */
+static __inline int quantl(g722_band_t *band, int el, int *dlow)
 {
-    int dlow;
-    int dhigh;
-    int el;
     int wd;
     int wd1;
-    int ril;
     int wd2;
+    int wd3;
+    int ril;
     int il4;
-    int ih2;
+    int i;
+
+    /* Block 1L, QUANTL */
+    wd = (el >= 0)  ?  el  :  -(el + 1);
+
+    /* The decision levels grow with i, so i is found by binary search.
+       There is no level past q6[29]. */
+    i = 1;
+    if (wd >= ((q6[16]*band->det) >> 12))
+        i += 16;
+    if (wd >= ((q6[i + 7]*band->det) >> 12))
+        i += 8;
+    if (wd >= ((q6[i + 3]*band->det) >> 12))
+        i += 4;
+    if (i < 29  &&  wd >= ((q6[i + 1]*band->det) >> 12))
+        i += 2;
+    if (wd >= ((q6[i]*band->det) >> 12))
+        i += 1;
+    i = (el < 0)  ?  iln[i]  :  ilp[i];
+
+    /* Block 2L, INVQAL */
+    ril = i >> 2;
+    wd2 = qm4[ril];
+    *dlow = (band->det*wd2) >> 15;
+
+    /* Block 3L, LOGSCL */
+    il4 = rl42[ril];
+    wd = (band->nb*127) >> 7;
+    band->nb = wd + wl[il4];
+    if (band->nb < 0)
+        band->nb = 0;
+    else if (band->nb > 18432)
+        band->nb = 18432;
+
+    /* Block 3L, SCALEL */
+    wd1 = (band->nb >> 6) & 31;
+    wd2 = 8 - (band->nb >> 11);
+    wd3 = (wd2 < 0)  ?  (ilb[wd1] << -wd2)  :  (ilb[wd1] >> wd2);
+    band->det = wd3 << 2;
+    return i;
+}
+/*- End of function --------------------------------------------------------*/
+
+/* Blocks 1H to 3H, from the high band error signal to the next step size.
+   Returns the high band code, and its inverse quantized value in *dhigh. */
+static __inline int quanth(g722_band_t *band, int eh, int *dhigh)
+{
+    int wd;
+    int wd1;
+    int wd2;
     int wd3;
-    int eh;
     int mih;
+    int ih2;
+    int ihigh;
+    int nb;
+
+    /* Block 1H, QUANTH */
+    wd = (eh >= 0)  ?  eh  :  -(eh + 1);
+    wd1 = (564*band->det) >> 12;
+    mih = (wd >= wd1)  ?  2  :  1;
+    ihigh = (eh < 0)  ?  ihn[mih]  :  ihp[mih];
+
+    /* Block 2H, INVQAH */
+    wd2 = qm2[ihigh];
+    *dhigh = (band->det*wd2) >> 15;
+
+    /* Block 3H, LOGSCH */
+    ih2 = rh2[ihigh];
+    wd = (band->nb*127) >> 7;
+
+    nb = wd + wh[ih2];
+    if (nb < 0)
+        nb = 0;
+    else if (nb > 22528)
+        nb = 22528;
+    band->nb = nb;
+
+    /* Block 3H, SCALEH */
+    wd1 = (band->nb >> 6) & 31;
+    wd2 = 10 - (band->nb >> 11);
+    wd3 = (wd2 < 0)  ?  (ilb[wd1] << -wd2)  :  (ilb[wd1] >> wd2);
+    band->det = wd3 << 2;
+    return ihigh;
+}
+/*- End of function --------------------------------------------------------*/
+
+static __inline int put_code(g722_encode_state_t *s, uint8_t g722_data[],
+                             int g722_bytes, int ilow, int ihigh)
+{
+    int code;
+
+#if   BITS_PER_SAMPLE == 8
+    code = ((ihigh << 6) | ilow);
+#elif BITS_PER_SAMPLE == 7
+    code = ((ihigh << 6) | ilow) >> 1;
+#elif BITS_PER_SAMPLE == 6
+    code = ((ihigh << 6) | ilow) >> 2;
+#endif
+
+#if PACKED_OUTPUT == 1
+    /* Pack the code bits */
+    s->out_buffer |= (code << s->out_bits);
+    s->out_bits += s->bits_per_sample;
+    if (s->out_bits >= 8)
+    {
+        g722_data[g722_bytes++] = (uint8_t) (s->out_buffer & 0xFF);
+        s->out_bits -= 8;
+        s->out_buffer >>= 8;
+    }
+#else
+    g722_data[g722_bytes++] = (uint8_t) code;
+#endif
+    return g722_bytes;
+}
+/*- End of function --------------------------------------------------------*/
+
+/* The QMF history of |s| and a chunk of |amp|, split into even and odd
+   samples so that consecutive outputs read consecutive samples */
+typedef struct
+{
+    int even[12 + QMF_CHUNK + QMF_LANES];
+    int odd[12 + QMF_CHUNK + QMF_LANES];
+    int xlow[QMF_CHUNK + QMF_LANES];
+    int xhigh[QMF_CHUNK + QMF_LANES];
+} g722_qmf_t;
+
+#if G722_SIMD_ENCODE
+typedef int32_t g722_v4si __attribute__((vector_size(16)));
+#endif
+
+static void qmf_load(g722_qmf_t *q, const g722_encode_state_t *s)
+{
+    int i;
+
+    for (i = 0;  i < 12;  i++)
+    {
+        q->even[i] = s->x[2*i];
+        q->odd[i] = s->x[2*i + 1];
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+/* Applies the transmit QMF to the next |pairs| sample pairs of |amp|, into
+   q->xlow and q->xhigh */
+static void qmf_apply(g722_qmf_t *q, const int16_t amp[], int pairs)
+{
     int i;
+    int k;
+
+    for (i = 0;  i < pairs;  i++)
+    {
+        q->even[12 + i] = amp[2*i];
+        q->odd[12 + i] = amp[2*i + 1];
+    }
+    /* The last vector may run past the chunk */
+    memset(q->even + 12 + pairs, 0, QMF_LANES*sizeof(int));
+    memset(q->odd + 12 + pairs, 0, QMF_LANES*sizeof(int));
+
+    /* Discard every other QMF output. Output k is the one the scalar code
+       computes once x[22] and x[23] hold even[12 + k] and odd[12 + k]. */
+    for (k = 0;  k < pairs;  k += QMF_LANES)
+    {
+#if G722_SIMD_ENCODE
+        g722_v4si sumeven = {0, 0, 0, 0};
+        g722_v4si sumodd = {0, 0, 0, 0};
+        g722_v4si even;
+        g722_v4si odd;
+
+        for (i = 0;  i < 12;  i++)
+        {
+            memcpy(&even, q->even + k + 1 + i, sizeof(even));
+            memcpy(&odd, q->odd + k + 1 + i, sizeof(odd));
+            sumodd += even*qmf_coeffs[i];
+            sumeven += odd*qmf_coeffs[11 - i];
+        }
+        /* We shift by 12 to allow for the QMF filters (DC gain = 4096), plus 1
+           to allow for us summing two filters, plus 1 to allow for the 15 bit
+           input to the G.722 algorithm. */
+        even = (sumeven + sumodd) >> 14;
+        odd = (sumeven - sumodd) >> 14;
+        memcpy(q->xlow + k, &even, sizeof(even));
+        memcpy(q->xhigh + k, &odd, sizeof(odd));
+#else
+        int l;
+
+        for (l = 0;  l < QMF_LANES;  l++)
+        {
+            int sumeven = 0;
+            int sumodd = 0;
+
+            for (i = 0;  i < 12;  i++)
+            {
+                sumodd += q->even[k + l + 1 + i]*qmf_coeffs[i];
+                sumeven += q->odd[k + l + 1 + i]*qmf_coeffs[11 - i];
+            }
+            q->xlow[k + l] = (sumeven + sumodd) >> 14;
+            q->xhigh[k + l] = (sumeven - sumodd) >> 14;
+        }
+#endif
+    }
+
+#ifdef RUN_LIKE_REFERENCE_G722
+    /* The following lines are only used to verify bit-exactness
+     * with reference implementation of G.722. Higher precision
+     * is achieved without limiting the values.
+     */
+    for (k = 0;  k < pairs;  k++)
+    {
+        q->xlow[k] = limitValues(q->xlow[k]);
+        q->xhigh[k] = limitValues(q->xhigh[k]);
+    }
+#endif
+
+    /* Shuffle the history down */
+    memmove(q->even, q->even + pairs, 12*sizeof(int));
+    memmove(q->odd, q->odd + pairs, 12*sizeof(int));
+}
+/*- End of function --------------------------------------------------------*/
+
+static void qmf_store(const g722_qmf_t *q, g722_encode_state_t *s)
+{
+    int i;
+
+    for (i = 0;  i < 12;  i++)
+    {
+        s->x[2*i] = q->even[i];
+        s->x[2*i + 1] = q->odd[i];
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+int g722_encode(g722_encode_state_t *s, uint8_t g722_data[],
+                       const int16_t amp[], int len)
+{
+    int dlow;
+    int dhigh;
+    int el;
+    int eh;
     int j;
+    int k;
+    int n;
     /* Low and high band PCM from the QMF */
     int xlow;
     int xhigh;
     int g722_bytes;
-    /* Even and odd tap accumulators */
-    int sumeven;
-    int sumodd;
     int ihigh;
     int ilow;
-    int code;
+    g722_qmf_t qmf;
 
     g722_bytes = 0;
-    xhigh = 0;
-    for (j = 0;  j < len;  )
+    if (s->itu_test_mode)
     {
-        if (s->itu_test_mode)
+        for (j = 0;  j < len;  j++)
         {
             xlow =
-            xhigh = amp[j++] >> 1;
+            xhigh = amp[j] >> 1;
+
+            /* Block 1L, SUBTRA */
+            el = saturate(xlow - s->band[0].s);
+            ilow = quantl(&s->band[0], el, &dlow);
+            block4(&s->band[0], dlow);
+
+            /* Block 1H, SUBTRA */
+            eh = saturate(xhigh - s->band[1].s);
+            ihigh = quanth(&s->band[1], eh, &dhigh);
+            block4(&s->band[1], dhigh);
+
+            g722_bytes = put_code(s, g722_data, g722_bytes, ilow, ihigh);
         }
-        else
+        return g722_bytes;
+    }
+
+    /* The QMF takes samples by pairs: a trailing odd sample is dropped. */
+    qmf_load(&qmf, s);
+    for (j = 0;  j + 1 < len;  j += 2*n)
+    {
+        n = (len - j)/2;
+        if (n > QMF_CHUNK)
+            n = QMF_CHUNK;
+        qmf_apply(&qmf, amp + j, n);
+
+        for (k = 0;  k < n;  k++)
         {
-            {
-                /* Apply the transmit QMF */
-                /* Shuffle the buffer down */
-                for (i = 0;  i < 22;  i++)
-                    s->x[i] = s->x[i + 2];
-                //TODO: if len is odd, then this can be a buffer overrun
-                s->x[22] = amp[j++];
-                s->x[23] = amp[j++];
-
-                /* Discard every other QMF output */
-                sumeven = 0;
-                sumodd = 0;
-                for (i = 0;  i < 12;  i++)
-                {
-                    sumodd += s->x[2*i]*qmf_coeffs[i];
-                    sumeven += s->x[2*i + 1]*qmf_coeffs[11 - i];
-                }
-                /* We shift by 12 to allow for the QMF filters (DC gain = 4096), plus 1
-                   to allow for us summing two filters, plus 1 to allow for the 15 bit
-                   input to the G.722 algorithm. */
-                xlow = (sumeven + sumodd) >> 14;
-                xhigh = (sumeven - sumodd) >> 14;
+            /* Block 1L, SUBTRA */
+            el = saturate(qmf.xlow[k] - s->band[0].s);
+            ilow = quantl(&s->band[0], el, &dlow);
+            block4(&s->band[0], dlow);
 
-#ifdef RUN_LIKE_REFERENCE_G722
-                /* The following lines are only used to verify bit-exactness
-                 * with reference implementation of G.722. Higher precision
-                 * is achieved without limiting the values.
-                 */
-                xlow = limitValues(xlow);
-                xhigh = limitValues(xhigh);
-#endif
-            }
+            /* Block 1H, SUBTRA */
+            eh = saturate(qmf.xhigh[k] - s->band[1].s);
+            ihigh = quanth(&s->band[1], eh, &dhigh);
+            block4(&s->band[1], dhigh);
+
+            g722_bytes = put_code(s, g722_data, g722_bytes, ilow, ihigh);
         }
-        /* Block 1L, SUBTRA */
-        el = saturate(xlow - s->band[0].s);
+    }
+    qmf_store(&qmf, s);
+    return g722_bytes;
+}
+/*- End of function --------------------------------------------------------*/
+
+#if G722_SIMD_ENCODE
+/* g722_encode_stereo() runs the low and high bands of both channels side by
+   side, one per vector lane: lanes 0 and 1 are the bands of the left
+   channel, lanes 2 and 3 those of the right one. The quantizers and step
+   size adaptation stay scalar, as they look up tables; block 4 runs on the
+   vectors. */
+#define BAND_LANES      (4)
+
+/* The block 4 state of g722_band_t, one band per lane */
+typedef struct
+{
+    g722_v4si s;
+    g722_v4si sp;
+    g722_v4si sz;
+    g722_v4si r[3];
+    g722_v4si a[3];
+    g722_v4si ap[3];
+    g722_v4si p[3];
+    g722_v4si d[7];
+    g722_v4si b[7];
+    g722_v4si bp[7];
+} g722_bands_t;
+
+/* Lane-wise select, minimum and maximum */
+#define V_SELECT(m, a, b) (((a) & (m)) | ((b) & ~(m)))
+#define V_MIN(a, b) V_SELECT((a) < (b), (a), (b))
+#define V_MAX(a, b) V_SELECT((a) > (b), (a), (b))
+
+static __inline g722_v4si saturate_v(g722_v4si amp)
+{
+    return V_MIN(V_MAX(amp, -32768), 32767);
+}
+/*- End of function --------------------------------------------------------*/
 
-        /* Block 1L, QUANTL */
-        wd = (el >= 0)  ?  el  :  -(el + 1);
+static void bands_load(g722_bands_t *v, g722_band_t *const band[BAND_LANES])
+{
+    int l;
+    int i;
 
-        for (i = 1;  i < 30;  i++)
+    for (l = 0;  l < BAND_LANES;  l++)
+    {
+        v->s[l] = band[l]->s;
+        v->sp[l] = band[l]->sp;
+        v->sz[l] = band[l]->sz;
+        for (i = 0;  i < 3;  i++)
         {
-            wd1 = (q6[i]*s->band[0].det) >> 12;
-            if (wd < wd1)
-                break;
+            v->r[i][l] = band[l]->r[i];
+            v->a[i][l] = band[l]->a[i];
+            v->ap[i][l] = band[l]->ap[i];
+            v->p[i][l] = band[l]->p[i];
         }
-        ilow = (el < 0)  ?  iln[i]  :  ilp[i];
-
-        /* Block 2L, INVQAL */
-        ril = ilow >> 2;
-        wd2 = qm4[ril];
-        dlow = (s->band[0].det*wd2) >> 15;
-
-        /* Block 3L, LOGSCL */
-        il4 = rl42[ril];
-        wd = (s->band[0].nb*127) >> 7;
-        s->band[0].nb = wd + wl[il4];
-        if (s->band[0].nb < 0)
-            s->band[0].nb = 0;
-        else if (s->band[0].nb > 18432)
-            s->band[0].nb = 18432;
-
-        /* Block 3L, SCALEL */
-        wd1 = (s->band[0].nb >> 6) & 31;
-        wd2 = 8 - (s->band[0].nb >> 11);
-        wd3 = (wd2 < 0)  ?  (ilb[wd1] << -wd2)  :  (ilb[wd1] >> wd2);
-        s->band[0].det = wd3 << 2;
-
-        block4(&s->band[0], dlow);
+        for (i = 0;  i < 7;  i++)
         {
-            int nb;
+            v->d[i][l] = band[l]->d[i];
+            v->b[i][l] = band[l]->b[i];
+            v->bp[i][l] = band[l]->bp[i];
+        }
+    }
+}
+/*- End of function --------------------------------------------------------*/
 
-            /* Block 1H, SUBTRA */
-            eh = saturate(xhigh - s->band[1].s);
+static void bands_store(g722_band_t *const band[BAND_LANES], const g722_bands_t *v)
+{
+    int l;
+    int i;
 
-            /* Block 1H, QUANTH */
-            wd = (eh >= 0)  ?  eh  :  -(eh + 1);
-            wd1 = (564*s->band[1].det) >> 12;
-            mih = (wd >= wd1)  ?  2  :  1;
-            ihigh = (eh < 0)  ?  ihn[mih]  :  ihp[mih];
-
-            /* Block 2H, INVQAH */
-            wd2 = qm2[ihigh];
-            dhigh = (s->band[1].det*wd2) >> 15;
-
-            /* Block 3H, LOGSCH */
-            ih2 = rh2[ihigh];
-            wd = (s->band[1].nb*127) >> 7;
-
-            nb = wd + wh[ih2];
-            if (nb < 0)
-                nb = 0;
-            else if (nb > 22528)
-                nb = 22528;
-            s->band[1].nb = nb;
-
-            /* Block 3H, SCALEH */
-            wd1 = (s->band[1].nb >> 6) & 31;
-            wd2 = 10 - (s->band[1].nb >> 11);
-            wd3 = (wd2 < 0)  ?  (ilb[wd1] << -wd2)  :  (ilb[wd1] >> wd2);
-            s->band[1].det = wd3 << 2;
+    for (l = 0;  l < BAND_LANES;  l++)
+    {
+        band[l]->s = v->s[l];
+        band[l]->sp = v->sp[l];
+        band[l]->sz = v->sz[l];
+        for (i = 0;  i < 3;  i++)
+        {
+            band[l]->r[i] = v->r[i][l];
+            band[l]->a[i] = v->a[i][l];
+            band[l]->ap[i] = v->ap[i][l];
+            band[l]->p[i] = v->p[i][l];
+        }
+        for (i = 0;  i < 7;  i++)
+        {
+            band[l]->d[i] = v->d[i][l];
+            band[l]->b[i] = v->b[i][l];
+            band[l]->bp[i] = v->bp[i][l];
+        }
+    }
+}
+/*- End of function --------------------------------------------------------*/
 
-            block4(&s->band[1], dhigh);
-#if   BITS_PER_SAMPLE == 8
-            code = ((ihigh << 6) | ilow);
-#elif BITS_PER_SAMPLE == 7
-            code = ((ihigh << 6) | ilow) >> 1;
-#elif BITS_PER_SAMPLE == 6
-            code = ((ihigh << 6) | ilow) >> 2;
+/* block4() on every lane */
+static __inline void block4_v(g722_bands_t *band, g722_v4si d)
+{
+    g722_v4si wd1;
+    g722_v4si wd2;
+    g722_v4si wd3;
+    g722_v4si sg0;
+    g722_v4si eq;
+    g722_v4si ap1;
+    g722_v4si ap2;
+    g722_v4si sz = {0, 0, 0, 0};
+    int i;
+
+    /* Block 4, RECONS */
+    band->d[0] = d;
+    band->r[0] = saturate_v(band->s + d);
+
+    /* Block 4, PARREC */
+    band->p[0] = saturate_v(band->sz + d);
+
+    /* Block 4, UPPOL2 */
+    sg0 = band->p[0] >> 15;
+    wd1 = saturate_v(band->a[1] << 2);
+
+    eq = (sg0 == (band->p[1] >> 15));
+    wd2 = V_SELECT(eq, -wd1, wd1);
+    wd2 = V_MIN(wd2, 32767);
+
+    ap2 = (wd2 >> 7) + V_SELECT(sg0 == (band->p[2] >> 15), 128, -128);
+    ap2 += (band->a[2]*32512) >> 15;
+    ap2 = V_MAX(V_MIN(ap2, 12288), -12288);
+    band->ap[2] = ap2;
+
+    /* Block 4, UPPOL1 */
+    wd1 = V_SELECT(eq, 192, -192);
+    wd2 = (band->a[1]*32640) >> 15;
+
+    ap1 = saturate_v(wd1 + wd2);
+    wd3 = saturate_v(15360 - ap2);
+    ap1 = V_MAX(V_MIN(ap1, wd3), -wd3);
+    band->ap[1] = ap1;
+
+    /* Block 4, UPZERO */
+    /* Block 4, FILTEZ */
+    wd1 = V_SELECT(d == 0, 0, 128);
+
+    sg0 = d >> 15;
+    for (i = 1;  i < 7;  i++)
+    {
+        wd2 = V_SELECT((band->d[i] >> 15) == sg0, wd1, -wd1);
+        wd3 = (band->b[i]*32640) >> 15;
+        band->bp[i] = saturate_v(wd2 + wd3);
+    }
+
+    /* Block 4, DELAYA */
+    for (i = 6;  i > 0;  i--)
+    {
+        band->d[i] = band->d[i - 1];
+        band->b[i] = band->bp[i];
+        wd1 = saturate_v(band->d[i] + band->d[i]);
+        sz += (band->b[i]*wd1) >> 15;
+    }
+    band->sz = sz;
+
+    for (i = 2;  i > 0;  i--)
+    {
+        band->r[i] = band->r[i - 1];
+        band->p[i] = band->p[i - 1];
+        band->a[i] = band->ap[i];
+    }
+
+    /* Block 4, FILTEP */
+    wd1 = saturate_v(band->r[1] + band->r[1]);
+    wd1 = (band->a[1]*wd1) >> 15;
+    wd2 = saturate_v(band->r[2] + band->r[2]);
+    wd2 = (band->a[2]*wd2) >> 15;
+    band->sp = saturate_v(wd1 + wd2);
+
+    /* Block 4, PREDIC */
+    band->s = saturate_v(band->sp + band->sz);
+}
+/*- End of function --------------------------------------------------------*/
 #endif
-        }
 
-#if PACKED_OUTPUT == 1
-            /* Pack the code bits */
-            s->out_buffer |= (code << s->out_bits);
-            s->out_bits += s->bits_per_sample;
-            if (s->out_bits >= 8)
-            {
-                g722_data[g722_bytes++] = (uint8_t) (s->out_buffer & 0xFF);
-                s->out_bits -= 8;
-                s->out_buffer >>= 8;
-            }
-#else
-            g722_data[g722_bytes++] = (uint8_t) code;
+int g722_encode_stereo(g722_encode_state_t *left, g722_encode_state_t *right,
+                       uint8_t left_data[], uint8_t right_data[],
+                       const int16_t left_amp[], const int16_t right_amp[],
+                       int len)
+{
+#if G722_SIMD_ENCODE
+    g722_band_t *band[BAND_LANES];
+    g722_bands_t v;
+    g722_qmf_t qmf[2];
+    int left_bytes;
+    int right_bytes;
+    int j;
+    int k;
+    int n;
+
+    if (left->itu_test_mode  ||  right->itu_test_mode)
 #endif
+    {
+        g722_encode(left, left_data, left_amp, len);
+        return g722_encode(right, right_data, right_amp, len);
     }
-    return g722_bytes;
+
+#if G722_SIMD_ENCODE
+    band[0] = &left->band[0];
+    band[1] = &left->band[1];
+    band[2] = &right->band[0];
+    band[3] = &right->band[1];
+    bands_load(&v, band);
+    qmf_load(&qmf[0], left);
+    qmf_load(&qmf[1], right);
+
+    left_bytes = 0;
+    right_bytes = 0;
+    for (j = 0;  j + 1 < len;  j += 2*n)
+    {
+        n = (len - j)/2;
+        if (n > QMF_CHUNK)
+            n = QMF_CHUNK;
+        qmf_apply(&qmf[0], left_amp + j, n);
+        qmf_apply(&qmf[1], right_amp + j, n);
+
+        for (k = 0;  k < n;  k++)
+        {
+            g722_v4si x = {qmf[0].xlow[k], qmf[0].xhigh[k], qmf[1].xlow[k], qmf[1].xhigh[k]};
+            g722_v4si e;
+            int dq[BAND_LANES];
+            int code[BAND_LANES];
+
+            /* Block 1L/1H, SUBTRA */
+            e = saturate_v(x - v.s);
+
+            code[0] = quantl(band[0], e[0], &dq[0]);
+            code[1] = quanth(band[1], e[1], &dq[1]);
+            code[2] = quantl(band[2], e[2], &dq[2]);
+            code[3] = quanth(band[3], e[3], &dq[3]);
+
+            memcpy(&x, dq, sizeof(x));
+            block4_v(&v, x);
+
+            left_bytes = put_code(left, left_data, left_bytes, code[0], code[1]);
+            right_bytes = put_code(right, right_data, right_bytes, code[2], code[3]);
+        }
+    }
+
+    bands_store(band, &v);
+    qmf_store(&qmf[0], left);
+    qmf_store(&qmf[1], right);
+    return left_bytes;
+#endif
 }
 /*- End of function --------------------------------------------------------*/
 /*- End of file ------------------------------------------------------------*/
@@ -395,6 +395,46 @@ OI_STATUS OI_CODEC_SBC_DecodeFrame(OI_CODEC_SBC_DECODER_CONTEXT* context,
                                    uint32_t* frameBytes, int16_t* pcmData,
                                    uint32_t* pcmBytes);
 
+/**
+ * Decode the SBC frames of one media packet. Frames are decoded one after the
+ * other as with OI_CODEC_SBC_DecodeFrame(), until frameCount frames were
+ * decoded, the frame data runs out or a frame fails to decode.
+ *
+ * @param context       Pointer to a decoder context structure. The same context
+ *                      must be used each time when decoding from the same
+ *                      stream.
+ *
+ * @param frameData     Address of a pointer to the SBC data to decode. This
+ *                      value will be updated to point past the last frame
+ *                      decoded.
+ *
+ * @param frameBytes    Pointer to a uint32_t containing the number of available
+ *                      bytes of frame data. This value will be updated to
+ *                      reflect the number of bytes remaining after the
+ *                      decoding operation.
+ *
+ * @param pcmData       Address of an array of int16_t pairs, which will be
+ *                      populated with the decoded audio data of all frames,
+ *                      back to back. This address is not updated.
+ *
+ * @param pcmBytes      Pointer to a uint32_t in/out parameter. On input, it
+ *                      should contain the number of bytes available for pcm
+ *                      data. On output, it will contain the number of bytes
+ *                      written by all frames decoded.
+ *
+ * @param frameCount    Maximum number of frames to decode.
+ *
+ * @param framesDecoded Pointer to a uint8_t set to the number of frames
+ *                      decoded.
+ *
+ * @return              The status of the frame that failed to decode, or OI_OK.
+ */
+OI_STATUS OI_CODEC_SBC_DecodeFrames(OI_CODEC_SBC_DECODER_CONTEXT* context,
+                                    const OI_BYTE** frameData,
+                                    uint32_t* frameBytes, int16_t* pcmData,
+                                    uint32_t* pcmBytes, uint8_t frameCount,
+                                    uint8_t* framesDecoded);
+
 /**
  * Calculate the number of SBC frames but don't decode. CRC's are not checked,
  * but the Sync word is found prior to count calculation.
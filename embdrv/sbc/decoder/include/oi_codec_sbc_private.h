@@ -82,6 +82,18 @@ Function prototypes and macro definitions used internally by the codec.
 #define DIVIDE(a, b) ((a) / (b))
 #endif
 
+/* Set SBC_SIMD_SYNTHESIS to 0 to run the 8-subband synthesis filterbank with
+ * the scalar code. Otherwise its DCT and window run on the vector unit, NEON
+ * on ARM and SSE4.1 or AVX2 on x86 where the best one is picked at run time.
+ * The output is bit-exact with the scalar code. */
+#ifndef SBC_SIMD_SYNTHESIS
+#if defined(__GNUC__)
+#define SBC_SIMD_SYNTHESIS 1
+#else
+#define SBC_SIMD_SYNTHESIS 0
+#endif
+#endif
+
 typedef union {
   uint8_t uint8[SBC_MAX_BANDS];
   uint32_t uint32[SBC_MAX_BANDS / 4];
@@ -125,6 +137,14 @@ typedef struct {
 #define DCTII_8_SHIFT_6 (DCTII_8_SHIFT_OUT - 1)
 #define DCTII_8_SHIFT_7 (DCTII_8_SHIFT_OUT - 2)
 
+#define AAN_C4_FIX (759250125) /* S1.30  759250125   0.707107*/
+
+#define AAN_C6_FIX (410903207) /* S1.30  410903207   0.382683*/
+
+#define AAN_Q0_FIX (581104888) /* S1.30  581104888   0.541196*/
+
+#define AAN_Q1_FIX (1402911301) /* S1.30 1402911301   1.306563*/
+
 #define DCT_SHIFT 15
 
 #define DCTIII_4_SHIFT_IN 2
@@ -183,6 +203,9 @@ PRIVATE void cosineModulateSynth4(SBC_BUFFER_T* RESTRICT out,
                                   int32_t const* RESTRICT in);
 PRIVATE void SynthWindow40_int32_int32_symmetry_with_sum(
     int16_t* pcm, SBC_BUFFER_T buffer[80], OI_UINT strideShift);
+PRIVATE void SynthWindow80_generated(int16_t* pcm,
+                                     SBC_BUFFER_T const* RESTRICT buffer,
+                                     OI_UINT strideShift);
 
 INLINE void dct3_4(int32_t* RESTRICT out, int32_t const* RESTRICT in);
 PRIVATE void analyze4_generated(SBC_BUFFER_T analysisBuffer[RESTRICT 40],
@@ -201,6 +224,22 @@ PRIVATE void analyze8_enhanced_generated(
     OI_UINT strideShift, int32_t subband[8]);
 #endif
 
+#if SBC_SIMD_SYNTHESIS
+/* Vector kernels, selected for the CPU by OI_SBC_SynthSimdInit() */
+typedef struct {
+  /* dct2_8() on the 4 blocks of 8 subband samples laid out back to back in
+   * |in|, the output of block i going to out[i] */
+  void (*dct2_8x4)(SBC_BUFFER_T* const out[4], int32_t const* RESTRICT in);
+
+  /* Same as SynthWindow80_generated() */
+  void (*synthWindow80)(int16_t* pcm, SBC_BUFFER_T const* RESTRICT buffer,
+                        OI_UINT strideShift);
+} OI_SBC_SYNTH_SIMD;
+
+extern OI_SBC_SYNTH_SIMD OI_SBC_SynthSimd;
+PRIVATE void OI_SBC_SynthSimdInit(void);
+#endif
+
 /* Decoder functions */
 
 INLINE void OI_SBC_ReadHeader(OI_CODEC_SBC_COMMON_CONTEXT* common,
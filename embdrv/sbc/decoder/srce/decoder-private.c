@@ -75,6 +75,10 @@ INLINE OI_STATUS internal_DecoderReset(OI_CODEC_SBC_DECODER_CONTEXT* context,
   context->limitFrameFormat = FALSE;
   OI_SBC_ExpandFrameFields(&context->common.frameInfo);
 
+#if SBC_SIMD_SYNTHESIS
+  OI_SBC_SynthSimdInit();
+#endif
+
   /*PLATFORM_DECODER_RESET(context);*/
 
   return OI_OK;
@@ -346,6 +346,36 @@ OI_STATUS OI_CODEC_SBC_DecodeFrame(OI_CODEC_SBC_DECODER_CONTEXT* context,
   return status;
 }
 
+OI_STATUS OI_CODEC_SBC_DecodeFrames(OI_CODEC_SBC_DECODER_CONTEXT* context,
+                                    const OI_BYTE** frameData,
+                                    uint32_t* frameBytes, int16_t* pcmData,
+                                    uint32_t* pcmBytes, uint8_t frameCount,
+                                    uint8_t* framesDecoded) {
+  OI_STATUS status = OI_OK;
+  uint32_t pcmAvail = *pcmBytes;
+  uint32_t frameBytesOut;
+
+  TRACE(("+OI_CODEC_SBC_DecodeFrames"));
+
+  *framesDecoded = 0;
+  while (*framesDecoded < frameCount && *frameBytes != 0) {
+    frameBytesOut = pcmAvail;
+    status = OI_CODEC_SBC_DecodeFrame(context, frameData, frameBytes, pcmData,
+                                      &frameBytesOut);
+    if (!OI_SUCCESS(status)) {
+      break;
+    }
+    pcmData += frameBytesOut / sizeof(int16_t);
+    pcmAvail -= frameBytesOut;
+    (*framesDecoded)++;
+  }
+
+  *pcmBytes -= pcmAvail;
+  TRACE(("-OI_CODEC_SBC_DecodeFrames: %d", status));
+
+  return status;
+}
+
 OI_STATUS OI_CODEC_SBC_SkipFrame(OI_CODEC_SBC_DECODER_CONTEXT* context,
                                  const OI_BYTE** frameData,
                                  uint32_t* frameBytes) {
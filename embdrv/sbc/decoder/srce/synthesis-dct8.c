@@ -37,14 +37,6 @@
 
 #include "oi_codec_sbc_private.h"
 
-#define AAN_C4_FIX (759250125) /* S1.30  759250125   0.707107*/
-
-#define AAN_C6_FIX (410903207) /* S1.30  410903207   0.382683*/
-
-#define AAN_Q0_FIX (581104888) /* S1.30  581104888   0.541196*/
-
-#define AAN_Q1_FIX (1402911301) /* S1.30 1402911301   1.306563*/
-
 /** Scales x by y bits to the right, adding a rounding factor.
  */
 #ifndef SCALE
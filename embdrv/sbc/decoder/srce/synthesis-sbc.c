@@ -163,6 +163,7 @@ The output samples X[0..7] are defined as sums of W:
 @{
 */
 
+#include <string.h>
 #include "oi_codec_sbc_private.h"
 
 const int32_t dec_window_4[21] = {
@@ -312,6 +313,99 @@ PRIVATE void OI_SBC_SynthFrame_80(OI_CODEC_SBC_DECODER_CONTEXT* context,
   context->common.filterBufferOffset = offset;
 }
 
+#if SBC_SIMD_SYNTHESIS
+/*
+ * Vector version of OI_SBC_SynthFrame_80. The blocks are taken in runs that
+ * end where the filter buffers wrap around: the DCTs of a run go 4 blocks at
+ * a time, then its windows run from the oldest block to the newest as usual.
+ * A DCT only writes the 8 values below those read by the windows of the
+ * earlier blocks of the run, so the output is unchanged.
+ */
+PRIVATE void OI_SBC_SynthFrame_80_SIMD(OI_CODEC_SBC_DECODER_CONTEXT* context,
+                                       int16_t* pcm, OI_UINT blkstart,
+                                       OI_UINT blkcount) {
+  OI_UINT blk;
+  OI_UINT ch;
+  OI_UINT i;
+  OI_UINT nrof_channels = context->common.frameInfo.nrof_channels;
+  OI_UINT pcmStrideShift = context->common.pcmStride == 1 ? 0 : 1;
+  OI_UINT offset = context->common.filterBufferOffset;
+  int32_t* s = context->common.subdata + 8 * nrof_channels * blkstart;
+  OI_UINT blkstop = blkstart + blkcount;
+
+  blk = blkstart;
+  while (blk < blkstop) {
+    OI_UINT count;
+    OI_UINT dcts;
+    SBC_BUFFER_T* out[4];
+
+    if (offset == 0) {
+      COPY_BACKWARD_32BIT_ALIGNED_72_HALFWORDS(
+          context->common.filterBuffer[0] + context->common.filterBufferLen -
+              72,
+          context->common.filterBuffer[0]);
+      if (nrof_channels == 2) {
+        COPY_BACKWARD_32BIT_ALIGNED_72_HALFWORDS(
+            context->common.filterBuffer[1] + context->common.filterBufferLen -
+                72,
+            context->common.filterBuffer[1]);
+      }
+      offset = context->common.filterBufferLen - 80;
+    } else {
+      offset -= 1 * 8;
+    }
+
+    /* Blocks until the next wrap around, this one included */
+    count = offset / 8 + 1;
+    if (count > blkstop - blk) {
+      count = blkstop - blk;
+    }
+
+    dcts = count * nrof_channels;
+    for (i = 0; i < dcts; i += 4) {
+      OI_UINT j;
+      if (dcts - i >= 4) {
+        for (j = 0; j < 4; j++) {
+          out[j] = context->common.filterBuffer[(i + j) % nrof_channels] +
+                   offset - 8 * ((i + j) / nrof_channels);
+        }
+        OI_SBC_SynthSimd.dct2_8x4(out, s + 8 * i);
+      } else {
+        /* Fewer than 4 left: run them through scratch space */
+        int32_t in[4 * 8];
+        SBC_BUFFER_T scratch[4][8];
+        OI_UINT left = dcts - i;
+        memset(in, 0, sizeof(in));
+        memcpy(in, s + 8 * i, left * 8 * sizeof(int32_t));
+        for (j = 0; j < 4; j++) {
+          out[j] = scratch[j];
+        }
+        OI_SBC_SynthSimd.dct2_8x4(out, in);
+        for (j = 0; j < left; j++) {
+          memcpy(context->common.filterBuffer[(i + j) % nrof_channels] +
+                     offset - 8 * ((i + j) / nrof_channels),
+                 scratch[j], sizeof(scratch[j]));
+        }
+      }
+    }
+
+    for (i = 0; i < count; i++) {
+      for (ch = 0; ch < nrof_channels; ch++) {
+        OI_SBC_SynthSimd.synthWindow80(
+            pcm + ch, context->common.filterBuffer[ch] + offset - 8 * i,
+            pcmStrideShift);
+      }
+      pcm += (8 << pcmStrideShift);
+    }
+
+    s += 8 * dcts;
+    offset -= 8 * (count - 1);
+    blk += count;
+  }
+  context->common.filterBufferOffset = offset;
+}
+#endif /* SBC_SIMD_SYNTHESIS */
+
 PRIVATE void OI_SBC_SynthFrame_4SB(OI_CODEC_SBC_DECODER_CONTEXT* context,
                                    int16_t* pcm, OI_UINT blkstart,
                                    OI_UINT blkcount) {
@@ -398,11 +492,19 @@ static const SYNTH_FRAME SynthFrameEnhanced[] = {
 
 #endif
 
+#if SBC_SIMD_SYNTHESIS
+static const SYNTH_FRAME SynthFrame8SB[] = {
+    NULL,                      /* invalid */
+    OI_SBC_SynthFrame_80_SIMD, /* mono */
+    OI_SBC_SynthFrame_80_SIMD  /* stereo */
+};
+#else
 static const SYNTH_FRAME SynthFrame8SB[] = {
     NULL,                 /* invalid */
     OI_SBC_SynthFrame_80, /* mono */
     OI_SBC_SynthFrame_80  /* stereo */
 };
+#endif
 
 static const SYNTH_FRAME SynthFrame4SB[] = {
     NULL,                  /* invalid */
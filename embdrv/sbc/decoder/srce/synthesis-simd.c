@@ -0,0 +1,170 @@
+/******************************************************************************
+ *
+ *  Copyright 2018 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/** @file
+
+Instantiates the vector kernels of synthesis-simd.inc for each supported
+instruction set and selects the one to use on this CPU.
+
+The kernels use the compiler's generic vectors, so that the same source is
+lowered to NEON, SSE4.1 or AVX2. Every lane computes exactly what the scalar
+code does for one sample, which keeps the output bit-exact.
+
+@ingroup codec_internal
+*/
+
+/**@addtogroup codec_internal */
+/**@{*/
+
+#include <string.h>
+#include "oi_codec_sbc_private.h"
+
+#if SBC_SIMD_SYNTHESIS
+
+typedef int16_t sbc_v4hi __attribute__((vector_size(8)));
+typedef int16_t sbc_v8hi __attribute__((vector_size(16)));
+typedef int32_t sbc_v4si __attribute__((vector_size(16)));
+typedef uint32_t sbc_v4su __attribute__((vector_size(16)));
+typedef int32_t sbc_v8si __attribute__((vector_size(32)));
+typedef uint32_t sbc_v8su __attribute__((vector_size(32)));
+
+#if defined(__clang__)
+#define SBC_SHUFFLE4(a, b, i0, i1, i2, i3) \
+  __builtin_shufflevector(a, b, i0, i1, i2, i3)
+#define SBC_REVERSE8(a) __builtin_shufflevector(a, a, 7, 6, 5, 4, 3, 2, 1, 0)
+#else
+#define SBC_SHUFFLE4(a, b, i0, i1, i2, i3) \
+  __builtin_shuffle(a, b, (sbc_v4si){i0, i1, i2, i3})
+#define SBC_REVERSE8(a) \
+  __builtin_shuffle(a, (sbc_v8hi){7, 6, 5, 4, 3, 2, 1, 0})
+#endif
+
+#define SBC_LOAD(v, p) memcpy(&(v), (p), sizeof(v))
+#define SBC_STORE(p, v) memcpy((p), &(v), sizeof(v))
+
+/* min and max of each lane */
+#define SBC_MIN(a, b) (((a) & ((a) < (b))) | ((b) & ~((a) < (b))))
+#define SBC_MAX(a, b) (((a) & ((a) > (b))) | ((b) & ~((a) > (b))))
+
+/* The terms of SynthWindow80_generated() by output sample: for lane j,
+ * [m][0] applies to buffer[16 * m + 4 + j] and [m][1] to
+ * buffer[16 * m + 12 - j]. Left shifts are folded into the coefficients,
+ * which gives the same 32-bit products. */
+static const int32_t window80_coef[5][2][8] = {
+    {
+        {0, -3263, -10385, -16457, 10445, -8443, -10337, -6087},
+        {8235, 29293, 24995, 19083, 0, 16913, 11167, 9293},
+    },
+    {
+        {-23167, -5229, -4944, -23641, -10594, -9632, -30605, -23144},
+        {26479, 30835, 9161, -29015, 0, 7374, 7668, 9976},
+    },
+    {
+        {-34794, -54042, -46126, -51556, 89196, 41020, 38212, 36110},
+        {75192, 63266, 55122, 49160, 0, 61788, 66536, 94684},
+    },
+    {
+        {34794, 34638, 18472, 24211, 10603, 9405, 16383, 3494},
+        {26479, 26663, 12705, 23469, 0, -18233, 22117, 11537},
+    },
+    {
+        {23167, 4555, 6239, 21223, 9539, 26189, 8603, 8721},
+        {8235, 12419, 9251, 26913, 0, 1499, 7543, 1370},
+    },
+};
+
+static const int32_t window80_shift[5][2][8] = {
+    {
+        {0, 5, 6, 6, 4, 7, 4, 2},
+        {3, 5, 5, 5, 0, 5, 4, 3},
+    },
+    {
+        {3, 0, 0, 2, 0, 0, 1, 0},
+        {2, 3, 3, 4, 0, 0, 0, 0},
+    },
+    {
+        {0, 0, 0, 0, 0, 0, 0, 0},
+        {0, 0, 0, 0, 0, 0, 0, 0},
+    },
+    {
+        {0, 0, 0, 1, 0, 1, 2, 0},
+        {2, 2, 1, 2, 0, 3, 4, 1},
+    },
+    {
+        {3, 1, 3, 8, 4, 7, 6, 7},
+        {3, 4, 4, 6, 0, 1, 3, 0},
+    },
+};
+
+#if defined(__i386__) || defined(__x86_64__)
+#define SBC_SIMD_SCALAR_WINDOW
+#endif
+
+/* Baseline instruction set: NEON on ARM, SSE2 on x86 */
+#define SBC_SIMD_TARGET
+#define SBC_SIMD_NAME(name) name##_generic
+#include "synthesis-simd.inc"
+#undef SBC_SIMD_TARGET
+#undef SBC_SIMD_NAME
+
+#if defined(__i386__) || defined(__x86_64__)
+#define SBC_SIMD_TARGET __attribute__((target("sse4.1")))
+#define SBC_SIMD_NAME(name) name##_sse41
+#include "synthesis-simd.inc"
+#undef SBC_SIMD_TARGET
+#undef SBC_SIMD_NAME
+
+#undef SBC_SIMD_SCALAR_WINDOW
+
+#define SBC_SIMD_TARGET __attribute__((target("avx2")))
+#define SBC_SIMD_NAME(name) name##_avx2
+#include "synthesis-simd.inc"
+#undef SBC_SIMD_TARGET
+#undef SBC_SIMD_NAME
+#endif
+
+OI_SBC_SYNTH_SIMD OI_SBC_SynthSimd;
+
+/**
+ * Points OI_SBC_SynthSimd to the kernels built for the widest instruction set
+ * this CPU supports. The window shifts each lane by its own amount, which
+ * only AVX2 and NEON can do in one instruction: the scalar window is faster
+ * than the vector one on older x86 CPUs.
+ */
+PRIVATE void OI_SBC_SynthSimdInit(void) {
+#if defined(__i386__) || defined(__x86_64__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    OI_SBC_SynthSimd.dct2_8x4 = dct2_8x4_avx2;
+    OI_SBC_SynthSimd.synthWindow80 = synthWindow80_avx2;
+  } else if (__builtin_cpu_supports("sse4.1")) {
+    OI_SBC_SynthSimd.dct2_8x4 = dct2_8x4_sse41;
+    OI_SBC_SynthSimd.synthWindow80 = SynthWindow80_generated;
+  } else {
+    OI_SBC_SynthSimd.dct2_8x4 = dct2_8x4_generic;
+    OI_SBC_SynthSimd.synthWindow80 = SynthWindow80_generated;
+  }
+#else
+  OI_SBC_SynthSimd.dct2_8x4 = dct2_8x4_generic;
+  OI_SBC_SynthSimd.synthWindow80 = synthWindow80_generic;
+#endif
+}
+
+#endif /* SBC_SIMD_SYNTHESIS */
+
+/**@}*/
@@ -53,4 +53,51 @@ extern void EncQuantizer(SBC_ENC_PARAMS*);
 #if (SBC_DSP_OPT == TRUE)
 int32_t SBC_Multiply_32_16_Simplified(int32_t s32In2Temp, int32_t s32In1Temp);
 #endif
+
+#if (SBC_SIMD_OPT == TRUE)
+/* Analysis windows as five taps of 8 (resp. 16) coefficients: the windowed
+ * block is Y[m] = sum of gas16AnalWindow[j * 2 * subbands + m] *
+ * X[j * 2 * subbands + m] for j = 0..4 */
+extern const int16_t gas16AnalWindow4[];
+extern const int16_t gas16AnalWindow8[];
+
+/* Vector kernels, selected for the CPU by sbc_enc_simd_init() */
+typedef struct SBC_ENC_SIMD_TAG {
+  /* Windows one block of one channel from |x| into the 2 * subbands values
+   * |y| fed to the DCT */
+  void (*window4)(const int16_t* x, int32_t* y);
+  void (*window8)(const int16_t* x, int32_t* y);
+
+  /* Runs SBC_FastIDCT4/8 on |count| windowed blocks laid out back to back in
+   * |y|, writing the subband samples to |out|. |count| is a multiple of 4. */
+  void (*idct4)(const int32_t* y, int32_t* out, int32_t count);
+  void (*idct8)(const int32_t* y, int32_t* out, int32_t count);
+
+  /* Stores in |max| the largest absolute value of each of the |stride|
+   * subbands of |sb| over |blocks| blocks. |stride| is a multiple of 4. */
+  void (*max_abs)(const int32_t* sb, int32_t stride, int32_t blocks,
+                  int32_t* max);
+
+  /* Same as max_abs for the joint stereo sums (L + R) / 2, stored in
+   * |max_sum|, and differences (L - R) / 2, stored in |max_diff| */
+  void (*max_abs_joint)(const int32_t* sb, int32_t subbands, int32_t blocks,
+                        int32_t* max_sum, int32_t* max_diff);
+
+  /* Runs the iterative bit slicing of sbc_enc_bit_alloc_mono/ste on the
+   * |count| values of |bitneed|, |count| being at most 16. Returns the slice
+   * at which it stops, with the bits left before that slice in |bit_count|
+   * and the bits it needs in |slice_count|. */
+  int32_t (*bit_slice)(const int16_t* bitneed, int32_t count,
+                       int32_t max_bitneed, int32_t bit_pool,
+                       int32_t* bit_count, int32_t* slice_count);
+
+  /* Quantizes |blocks| blocks of |stride| subband samples into |out|:
+   * ((sb >> 2) + bias) * mult >> 29, keeping the low 16 bits */
+  void (*quantize)(const int32_t* sb, const int32_t* bias, const int32_t* mult,
+                   int32_t stride, int32_t blocks, uint32_t* out);
+} SBC_ENC_SIMD;
+
+extern SBC_ENC_SIMD sbc_enc_simd;
+extern void sbc_enc_simd_init(void);
+#endif
 #endif
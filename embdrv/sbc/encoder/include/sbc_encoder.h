@@ -144,6 +144,28 @@
 #define SBC_JOINT_STE_INCLUDED TRUE
 #endif
 
+/* Set SBC_SIMD_OPT to TRUE to run the analysis window, the DCT, the scale
+ * factor search, the bit slicing and the quantizer on the vector unit. The
+ * kernels are built for NEON on ARM, and for SSE4.1 and AVX2 on x86 where the
+ * best one is picked at run time. The output is bit-exact with the scalar
+ * code, which it requires to be in its default configuration. */
+#ifndef SBC_SIMD_OPT
+#if defined(__GNUC__)
+#define SBC_SIMD_OPT TRUE
+#else
+#define SBC_SIMD_OPT FALSE
+#endif
+#endif
+
+#if (SBC_SIMD_OPT == TRUE)
+#if (SBC_ARM_ASM_OPT == TRUE || SBC_IPAQ_OPT == FALSE || SBC_DSP_OPT == TRUE || \
+     SBC_IS_64_MULT_IN_WINDOW_ACCU == TRUE ||                                  \
+     SBC_IS_64_MULT_IN_IDCT == TRUE || SBC_FAST_DCT == FALSE ||                \
+     SBC_IS_64_MULT_IN_QUANTIZER == FALSE)
+#error "SBC_SIMD_OPT requires the default fixed-point configuration"
+#endif
+#endif
+
 #define MINIMUM_ENC_VX_BUFFER_SIZE (8 * 10 * 2)
 #ifndef ENC_VX_BUFFER_SIZE
 #define ENC_VX_BUFFER_SIZE (MINIMUM_ENC_VX_BUFFER_SIZE + 64)
@@ -104,6 +104,11 @@ void sbc_enc_bit_alloc_mono(SBC_ENC_PARAMS* pstrCodecParams) {
     }
     ps16GenBufPtr = ps16BitNeed + s32Ch * s32NumOfSubBands;
     /*iterative process to find hwo many bitslices fit into the bitpool*/
+#if (SBC_SIMD_OPT == TRUE)
+    s32BitSlice = sbc_enc_simd.bit_slice(
+        ps16GenBufPtr, s32NumOfSubBands, s32MaxBitNeed,
+        pstrCodecParams->s16BitPool, &s32BitCount, &s32SliceCount);
+#else
     s32BitSlice = s32MaxBitNeed + 1;
     s32BitCount = pstrCodecParams->s16BitPool;
     s32SliceCount = 0;
@@ -125,6 +130,7 @@ void sbc_enc_bit_alloc_mono(SBC_ENC_PARAMS* pstrCodecParams) {
       } /*end of for*/
       ps16GenBufPtr = ps16BitNeed + s32Ch * s32NumOfSubBands;
     } while (s32BitCount - s32SliceCount > 0);
+#endif
 
     if (s32BitCount == 0) {
       s32BitCount -= s32SliceCount;
@@ -95,6 +95,11 @@ void sbc_enc_bit_alloc_ste(SBC_ENC_PARAMS* pstrCodecParams) {
   }
 
   /* iterative process to find out hwo many bitslices fit into the bitpool */
+#if (SBC_SIMD_OPT == TRUE)
+  s32BitSlice =
+      sbc_enc_simd.bit_slice(ps16BitNeed, 2 * s32NumOfSubBands, s32MaxBitNeed,
+                             s32BitPool, &s32BitCount, &s32SliceCount);
+#else
   s32BitSlice = s32MaxBitNeed + 1;
   s32BitCount = s32BitPool;
   s32SliceCount = 0;
@@ -115,6 +120,7 @@ void sbc_enc_bit_alloc_ste(SBC_ENC_PARAMS* pstrCodecParams) {
       ps16GenBufPtr++;
     }
   } while (s32BitCount - s32SliceCount > 0);
+#endif
 
   if (s32BitCount - s32SliceCount == 0) {
     s32BitCount -= s32SliceCount;
@@ -29,7 +29,7 @@
 
 int16_t EncMaxShiftCounter;
 
-#if (SBC_JOINT_STE_INCLUDED == TRUE)
+#if (SBC_JOINT_STE_INCLUDED == TRUE && SBC_SIMD_OPT == FALSE)
 int32_t s32LRDiff[SBC_MAX_NUM_OF_BLOCKS] = {0};
 int32_t s32LRSum[SBC_MAX_NUM_OF_BLOCKS] = {0};
 #endif
@@ -48,9 +48,16 @@ uint32_t SBC_Encode(SBC_ENC_PARAMS* pstrEncParams, int16_t* input,
 #if (SBC_JOINT_STE_INCLUDED == TRUE)
   int32_t s32MaxValue2;
   uint32_t u32CountSum, u32CountDiff;
+#if (SBC_SIMD_OPT == TRUE)
+  int32_t s32Left, s32Right;
+#else
   int32_t *pSum, *pDiff;
+#endif
 #endif
   register int32_t s32NumOfSubBands = pstrEncParams->s16NumOfSubBands;
+#if (SBC_SIMD_OPT == TRUE)
+  int32_t as32MaxValue[SBC_MAX_NUM_OF_CHANNELS * SBC_MAX_NUM_OF_SUBBANDS];
+#endif
 
   /* SBC ananlysis filter*/
   if (s32NumOfSubBands == 4)
@@ -62,13 +69,21 @@ uint32_t SBC_Encode(SBC_ENC_PARAMS* pstrEncParams, int16_t* input,
   ps16ScfL = pstrEncParams->as16ScaleFactor;
   s32Ch = pstrEncParams->s16NumOfChannels * s32NumOfSubBands;
 
+#if (SBC_SIMD_OPT == TRUE)
+  sbc_enc_simd.max_abs(pstrEncParams->s32SbBuffer, s32Ch, s32NumOfBlocks,
+                       as32MaxValue);
+#endif
   for (s32Sb = 0; s32Sb < s32Ch; s32Sb++) {
+#if (SBC_SIMD_OPT == TRUE)
+    s32MaxValue = as32MaxValue[s32Sb];
+#else
     SbBuffer = pstrEncParams->s32SbBuffer + s32Sb;
     s32MaxValue = 0;
     for (s32Blk = s32NumOfBlocks; s32Blk > 0; s32Blk--) {
       if (s32MaxValue < abs32(*SbBuffer)) s32MaxValue = abs32(*SbBuffer);
       SbBuffer += s32Ch;
     }
+#endif
 
     u32Count = (s32MaxValue > 0x800000) ? 9 : 0;
 
@@ -85,7 +100,16 @@ uint32_t SBC_Encode(SBC_ENC_PARAMS* pstrEncParams, int16_t* input,
     /* Calculate sum and differance  scale factors for making JS decision   */
     ps16ScfL = pstrEncParams->as16ScaleFactor;
     /* calculate the scale factor of Joint stereo max sum and diff */
+#if (SBC_SIMD_OPT == TRUE)
+    sbc_enc_simd.max_abs_joint(pstrEncParams->s32SbBuffer, s32NumOfSubBands,
+                               s32NumOfBlocks, as32MaxValue,
+                               as32MaxValue + s32NumOfSubBands);
+#endif
     for (s32Sb = 0; s32Sb < s32NumOfSubBands - 1; s32Sb++) {
+#if (SBC_SIMD_OPT == TRUE)
+      s32MaxValue = as32MaxValue[s32Sb];
+      s32MaxValue2 = as32MaxValue[s32NumOfSubBands + s32Sb];
+#else
       SbBuffer = pstrEncParams->s32SbBuffer + s32Sb;
       s32MaxValue2 = 0;
       s32MaxValue = 0;
@@ -100,6 +124,7 @@ uint32_t SBC_Encode(SBC_ENC_PARAMS* pstrEncParams, int16_t* input,
         pDiff++;
         SbBuffer += s32Ch;
       }
+#endif
       u32Count = (s32MaxValue > 0x800000) ? 9 : 0;
       for (; u32Count < 15; u32Count++) {
         if (s32MaxValue <= (int32_t)(0x8000 << u32Count)) break;
@@ -120,6 +145,16 @@ uint32_t SBC_Encode(SBC_ENC_PARAMS* pstrEncParams, int16_t* input,
         *(ps16ScfL + s32NumOfSubBands) = (int16_t)u32CountDiff;
 
         SbBuffer = pstrEncParams->s32SbBuffer + s32Sb;
+#if (SBC_SIMD_OPT == TRUE)
+        for (s32Blk = 0; s32Blk < s32NumOfBlocks; s32Blk++) {
+          s32Left = *SbBuffer;
+          s32Right = *(SbBuffer + s32NumOfSubBands);
+          *SbBuffer = (s32Left + s32Right) >> 1;
+          *(SbBuffer + s32NumOfSubBands) = (s32Left - s32Right) >> 1;
+
+          SbBuffer += s32NumOfSubBands << 1;
+        }
+#else
         pSum = s32LRSum;
         pDiff = s32LRDiff;
 
@@ -131,6 +166,7 @@ uint32_t SBC_Encode(SBC_ENC_PARAMS* pstrEncParams, int16_t* input,
           pSum++;
           pDiff++;
         }
+#endif
 
         pstrEncParams->as16Join[s32Sb] = 1;
       } else {
@@ -70,14 +70,22 @@ uint32_t EncPacking(SBC_ENC_PARAMS* pstrEncParams, uint8_t* output) {
   int32_t s32NumOfBlocks;
   int32_t s32NumOfSubBands = pstrEncParams->s16NumOfSubBands;
   int32_t s32NumOfChannels = pstrEncParams->s16NumOfChannels;
-  uint32_t u32SfRaisedToPow2; /*scale factor raised to power 2*/
   int16_t* ps16ScfPtr;
   int32_t* ps32SbPtr;
   uint16_t u16Levels; /*to store levels*/
-  int32_t s32Temp1;   /*used in 64-bit multiplication*/
-  int32_t s32Low;     /*used in 64-bit multiplication*/
+#if (SBC_SIMD_OPT == TRUE)
+  int32_t as32Bias[SBC_MAX_NUM_OF_CHANNELS * SBC_MAX_NUM_OF_SUBBANDS];
+  int32_t as32Mult[SBC_MAX_NUM_OF_CHANNELS * SBC_MAX_NUM_OF_SUBBANDS];
+  uint32_t au32Quantized[SBC_MAX_NUM_OF_CHANNELS * SBC_MAX_NUM_OF_SUBBANDS *
+                         SBC_MAX_NUM_OF_BLOCKS];
+  uint32_t* pu32Quantized;
+#else
+  uint32_t u32SfRaisedToPow2; /*scale factor raised to power 2*/
+  int32_t s32Temp1;           /*used in 64-bit multiplication*/
+  int32_t s32Low;             /*used in 64-bit multiplication*/
 #if (SBC_IS_64_MULT_IN_QUANTIZER == TRUE)
   int32_t s32Hi1, s32Low1, s32Carry, s32TempVal2, s32Hi, s32Temp2;
+#endif
 #endif
 
   pu8PacketPtr = output;           /*Initialize the ptr*/
@@ -129,13 +137,30 @@ uint32_t EncPacking(SBC_ENC_PARAMS* pstrEncParams, uint8_t* output) {
   ps32SbPtr = pstrEncParams->s32SbBuffer;
   /*Temp=*pu8PacketPtr;*/
   s32NumOfBlocks = pstrEncParams->s16NumOfBlocks;
+#if (SBC_SIMD_OPT == TRUE)
+  /* The 64-bit quantizer below reduces to the 16 bits taken at
+   * scale factor + 14 of ((sb >> 2) + (1 << (scale factor + 13))) * levels.
+   * Scaling levels up by 15 - scale factor moves them to bit 29 for all
+   * subbands, so the whole frame is quantized with the same shift. */
+  for (s32Ch = 0; s32Ch < s32Sb; s32Ch++) {
+    u16Levels = (uint16_t)(((uint32_t)1 << pstrEncParams->as16Bits[s32Ch]) - 1);
+    as32Bias[s32Ch] = 1 << (pstrEncParams->as16ScaleFactor[s32Ch] + 13);
+    as32Mult[s32Ch] = (int32_t)u16Levels
+                      << (15 - pstrEncParams->as16ScaleFactor[s32Ch]);
+  }
+  sbc_enc_simd.quantize(ps32SbPtr, as32Bias, as32Mult, s32Sb, s32NumOfBlocks,
+                        au32Quantized);
+  pu32Quantized = au32Quantized;
+#endif
   for (s32Blk = s32NumOfBlocks - 1; s32Blk >= 0; s32Blk--) {
     ps16GenPtr = pstrEncParams->as16Bits;
     ps16ScfPtr = pstrEncParams->as16ScaleFactor;
     for (s32Ch = s32Sb - 1; s32Ch >= 0; s32Ch--) {
       s32LoopCount = *ps16GenPtr++;
       if (s32LoopCount != 0) {
-#if (SBC_IS_64_MULT_IN_QUANTIZER == TRUE)
+#if (SBC_SIMD_OPT == TRUE)
+        u32QuantizedSbValue0 = *pu32Quantized;
+#elif (SBC_IS_64_MULT_IN_QUANTIZER == TRUE)
         /* finding level from reconstruction part of decoder */
         u32SfRaisedToPow2 = ((uint32_t)1 << ((*ps16ScfPtr) + 1));
         u16Levels = (uint16_t)(((uint32_t)1 << s32LoopCount) - 1);
@@ -202,6 +227,9 @@ uint32_t EncPacking(SBC_ENC_PARAMS* pstrEncParams, uint8_t* output) {
       }
       ps16ScfPtr++;
       ps32SbPtr++;
+#if (SBC_SIMD_OPT == TRUE)
+      pu32Quantized++;
+#endif
     }
   }
 
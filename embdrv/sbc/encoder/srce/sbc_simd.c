@@ -0,0 +1,113 @@
+/******************************************************************************
+ *
+ *  Copyright 2018 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  Instantiates the vector kernels of sbc_simd_kernels.h for each supported
+ *  instruction set and selects the one to use on this CPU.
+ *
+ ******************************************************************************/
+
+#include <string.h>
+#include "sbc_dct.h"
+#include "sbc_enc_func_declare.h"
+#include "sbc_encoder.h"
+
+#if (SBC_SIMD_OPT == TRUE)
+
+/* The kernels use the compiler's generic vectors, so that the same source is
+ * lowered to NEON, SSE4.1 or AVX2. Every lane computes exactly what the
+ * scalar code does for one sample, which keeps the output bit-exact. */
+typedef int16_t sbc_v8hi __attribute__((vector_size(16)));
+typedef int32_t sbc_v4si __attribute__((vector_size(16)));
+typedef int32_t sbc_v8si __attribute__((vector_size(32)));
+typedef int64_t sbc_v4di __attribute__((vector_size(32)));
+typedef uint64_t sbc_v4du __attribute__((vector_size(32)));
+
+#if defined(__clang__)
+#define SBC_SHUFFLE(a, b, i0, i1, i2, i3) \
+  __builtin_shufflevector(a, b, i0, i1, i2, i3)
+#else
+#define SBC_SHUFFLE(a, b, i0, i1, i2, i3) \
+  __builtin_shuffle(a, b, (sbc_v4si){i0, i1, i2, i3})
+#endif
+
+/* Loads 8 samples or coefficients widened to 32 bits */
+#define SBC_LOAD_V8HI(v, p)                    \
+  {                                            \
+    sbc_v8hi v8hi_;                            \
+    memcpy(&v8hi_, (p), sizeof(v8hi_));        \
+    (v) = __builtin_convertvector(v8hi_, sbc_v8si); \
+  }
+
+#define SBC_LOAD(v, p) memcpy(&(v), (p), sizeof(v))
+#define SBC_STORE(p, v) memcpy((p), &(v), sizeof(v))
+
+/* abs32() and max of each lane */
+#define SBC_ABS(v) (((v) ^ ((v) >> 31)) - ((v) >> 31))
+#define SBC_MAX(a, b) (((a) & ((a) > (b))) | ((b) & ~((a) > (b))))
+
+/* Baseline instruction set: NEON on ARM, SSE2 on x86 */
+#define SBC_SIMD_TARGET
+#define SBC_SIMD_NAME(name) name##_generic
+#include "sbc_simd_kernels.h"
+#undef SBC_SIMD_TARGET
+#undef SBC_SIMD_NAME
+
+#if defined(__i386__) || defined(__x86_64__)
+#define SBC_SIMD_TARGET __attribute__((target("sse4.1")))
+#define SBC_SIMD_NAME(name) name##_sse41
+#include "sbc_simd_kernels.h"
+#undef SBC_SIMD_TARGET
+#undef SBC_SIMD_NAME
+
+#define SBC_SIMD_TARGET __attribute__((target("avx2")))
+#define SBC_SIMD_NAME(name) name##_avx2
+#include "sbc_simd_kernels.h"
+#undef SBC_SIMD_TARGET
+#undef SBC_SIMD_NAME
+#endif
+
+SBC_ENC_SIMD sbc_enc_simd;
+
+/*******************************************************************************
+ *
+ * Function         sbc_enc_simd_init
+ *
+ * Description      Points sbc_enc_simd to the kernels built for the widest
+ *                  instruction set this CPU supports.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void sbc_enc_simd_init(void) {
+#if defined(__i386__) || defined(__x86_64__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    sbc_enc_simd = sbc_enc_simd_avx2;
+    return;
+  }
+  if (__builtin_cpu_supports("sse4.1")) {
+    sbc_enc_simd = sbc_enc_simd_sse41;
+    return;
+  }
+#endif
+  sbc_enc_simd = sbc_enc_simd_generic;
+}
+
+#endif /* SBC_SIMD_OPT */
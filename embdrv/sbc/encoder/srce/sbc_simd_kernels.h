@@ -0,0 +1,320 @@
+/******************************************************************************
+ *
+ *  Copyright 2018 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  Vector kernels of the SBC encoder. This file is included by sbc_simd.c
+ *  once per instruction set, with SBC_SIMD_TARGET set to the matching target
+ *  attribute and SBC_SIMD_NAME suffixing every definition, and therefore has
+ *  no include guard.
+ *
+ ******************************************************************************/
+
+/* SBC_MULT_32_16_SIMPLIFIED on each lane. As |c| is below 0x8000, the 64-bit
+ * product shifted by 15 splits into the high half of |x| times 2 * |c| plus
+ * the low half of |x| times |c| shifted by 15, which both fit in 32 bits. */
+SBC_SIMD_TARGET static inline sbc_v4si SBC_SIMD_NAME(mult)(sbc_v4si x,
+                                                           int32_t c) {
+  return (((x >> 16) * c) << 1) + (((x & 0xFFFF) * c) >> 15);
+}
+
+/* Transposes the 4x4 matrix whose rows are r[0..3] */
+SBC_SIMD_TARGET static inline void SBC_SIMD_NAME(transpose)(sbc_v4si* r) {
+  sbc_v4si t0 = SBC_SHUFFLE(r[0], r[1], 0, 4, 1, 5);
+  sbc_v4si t1 = SBC_SHUFFLE(r[0], r[1], 2, 6, 3, 7);
+  sbc_v4si t2 = SBC_SHUFFLE(r[2], r[3], 0, 4, 1, 5);
+  sbc_v4si t3 = SBC_SHUFFLE(r[2], r[3], 2, 6, 3, 7);
+  r[0] = SBC_SHUFFLE(t0, t2, 0, 1, 4, 5);
+  r[1] = SBC_SHUFFLE(t0, t2, 2, 3, 6, 7);
+  r[2] = SBC_SHUFFLE(t1, t3, 0, 1, 4, 5);
+  r[3] = SBC_SHUFFLE(t1, t3, 2, 3, 6, 7);
+}
+
+/* Loads column |col| to |col| + 3 of 4 rows of |stride| values as 4 vectors
+ * holding one column each */
+SBC_SIMD_TARGET static inline void SBC_SIMD_NAME(load_columns)(
+    const int32_t* p, int32_t stride, int32_t col, sbc_v4si* v) {
+  int32_t i;
+
+  for (i = 0; i < 4; i++) SBC_LOAD(v[i], p + i * stride + col);
+  SBC_SIMD_NAME(transpose)(v);
+}
+
+/* Stores 4 vectors holding one column each to column |col| to |col| + 3 of
+ * 4 rows of |stride| values */
+SBC_SIMD_TARGET static inline void SBC_SIMD_NAME(store_columns)(
+    int32_t* p, int32_t stride, int32_t col, sbc_v4si* v) {
+  int32_t i;
+
+  SBC_SIMD_NAME(transpose)(v);
+  for (i = 0; i < 4; i++) SBC_STORE(p + i * stride + col, v[i]);
+}
+
+/* WINDOW_PARTIAL_4: 5 taps of 8 coefficients */
+SBC_SIMD_TARGET static void SBC_SIMD_NAME(window4)(const int16_t* x,
+                                                   int32_t* y) {
+  sbc_v8si acc = {0, 0, 0, 0, 0, 0, 0, 0};
+  sbc_v8si vx, vw;
+  int32_t j;
+
+  for (j = 0; j < 5; j++) {
+    SBC_LOAD_V8HI(vx, x + j * 8);
+    SBC_LOAD_V8HI(vw, gas16AnalWindow4 + j * 8);
+    acc += vw * vx;
+  }
+  SBC_STORE(y, acc);
+}
+
+/* WINDOW_PARTIAL_8: 5 taps of 16 coefficients */
+SBC_SIMD_TARGET static void SBC_SIMD_NAME(window8)(const int16_t* x,
+                                                   int32_t* y) {
+  sbc_v8si lo = {0, 0, 0, 0, 0, 0, 0, 0};
+  sbc_v8si hi = {0, 0, 0, 0, 0, 0, 0, 0};
+  sbc_v8si vx, vw;
+  int32_t j;
+
+  for (j = 0; j < 5; j++) {
+    SBC_LOAD_V8HI(vx, x + j * 16);
+    SBC_LOAD_V8HI(vw, gas16AnalWindow8 + j * 16);
+    lo += vw * vx;
+    SBC_LOAD_V8HI(vx, x + j * 16 + 8);
+    SBC_LOAD_V8HI(vw, gas16AnalWindow8 + j * 16 + 8);
+    hi += vw * vx;
+  }
+  SBC_STORE(y, lo);
+  SBC_STORE(y + 8, hi);
+}
+
+/* SBC_FastIDCT4 on 4 blocks at a time, one per lane */
+SBC_SIMD_TARGET static void SBC_SIMD_NAME(idct4)(const int32_t* y,
+                                                 int32_t* out,
+                                                 int32_t count) {
+  sbc_v4si in[8], res[4];
+  sbc_v4si temp, x2, tmp[8];
+  int32_t n;
+
+  for (n = 0; n < count; n += 4) {
+    SBC_SIMD_NAME(load_columns)(y, 8, 0, in);
+    SBC_SIMD_NAME(load_columns)(y, 8, 4, in + 4);
+
+    x2 = in[2] >> 1;
+    temp = in[0] + in[4];
+    tmp[0] = SBC_SIMD_NAME(mult)(temp, SBC_COS_PI_SUR_4 >> 1);
+    tmp[1] = x2 - tmp[0];
+    tmp[0] += x2;
+    temp = in[1] + in[3];
+    tmp[3] = SBC_SIMD_NAME(mult)(temp, SBC_COS_3PI_SUR_8 >> 1);
+    tmp[2] = SBC_SIMD_NAME(mult)(temp, SBC_COS_PI_SUR_8 >> 1);
+    temp = in[5] - in[7];
+    tmp[5] = SBC_SIMD_NAME(mult)(temp, SBC_COS_3PI_SUR_8 >> 1);
+    tmp[4] = SBC_SIMD_NAME(mult)(temp, SBC_COS_PI_SUR_8 >> 1);
+    tmp[6] = tmp[2] + tmp[5];
+    tmp[7] = tmp[3] - tmp[4];
+    res[0] = tmp[0] + tmp[6];
+    res[1] = tmp[1] + tmp[7];
+    res[2] = tmp[1] - tmp[7];
+    res[3] = tmp[0] - tmp[6];
+
+    SBC_SIMD_NAME(store_columns)(out, 4, 0, res);
+    y += 4 * 8;
+    out += 4 * 4;
+  }
+}
+
+/* SBC_FastIDCT8 on 4 blocks at a time, one per lane */
+SBC_SIMD_TARGET static void SBC_SIMD_NAME(idct8)(const int32_t* y,
+                                                 int32_t* out,
+                                                 int32_t count) {
+  sbc_v4si in[16], res[8];
+  sbc_v4si x0, x1, x2, x3, x4, x5, x6, x7, temp;
+  sbc_v4si res_even[4], res_odd[4];
+  int32_t n, k;
+
+  for (n = 0; n < count; n += 4) {
+    for (k = 0; k < 16; k += 4) SBC_SIMD_NAME(load_columns)(y, 16, k, in + k);
+
+    x0 = SBC_SIMD_NAME(mult)(in[4], SBC_COS_PI_SUR_4);
+    x1 = (in[3] + in[5]) >> 1;
+    x2 = (in[2] + in[6]) >> 1;
+    x3 = (in[1] + in[7]) >> 1;
+    x4 = (in[0] + in[8]) >> 1;
+    x5 = (in[9] - in[15]) >> 1;
+    x6 = (in[10] - in[14]) >> 1;
+    x7 = (in[11] - in[13]) >> 1;
+
+    temp = x0;
+    x0 = SBC_SIMD_NAME(mult)(x0 + x4, SBC_COS_PI_SUR_4);
+    x4 = SBC_SIMD_NAME(mult)(temp - x4, SBC_COS_PI_SUR_4);
+
+    x2 -= x6;
+    x6 <<= 1;
+
+    x6 = SBC_SIMD_NAME(mult)(x6, SBC_COS_PI_SUR_4);
+    temp = x2;
+    x2 = SBC_SIMD_NAME(mult)(x2 + x6, SBC_COS_PI_SUR_8);
+    x6 = SBC_SIMD_NAME(mult)(temp - x6, SBC_COS_3PI_SUR_8);
+
+    res_even[0] = x0 + x2;
+    res_even[1] = x4 + x6;
+    res_even[2] = x4 - x6;
+    res_even[3] = x0 - x2;
+
+    x7 <<= 1;
+    x5 = (x5 << 1) - x7;
+    x3 = (x3 << 1) - x5;
+    x1 -= x3 >> 1;
+
+    x5 = SBC_SIMD_NAME(mult)(x5, SBC_COS_PI_SUR_4);
+    temp = x1;
+    x1 = x1 + x5;
+    x5 = temp - x5;
+
+    x3 -= x7;
+    x7 <<= 1;
+    x7 = SBC_SIMD_NAME(mult)(x7, SBC_COS_PI_SUR_4);
+
+    temp = x3;
+    x3 = SBC_SIMD_NAME(mult)(x3 + x7, SBC_COS_PI_SUR_8);
+    x7 = SBC_SIMD_NAME(mult)(temp - x7, SBC_COS_3PI_SUR_8);
+
+    res_odd[0] = SBC_SIMD_NAME(mult)(x1 + x3, SBC_COS_PI_SUR_16);
+    res_odd[1] = SBC_SIMD_NAME(mult)(x5 + x7, SBC_COS_3PI_SUR_16);
+    res_odd[2] = SBC_SIMD_NAME(mult)(x5 - x7, SBC_COS_5PI_SUR_16);
+    res_odd[3] = SBC_SIMD_NAME(mult)(x1 - x3, SBC_COS_7PI_SUR_16);
+
+    res[0] = res_even[0] + res_odd[0];
+    res[1] = res_even[1] + res_odd[1];
+    res[2] = res_even[2] + res_odd[2];
+    res[3] = res_even[3] + res_odd[3];
+    res[7] = res_even[0] - res_odd[0];
+    res[6] = res_even[1] - res_odd[1];
+    res[5] = res_even[2] - res_odd[2];
+    res[4] = res_even[3] - res_odd[3];
+
+    SBC_SIMD_NAME(store_columns)(out, 8, 0, res);
+    SBC_SIMD_NAME(store_columns)(out, 8, 4, res + 4);
+    y += 4 * 16;
+    out += 4 * 8;
+  }
+}
+
+SBC_SIMD_TARGET static void SBC_SIMD_NAME(max_abs)(const int32_t* sb,
+                                                   int32_t stride,
+                                                   int32_t blocks,
+                                                   int32_t* max) {
+  sbc_v4si v, m;
+  int32_t k, blk;
+
+  for (k = 0; k < stride; k += 4) {
+    m = (sbc_v4si){0, 0, 0, 0};
+    for (blk = 0; blk < blocks; blk++) {
+      SBC_LOAD(v, sb + blk * stride + k);
+      v = SBC_ABS(v);
+      m = SBC_MAX(m, v);
+    }
+    SBC_STORE(max + k, m);
+  }
+}
+
+SBC_SIMD_TARGET static void SBC_SIMD_NAME(max_abs_joint)(const int32_t* sb,
+                                                         int32_t subbands,
+                                                         int32_t blocks,
+                                                         int32_t* max_sum,
+                                                         int32_t* max_diff) {
+  sbc_v4si left, right, sum, diff, msum, mdiff;
+  int32_t k, blk;
+
+  for (k = 0; k < subbands; k += 4) {
+    msum = (sbc_v4si){0, 0, 0, 0};
+    mdiff = (sbc_v4si){0, 0, 0, 0};
+    for (blk = 0; blk < blocks; blk++) {
+      SBC_LOAD(left, sb + blk * 2 * subbands + k);
+      SBC_LOAD(right, sb + blk * 2 * subbands + subbands + k);
+      sum = (left + right) >> 1;
+      diff = (left - right) >> 1;
+      sum = SBC_ABS(sum);
+      diff = SBC_ABS(diff);
+      msum = SBC_MAX(msum, sum);
+      mdiff = SBC_MAX(mdiff, diff);
+    }
+    SBC_STORE(max_sum + k, msum);
+    SBC_STORE(max_diff + k, mdiff);
+  }
+}
+
+SBC_SIMD_TARGET static int32_t SBC_SIMD_NAME(bit_slice)(
+    const int16_t* bitneed, int32_t count, int32_t max_bitneed,
+    int32_t bit_pool, int32_t* bit_count, int32_t* slice_count) {
+  int16_t as16BitNeed[16];
+  sbc_v8si lo, hi, dlo, dhi, n;
+  int32_t i, s32BitSlice, s32BitCount, s32SliceCount;
+
+  /* Unused lanes are far enough below every slice to never count */
+  for (i = 0; i < 16; i++) as16BitNeed[i] = (i < count) ? bitneed[i] : INT16_MIN;
+  SBC_LOAD_V8HI(lo, as16BitNeed);
+  SBC_LOAD_V8HI(hi, as16BitNeed + 8);
+
+  s32BitSlice = max_bitneed + 1;
+  s32BitCount = bit_pool;
+  s32SliceCount = 0;
+  do {
+    s32BitSlice--;
+    s32BitCount -= s32SliceCount;
+
+    /* -1 per bitneed less than 16 slices above, and another -1 if it is
+     * just one slice above */
+    dlo = lo - s32BitSlice;
+    dhi = hi - s32BitSlice;
+    n = ((dlo >= 1) & (dlo < 16)) + (dlo == 1) + ((dhi >= 1) & (dhi < 16)) +
+        (dhi == 1);
+    s32SliceCount = 0;
+    for (i = 0; i < 8; i++) s32SliceCount -= n[i];
+  } while (s32BitCount - s32SliceCount > 0);
+
+  *bit_count = s32BitCount;
+  *slice_count = s32SliceCount;
+  return s32BitSlice;
+}
+
+SBC_SIMD_TARGET static void SBC_SIMD_NAME(quantize)(
+    const int32_t* sb, const int32_t* bias, const int32_t* mult, int32_t stride,
+    int32_t blocks, uint32_t* out) {
+  sbc_v4si v, vbias, vmult, q;
+  sbc_v4di p;
+  int32_t k, blk;
+
+  for (k = 0; k < stride; k += 4) {
+    SBC_LOAD(vbias, bias + k);
+    SBC_LOAD(vmult, mult + k);
+    for (blk = 0; blk < blocks; blk++) {
+      SBC_LOAD(v, sb + blk * stride + k);
+      v = (v >> 2) + vbias;
+      p = __builtin_convertvector(v, sbc_v4di) *
+          __builtin_convertvector(vmult, sbc_v4di);
+      q = __builtin_convertvector((sbc_v4du)p >> 29, sbc_v4si) & 0xFFFF;
+      SBC_STORE(out + blk * stride + k, q);
+    }
+  }
+}
+
+static const SBC_ENC_SIMD SBC_SIMD_NAME(sbc_enc_simd) = {
+    SBC_SIMD_NAME(window4),  SBC_SIMD_NAME(window8),
+    SBC_SIMD_NAME(idct4),    SBC_SIMD_NAME(idct8),
+    SBC_SIMD_NAME(max_abs),  SBC_SIMD_NAME(max_abs_joint),
+    SBC_SIMD_NAME(bit_slice), SBC_SIMD_NAME(quantize),
+};
@@ -102,3 +102,7 @@ void post_to_hci_message_loop(const base::Location& from_here,
                               BT_HDR* p_msg);
 
 void hci_layer_cleanup_interface();
+
+// Writes command flow control state and per-opcode command latency
+// histograms to |fd|.
+void hci_layer_debug_dump(int fd);
@@ -18,6 +18,7 @@
 
 #define LOG_TAG "bt_snoop"
 
+#include <algorithm>
 #include <mutex>
 
 #include <arpa/inet.h>
@@ -31,10 +32,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/eventfd.h>
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/uio.h>
 #include <unistd.h>
+#include <atomic>
 #include <mutex>
 #include <unordered_map>
 #include <unordered_set>
@@ -44,8 +47,10 @@
 #include "hci/include/btsnoop_mem.h"
 #include "hci_layer.h"
 #include "internal_include/bt_trace.h"
+#include "osi/include/allocator.h"
 #include "osi/include/log.h"
 #include "osi/include/properties.h"
+#include "osi/include/thread.h"
 #include "osi/include/time.h"
 #include "stack/include/hcimsgs.h"
 #include "stack/include/rfcdefs.h"
@@ -81,6 +86,16 @@
 #endif  //OFF_TARGET_TEST_ENABLED
 #define BTSNOOP_MAX_PACKETS_PROPERTY "persist.bluetooth.btsnoopsize"
 
+// Captured packets are staged in a ring of this many bytes (a power of two)
+// and written out by the snoop writer thread in batches. The writer is woken
+// early once |SNOOP_RING_WAKE_THRESHOLD| bytes are pending, otherwise every
+// |SNOOP_RING_FLUSH_INTERVAL_MS|. Packets that do not fit are dropped and
+// counted in the |dropped_packets| field of the next record.
+#define SNOOP_RING_SIZE (1 << 20)
+#define SNOOP_RING_WAKE_THRESHOLD (SNOOP_RING_SIZE / 8)
+#define SNOOP_RING_FLUSH_INTERVAL_MS 200
+#define SNOOP_WRITE_TIMEOUT_MS 500
+
 typedef enum {
   kCommandPacket = 1,
   kAclPacket = 2,
@@ -106,8 +121,25 @@ static std::mutex btsnoop_mutex;
 static std::mutex btSnoopFd_mutex;
 
 static int32_t packets_per_file;
-static int32_t packet_counter;
-static bool sock_snoop_active = false;
+// Read and updated by the snoop writer thread, set by start_up() and
+// update_snoop_fd() on other threads.
+static std::atomic<int32_t> packet_counter{0};
+static std::atomic_bool sock_snoop_active{false};
+
+// Staging ring between capture(), which is serialized by |btsnoop_mutex|, and
+// the snoop writer thread. |head| and |tail| are free-running byte offsets
+// advanced by the producer and the writer respectively.
+typedef struct {
+  uint8_t* buffer;
+  std::atomic<size_t> head;
+  std::atomic<size_t> tail;
+  std::atomic<bool> stopping;
+  uint32_t dropped_packets;
+  int wakeup_fd;
+} snoop_ring_t;
+
+static snoop_ring_t snoop_ring = {NULL, {0}, {0}, {false}, 0, INVALID_FD};
+static thread_t* snoop_writer_thread;
 
 extern bt_logger_interface_t *logger_interface;
 int64_t gmt_offset;
@@ -190,6 +222,8 @@ static std::string get_btsnoop_last_log_path(std::string log_path);
 static void open_next_snoop_file();
 static void btsnoop_write_packet(packet_type_t type, uint8_t* packet,
                                  bool is_received, uint64_t timestamp_us);
+static void snoop_writer_start(void);
+static void snoop_writer_stop(void);
 
 // Module lifecycle functions
 
@@ -264,6 +298,7 @@ static future_t* start_up() {
     open_next_snoop_file();
     packets_per_file = (//osi_property_get_int32(BTSNOOP_MAX_PACKETS_PROPERTY,
                                               DEFAULT_BTSNOOP_SIZE);
+    snoop_writer_start();
     btsnoop_net_open();
     START_SNOOP_LOGGING();
   }
@@ -274,6 +309,8 @@ static future_t* start_up() {
 
 static future_t* shut_down(void) {
   std::lock_guard<std::mutex> lock(btsnoop_mutex);
+  snoop_writer_stop();
+
 #if (OFF_TARGET_TEST_ENABLED == FALSE)
   if (is_btsnoop_enabled) {
     if (is_btsnoop_filtered) {
@@ -485,6 +522,168 @@ static uint64_t htonll(uint64_t ll) {
   return ll;
 }
 
+static void snoop_ring_copy_in(size_t pos, const void* data, size_t length) {
+  size_t offset = pos & (SNOOP_RING_SIZE - 1);
+  size_t first = std::min(length, (size_t)SNOOP_RING_SIZE - offset);
+  memcpy(snoop_ring.buffer + offset, data, first);
+  memcpy(snoop_ring.buffer, static_cast<const uint8_t*>(data) + first,
+         length - first);
+}
+
+static void snoop_ring_copy_out(size_t pos, void* data, size_t length) {
+  size_t offset = pos & (SNOOP_RING_SIZE - 1);
+  size_t first = std::min(length, (size_t)SNOOP_RING_SIZE - offset);
+  memcpy(data, snoop_ring.buffer + offset, first);
+  memcpy(static_cast<uint8_t*>(data) + first, snoop_ring.buffer,
+         length - first);
+}
+
+// Stages one record for the writer thread. Called with |btsnoop_mutex| held,
+// so there is only ever one producer. Never blocks: if the writer has fallen
+// behind, the packet is dropped and accounted for in the next record.
+static void snoop_ring_put(btsnoop_header_t* header, const uint8_t* packet,
+                           size_t length) {
+  if (snoop_ring.buffer == NULL) return;
+
+  size_t head = snoop_ring.head.load(std::memory_order_relaxed);
+  size_t tail = snoop_ring.tail.load(std::memory_order_acquire);
+  size_t record_length = sizeof(btsnoop_header_t) + length;
+  if (SNOOP_RING_SIZE - (head - tail) < record_length) {
+    snoop_ring.dropped_packets++;
+    return;
+  }
+
+  header->dropped_packets = htonl(snoop_ring.dropped_packets);
+  snoop_ring_copy_in(head, header, sizeof(btsnoop_header_t));
+  snoop_ring_copy_in(head + sizeof(btsnoop_header_t), packet, length);
+  snoop_ring.head.store(head + record_length, std::memory_order_release);
+
+  // Only wake the writer once per crossing of the threshold; below it the
+  // periodic flush picks the records up.
+  if (head - tail < SNOOP_RING_WAKE_THRESHOLD &&
+      head + record_length - tail >= SNOOP_RING_WAKE_THRESHOLD)
+    eventfd_write(snoop_ring.wakeup_fd, 1ULL);
+}
+
+// Writes the records in [|start|, |end|) of the ring to the snoop file and
+// the network client.
+static void snoop_write_records(size_t start, size_t end) {
+  size_t offset = start & (SNOOP_RING_SIZE - 1);
+  size_t length = end - start;
+  size_t first = std::min(length, (size_t)SNOOP_RING_SIZE - offset);
+  iovec iov[] = {{snoop_ring.buffer + offset, first},
+                 {snoop_ring.buffer, length - first}};
+  int iov_count = (first == length) ? 1 : 2;
+
+  for (int i = 0; i < iov_count; i++)
+    btsnoop_net_write(iov[i].iov_base, iov[i].iov_len);
+
+  std::lock_guard<std::mutex> lock(btSnoopFd_mutex);
+  if (logfile_fd == INVALID_FD) return;
+
+  struct pollfd fds;
+  fds.fd = logfile_fd;
+  fds.events = POLLOUT;
+
+  int status = poll(&fds, 1, SNOOP_WRITE_TIMEOUT_MS);
+  if (status > 0 && fds.revents & POLLOUT) {
+    ssize_t ret;
+    OSI_NO_INTR(ret = writev(logfile_fd, iov, iov_count));
+    if (ret != (ssize_t)length)
+      LOG_ERROR(LOG_TAG, "%s short write %zd of %zu bytes: %s", __func__, ret,
+                length, strerror(errno));
+  } else if (status == 0) {
+    LOG_WARN(LOG_TAG, "%s poll() timeout, %zu bytes lost", __func__, length);
+  } else if (status == -1) {
+    LOG_ERROR(LOG_TAG, "%s poll failed errno %d (%s)", __func__, errno,
+              strerror(errno));
+  }
+}
+
+// Drains everything staged so far, rotating to the next snoop file every
+// |packets_per_file| records.
+static void snoop_ring_flush(void) {
+  size_t tail = snoop_ring.tail.load(std::memory_order_relaxed);
+  size_t head = snoop_ring.head.load(std::memory_order_acquire);
+
+  while (tail != head) {
+    if (!sock_snoop_active && packet_counter >= packets_per_file)
+      open_next_snoop_file();
+
+    size_t end = tail;
+    while (end != head &&
+           (sock_snoop_active || packet_counter < packets_per_file)) {
+      btsnoop_header_t header;
+      snoop_ring_copy_out(end, &header, sizeof(btsnoop_header_t));
+      end += sizeof(btsnoop_header_t) + ntohl(header.length_captured) - 1;
+      packet_counter++;
+    }
+
+    snoop_write_records(tail, end);
+    tail = end;
+    snoop_ring.tail.store(tail, std::memory_order_release);
+  }
+}
+
+static void snoop_writer_run(UNUSED_ATTR void* context) {
+  while (!snoop_ring.stopping.load(std::memory_order_relaxed)) {
+    struct pollfd fds;
+    fds.fd = snoop_ring.wakeup_fd;
+    fds.events = POLLIN;
+    if (poll(&fds, 1, SNOOP_RING_FLUSH_INTERVAL_MS) > 0) {
+      eventfd_t value;
+      eventfd_read(snoop_ring.wakeup_fd, &value);
+    }
+    snoop_ring_flush();
+  }
+
+  snoop_ring_flush();
+}
+
+static void snoop_writer_start(void) {
+  snoop_ring.wakeup_fd = eventfd(0, EFD_NONBLOCK);
+  if (snoop_ring.wakeup_fd == INVALID_FD) {
+    LOG_ERROR(LOG_TAG, "%s unable to create eventfd: %s", __func__,
+              strerror(errno));
+    return;
+  }
+
+  snoop_ring.buffer = static_cast<uint8_t*>(osi_malloc(SNOOP_RING_SIZE));
+  snoop_ring.head = 0;
+  snoop_ring.tail = 0;
+  snoop_ring.stopping = false;
+  snoop_ring.dropped_packets = 0;
+
+  snoop_writer_thread = thread_new("btsnoop_writer");
+  if (snoop_writer_thread == NULL) {
+    LOG_ERROR(LOG_TAG, "%s unable to create writer thread", __func__);
+    snoop_writer_stop();
+    return;
+  }
+  thread_post(snoop_writer_thread, snoop_writer_run, NULL);
+}
+
+// Flushes whatever is still staged and stops the writer thread. Called with
+// |btsnoop_mutex| held so no new records arrive meanwhile.
+static void snoop_writer_stop(void) {
+  if (snoop_writer_thread != NULL) {
+    snoop_ring.stopping = true;
+    eventfd_write(snoop_ring.wakeup_fd, 1ULL);
+    thread_free(snoop_writer_thread);
+    snoop_writer_thread = NULL;
+  }
+
+  if (snoop_ring.dropped_packets)
+    LOG_WARN(LOG_TAG, "%s dropped %u packets while the writer was behind",
+             __func__, snoop_ring.dropped_packets);
+
+  osi_free_and_reset((void**)&snoop_ring.buffer);
+  if (snoop_ring.wakeup_fd != INVALID_FD) {
+    close(snoop_ring.wakeup_fd);
+    snoop_ring.wakeup_fd = INVALID_FD;
+  }
+}
+
 static void calculate_acl_packet_length(uint32_t *length, uint8_t* packet, bool is_received) {
   uint32_t def_len = (packet[3] << 8) + packet[2] + 5;
   static const size_t HCI_ACL_HEADER_SIZE = 4;
@@ -557,7 +756,6 @@ static void btsnoop_write_packet(packet_type_t type, uint8_t* packet,
                                  bool is_received, uint64_t timestamp_us) {
   uint32_t length_he = 0;
   uint32_t flags = 0;
-  int status = 0;
 
   switch (type) {
     case kCommandPacket:
@@ -593,35 +791,10 @@ static void btsnoop_write_packet(packet_type_t type, uint8_t* packet,
       blacklisted ? htonl(L2C_HEADER_SIZE) : header.length_original;
   if (blacklisted) length_he = L2C_HEADER_SIZE;
   header.flags = htonl(flags);
-  header.dropped_packets = 0;
   header.timestamp = htonll(timestamp_us + BTSNOOP_EPOCH_DELTA);
   header.type = type;
 
-  btsnoop_net_write(&header, sizeof(btsnoop_header_t));
-  btsnoop_net_write(packet, length_he - 1);
-
-  if (logfile_fd != INVALID_FD) {
-    packet_counter++;
-    if (!sock_snoop_active && packet_counter > packets_per_file) {
-      open_next_snoop_file();
-    }
-
-    struct pollfd fds;
-    fds.fd = logfile_fd;
-    fds.events = POLLOUT;
-    iovec iov[] = {{&header, sizeof(btsnoop_header_t)},
-                   {reinterpret_cast<void*>(packet), length_he - 1}};
-
-    status = poll(&fds, 1, 0);
-    if(status > 0 && fds.revents & POLLOUT) {
-      TEMP_FAILURE_RETRY(writev(logfile_fd, iov, 2));
-    } else if (status == 0) {
-      LOG_WARN(LOG_TAG, "%s poll() timeout", __func__);
-    } else if (status == -1) {
-      LOG_ERROR(LOG_TAG, "%s poll failed errno %d (%s)",
-                    __func__, errno, strerror(errno));
-    }
-  }
+  snoop_ring_put(&header, packet, length_he - 1);
 }
 
 void update_snoop_fd(int snoop_fd) {
@@ -20,10 +20,11 @@
 
 #include "bt_common.h"
 #include "buffer_allocator.h"
+#include "osi/include/pool_allocator.h"
 
 static void* buffer_alloc(size_t size) {
   CHECK(size <= BT_DEFAULT_BUFFER_SIZE);
-  return osi_malloc(size);
+  return pool_allocator_alloc(size);
 }
 
 static const allocator_t interface = {buffer_alloc, osi_free};
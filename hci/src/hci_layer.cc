@@ -27,12 +27,17 @@
 #include <base/threading/thread.h>
 
 #include <signal.h>
+#include <stdio.h>
 #include <string.h>
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <atomic>
 #include <chrono>
+#include <deque>
+#include <map>
 #include <mutex>
+#include <unordered_map>
 
 #include "btcore/include/module.h"
 #include "btsnoop.h"
@@ -43,7 +48,6 @@
 #include "hcimsgs.h"
 #include "bt_utils.h"
 #include "osi/include/alarm.h"
-#include "osi/include/list.h"
 #include "osi/include/log.h"
 #include "osi/include/properties.h"
 #include "osi/include/reactor.h"
@@ -61,7 +65,7 @@ extern void hci_log_firmware_debug_packet(int fd, BT_HDR* packet);
 
 static int hci_firmware_log_fd = INVALID_FD;
 
-typedef struct {
+typedef struct waiting_command_t {
   uint16_t opcode;
   future_t* complete_future;
   command_complete_cb complete_callback;
@@ -69,8 +73,26 @@ typedef struct {
   void* context;
   BT_HDR* command;
   std::chrono::time_point<std::chrono::steady_clock> timestamp;
+
+  // Links in the send-ordered list of commands pending response.
+  struct waiting_command_t* pending_prev;
+  struct waiting_command_t* pending_next;
 } waiting_command_t;
 
+// Upper bounds, in milliseconds, of the command latency histogram buckets.
+// Responses slower than the last bound land in an extra overflow bucket.
+static const int LATENCY_BUCKET_BOUNDS_MS[] = {1,  2,   5,   10,  20,
+                                               50, 100, 200, 500, 1000};
+#define LATENCY_BUCKET_COUNT \
+  (sizeof(LATENCY_BUCKET_BOUNDS_MS) / sizeof(LATENCY_BUCKET_BOUNDS_MS[0]) + 1)
+
+typedef struct {
+  size_t count;
+  uint64_t total_us;
+  uint64_t max_us;
+  size_t buckets[LATENCY_BUCKET_COUNT];
+} command_latency_t;
+
 // Using a define here, because it can be stringified for the property lookup
 // Reducing startup timeout to less than 3sec to ensure that wakelock is aquired
 // during initialization
@@ -115,10 +137,22 @@ static int command_credits = 1;
 static std::mutex command_credits_mutex;
 static std::queue<base::Closure> command_queue;
 
+// Number of commands handed to the message loop that have not yet been
+// added to the commands pending response.
+static std::atomic<int> commands_posted(0);
+
 // Inbound-related
 static alarm_t* command_response_timer;
-static list_t* commands_pending_response;
 static std::recursive_mutex commands_pending_response_mutex;
+// Commands awaiting a response, oldest first. Entries are also indexed by
+// opcode, in send order, so the matching response finds them directly.
+static waiting_command_t* commands_pending_head;
+static waiting_command_t* commands_pending_tail;
+static int commands_pending_count;
+static std::unordered_map<command_opcode_t, std::deque<waiting_command_t*>>
+    commands_pending_by_opcode;
+// Response latency per opcode, guarded by |commands_pending_response_mutex|.
+static std::map<command_opcode_t, command_latency_t> command_latencies;
 
 // The hand-off point for data going to a higher layer, set by the higher layer
 static base::Callback<void(const base::Location&, BT_HDR*)>
@@ -127,6 +161,9 @@ static base::Callback<void(const base::Location&, BT_HDR*)>
 static bool filter_incoming_event(BT_HDR* packet);
 static waiting_command_t* get_waiting_command(command_opcode_t opcode);
 static int get_num_waiting_commands();
+static void add_waiting_command(waiting_command_t* wait_entry);
+static void remove_waiting_command(waiting_command_t* wait_entry);
+static void record_command_latency(const waiting_command_t* wait_entry);
 
 static void event_finish_startup(void* context);
 static void startup_timer_expired(void* context);
@@ -204,6 +241,7 @@ static future_t* hci_module_start_up(void) {
   // This value can change when you get a command complete or command status
   // event.
   command_credits = 1;
+  commands_posted = 0;
 
   // For now, always use the default timeout on non-Android builds.
   period_ms_t startup_timeout_ms = DEFAULT_STARTUP_TIMEOUT_MS;
@@ -246,14 +284,6 @@ static future_t* hci_module_start_up(void) {
     LOG_ERROR(LOG_TAG, "%s unable to make thread RT.", __func__);
   }
 
-  commands_pending_response = list_new(NULL);
-  if (!commands_pending_response) {
-    LOG_ERROR(LOG_TAG,
-              "%s unable to create list for commands pending response.",
-              __func__);
-    goto error;
-  }
-
   // Make sure we run in a bounded amount of time
   future_t* local_startup_future;
   local_startup_future = future_new();
@@ -301,8 +331,10 @@ static future_t* hci_module_shut_down() {
 
   {
     std::lock_guard<std::recursive_mutex> lock(commands_pending_response_mutex);
-    list_free(commands_pending_response);
-    commands_pending_response = NULL;
+    commands_pending_head = NULL;
+    commands_pending_tail = NULL;
+    commands_pending_count = 0;
+    commands_pending_by_opcode.clear();
   }
 
   packet_fragmenter->cleanup();
@@ -434,6 +466,7 @@ static void enqueue_command(waiting_command_t* wait_entry) {
       osi_free(wait_entry);
       return;
     }
+    commands_posted++;
     message_loop_->task_runner()->PostTask(FROM_HERE, std::move(callback));
     command_credits--;
   } else {
@@ -446,7 +479,8 @@ static void event_command_ready(waiting_command_t* wait_entry) {
     /// Move it to the list of commands awaiting response
     std::lock_guard<std::recursive_mutex> lock(commands_pending_response_mutex);
     wait_entry->timestamp = std::chrono::steady_clock::now();
-    list_append(commands_pending_response, wait_entry);
+    add_waiting_command(wait_entry);
+    commands_posted--;
   }
   // Send it off
   packet_fragmenter->fragment_and_dispatch(wait_entry->command);
@@ -522,11 +556,8 @@ static void command_timed_out(void* original_wait_entry) {
   LOG_ERROR(LOG_TAG, "%s: %d commands pending response", __func__,
             get_num_waiting_commands());
 
-  for (const list_node_t* node = list_begin(commands_pending_response);
-       node != list_end(commands_pending_response); node = list_next(node)) {
-    waiting_command_t* wait_entry =
-        reinterpret_cast<waiting_command_t*>(list_node(node));
-
+  for (waiting_command_t* wait_entry = commands_pending_head; wait_entry != NULL;
+       wait_entry = wait_entry->pending_next) {
     int wait_time_ms =
         std::chrono::duration_cast<std::chrono::milliseconds>(
             std::chrono::steady_clock::now() - wait_entry->timestamp)
@@ -596,10 +627,12 @@ void process_command_credits(int credits) {
     return;
   }
 
-  // Subtract commands in flight.
-  command_credits = credits - get_num_waiting_commands();
+  // Subtract commands in flight, including those already handed to the
+  // message loop but not yet sent.
+  command_credits = credits - get_num_waiting_commands() - commands_posted;
 
   while (command_credits > 0 && command_queue.size() > 0) {
+    commands_posted++;
     message_loop_->task_runner()->PostTask(FROM_HERE,
                                            std::move(command_queue.front()));
     command_queue.pop();
@@ -713,54 +746,101 @@ static void dispatch_reassembled(BT_HDR* packet) {
 
 // Misc internal functions
 
-static waiting_command_t* get_waiting_command(command_opcode_t opcode) {
-  std::lock_guard<std::recursive_mutex> lock(commands_pending_response_mutex);
-
-  for (const list_node_t* node = list_begin(commands_pending_response);
-       node != list_end(commands_pending_response); node = list_next(node)) {
-    waiting_command_t* wait_entry =
-        reinterpret_cast<waiting_command_t*>(list_node(node));
+static void add_waiting_command(waiting_command_t* wait_entry) {
+  wait_entry->pending_prev = commands_pending_tail;
+  wait_entry->pending_next = NULL;
+  if (commands_pending_tail != NULL)
+    commands_pending_tail->pending_next = wait_entry;
+  else
+    commands_pending_head = wait_entry;
+  commands_pending_tail = wait_entry;
+  commands_pending_count++;
+
+  commands_pending_by_opcode[wait_entry->opcode].push_back(wait_entry);
+}
 
-    if (!wait_entry || wait_entry->opcode != opcode) continue;
+// Responses to the same opcode arrive in send order, so |wait_entry| is
+// always the oldest pending command with its opcode.
+static void remove_waiting_command(waiting_command_t* wait_entry) {
+  waiting_command_t* prev = wait_entry->pending_prev;
+  waiting_command_t* next = wait_entry->pending_next;
+  if (prev != NULL)
+    prev->pending_next = next;
+  else
+    commands_pending_head = next;
+  if (next != NULL)
+    next->pending_prev = prev;
+  else
+    commands_pending_tail = prev;
+  wait_entry->pending_prev = NULL;
+  wait_entry->pending_next = NULL;
+  commands_pending_count--;
+
+  auto it = commands_pending_by_opcode.find(wait_entry->opcode);
+  CHECK(it != commands_pending_by_opcode.end());
+  CHECK(it->second.front() == wait_entry);
+  it->second.pop_front();
+  if (it->second.empty()) commands_pending_by_opcode.erase(it);
+}
 
-    list_remove(commands_pending_response, wait_entry);
+static void record_command_latency(const waiting_command_t* wait_entry) {
+  uint64_t latency_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - wait_entry->timestamp)
+          .count();
+
+  command_latency_t& latency = command_latencies[wait_entry->opcode];
+  latency.count++;
+  latency.total_us += latency_us;
+  latency.max_us = std::max(latency.max_us, latency_us);
+
+  size_t bucket = 0;
+  while (bucket < LATENCY_BUCKET_COUNT - 1 &&
+         latency_us >= (uint64_t)LATENCY_BUCKET_BOUNDS_MS[bucket] * 1000)
+    bucket++;
+  latency.buckets[bucket]++;
+}
 
-    return wait_entry;
-  }
-  // look for any command complete with improper VS Opcode
-  for (const list_node_t *node = list_begin(commands_pending_response);
-      node != list_end(commands_pending_response);
-      node = list_next(node)) {
-    waiting_command_t *wait_entry =
-        reinterpret_cast<waiting_command_t*> (list_node(node));
+static waiting_command_t* get_waiting_command(command_opcode_t opcode) {
+  std::lock_guard<std::recursive_mutex> lock(commands_pending_response_mutex);
 
-    if (wait_entry && (wait_entry->opcode != opcode) &&
-        (((wait_entry->opcode & HCI_GRP_VENDOR_SPECIFIC) == HCI_GRP_VENDOR_SPECIFIC) &&
-         (((opcode & HCI_GRP_VENDOR_SPECIFIC) == HCI_GRP_VENDOR_SPECIFIC) ||
-            opcode == 0))) {
-      LOG_DEBUG(LOG_TAG,"%s Treat it as valid, wait_entry opcode 0x%x opcode 0x%x",
-                __func__, wait_entry->opcode, opcode);
-    } else {
-      continue;
+  waiting_command_t* wait_entry = NULL;
+  auto it = commands_pending_by_opcode.find(opcode);
+  if (it != commands_pending_by_opcode.end()) {
+    wait_entry = it->second.front();
+  } else {
+    // look for any command complete with improper VS Opcode
+    for (waiting_command_t* entry = commands_pending_head; entry != NULL;
+         entry = entry->pending_next) {
+      if (((entry->opcode & HCI_GRP_VENDOR_SPECIFIC) ==
+           HCI_GRP_VENDOR_SPECIFIC) &&
+          (((opcode & HCI_GRP_VENDOR_SPECIFIC) == HCI_GRP_VENDOR_SPECIFIC) ||
+           opcode == 0)) {
+        LOG_DEBUG(LOG_TAG,
+                  "%s Treat it as valid, wait_entry opcode 0x%x opcode 0x%x",
+                  __func__, entry->opcode, opcode);
+        wait_entry = entry;
+        break;
+      }
     }
-
-    list_remove(commands_pending_response, wait_entry);
-
-    return wait_entry;
   }
-  return NULL;
+  if (wait_entry == NULL) return NULL;
+
+  remove_waiting_command(wait_entry);
+  record_command_latency(wait_entry);
+  return wait_entry;
 }
 
 static int get_num_waiting_commands() {
   std::lock_guard<std::recursive_mutex> lock(commands_pending_response_mutex);
-  return list_length(commands_pending_response);
+  return commands_pending_count;
 }
 
 static void update_command_response_timer(void) {
   std::lock_guard<std::recursive_mutex> lock(commands_pending_response_mutex);
 
   if (command_response_timer == NULL) return;
-  if (list_is_empty(commands_pending_response)) {
+  if (commands_pending_head == NULL) {
     if (alarm_is_scheduled(command_response_timer)) {
       alarm_cancel(command_response_timer);
     } else {
@@ -769,7 +849,36 @@ static void update_command_response_timer(void) {
     }
   } else {
     alarm_set(command_response_timer, COMMAND_PENDING_TIMEOUT_MS,
-              command_timed_out, list_front(commands_pending_response));
+              command_timed_out, commands_pending_head);
+  }
+}
+
+void hci_layer_debug_dump(int fd) {
+  dprintf(fd, "\nHCI Command Flow Control:\n");
+  {
+    std::lock_guard<std::mutex> command_credits_lock(command_credits_mutex);
+    dprintf(fd, "  Command credits: %d\n", command_credits);
+    dprintf(fd, "  Commands queued for credits: %zu\n", command_queue.size());
+  }
+  dprintf(fd, "  Commands posted, not yet sent: %d\n", commands_posted.load());
+
+  std::lock_guard<std::recursive_mutex> lock(commands_pending_response_mutex);
+  dprintf(fd, "  Commands pending response: %d\n", commands_pending_count);
+
+  dprintf(fd, "\nHCI Command Latency (ms):\n");
+  dprintf(fd, "  Opcode  Count     Avg     Max    ");
+  for (size_t i = 0; i < LATENCY_BUCKET_COUNT - 1; i++)
+    dprintf(fd, " <%-5d", LATENCY_BUCKET_BOUNDS_MS[i]);
+  dprintf(fd, " >=%d\n", LATENCY_BUCKET_BOUNDS_MS[LATENCY_BUCKET_COUNT - 2]);
+
+  for (const auto& it : command_latencies) {
+    const command_latency_t& latency = it.second;
+    dprintf(fd, "  0x%04x  %-8zu  %-6.1f  %-6.1f ", it.first, latency.count,
+            latency.total_us / 1000.0 / latency.count,
+            latency.max_us / 1000.0);
+    for (size_t i = 0; i < LATENCY_BUCKET_COUNT; i++)
+      dprintf(fd, " %-6zu", latency.buckets[i]);
+    dprintf(fd, "\n");
   }
 }
 
@@ -999,6 +999,11 @@
 #define PORT_TX_BUF_CRITICAL_WM 15
 #endif
 
+/* The largest number of buffers filled by one read from a call-out client. */
+#ifndef PORT_TX_CO_BATCH
+#define PORT_TX_CO_BATCH 8
+#endif
+
 /* The RFCOMM multiplexer preferred flow control mechanism. */
 #ifndef PORT_FC_DEFAULT
 #define PORT_FC_DEFAULT PORT_FC_CREDIT
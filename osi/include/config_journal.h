@@ -0,0 +1,83 @@
+/******************************************************************************
+ *
+ *  Copyright 2018 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+// This module implements an append-only journal of changes made to a
+// |config_t|. Rather than rewriting the whole config file on every change,
+// clients record each change in the journal, commit it to disk now and then,
+// and only rarely compact the journal by saving the config with
+// |config_save| and resetting the journal.
+//
+// Implementation notes:
+// - Each record carries a CRC-32, so a record torn by a crash or power loss
+//   while being appended is detected when the journal is opened. It is
+//   dropped together with everything after it.
+// - Replaying the journal over a config saved after some of its records were
+//   written gives the same result as replaying it over the config it started
+//   from, since records only set or remove keys. A crash between saving the
+//   config and resetting the journal therefore loses nothing.
+// - Recording changes may be done from any thread, concurrently with
+//   |config_journal_commit|. Commits and resets must be serialized by the
+//   client.
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "osi/include/config.h"
+
+typedef struct config_journal_t config_journal_t;
+
+// Opens the journal file |filename|, creating it if it does not exist, and
+// replays every complete record in it into |config|. A torn or corrupt record
+// and all records after it are truncated from the file. Returns NULL if the
+// file could not be opened or created. Clients must call
+// |config_journal_free| on the returned handle when it is no longer required.
+// |filename| and |config| must not be NULL.
+config_journal_t* config_journal_open(const char* filename, config_t* config);
+
+// Closes the journal file and frees |journal|. Changes recorded but not
+// committed are lost. |journal| may be NULL.
+void config_journal_free(config_journal_t* journal);
+
+// Records that |key| in |section| was set to |value|. Nothing is written to
+// disk until |config_journal_commit| is called. None of the parameters may be
+// NULL.
+void config_journal_set(config_journal_t* journal, const char* section,
+                        const char* key, const char* value);
+
+// Records that |key| was removed from |section|. Nothing is written to disk
+// until |config_journal_commit| is called. None of the parameters may be
+// NULL.
+void config_journal_remove_key(config_journal_t* journal, const char* section,
+                               const char* key);
+
+// Appends the changes recorded since the last commit to the journal file and
+// syncs it to disk. On failure, the file is left as it was and the changes
+// are kept for the next commit. Returns true on success. |journal| may not be
+// NULL.
+bool config_journal_commit(config_journal_t* journal);
+
+// Empties the journal file, once every committed change has been saved to
+// the config file by |config_save|. Changes recorded but not yet committed
+// are kept. Returns true on success. |journal| may not be NULL.
+bool config_journal_reset(config_journal_t* journal);
+
+// Returns the size in bytes of the committed records in the journal file,
+// which clients use to decide when to compact. |journal| may not be NULL.
+size_t config_journal_size(const config_journal_t* journal);
@@ -36,6 +36,23 @@ typedef void (*fixed_queue_cb)(fixed_queue_t* queue, void* context);
 // the returned queue with |fixed_queue_free|.
 fixed_queue_t* fixed_queue_new(size_t capacity);
 
+// Creates a new fixed queue backed by a bounded lock-free ring rather than a
+// locked list. |capacity| is rounded up to the next power of two. Enqueue and
+// dequeue never take a lock or allocate, and the queue's file descriptors are
+// only signalled when a consumer (or a registered reactor) is parked on them.
+// Any number of producers may use the queue concurrently, and so may any
+// number of consumers as long as no reactor is registered for it. Once
+// |fixed_queue_register_dequeue| has been called, the reactor's thread must be
+// the only consumer: the ready callback is only invoked for elements that are
+// there to be dequeued, and another consumer could take them first.
+// |fixed_queue_get_list| and |fixed_queue_try_remove_from_queue| are not
+// supported on these queues, and the descriptors returned by
+// |fixed_queue_get_enqueue_fd|/|fixed_queue_get_dequeue_fd| must not be
+// select(2)ed on directly. Returns NULL on failure, including for a |capacity|
+// above 65536 since all slots are allocated up front. The caller must free the
+// returned queue with |fixed_queue_free|.
+fixed_queue_t* fixed_queue_new_ring(size_t capacity);
+
 // Frees a queue and (optionally) the enqueued elements.
 // |queue| is the queue to free. If the |free_cb| callback is not null,
 // it is called on each queue element to free it.
@@ -81,6 +98,13 @@ bool fixed_queue_try_enqueue(fixed_queue_t* queue, void* data);
 // immediately. Otherwise, the next element in the queue is returned.
 void* fixed_queue_try_dequeue(fixed_queue_t* queue);
 
+// Dequeues up to |max_items| elements from |queue| into |items| without
+// blocking, in FIFO order. Returns the number of elements dequeued, which is
+// 0 if the queue is empty or NULL. |items| may only be NULL if |max_items|
+// is 0.
+size_t fixed_queue_dequeue_all(fixed_queue_t* queue, void** items,
+                               size_t max_items);
+
 // Returns the first element from |queue|, if present, without dequeuing it.
 // This function will never block the caller. Returns NULL if there are no
 // elements in the queue or |queue| is NULL.
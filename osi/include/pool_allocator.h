@@ -0,0 +1,64 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2014 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Fixed size-class slab pools for short-lived packet buffers. Blocks are
+// carved out of static arenas and recycled through small per-thread caches,
+// so steady-state allocation and release take no lock and never call malloc.
+// Requests that do not fit a size class, or arrive while their class is
+// exhausted, fall back to |osi_malloc|.
+//
+// Pool blocks are released with |osi_free| like any other buffer, so they can
+// be handed to code that does not know where they came from.
+
+// Number of size classes served by the pools.
+#define POOL_ALLOCATOR_NUM_CLASSES 3
+
+typedef struct {
+  size_t block_size;   // Largest request served by this class
+  size_t block_count;  // Number of blocks in the class arena
+  size_t hits;         // Requests served from the pool
+  size_t misses;       // Requests that fell back to |osi_malloc|
+  size_t in_use;       // Pool blocks currently handed out
+  size_t high_water;   // Largest value |in_use| has reached
+} pool_allocator_stats_t;
+
+// Allocates a buffer of at least |size| bytes, from the smallest size class
+// that fits if one has a free block, otherwise with |osi_malloc|. Never
+// returns NULL. The returned buffer must be freed with |osi_free|.
+void* pool_allocator_alloc(size_t size);
+
+// Returns true if |ptr| points into one of the pool arenas.
+bool pool_allocator_owns(const void* ptr);
+
+// Returns pool block |ptr| to its size class. |ptr| must be a block returned
+// by |pool_allocator_alloc| for which |pool_allocator_owns| is true. Most
+// callers should use |osi_free| instead, which dispatches here as needed.
+void pool_allocator_release(void* ptr);
+
+// Copies the statistics of size class |index| into |stats|. |index| must be
+// less than |POOL_ALLOCATOR_NUM_CLASSES| and |stats| must not be NULL.
+void pool_allocator_get_stats(size_t index, pool_allocator_stats_t* stats);
+
+// Dump pool statistics to the |fd| file descriptor.
+// The information is in user-readable text format. The |fd| must be valid.
+void pool_allocator_debug_dump(int fd);
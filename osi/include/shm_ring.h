@@ -0,0 +1,109 @@
+/******************************************************************************
+ *
+ *  Copyright 2018 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+// This module implements a single-producer, single-consumer byte ring in
+// shared memory, used to stream PCM between processes without a syscall per
+// transfer. The consumer creates the ring and passes its file descriptors to
+// the producer process, which attaches to it.
+//
+// Implementation notes:
+// - The ring lives in a memfd, sealed so that the peer cannot shrink it under
+//   the creator. Two eventfds serve as doorbells: one is rung when data is
+//   written, the other when space is freed. A side only rings the doorbell
+//   when its peer is actually parked waiting for it, so a stream that never
+//   runs dry or full costs no syscalls at all.
+// - Indices read from shared memory are checked before use; a peer that
+//   corrupts them only causes the ring to be reported as closed.
+// - Each side must be used from one thread at a time.
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct shm_ring_t shm_ring_t;
+
+// The number of file descriptors that |shm_ring_get_fds| returns and
+// |shm_ring_attach| takes.
+#define SHM_RING_NUM_FDS 3
+
+// Creates a ring able to hold |capacity| bytes, rounded up to a power of two,
+// and returns the consumer side of it. Returns NULL if shared memory is not
+// available. Clients must call |shm_ring_free| on the returned handle when it
+// is no longer required. |capacity| must be non-zero.
+shm_ring_t* shm_ring_create(size_t capacity);
+
+// Attaches to a ring created by |shm_ring_create| in another process and
+// returns the producer side of it. |fds| holds the SHM_RING_NUM_FDS file
+// descriptors returned by |shm_ring_get_fds|; on success the ring takes
+// ownership of them, on failure they are left open. Returns NULL if the
+// descriptors do not describe a valid ring.
+shm_ring_t* shm_ring_attach(const int fds[SHM_RING_NUM_FDS]);
+
+// Unmaps the ring and closes its file descriptors. The peer's side keeps
+// working until it is freed too. |ring| may be NULL.
+void shm_ring_free(shm_ring_t* ring);
+
+// Stores into |fds| the SHM_RING_NUM_FDS file descriptors the peer needs to
+// attach to |ring|. They remain owned by |ring|. |ring| may not be NULL.
+void shm_ring_get_fds(const shm_ring_t* ring, int fds[SHM_RING_NUM_FDS]);
+
+// Marks the ring as closed and wakes the peer if it is waiting. Subsequent
+// writes fail on both sides; data already written can still be read.
+// |ring| may not be NULL.
+void shm_ring_close(shm_ring_t* ring);
+
+// Returns true once a producer attached to |ring|. |ring| may not be NULL.
+bool shm_ring_is_attached(const shm_ring_t* ring);
+
+// Returns true if either side closed the ring, or if the peer corrupted it.
+// |ring| may not be NULL.
+bool shm_ring_is_closed(const shm_ring_t* ring);
+
+// Returns the number of bytes that can be read from |ring| right away.
+// |ring| may not be NULL.
+size_t shm_ring_readable(const shm_ring_t* ring);
+
+// Returns the number of bytes that can be written to |ring| right away.
+// |ring| may not be NULL.
+size_t shm_ring_writable(const shm_ring_t* ring);
+
+// Copies up to |length| bytes out of |ring| into |buffer| without blocking.
+// Returns the number of bytes read. Only the consumer may call this. |ring|
+// and |buffer| may not be NULL.
+size_t shm_ring_read(shm_ring_t* ring, void* buffer, size_t length);
+
+// Discards every byte that can be read from |ring|. Only the consumer may
+// call this. |ring| may not be NULL.
+void shm_ring_flush(shm_ring_t* ring);
+
+// Copies up to |length| bytes from |buffer| into |ring| without blocking.
+// Returns the number of bytes written, which is 0 once the ring is closed.
+// Only the producer may call this. |ring| and |buffer| may not be NULL.
+size_t shm_ring_write(shm_ring_t* ring, const void* buffer, size_t length);
+
+// Waits for up to |timeout_ms| milliseconds until at least |length| bytes can
+// be read from |ring|, or written to it for |shm_ring_wait_writable|. The wait
+// also ends if |hangup_fd| reports a hangup; it may be INVALID_FD. Returns 1
+// when the bytes are available, 0 on timeout, and -1 if the ring was closed
+// or |hangup_fd| hung up. |length| is clamped to the ring's capacity. |ring|
+// may not be NULL.
+int shm_ring_wait_readable(shm_ring_t* ring, size_t length, int timeout_ms,
+                           int hangup_fd);
+int shm_ring_wait_writable(shm_ring_t* ring, size_t length, int timeout_ms,
+                           int hangup_fd);
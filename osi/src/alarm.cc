@@ -36,11 +36,12 @@
 
 #include <hardware/bluetooth.h>
 
+#include <algorithm>
 #include <mutex>
+#include <vector>
 
 #include "osi/include/allocator.h"
 #include "osi/include/fixed_queue.h"
-#include "osi/include/list.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
 #include "osi/include/semaphore.h"
@@ -107,8 +108,40 @@ struct alarm_t {
 
   bool for_msg_loop;  // True, if the alarm should be processed on message loop
   CancelableClosureInStruct closure;  // posted to message loop for processing
+
+  // Links into the timer wheel slot holding this alarm while it is pending.
+  // |wheel_level| is -1 if the alarm is not in the wheel.
+  alarm_t* wheel_prev;
+  alarm_t* wheel_next;
+  int wheel_level;
+  int wheel_slot;
 };
 
+// Pending alarms live in a hierarchical timer wheel. Level L has
+// |WHEEL_SLOTS| slots, each covering 1 << (L * WHEEL_BITS) ms, and an alarm
+// is filed at the lowest level whose next-coarser bucket it shares with
+// |base|. Every alarm at level L therefore expires before every alarm at
+// level L + 1, and slots within a level are ordered, so arming and canceling
+// are O(1) and the earliest alarm is found through the occupancy bitmaps.
+// Enough levels are kept to cover the whole 64-bit deadline range.
+#define WHEEL_BITS 6
+#define WHEEL_SLOTS (1 << WHEEL_BITS)
+#define WHEEL_LEVELS ((64 + WHEEL_BITS - 1) / WHEEL_BITS)
+
+typedef struct {
+  alarm_t* head;
+  alarm_t* tail;
+} wheel_slot_t;
+
+typedef struct {
+  period_ms_t base;  // Time the wheel was last advanced to
+  size_t count;      // Number of pending alarms
+  alarm_t* first;    // Cached earliest alarm, valid if |first_valid|
+  bool first_valid;
+  uint64_t occupied[WHEEL_LEVELS];  // Bit N set if slot N is non-empty
+  wheel_slot_t slots[WHEEL_LEVELS][WHEEL_SLOTS];
+} timer_wheel_t;
+
 // If the next wakeup time is less than this threshold, we should acquire
 // a wakelock instead of setting a wake alarm so we're not bouncing in
 // and out of suspend frequently. This value is externally visible to allow
@@ -124,9 +157,9 @@ static const clockid_t CLOCK_ID_ALARM = CLOCK_BOOTTIME_ALARM;
 
 // This mutex ensures that the |alarm_set|, |alarm_cancel|, and alarm callback
 // functions execute serially and not concurrently. As a result, this mutex
-// also protects the |alarms| list.
+// also protects the |alarms| wheel.
 static std::mutex alarms_mutex;
-static list_t* alarms;
+static timer_wheel_t* alarms;
 static timer_t timer;
 static timer_t wakeup_timer;
 static bool timer_set;
@@ -150,6 +183,11 @@ static void alarm_cancel_internal(alarm_t* alarm);
 static void remove_pending_alarm(alarm_t* alarm);
 static void schedule_next_instance(alarm_t* alarm);
 static void reschedule_root_alarm(void);
+static void wheel_insert(timer_wheel_t* wheel, alarm_t* alarm);
+static void wheel_remove(timer_wheel_t* wheel, alarm_t* alarm);
+static alarm_t* wheel_first(timer_wheel_t* wheel);
+static void wheel_advance(timer_wheel_t* wheel, period_ms_t now_ms,
+                          std::vector<alarm_t*>* expired);
 static void alarm_queue_ready(fixed_queue_t* queue, void* context);
 static void timer_callback(void* data);
 static void callback_dispatch(void* context);
@@ -188,6 +226,7 @@ static alarm_t* alarm_new_internal(const char* name, bool is_periodic) {
   ret->stats.name = osi_strdup(name);
 
   ret->for_msg_loop = false;
+  ret->wheel_level = -1;
   // placement new
   new (&ret->closure) CancelableClosureInStruct();
 
@@ -268,8 +307,7 @@ void alarm_cancel(alarm_t* alarm) {
 // Internal implementation of canceling an alarm.
 // The caller must hold the |alarms_mutex|
 static void alarm_cancel_internal(alarm_t* alarm) {
-  bool needs_reschedule =
-      (!list_is_empty(alarms) && list_front(alarms) == alarm);
+  bool needs_reschedule = (wheel_first(alarms) == alarm);
 
   remove_pending_alarm(alarm);
 
@@ -309,7 +347,7 @@ void alarm_cleanup(void) {
   semaphore_free(alarm_expired);
   alarm_expired = NULL;
 
-  list_free(alarms);
+  osi_free(alarms);
   alarms = NULL;
 }
 
@@ -323,11 +361,7 @@ static bool lazy_initialize(void) {
 
   std::lock_guard<std::mutex> lock(alarms_mutex);
 
-  alarms = list_new(NULL);
-  if (!alarms) {
-    LOG_ERROR(LOG_TAG, "%s unable to allocate alarm list.", __func__);
-    goto error;
-  }
+  alarms = static_cast<timer_wheel_t*>(osi_calloc(sizeof(timer_wheel_t)));
 
   if (!timer_create_internal(CLOCK_ID, &timer)) goto error;
   timer_initialized = true;
@@ -386,7 +420,7 @@ error:
 
   if (timer_initialized) timer_delete(timer);
 
-  list_free(alarms);
+  osi_free(alarms);
   alarms = NULL;
 
   return false;
@@ -405,10 +439,10 @@ static period_ms_t now(void) {
   return (ts.tv_sec * 1000LL) + (ts.tv_nsec / 1000000LL);
 }
 
-// Remove alarm from internal alarm list and the processing queue
+// Remove alarm from internal alarm wheel and the processing queue
 // The caller must hold the |alarms_mutex|
 static void remove_pending_alarm(alarm_t* alarm) {
-  list_remove(alarms, alarm);
+  wheel_remove(alarms, alarm);
 
   if (alarm->for_msg_loop) {
     alarm->closure.i.Cancel();
@@ -423,10 +457,9 @@ static void remove_pending_alarm(alarm_t* alarm) {
 
 // Must be called with |alarms_mutex| held
 static void schedule_next_instance(alarm_t* alarm) {
-  // If the alarm is currently set and it's at the start of the list,
+  // If the alarm is currently set and it's the earliest one,
   // we'll need to re-schedule since we've adjusted the earliest deadline.
-  bool needs_reschedule =
-      (!list_is_empty(alarms) && list_front(alarms) == alarm);
+  bool needs_reschedule = (wheel_first(alarms) == alarm);
   if (alarm->callback) remove_pending_alarm(alarm);
 
   // Calculate the next deadline for this alarm
@@ -436,30 +469,174 @@ static void schedule_next_instance(alarm_t* alarm) {
     ms_into_period = ((just_now - alarm->creation_time) % alarm->period);
   alarm->deadline = just_now + (alarm->period - ms_into_period);
 
-  // Add it into the timer list sorted by deadline (earliest deadline first).
-  if (list_is_empty(alarms) ||
-      ((alarm_t*)list_front(alarms))->deadline > alarm->deadline) {
-    list_prepend(alarms, alarm);
-  } else {
-    for (list_node_t* node = list_begin(alarms); node != list_end(alarms);
-         node = list_next(node)) {
-      list_node_t* next = list_next(node);
-      if (next == list_end(alarms) ||
-          ((alarm_t*)list_node(next))->deadline > alarm->deadline) {
-        list_insert_after(alarms, node, alarm);
-        break;
-      }
-    }
-  }
+  wheel_insert(alarms, alarm);
 
   // If the new alarm has the earliest deadline, we need to re-evaluate our
   // schedule.
-  if (needs_reschedule ||
-      (!list_is_empty(alarms) && list_front(alarms) == alarm)) {
+  if (needs_reschedule || wheel_first(alarms) == alarm) {
     reschedule_root_alarm();
   }
 }
 
+// Returns the wheel level an alarm due at |deadline| belongs to, given the
+// wheel was last advanced to |base|.
+static int wheel_level_for(period_ms_t base, period_ms_t deadline) {
+  period_ms_t diff = base ^ deadline;
+  if (diff == 0) return 0;
+  return (63 - __builtin_clzll(diff)) / WHEEL_BITS;
+}
+
+static void wheel_insert(timer_wheel_t* wheel, alarm_t* alarm) {
+  CHECK(alarm->wheel_level == -1);
+
+  // Overdue alarms are filed at the current time so they expire on the next
+  // advance.
+  period_ms_t deadline = std::max(alarm->deadline, wheel->base);
+  int level = wheel_level_for(wheel->base, deadline);
+  int slot = (deadline >> (level * WHEEL_BITS)) & (WHEEL_SLOTS - 1);
+
+  wheel_slot_t* s = &wheel->slots[level][slot];
+  alarm->wheel_prev = s->tail;
+  alarm->wheel_next = NULL;
+  if (s->tail)
+    s->tail->wheel_next = alarm;
+  else
+    s->head = alarm;
+  s->tail = alarm;
+  alarm->wheel_level = level;
+  alarm->wheel_slot = slot;
+
+  wheel->occupied[level] |= (1ULL << slot);
+  wheel->count++;
+
+  if (wheel->first_valid &&
+      (wheel->first == NULL || alarm->deadline < wheel->first->deadline))
+    wheel->first = alarm;
+}
+
+static void wheel_remove(timer_wheel_t* wheel, alarm_t* alarm) {
+  if (alarm->wheel_level == -1) return;
+
+  wheel_slot_t* s = &wheel->slots[alarm->wheel_level][alarm->wheel_slot];
+  if (alarm->wheel_prev)
+    alarm->wheel_prev->wheel_next = alarm->wheel_next;
+  else
+    s->head = alarm->wheel_next;
+  if (alarm->wheel_next)
+    alarm->wheel_next->wheel_prev = alarm->wheel_prev;
+  else
+    s->tail = alarm->wheel_prev;
+
+  if (s->head == NULL)
+    wheel->occupied[alarm->wheel_level] &= ~(1ULL << alarm->wheel_slot);
+  wheel->count--;
+
+  if (wheel->first == alarm) wheel->first_valid = false;
+
+  alarm->wheel_prev = NULL;
+  alarm->wheel_next = NULL;
+  alarm->wheel_level = -1;
+}
+
+// Returns the pending alarm with the earliest deadline, or NULL if there are
+// no pending alarms. Alarms with equal deadlines are returned in the order
+// they were set.
+static alarm_t* wheel_first(timer_wheel_t* wheel) {
+  if (wheel->first_valid) return wheel->first;
+
+  wheel->first = NULL;
+  for (int level = 0; level < WHEEL_LEVELS; level++) {
+    if (wheel->occupied[level] == 0) continue;
+
+    // Only the first non-empty slot of the first non-empty level can hold
+    // the earliest alarm.
+    int slot = __builtin_ctzll(wheel->occupied[level]);
+    for (alarm_t* alarm = wheel->slots[level][slot].head; alarm != NULL;
+         alarm = alarm->wheel_next) {
+      if (wheel->first == NULL || alarm->deadline < wheel->first->deadline)
+        wheel->first = alarm;
+    }
+    break;
+  }
+
+  wheel->first_valid = true;
+  return wheel->first;
+}
+
+// Moves all alarms in the slots of |level| selected by the |slots| bitmask to
+// the end of |out|, keeping their order.
+static void wheel_take_slots(timer_wheel_t* wheel, int level, uint64_t slots,
+                             std::vector<alarm_t*>* out) {
+  uint64_t pending = slots & wheel->occupied[level];
+  wheel->occupied[level] &= ~slots;
+
+  while (pending != 0) {
+    int slot = __builtin_ctzll(pending);
+    pending &= pending - 1;
+
+    wheel_slot_t* s = &wheel->slots[level][slot];
+    alarm_t* alarm = s->head;
+    while (alarm != NULL) {
+      alarm_t* next = alarm->wheel_next;
+      alarm->wheel_prev = NULL;
+      alarm->wheel_next = NULL;
+      alarm->wheel_level = -1;
+      wheel->count--;
+      out->push_back(alarm);
+      alarm = next;
+    }
+    s->head = NULL;
+    s->tail = NULL;
+  }
+}
+
+// Advances the wheel to |now_ms| and appends every alarm due by then to
+// |expired|, ordered by deadline. Alarms that are not yet due but now share a
+// coarse slot with |now_ms| are cascaded down to finer levels.
+static void wheel_advance(timer_wheel_t* wheel, period_ms_t now_ms,
+                          std::vector<alarm_t*>* expired) {
+  static std::vector<alarm_t*> taken;
+  if (now_ms < wheel->base) now_ms = wheel->base;
+
+  for (int level = 0; level < WHEEL_LEVELS; level++) {
+    int shift = level * WHEEL_BITS;
+    int upper_shift = shift + WHEEL_BITS;
+
+    // Once |now_ms| has left the coarser bucket |base| was in, every alarm at
+    // this level is due.
+    if (upper_shift < 64 &&
+        (wheel->base >> upper_shift) != (now_ms >> upper_shift)) {
+      wheel_take_slots(wheel, level, ~0ULL, &taken);
+      continue;
+    }
+
+    // Otherwise only the slots up to and including the one |now_ms| falls in
+    // need attention, and coarser levels are unaffected.
+    int from = (wheel->base >> shift) & (WHEEL_SLOTS - 1);
+    int to = (now_ms >> shift) & (WHEEL_SLOTS - 1);
+    uint64_t upto = (to == WHEEL_SLOTS - 1) ? ~0ULL : ((1ULL << (to + 1)) - 1);
+    wheel_take_slots(wheel, level, upto & ~((1ULL << from) - 1), &taken);
+    break;
+  }
+
+  wheel->base = now_ms;
+  wheel->first_valid = false;
+
+  size_t first_expired = expired->size();
+  for (alarm_t* alarm : taken) {
+    if (alarm->deadline <= now_ms)
+      expired->push_back(alarm);
+    else
+      wheel_insert(wheel, alarm);
+  }
+  taken.clear();
+
+  std::stable_sort(expired->begin() + first_expired, expired->end(),
+                   [](const alarm_t* a, const alarm_t* b) {
+                     return a->deadline < b->deadline;
+                   });
+}
+
 // NOTE: must be called with |alarms_mutex| held
 __attribute__((no_sanitize("integer")))
 static void reschedule_root_alarm(void) {
@@ -473,9 +650,9 @@ static void reschedule_root_alarm(void) {
   struct itimerspec timer_time;
   memset(&timer_time, 0, sizeof(timer_time));
 
-  if (list_is_empty(alarms)) goto done;
+  next = wheel_first(alarms);
+  if (next == NULL) goto done;
 
-  next = static_cast<alarm_t*>(list_front(alarms));
   next_expiration = next->deadline - now();
   if (next_expiration < TIMER_INTERVAL_FOR_WAKELOCK_IN_MS) {
     if (!timer_set) {
@@ -536,8 +713,8 @@ done:
   // milliseconds) and the timer expired normally before we called
   // |timer_gettime|. Worst case, |alarm_expired| is signaled twice for that
   // alarm. Nothing bad should happen in that case though since the callback
-  // dispatch function checks to make sure the timer at the head of the list
-  // actually expired.
+  // dispatch function only dispatches alarms whose deadline actually
+  // expired.
   if (timer_set) {
     struct itimerspec time_to_expire;
     timer_gettime(timer, &time_to_expire);
@@ -614,47 +791,46 @@ static void timer_callback(UNUSED_ATTR void* ptr) {
 
 // Function running on |dispatcher_thread| that performs the following:
 //   (1) Receives a signal using |alarm_exired| that the alarm has expired
-//   (2) Dispatches the alarm callback for processing by the corresponding
-// thread for that alarm.
+//   (2) Dispatches the callbacks of all alarms that are due for processing by
+// the corresponding thread for each alarm.
 static void callback_dispatch(UNUSED_ATTR void* context) {
+  std::vector<alarm_t*> expired;
+
   while (true) {
     semaphore_wait(alarm_expired);
     if (!dispatcher_thread_active) break;
 
     std::lock_guard<std::mutex> lock(alarms_mutex);
-    alarm_t* alarm;
-
-    // Take into account that the alarm may get cancelled before we get to it.
-    // We're done here if there are no alarms or the alarm at the front is in
-    // the future. Exit right away since there's nothing left to do.
-    if (list_is_empty(alarms) ||
-        (alarm = static_cast<alarm_t*>(list_front(alarms)))->deadline > now()) {
-      reschedule_root_alarm();
-      continue;
-    }
 
-    list_remove(alarms, alarm);
+    // Alarms canceled before we got to them are no longer in the wheel, so
+    // this may well find nothing to do.
+    expired.clear();
+    wheel_advance(alarms, now(), &expired);
 
-    if (alarm->is_periodic) {
-      alarm->prev_deadline = alarm->deadline;
-      schedule_next_instance(alarm);
-      alarm->stats.rescheduled_count++;
-    }
-    reschedule_root_alarm();
-
-    // Enqueue the alarm for processing
-    if (alarm->for_msg_loop) {
-      if (!get_message_loop()) {
-        LOG_ERROR(LOG_TAG, "%s: message loop already NULL. Alarm: %s", __func__,
-                  alarm->stats.name);
-        continue;
+    for (alarm_t* alarm : expired) {
+      if (alarm->is_periodic) {
+        alarm->prev_deadline = alarm->deadline;
+        schedule_next_instance(alarm);
+        alarm->stats.rescheduled_count++;
       }
 
-      alarm->closure.i.Reset(Bind(alarm_ready_mloop, alarm));
-      get_message_loop()->task_runner()->PostTask(FROM_HERE, alarm->closure.i.callback());
-    } else {
-      fixed_queue_enqueue(alarm->queue, alarm);
+      // Enqueue the alarm for processing
+      if (alarm->for_msg_loop) {
+        if (!get_message_loop()) {
+          LOG_ERROR(LOG_TAG, "%s: message loop already NULL. Alarm: %s",
+                    __func__, alarm->stats.name);
+          continue;
+        }
+
+        alarm->closure.i.Reset(Bind(alarm_ready_mloop, alarm));
+        get_message_loop()->task_runner()->PostTask(
+            FROM_HERE, alarm->closure.i.callback());
+      } else {
+        fixed_queue_enqueue(alarm->queue, alarm);
+      }
     }
+
+    reschedule_root_alarm();
   }
 
   LOG_DEBUG(LOG_TAG, "%s Callback thread exited", __func__);
@@ -725,53 +901,60 @@ static void dump_stat(int fd, stat_t* stat, const char* description) {
           (unsigned long long)average_time_ms);
 }
 
-void alarm_debug_dump(int fd) {
-  dprintf(fd, "\nBluetooth Alarms Statistics:\n");
+static void dump_alarm(int fd, alarm_t* alarm, period_ms_t just_now) {
+  alarm_stats_t* stats = &alarm->stats;
 
-  std::lock_guard<std::mutex> lock(alarms_mutex);
+  dprintf(fd, "  Alarm : %s (%s)\n", stats->name,
+          (alarm->is_periodic) ? "PERIODIC" : "SINGLE");
 
-  if (alarms == NULL) {
-    dprintf(fd, "  None\n");
-    return;
-  }
+  dprintf(fd, "%-51s: %zu / %zu / %zu / %zu\n",
+          "    Action counts (sched/resched/exec/cancel)",
+          stats->scheduled_count, stats->rescheduled_count,
+          stats->callback_execution.count, stats->canceled_count);
 
-  period_ms_t just_now = now();
+  dprintf(fd, "%-51s: %zu / %zu\n",
+          "    Deviation counts (overdue/premature)",
+          stats->overdue_scheduling.count, stats->premature_scheduling.count);
 
-  dprintf(fd, "  Total Alarms: %zu\n\n", list_length(alarms));
+  dprintf(fd, "%-51s: %llu / %llu / %lld\n",
+          "    Time in ms (since creation/interval/remaining)",
+          (unsigned long long)(just_now - alarm->creation_time),
+          (unsigned long long)alarm->period,
+          (long long)(alarm->deadline - just_now));
 
-  // Dump info for each alarm
-  for (list_node_t* node = list_begin(alarms); node != list_end(alarms);
-       node = list_next(node)) {
-    alarm_t* alarm = (alarm_t*)list_node(node);
-    alarm_stats_t* stats = &alarm->stats;
+  dump_stat(fd, &stats->callback_execution,
+            "    Callback execution time in ms (total/max/avg)");
 
-    dprintf(fd, "  Alarm : %s (%s)\n", stats->name,
-            (alarm->is_periodic) ? "PERIODIC" : "SINGLE");
+  dump_stat(fd, &stats->overdue_scheduling,
+            "    Overdue scheduling time in ms (total/max/avg)");
 
-    dprintf(fd, "%-51s: %zu / %zu / %zu / %zu\n",
-            "    Action counts (sched/resched/exec/cancel)",
-            stats->scheduled_count, stats->rescheduled_count,
-            stats->callback_execution.count, stats->canceled_count);
+  dump_stat(fd, &stats->premature_scheduling,
+            "    Premature scheduling time in ms (total/max/avg)");
 
-    dprintf(fd, "%-51s: %zu / %zu\n",
-            "    Deviation counts (overdue/premature)",
-            stats->overdue_scheduling.count, stats->premature_scheduling.count);
+  dprintf(fd, "\n");
+}
 
-    dprintf(fd, "%-51s: %llu / %llu / %lld\n",
-            "    Time in ms (since creation/interval/remaining)",
-            (unsigned long long)(just_now - alarm->creation_time),
-            (unsigned long long)alarm->period,
-            (long long)(alarm->deadline - just_now));
+void alarm_debug_dump(int fd) {
+  dprintf(fd, "\nBluetooth Alarms Statistics:\n");
 
-    dump_stat(fd, &stats->callback_execution,
-              "    Callback execution time in ms (total/max/avg)");
+  std::lock_guard<std::mutex> lock(alarms_mutex);
 
-    dump_stat(fd, &stats->overdue_scheduling,
-              "    Overdue scheduling time in ms (total/max/avg)");
+  if (alarms == NULL) {
+    dprintf(fd, "  None\n");
+    return;
+  }
 
-    dump_stat(fd, &stats->premature_scheduling,
-              "    Premature scheduling time in ms (total/max/avg)");
+  period_ms_t just_now = now();
+
+  dprintf(fd, "  Total Alarms: %zu\n\n", alarms->count);
 
-    dprintf(fd, "\n");
+  // Dump info for each alarm, roughly in order of expiry
+  for (int level = 0; level < WHEEL_LEVELS; level++) {
+    for (int slot = 0; slot < WHEEL_SLOTS; slot++) {
+      for (alarm_t* alarm = alarms->slots[level][slot].head; alarm != NULL;
+           alarm = alarm->wheel_next) {
+        dump_alarm(fd, alarm, just_now);
+      }
+    }
   }
 }
@@ -21,6 +21,7 @@
 
 #include "osi/include/allocation_tracker.h"
 #include "osi/include/allocator.h"
+#include "osi/include/pool_allocator.h"
 
 static const allocator_id_t alloc_allocator_id = 42;
 
@@ -70,6 +71,11 @@ void* osi_calloc(size_t size) {
 }
 
 void osi_free(void* ptr) {
+  if (pool_allocator_owns(ptr)) {
+    pool_allocator_release(ptr);
+    return;
+  }
+
   free(allocation_tracker_notify_free(alloc_allocator_id, ptr));
 }
 
@@ -39,18 +39,47 @@
 #include "bt_target.h"
 #include <inttypes.h>
 
+#include <unordered_map>
+
 typedef struct {
   char* key;
   char* value;
 } entry_t;
 
+// Hashes and compares the NUL-terminated strings owned by sections and
+// entries, so lookups by a caller's |const char*| never allocate.
+struct config_string_hash {
+  size_t operator()(const char* str) const {
+    // FNV-1a
+    size_t hash = 2166136261u;
+    for (; *str; str++) hash = (hash ^ (unsigned char)*str) * 16777619u;
+    return hash;
+  }
+};
+
+struct config_string_equal {
+  bool operator()(const char* a, const char* b) const {
+    return strcmp(a, b) == 0;
+  }
+};
+
+typedef std::unordered_map<const char*, entry_t*, config_string_hash,
+                           config_string_equal>
+    entry_index_t;
+
 typedef struct {
   char* name;
-  list_t* entries;
+  list_t* entries;       // Entries in insertion order, for |config_save|
+  entry_index_t* index;  // Entries keyed by |entry_t::key|
 } section_t;
 
+typedef std::unordered_map<const char*, section_t*, config_string_hash,
+                           config_string_equal>
+    section_index_t;
+
 struct config_t {
-  list_t* sections;
+  list_t* sections;        // Sections in insertion order, for |config_save|
+  section_index_t* index;  // Sections keyed by |section_t::name|
 };
 
 // Empty definition; this type is aliased to list_node_t.
@@ -61,6 +90,7 @@ static bool config_parse(FILE* fp, config_t* config);
 static section_t* section_new(const char* name);
 static void section_free(void* ptr);
 static section_t* section_find(const config_t* config, const char* section);
+static section_t* section_add(config_t* config, const char* section);
 
 static entry_t* entry_new(const char* key, const char* value);
 static void entry_free(void* ptr);
@@ -75,6 +105,7 @@ config_t* config_new_empty(void) {
     LOG_ERROR(LOG_TAG, "%s unable to allocate list for sections.", __func__);
     goto error;
   }
+  config->index = new section_index_t;
 
   return config;
 
@@ -134,6 +165,8 @@ config_t* config_new_clone(const config_t* src) {
 void config_free(config_t* config) {
   if (!config) return;
 
+  // The index keys point into the sections, so drop it first.
+  delete config->index;
   list_free(config->sections);
   osi_free(config);
 }
@@ -269,10 +302,8 @@ void config_set_string(config_t* config, const char* section, const char* key,
                        const char* value) {
   section_t* sec = section_find(config, section);
   if (!sec) {
-    sec = section_new(section);
-    if (sec)
-      list_append(config->sections, sec);
-    else {
+    sec = section_add(config, section);
+    if (!sec) {
       LOG_ERROR(LOG_TAG,"%s: Unable to allocate memory for section", __func__);
     }
   }
@@ -288,18 +319,17 @@ void config_set_string(config_t* config, const char* section, const char* key,
   }
 
   if (sec) {
-    for (const list_node_t* node = list_begin(sec->entries);
-         node != list_end(sec->entries); node = list_next(node)) {
-      entry_t* entry = static_cast<entry_t*>(list_node(node));
-      if (!strcmp(entry->key, key)) {
-        osi_free(entry->value);
-        entry->value = osi_strdup(value_no_newline.c_str());
-        return;
-      }
+    auto it = sec->index->find(key);
+    if (it != sec->index->end()) {
+      entry_t* entry = it->second;
+      osi_free(entry->value);
+      entry->value = osi_strdup(value_no_newline.c_str());
+      return;
     }
 
     entry_t* entry = entry_new(key, value_no_newline.c_str());
     list_append(sec->entries, entry);
+    sec->index->emplace(entry->key, entry);
   }
 }
 
@@ -310,6 +340,7 @@ bool config_remove_section(config_t* config, const char* section) {
   section_t* sec = section_find(config, section);
   if (!sec) return false;
 
+  config->index->erase(sec->name);
   return list_remove(config->sections, sec);
 }
 
@@ -319,9 +350,13 @@ bool config_remove_key(config_t* config, const char* section, const char* key) {
   CHECK(key != NULL);
 
   section_t* sec = section_find(config, section);
-  entry_t* entry = entry_find(config, section, key);
-  if (!sec || !entry) return false;
+  if (!sec) return false;
 
+  auto it = sec->index->find(key);
+  if (it == sec->index->end()) return false;
+
+  entry_t* entry = it->second;
+  sec->index->erase(it);
   return list_remove(sec->entries, entry);
 }
 
@@ -383,6 +418,13 @@ void config_sections_sort_by_entry_key(config_t* config, compare_func comp) {
       p = q;
     }
 
+    // Keys and values were swapped between entries; re-point the index.
+    sec->index->clear();
+    for (const list_node_t* enode = list_begin(sec->entries);
+         enode != list_end(sec->entries); enode = list_next(enode)) {
+      entry_t* entry = (entry_t*)list_node(enode);
+      sec->index->emplace(entry->key, entry);
+    }
   }
 }
 #endif
@@ -568,9 +610,7 @@ static bool config_parse(FILE* fp, config_t* config) {
         strlcpy(comment, line_ptr, 1024);
 
         if(!section_find(config, comment)) {
-            section_t *sec = section_new(comment);
-            if (sec)
-                list_append(config->sections, sec);
+            section_add(config, comment);
         }
     } else if (*line_ptr == '[') {
       size_t len = strlen(line_ptr);
@@ -605,6 +645,7 @@ static section_t* section_new(const char* name) {
 
   section->name = osi_strdup(name);
   section->entries = list_new(entry_free);
+  section->index = new entry_index_t;
   return section;
 }
 
@@ -612,19 +653,26 @@ static void section_free(void* ptr) {
   if (!ptr) return;
 
   section_t* section = static_cast<section_t*>(ptr);
+  delete section->index;
   osi_free(section->name);
   list_free(section->entries);
   osi_free(section);
 }
 
 static section_t* section_find(const config_t* config, const char* section) {
-  for (const list_node_t* node = list_begin(config->sections);
-       node != list_end(config->sections); node = list_next(node)) {
-    section_t* sec = static_cast<section_t*>(list_node(node));
-    if (sec && !strcmp(sec->name, section)) return sec;
+  auto it = config->index->find(section);
+  return (it != config->index->end()) ? it->second : NULL;
 }
 
-  return NULL;
+// Creates a section named |section| at the end of |config| and indexes it.
+// The caller must make sure |config| has no section by that name yet.
+static section_t* section_add(config_t* config, const char* section) {
+  section_t* sec = section_new(section);
+  if (!sec) return NULL;
+
+  list_append(config->sections, sec);
+  config->index->emplace(sec->name, sec);
+  return sec;
 }
 
 static entry_t* entry_new(const char* key, const char* value) {
@@ -649,11 +697,6 @@ static entry_t* entry_find(const config_t* config, const char* section,
   section_t* sec = section_find(config, section);
   if (!sec) return NULL;
 
-  for (const list_node_t* node = list_begin(sec->entries);
-       node != list_end(sec->entries); node = list_next(node)) {
-    entry_t* entry = static_cast<entry_t*>(list_node(node));
-    if (!strcmp(entry->key, key)) return entry;
-  }
-
-  return NULL;
+  auto it = sec->index->find(key);
+  return (it != sec->index->end()) ? it->second : NULL;
 }
@@ -0,0 +1,302 @@
+/******************************************************************************
+ *
+ *  Copyright 2018 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "bt_osi_config_journal"
+
+#include "osi/include/config_journal.h"
+
+#include <base/logging.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "osi/include/crc32.h"
+#include "osi/include/log.h"
+#include "osi/include/osi.h"
+
+// The file starts with |JOURNAL_MAGIC| and |JOURNAL_VERSION|, followed by
+// records made of a header and the section, key and value strings:
+//
+//   uint32_t crc;           CRC-32 of everything after this field
+//   uint8_t op;             JOURNAL_OP_*
+//   uint16_t section_len;
+//   uint16_t key_len;
+//   uint32_t value_len;
+//
+// Integers are stored little endian.
+#define JOURNAL_MAGIC 0x4a435442  // "BTCJ"
+#define JOURNAL_VERSION 1
+#define JOURNAL_HEADER_SIZE 8
+#define RECORD_HEADER_SIZE 13
+
+#define JOURNAL_OP_SET 1
+#define JOURNAL_OP_REMOVE_KEY 2
+
+struct config_journal_t {
+  int fd;
+  size_t size;  // Bytes of valid data in the file, header included
+
+  std::mutex pending_lock;  // Protects |pending|
+  std::string pending;      // Encoded records not committed yet
+};
+
+static bool journal_write_header(config_journal_t* journal);
+static size_t journal_replay(const std::vector<uint8_t>& data,
+                             config_t* config);
+static void journal_append(config_journal_t* journal, uint8_t op,
+                           const char* section, const char* key,
+                           const char* value);
+
+config_journal_t* config_journal_open(const char* filename, config_t* config) {
+  CHECK(filename != NULL);
+  CHECK(config != NULL);
+
+  int fd;
+  OSI_NO_INTR(fd = open(filename, O_RDWR | O_CREAT | O_CLOEXEC,
+                        S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP));
+  if (fd < 0) {
+    LOG_ERROR(LOG_TAG, "%s unable to open journal '%s': %s", __func__,
+              filename, strerror(errno));
+    return NULL;
+  }
+
+  std::vector<uint8_t> data;
+  uint8_t buf[4096];
+  ssize_t ret;
+  do {
+    OSI_NO_INTR(ret = read(fd, buf, sizeof(buf)));
+    if (ret > 0) data.insert(data.end(), buf, buf + ret);
+  } while (ret > 0);
+  if (ret < 0) {
+    LOG_ERROR(LOG_TAG, "%s unable to read journal '%s': %s", __func__,
+              filename, strerror(errno));
+    close(fd);
+    return NULL;
+  }
+
+  config_journal_t* journal = new config_journal_t;
+  journal->fd = fd;
+  journal->size = journal_replay(data, config);
+
+  if (journal->size == 0) {
+    // New, unknown or unreadable file: start over.
+    if (!data.empty())
+      LOG_WARN(LOG_TAG, "%s discarding unrecognized journal '%s'", __func__,
+               filename);
+    if (!journal_write_header(journal)) {
+      config_journal_free(journal);
+      return NULL;
+    }
+  } else if (journal->size < data.size()) {
+    LOG_WARN(LOG_TAG, "%s dropping %zu bytes of torn records from '%s'",
+             __func__, data.size() - journal->size, filename);
+    if (ftruncate(fd, journal->size) < 0 || fsync(fd) < 0)
+      LOG_WARN(LOG_TAG, "%s unable to truncate journal '%s': %s", __func__,
+               filename, strerror(errno));
+  }
+
+  return journal;
+}
+
+void config_journal_free(config_journal_t* journal) {
+  if (!journal) return;
+
+  close(journal->fd);
+  delete journal;
+}
+
+void config_journal_set(config_journal_t* journal, const char* section,
+                        const char* key, const char* value) {
+  CHECK(journal != NULL);
+  CHECK(section != NULL);
+  CHECK(key != NULL);
+  CHECK(value != NULL);
+
+  journal_append(journal, JOURNAL_OP_SET, section, key, value);
+}
+
+void config_journal_remove_key(config_journal_t* journal, const char* section,
+                               const char* key) {
+  CHECK(journal != NULL);
+  CHECK(section != NULL);
+  CHECK(key != NULL);
+
+  journal_append(journal, JOURNAL_OP_REMOVE_KEY, section, key, "");
+}
+
+bool config_journal_commit(config_journal_t* journal) {
+  CHECK(journal != NULL);
+
+  std::string records;
+  {
+    std::lock_guard<std::mutex> lock(journal->pending_lock);
+    records.swap(journal->pending);
+  }
+  if (records.empty()) return true;
+
+  size_t written = 0;
+  while (written < records.size()) {
+    ssize_t ret;
+    OSI_NO_INTR(ret = pwrite(journal->fd, records.data() + written,
+                             records.size() - written,
+                             journal->size + written));
+    if (ret <= 0) break;
+    written += ret;
+  }
+
+  if (written < records.size() || fdatasync(journal->fd) < 0) {
+    LOG_ERROR(LOG_TAG, "%s unable to write journal: %s", __func__,
+              strerror(errno));
+    // Drop whatever part made it to the file, and put the records back in
+    // front of the ones recorded meanwhile.
+    if (ftruncate(journal->fd, journal->size) < 0)
+      LOG_ERROR(LOG_TAG, "%s unable to truncate journal: %s", __func__,
+                strerror(errno));
+    std::lock_guard<std::mutex> lock(journal->pending_lock);
+    journal->pending.insert(0, records);
+    return false;
+  }
+
+  journal->size += records.size();
+  return true;
+}
+
+bool config_journal_reset(config_journal_t* journal) {
+  CHECK(journal != NULL);
+
+  if (ftruncate(journal->fd, JOURNAL_HEADER_SIZE) < 0 ||
+      fsync(journal->fd) < 0) {
+    LOG_ERROR(LOG_TAG, "%s unable to truncate journal: %s", __func__,
+              strerror(errno));
+    return false;
+  }
+
+  journal->size = JOURNAL_HEADER_SIZE;
+  return true;
+}
+
+size_t config_journal_size(const config_journal_t* journal) {
+  CHECK(journal != NULL);
+  return journal->size - JOURNAL_HEADER_SIZE;
+}
+
+static void put_le(std::string* out, uint32_t value, int bytes) {
+  for (int i = 0; i < bytes; i++) out->push_back((char)(value >> (8 * i)));
+}
+
+static uint32_t get_le(const uint8_t* p, int bytes) {
+  uint32_t value = 0;
+  for (int i = 0; i < bytes; i++) value |= (uint32_t)p[i] << (8 * i);
+  return value;
+}
+
+static bool journal_write_header(config_journal_t* journal) {
+  std::string header;
+  put_le(&header, JOURNAL_MAGIC, 4);
+  put_le(&header, JOURNAL_VERSION, 4);
+
+  ssize_t ret;
+  OSI_NO_INTR(ret = pwrite(journal->fd, header.data(), header.size(), 0));
+  if (ret != (ssize_t)header.size() ||
+      ftruncate(journal->fd, header.size()) < 0 || fsync(journal->fd) < 0) {
+    LOG_ERROR(LOG_TAG, "%s unable to write journal header: %s", __func__,
+              strerror(errno));
+    return false;
+  }
+
+  journal->size = header.size();
+  return true;
+}
+
+// Applies the records of the journal file contents |data| to |config|, and
+// returns the size of the valid part of |data|, or 0 if it does not start
+// with a journal header.
+static size_t journal_replay(const std::vector<uint8_t>& data,
+                             config_t* config) {
+  if (data.size() < JOURNAL_HEADER_SIZE ||
+      get_le(data.data(), 4) != JOURNAL_MAGIC ||
+      get_le(data.data() + 4, 4) != JOURNAL_VERSION)
+    return 0;
+
+  size_t offset = JOURNAL_HEADER_SIZE;
+  while (data.size() - offset >= RECORD_HEADER_SIZE) {
+    const uint8_t* p = data.data() + offset;
+    uint8_t op = p[4];
+    size_t section_len = get_le(p + 5, 2);
+    size_t key_len = get_le(p + 7, 2);
+    size_t value_len = get_le(p + 9, 4);
+
+    size_t avail = data.size() - offset - RECORD_HEADER_SIZE;
+    if (section_len > avail || key_len > avail - section_len ||
+        value_len > avail - section_len - key_len)
+      break;
+
+    size_t record_len = RECORD_HEADER_SIZE + section_len + key_len + value_len;
+    if (crc32_compute(p + 4, record_len - 4) != get_le(p, 4)) break;
+
+    const char* strings = (const char*)p + RECORD_HEADER_SIZE;
+    std::string section(strings, section_len);
+    std::string key(strings + section_len, key_len);
+    if (op == JOURNAL_OP_SET) {
+      std::string value(strings + section_len + key_len, value_len);
+      config_set_string(config, section.c_str(), key.c_str(), value.c_str());
+    } else if (op == JOURNAL_OP_REMOVE_KEY) {
+      config_remove_key(config, section.c_str(), key.c_str());
+    } else {
+      break;
+    }
+
+    offset += record_len;
+  }
+
+  return offset;
+}
+
+static void journal_append(config_journal_t* journal, uint8_t op,
+                           const char* section, const char* key,
+                           const char* value) {
+  size_t section_len = strlen(section);
+  size_t key_len = strlen(key);
+  size_t value_len = strlen(value);
+  CHECK(section_len <= UINT16_MAX);
+  CHECK(key_len <= UINT16_MAX);
+
+  std::string record;
+  record.reserve(RECORD_HEADER_SIZE + section_len + key_len + value_len);
+  put_le(&record, 0, 4);
+  put_le(&record, op, 1);
+  put_le(&record, section_len, 2);
+  put_le(&record, key_len, 2);
+  put_le(&record, value_len, 4);
+  record.append(section, section_len);
+  record.append(key, key_len);
+  record.append(value, value_len);
+
+  uint32_t crc =
+      crc32_compute((const uint8_t*)record.data() + 4, record.size() - 4);
+  for (int i = 0; i < 4; i++) record[i] = (char)(crc >> (8 * i));
+
+  std::lock_guard<std::mutex> lock(journal->pending_lock);
+  journal->pending.append(record);
+}
@@ -0,0 +1,41 @@
+/******************************************************************************
+ *
+ *  Copyright 2018 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "osi/include/crc32.h"
+
+// Reflected look-up table, built at compile time
+typedef struct { uint32_t t[256]; } crc32_table_t;
+
+static constexpr crc32_table_t build_crc32_table(void) {
+  crc32_table_t table = {};
+  for (uint32_t b = 0; b < 256; b++) {
+    uint32_t crc = b;
+    for (int i = 0; i < 8; i++) crc = (crc >> 1) ^ ((crc & 1) ? 0xedb88320 : 0);
+    table.t[b] = crc;
+  }
+  return table;
+}
+
+static constexpr crc32_table_t crc32_table = build_crc32_table();
+
+uint32_t crc32_compute(const void* data, size_t len) {
+  const uint8_t* p = (const uint8_t*)data;
+  uint32_t crc = 0xffffffff;
+  while (len--) crc = (crc >> 8) ^ crc32_table.t[(crc ^ *p++) & 0xff];
+  return ~crc;
+}
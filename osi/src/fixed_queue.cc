@@ -16,19 +16,55 @@
  *
  ******************************************************************************/
 
+#define LOG_TAG "bt_osi_fixed_queue"
+
 #include <base/logging.h>
+#include <errno.h>
+#include <poll.h>
 #include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
 
+#include <atomic>
 #include <mutex>
 
 #include "osi/include/allocator.h"
 #include "osi/include/fixed_queue.h"
 #include "osi/include/list.h"
+#include "osi/include/log.h"
 #include "osi/include/osi.h"
 #include "osi/include/reactor.h"
 #include "osi/include/semaphore.h"
 
+// A single slot of the lock-free ring. |sequence| tells producers and
+// consumers which lap of the ring the slot belongs to (Vyukov's bounded
+// queue), so neither side needs a lock to claim it.
+typedef struct {
+  std::atomic<size_t> sequence;
+  void* data;
+} ring_slot_t;
+
+// Backing store for queues created with |fixed_queue_new_ring|. The eventfds
+// are only written when the other side is parked on them, so the uncontended
+// enqueue/dequeue path issues no syscalls at all.
+typedef struct {
+  ring_slot_t* slots;
+  size_t mask;
+
+  // Producer and consumer cursors live on separate cache lines.
+  alignas(64) std::atomic<size_t> enqueue_pos;
+  alignas(64) std::atomic<size_t> dequeue_pos;
+
+  alignas(64) std::atomic<int> dequeue_waiters;
+  std::atomic<int> enqueue_waiters;
+  std::atomic<bool> reactor_parked;
+  int dequeue_fd;
+  int enqueue_fd;
+} ring_t;
+
 typedef struct fixed_queue_t {
+  ring_t* ring;  // Set for lock-free queues, in which case |list|,
+                 // |enqueue_sem|, |dequeue_sem| and |mutex| are unused.
   list_t* list;
   semaphore_t* enqueue_sem;
   semaphore_t* dequeue_sem;
@@ -41,6 +77,17 @@ typedef struct fixed_queue_t {
 } fixed_queue_t;
 
 static void internal_dequeue_ready(void* context);
+static void ring_free(ring_t* ring);
+static size_t ring_length(const ring_t* ring);
+static bool ring_has_data(const ring_t* ring);
+static bool ring_try_push(ring_t* ring, void* data);
+static void* ring_try_pop(ring_t* ring);
+static void ring_push(ring_t* ring, void* data);
+static void* ring_pop(ring_t* ring);
+static void ring_wake_consumer(ring_t* ring);
+static void ring_wake_producer(ring_t* ring);
+
+static const size_t RING_MAX_CAPACITY = 1 << 16;
 
 fixed_queue_t* fixed_queue_new(size_t capacity) {
   fixed_queue_t* ret =
@@ -65,11 +112,62 @@ error:
   return NULL;
 }
 
+fixed_queue_t* fixed_queue_new_ring(size_t capacity) {
+  // All slots are allocated up front, an unbounded queue can't be a ring.
+  if (capacity > RING_MAX_CAPACITY) {
+    LOG_ERROR(LOG_TAG, "%s capacity %zu too large for a ring queue", __func__,
+              capacity);
+    return NULL;
+  }
+
+  size_t slots = 1;
+  while (slots < capacity) slots <<= 1;
+
+  fixed_queue_t* ret =
+      static_cast<fixed_queue_t*>(osi_calloc(sizeof(fixed_queue_t)));
+  ret->capacity = slots;
+
+  ring_t* ring = new ring_t;
+  ring->slots = new ring_slot_t[slots];
+  ring->mask = slots - 1;
+  for (size_t i = 0; i < slots; i++) {
+    ring->slots[i].sequence.store(i, std::memory_order_relaxed);
+    ring->slots[i].data = NULL;
+  }
+  ring->enqueue_pos.store(0, std::memory_order_relaxed);
+  ring->dequeue_pos.store(0, std::memory_order_relaxed);
+  ring->dequeue_waiters.store(0, std::memory_order_relaxed);
+  ring->enqueue_waiters.store(0, std::memory_order_relaxed);
+  ring->reactor_parked.store(false, std::memory_order_relaxed);
+  ring->dequeue_fd = eventfd(0, EFD_NONBLOCK);
+  ring->enqueue_fd = eventfd(0, EFD_NONBLOCK);
+  ret->ring = ring;
+
+  if (ring->dequeue_fd == INVALID_FD || ring->enqueue_fd == INVALID_FD) {
+    LOG_ERROR(LOG_TAG, "%s unable to allocate eventfd: %s", __func__,
+              strerror(errno));
+    fixed_queue_free(ret, NULL);
+    return NULL;
+  }
+
+  return ret;
+}
+
 void fixed_queue_free(fixed_queue_t* queue, fixed_queue_free_cb free_cb) {
   if (!queue) return;
 
   fixed_queue_unregister_dequeue(queue);
 
+  if (queue->ring) {
+    if (free_cb) {
+      void* data;
+      while ((data = ring_try_pop(queue->ring)) != NULL) free_cb(data);
+    }
+    ring_free(queue->ring);
+    osi_free(queue);
+    return;
+  }
+
   if (free_cb)
     for (const list_node_t* node = list_begin(queue->list);
          node != list_end(queue->list); node = list_next(node))
@@ -96,6 +194,8 @@ void fixed_queue_flush(fixed_queue_t* queue, fixed_queue_free_cb free_cb) {
 bool fixed_queue_is_empty(fixed_queue_t* queue) {
   if (queue == NULL) return true;
 
+  if (queue->ring) return !ring_has_data(queue->ring);
+
   std::lock_guard<std::mutex> lock(*queue->mutex);
   return list_is_empty(queue->list);
 }
@@ -103,6 +203,8 @@ bool fixed_queue_is_empty(fixed_queue_t* queue) {
 size_t fixed_queue_length(fixed_queue_t* queue) {
   if (queue == NULL) return 0;
 
+  if (queue->ring) return ring_length(queue->ring);
+
   std::lock_guard<std::mutex> lock(*queue->mutex);
   return list_length(queue->list);
 }
@@ -117,6 +219,11 @@ void fixed_queue_enqueue(fixed_queue_t* queue, void* data) {
   CHECK(queue != NULL);
   CHECK(data != NULL);
 
+  if (queue->ring) {
+    ring_push(queue->ring, data);
+    return;
+  }
+
   semaphore_wait(queue->enqueue_sem);
 
   {
@@ -130,6 +237,8 @@ void fixed_queue_enqueue(fixed_queue_t* queue, void* data) {
 void* fixed_queue_dequeue(fixed_queue_t* queue) {
   CHECK(queue != NULL);
 
+  if (queue->ring) return ring_pop(queue->ring);
+
   semaphore_wait(queue->dequeue_sem);
 
   void* ret = NULL;
@@ -148,6 +257,12 @@ bool fixed_queue_try_enqueue(fixed_queue_t* queue, void* data) {
   CHECK(queue != NULL);
   CHECK(data != NULL);
 
+  if (queue->ring) {
+    if (!ring_try_push(queue->ring, data)) return false;
+    ring_wake_consumer(queue->ring);
+    return true;
+  }
+
   if (!semaphore_try_wait(queue->enqueue_sem)) return false;
 
   {
@@ -162,6 +277,12 @@ bool fixed_queue_try_enqueue(fixed_queue_t* queue, void* data) {
 void* fixed_queue_try_dequeue(fixed_queue_t* queue) {
   if (queue == NULL) return NULL;
 
+  if (queue->ring) {
+    void* ret = ring_try_pop(queue->ring);
+    if (ret != NULL) ring_wake_producer(queue->ring);
+    return ret;
+  }
+
   if (!semaphore_try_wait(queue->dequeue_sem)) return NULL;
 
   void* ret = NULL;
@@ -176,9 +297,41 @@ void* fixed_queue_try_dequeue(fixed_queue_t* queue) {
   return ret;
 }
 
+size_t fixed_queue_dequeue_all(fixed_queue_t* queue, void** items,
+                               size_t max_items) {
+  if (queue == NULL) return 0;
+  CHECK(items != NULL || max_items == 0);
+
+  size_t count = 0;
+  if (queue->ring) {
+    while (count < max_items) {
+      void* data = ring_try_pop(queue->ring);
+      if (data == NULL) break;
+      items[count++] = data;
+    }
+    if (count > 0) ring_wake_producer(queue->ring);
+    return count;
+  }
+
+  while (count < max_items) {
+    void* data = fixed_queue_try_dequeue(queue);
+    if (data == NULL) break;
+    items[count++] = data;
+  }
+  return count;
+}
+
 void* fixed_queue_try_peek_first(fixed_queue_t* queue) {
   if (queue == NULL) return NULL;
 
+  if (queue->ring) {
+    ring_t* ring = queue->ring;
+    size_t pos = ring->dequeue_pos.load(std::memory_order_relaxed);
+    ring_slot_t* slot = &ring->slots[pos & ring->mask];
+    if (slot->sequence.load(std::memory_order_acquire) != pos + 1) return NULL;
+    return slot->data;
+  }
+
   std::lock_guard<std::mutex> lock(*queue->mutex);
   return list_is_empty(queue->list) ? NULL : list_front(queue->list);
 }
@@ -186,6 +339,15 @@ void* fixed_queue_try_peek_first(fixed_queue_t* queue) {
 void* fixed_queue_try_peek_last(fixed_queue_t* queue) {
   if (queue == NULL) return NULL;
 
+  if (queue->ring) {
+    ring_t* ring = queue->ring;
+    size_t pos = ring->enqueue_pos.load(std::memory_order_acquire);
+    if (pos == ring->dequeue_pos.load(std::memory_order_acquire)) return NULL;
+    ring_slot_t* slot = &ring->slots[(pos - 1) & ring->mask];
+    if (slot->sequence.load(std::memory_order_acquire) != pos) return NULL;
+    return slot->data;
+  }
+
   std::lock_guard<std::mutex> lock(*queue->mutex);
   return list_is_empty(queue->list) ? NULL : list_back(queue->list);
 }
@@ -193,6 +355,9 @@ void* fixed_queue_try_peek_last(fixed_queue_t* queue) {
 void* fixed_queue_try_remove_from_queue(fixed_queue_t* queue, void* data) {
   if (queue == NULL) return NULL;
 
+  // Elements cannot be unlinked from the middle of a lock-free ring.
+  CHECK(queue->ring == NULL);
+
   bool removed = false;
   {
     std::lock_guard<std::mutex> lock(*queue->mutex);
@@ -212,6 +377,7 @@ void* fixed_queue_try_remove_from_queue(fixed_queue_t* queue, void* data) {
 
 list_t* fixed_queue_get_list(fixed_queue_t* queue) {
   CHECK(queue != NULL);
+  CHECK(queue->ring == NULL);
 
   // NOTE: Using the list in this way is not thread-safe.
   // Using this list in any context where threads can call other functions
@@ -221,11 +387,13 @@ list_t* fixed_queue_get_list(fixed_queue_t* queue) {
 
 int fixed_queue_get_dequeue_fd(const fixed_queue_t* queue) {
   CHECK(queue != NULL);
+  if (queue->ring) return queue->ring->dequeue_fd;
   return semaphore_get_fd(queue->dequeue_sem);
 }
 
 int fixed_queue_get_enqueue_fd(const fixed_queue_t* queue) {
   CHECK(queue != NULL);
+  if (queue->ring) return queue->ring->enqueue_fd;
   return semaphore_get_fd(queue->enqueue_sem);
 }
 
@@ -243,6 +411,16 @@ void fixed_queue_register_dequeue(fixed_queue_t* queue, reactor_t* reactor,
   queue->dequeue_object =
       reactor_register(reactor, fixed_queue_get_dequeue_fd(queue), queue,
                        internal_dequeue_ready, NULL);
+
+  if (queue->ring) {
+    // The reactor is now parked on the dequeue fd; kick it once in case
+    // elements were enqueued before registration.
+    queue->ring->reactor_parked.store(true);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (ring_has_data(queue->ring) &&
+        queue->ring->reactor_parked.exchange(false))
+      eventfd_write(queue->ring->dequeue_fd, 1ULL);
+  }
 }
 
 void fixed_queue_unregister_dequeue(fixed_queue_t* queue) {
@@ -252,11 +430,171 @@ void fixed_queue_unregister_dequeue(fixed_queue_t* queue) {
     reactor_unregister(queue->dequeue_object);
     queue->dequeue_object = NULL;
   }
+
+  if (queue->ring) queue->ring->reactor_parked.store(false);
 }
 
 static void internal_dequeue_ready(void* context) {
   CHECK(context != NULL);
 
   fixed_queue_t* queue = static_cast<fixed_queue_t*>(context);
-  queue->dequeue_ready(queue, queue->dequeue_context);
+  if (!queue->ring) {
+    queue->dequeue_ready(queue, queue->dequeue_context);
+    return;
+  }
+
+  // A single wakeup may stand for many elements: drain the doorbell, then
+  // dispatch once per element that was present on entry. Elements that arrive
+  // while dispatching are picked up by re-parking below.
+  ring_t* ring = queue->ring;
+  eventfd_t value;
+  eventfd_read(ring->dequeue_fd, &value);
+
+  for (size_t pending = ring_length(ring); pending > 0; pending--) {
+    if (!ring_has_data(ring)) break;
+    queue->dequeue_ready(queue, queue->dequeue_context);
+    // The callback may have unregistered the queue.
+    if (queue->dequeue_object == NULL) return;
+  }
+
+  ring->reactor_parked.store(true);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (ring_has_data(ring) && ring->reactor_parked.exchange(false))
+    eventfd_write(ring->dequeue_fd, 1ULL);
+}
+
+static void ring_free(ring_t* ring) {
+  if (ring->dequeue_fd != INVALID_FD) close(ring->dequeue_fd);
+  if (ring->enqueue_fd != INVALID_FD) close(ring->enqueue_fd);
+  delete[] ring->slots;
+  delete ring;
+}
+
+static size_t ring_length(const ring_t* ring) {
+  size_t dequeue_pos = ring->dequeue_pos.load(std::memory_order_acquire);
+  size_t enqueue_pos = ring->enqueue_pos.load(std::memory_order_acquire);
+  // The cursors are read separately and may be momentarily inconsistent.
+  return enqueue_pos > dequeue_pos ? enqueue_pos - dequeue_pos : 0;
+}
+
+// Returns true if the element at the head of |ring| has been published. Unlike
+// |ring_length|, this does not count slots a producer has claimed but not yet
+// written, so a subsequent |ring_try_pop| will succeed provided nobody else
+// pops first, which holds for the reactor dispatch since a registered reactor
+// is required to be the only consumer.
+static bool ring_has_data(const ring_t* ring) {
+  size_t pos = ring->dequeue_pos.load(std::memory_order_acquire);
+  const ring_slot_t* slot = &ring->slots[pos & ring->mask];
+  return slot->sequence.load(std::memory_order_acquire) == pos + 1;
+}
+
+static bool ring_try_push(ring_t* ring, void* data) {
+  size_t pos = ring->enqueue_pos.load(std::memory_order_relaxed);
+  ring_slot_t* slot;
+  for (;;) {
+    slot = &ring->slots[pos & ring->mask];
+    size_t seq = slot->sequence.load(std::memory_order_acquire);
+    intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+    if (diff == 0) {
+      if (ring->enqueue_pos.compare_exchange_weak(pos, pos + 1,
+                                                  std::memory_order_relaxed))
+        break;
+    } else if (diff < 0) {
+      return false;  // full
+    } else {
+      pos = ring->enqueue_pos.load(std::memory_order_relaxed);
+    }
+  }
+
+  slot->data = data;
+  slot->sequence.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+static void* ring_try_pop(ring_t* ring) {
+  size_t pos = ring->dequeue_pos.load(std::memory_order_relaxed);
+  ring_slot_t* slot;
+  for (;;) {
+    slot = &ring->slots[pos & ring->mask];
+    size_t seq = slot->sequence.load(std::memory_order_acquire);
+    intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+    if (diff == 0) {
+      if (ring->dequeue_pos.compare_exchange_weak(pos, pos + 1,
+                                                  std::memory_order_relaxed))
+        break;
+    } else if (diff < 0) {
+      return NULL;  // empty
+    } else {
+      pos = ring->dequeue_pos.load(std::memory_order_relaxed);
+    }
+  }
+
+  void* data = slot->data;
+  slot->sequence.store(pos + ring->mask + 1, std::memory_order_release);
+  return data;
+}
+
+// Blocks until |fd| is readable, then clears it.
+static void ring_park(int fd) {
+  struct pollfd pfd;
+  pfd.fd = fd;
+  pfd.events = POLLIN;
+  pfd.revents = 0;
+  int ret;
+  OSI_NO_INTR(ret = poll(&pfd, 1, -1));
+  if (ret == -1) {
+    LOG_ERROR(LOG_TAG, "%s unable to poll eventfd: %s", __func__,
+              strerror(errno));
+    return;
+  }
+  eventfd_t value;
+  eventfd_read(fd, &value);
+}
+
+// The waiter counters and |reactor_parked| pair with the sequentially
+// consistent fences in |ring_wake_*|: either the waker observes the waiter, or
+// the waiter's re-check after registering observes the new element.
+static void ring_push(ring_t* ring, void* data) {
+  while (!ring_try_push(ring, data)) {
+    ring->enqueue_waiters.fetch_add(1);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (ring_try_push(ring, data)) {
+      ring->enqueue_waiters.fetch_sub(1);
+      break;
+    }
+    ring_park(ring->enqueue_fd);
+    ring->enqueue_waiters.fetch_sub(1);
+  }
+  ring_wake_consumer(ring);
+}
+
+static void* ring_pop(ring_t* ring) {
+  void* data;
+  while ((data = ring_try_pop(ring)) == NULL) {
+    ring->dequeue_waiters.fetch_add(1);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    data = ring_try_pop(ring);
+    if (data != NULL) {
+      ring->dequeue_waiters.fetch_sub(1);
+      break;
+    }
+    ring_park(ring->dequeue_fd);
+    ring->dequeue_waiters.fetch_sub(1);
+  }
+  ring_wake_producer(ring);
+  return data;
+}
+
+static void ring_wake_consumer(ring_t* ring) {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (ring->dequeue_waiters.load(std::memory_order_relaxed) > 0 ||
+      (ring->reactor_parked.load(std::memory_order_relaxed) &&
+       ring->reactor_parked.exchange(false)))
+    eventfd_write(ring->dequeue_fd, 1ULL);
+}
+
+static void ring_wake_producer(ring_t* ring) {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (ring->enqueue_waiters.load(std::memory_order_relaxed) > 0)
+    eventfd_write(ring->enqueue_fd, 1ULL);
 }
@@ -0,0 +1,205 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2014 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <base/logging.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <atomic>
+#include <mutex>
+
+#include "osi/include/allocator.h"
+#include "osi/include/pool_allocator.h"
+
+// Size classes, sized for BT_HDR-wrapped HCI traffic: commands and events
+// (255-byte parameters), one ACL packet at a typical controller MTU, and a
+// reassembled L2CAP PDU of BT_DEFAULT_BUFFER_SIZE.
+#define EVENT_BLOCK_SIZE 272
+#define EVENT_BLOCK_COUNT 128
+#define ACL_BLOCK_SIZE 1056
+#define ACL_BLOCK_COUNT 64
+#define LARGE_BLOCK_SIZE 4112
+#define LARGE_BLOCK_COUNT 16
+
+// Number of blocks each thread keeps per class before handing them back.
+#define THREAD_CACHE_SIZE 8
+
+typedef struct {
+  size_t block_size;
+  size_t block_count;
+  uint8_t* arena;
+
+  std::mutex lock;  // Guards |free_blocks| and |free_count|
+  void** free_blocks;
+  size_t free_count;
+
+  std::atomic<size_t> hits;
+  std::atomic<size_t> misses;
+  std::atomic<size_t> in_use;
+  std::atomic<size_t> high_water;
+} pool_class_t;
+
+alignas(16) static uint8_t event_arena[EVENT_BLOCK_COUNT * EVENT_BLOCK_SIZE];
+alignas(16) static uint8_t acl_arena[ACL_BLOCK_COUNT * ACL_BLOCK_SIZE];
+alignas(16) static uint8_t large_arena[LARGE_BLOCK_COUNT * LARGE_BLOCK_SIZE];
+
+static void* event_free_blocks[EVENT_BLOCK_COUNT];
+static void* acl_free_blocks[ACL_BLOCK_COUNT];
+static void* large_free_blocks[LARGE_BLOCK_COUNT];
+
+static pool_class_t pool_classes[POOL_ALLOCATOR_NUM_CLASSES] = {
+    {EVENT_BLOCK_SIZE, EVENT_BLOCK_COUNT, event_arena, {}, event_free_blocks},
+    {ACL_BLOCK_SIZE, ACL_BLOCK_COUNT, acl_arena, {}, acl_free_blocks},
+    {LARGE_BLOCK_SIZE, LARGE_BLOCK_COUNT, large_arena, {}, large_free_blocks},
+};
+
+static std::once_flag pools_initialized;
+
+// Per-thread stash of free blocks. Whatever is left when the thread exits is
+// returned to the shared free lists.
+struct thread_cache_t {
+  void* blocks[POOL_ALLOCATOR_NUM_CLASSES][THREAD_CACHE_SIZE];
+  size_t count[POOL_ALLOCATOR_NUM_CLASSES];
+
+  ~thread_cache_t();
+};
+
+static thread_local thread_cache_t thread_cache;
+
+static void pools_init(void) {
+  for (size_t i = 0; i < POOL_ALLOCATOR_NUM_CLASSES; i++) {
+    pool_class_t* pool = &pool_classes[i];
+    for (size_t j = 0; j < pool->block_count; j++)
+      pool->free_blocks[j] = pool->arena + (j * pool->block_size);
+    pool->free_count = pool->block_count;
+  }
+}
+
+static pool_class_t* class_for_block(const void* ptr) {
+  const uint8_t* p = static_cast<const uint8_t*>(ptr);
+  for (size_t i = 0; i < POOL_ALLOCATOR_NUM_CLASSES; i++) {
+    pool_class_t* pool = &pool_classes[i];
+    if (p >= pool->arena &&
+        p < pool->arena + (pool->block_count * pool->block_size))
+      return pool;
+  }
+  return NULL;
+}
+
+// Moves up to |count| blocks from the shared free list of class |index| into
+// the calling thread's cache. Returns the number of blocks moved.
+static size_t refill_thread_cache(size_t index, size_t count) {
+  pool_class_t* pool = &pool_classes[index];
+  std::lock_guard<std::mutex> lock(pool->lock);
+
+  size_t moved = 0;
+  while (moved < count && pool->free_count > 0) {
+    thread_cache.blocks[index][thread_cache.count[index]++] =
+        pool->free_blocks[--pool->free_count];
+    moved++;
+  }
+  return moved;
+}
+
+// Hands |count| blocks from the top of the calling thread's cache for class
+// |index| back to the shared free list.
+static void drain_thread_cache(size_t index, size_t count) {
+  pool_class_t* pool = &pool_classes[index];
+  std::lock_guard<std::mutex> lock(pool->lock);
+
+  for (size_t i = 0; i < count; i++) {
+    CHECK(pool->free_count < pool->block_count);
+    pool->free_blocks[pool->free_count++] =
+        thread_cache.blocks[index][--thread_cache.count[index]];
+  }
+}
+
+thread_cache_t::~thread_cache_t() {
+  for (size_t i = 0; i < POOL_ALLOCATOR_NUM_CLASSES; i++)
+    drain_thread_cache(i, count[i]);
+}
+
+void* pool_allocator_alloc(size_t size) {
+  std::call_once(pools_initialized, pools_init);
+
+  size_t index = 0;
+  while (index < POOL_ALLOCATOR_NUM_CLASSES &&
+         size > pool_classes[index].block_size)
+    index++;
+  if (index == POOL_ALLOCATOR_NUM_CLASSES) return osi_malloc(size);
+
+  pool_class_t* pool = &pool_classes[index];
+  if (thread_cache.count[index] == 0 &&
+      refill_thread_cache(index, THREAD_CACHE_SIZE / 2) == 0) {
+    pool->misses.fetch_add(1, std::memory_order_relaxed);
+    return osi_malloc(size);
+  }
+
+  pool->hits.fetch_add(1, std::memory_order_relaxed);
+  size_t in_use = pool->in_use.fetch_add(1, std::memory_order_relaxed) + 1;
+  size_t high_water = pool->high_water.load(std::memory_order_relaxed);
+  while (in_use > high_water &&
+         !pool->high_water.compare_exchange_weak(high_water, in_use,
+                                                 std::memory_order_relaxed)) {
+  }
+
+  return thread_cache.blocks[index][--thread_cache.count[index]];
+}
+
+bool pool_allocator_owns(const void* ptr) {
+  return class_for_block(ptr) != NULL;
+}
+
+void pool_allocator_release(void* ptr) {
+  pool_class_t* pool = class_for_block(ptr);
+  CHECK(pool != NULL);
+  CHECK((static_cast<uint8_t*>(ptr) - pool->arena) % pool->block_size == 0);
+
+  size_t index = pool - pool_classes;
+  if (thread_cache.count[index] == THREAD_CACHE_SIZE)
+    drain_thread_cache(index, THREAD_CACHE_SIZE / 2);
+
+  thread_cache.blocks[index][thread_cache.count[index]++] = ptr;
+  pool->in_use.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void pool_allocator_get_stats(size_t index, pool_allocator_stats_t* stats) {
+  CHECK(index < POOL_ALLOCATOR_NUM_CLASSES);
+  CHECK(stats != NULL);
+
+  const pool_class_t* pool = &pool_classes[index];
+  stats->block_size = pool->block_size;
+  stats->block_count = pool->block_count;
+  stats->hits = pool->hits.load(std::memory_order_relaxed);
+  stats->misses = pool->misses.load(std::memory_order_relaxed);
+  stats->in_use = pool->in_use.load(std::memory_order_relaxed);
+  stats->high_water = pool->high_water.load(std::memory_order_relaxed);
+}
+
+void pool_allocator_debug_dump(int fd) {
+  dprintf(fd, "\nBluetooth Buffer Pool Statistics:\n");
+  dprintf(fd, "  Block size  Blocks  Hits        Misses      In use  Peak\n");
+
+  for (size_t i = 0; i < POOL_ALLOCATOR_NUM_CLASSES; i++) {
+    pool_allocator_stats_t stats;
+    pool_allocator_get_stats(i, &stats);
+    dprintf(fd, "  %-10zu  %-6zu  %-10zu  %-10zu  %-6zu  %zu\n",
+            stats.block_size, stats.block_count, stats.hits, stats.misses,
+            stats.in_use, stats.high_water);
+  }
+}
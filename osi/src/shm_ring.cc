@@ -0,0 +1,394 @@
+/******************************************************************************
+ *
+ *  Copyright 2018 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "bt_osi_shm_ring"
+
+#include <base/logging.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <new>
+
+#include "osi/include/allocator.h"
+#include "osi/include/log.h"
+#include "osi/include/osi.h"
+#include "osi/include/shm_ring.h"
+#include "osi/include/time.h"
+
+#define SHM_RING_MAGIC 0x52494e47 /* "RING" */
+#define SHM_RING_MAX_CAPACITY (1u << 30)
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#define MFD_ALLOW_SEALING 0x0002U
+#endif
+
+// The shared header at the start of the memfd, followed by the data. Each
+// side only ever writes its own index; the one owned by the peer is checked
+// against the capacity every time it is read.
+typedef struct {
+  uint32_t magic;
+  uint32_t capacity;
+
+  alignas(64) std::atomic<uint32_t> head;  // Written by the producer
+  std::atomic<uint32_t> producer_waiting;
+
+  alignas(64) std::atomic<uint32_t> tail;  // Written by the consumer
+  std::atomic<uint32_t> consumer_waiting;
+
+  alignas(64) std::atomic<uint32_t> attached;
+  std::atomic<uint32_t> closed;
+} shm_ring_header_t;
+
+struct shm_ring_t {
+  shm_ring_header_t* header;
+  uint8_t* data;
+  size_t map_size;
+
+  // Local copies, never re-read from shared memory.
+  uint32_t capacity;
+  uint32_t position;  // |tail| for the consumer, |head| for the producer
+  bool is_producer;
+
+  int mem_fd;
+  int data_fd;   // Rung by the producer when data is written
+  int space_fd;  // Rung by the consumer when space is freed
+};
+
+static shm_ring_t* ring_map(int mem_fd, size_t capacity);
+static void ring_wake(std::atomic<uint32_t>* waiting, int fd);
+static int ring_wait(shm_ring_t* ring, bool readable, size_t length,
+                     int timeout_ms, int hangup_fd);
+
+shm_ring_t* shm_ring_create(size_t capacity) {
+  CHECK(capacity > 0);
+
+  if (capacity > SHM_RING_MAX_CAPACITY) return NULL;
+  size_t rounded = 1;
+  while (rounded < capacity) rounded <<= 1;
+
+#if defined(__NR_memfd_create)
+  int mem_fd = syscall(__NR_memfd_create, "bt_shm_ring",
+                       MFD_CLOEXEC | MFD_ALLOW_SEALING);
+#else
+  int mem_fd = INVALID_FD;
+  errno = ENOSYS;
+#endif
+  if (mem_fd == INVALID_FD) {
+    LOG_WARN(LOG_TAG, "%s unable to create memfd: %s", __func__,
+             strerror(errno));
+    return NULL;
+  }
+
+  if (ftruncate(mem_fd, sizeof(shm_ring_header_t) + rounded) == -1) {
+    LOG_ERROR(LOG_TAG, "%s unable to size memfd: %s", __func__,
+              strerror(errno));
+    close(mem_fd);
+    return NULL;
+  }
+
+#if defined(F_ADD_SEALS)
+  // The peer must not be able to shrink the file and fault us on access.
+  if (fcntl(mem_fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) ==
+      -1) {
+    LOG_WARN(LOG_TAG, "%s unable to seal memfd: %s", __func__, strerror(errno));
+  }
+#endif
+
+  shm_ring_t* ring = ring_map(mem_fd, rounded);
+  if (ring == NULL) {
+    close(mem_fd);
+    return NULL;
+  }
+
+  shm_ring_header_t* header = new (ring->header) shm_ring_header_t;
+  header->magic = SHM_RING_MAGIC;
+  header->capacity = rounded;
+  header->head = 0;
+  header->producer_waiting = 0;
+  header->tail = 0;
+  header->consumer_waiting = 0;
+  header->attached = 0;
+  header->closed = 0;
+
+  ring->data_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  ring->space_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (ring->data_fd == INVALID_FD || ring->space_fd == INVALID_FD) {
+    LOG_ERROR(LOG_TAG, "%s unable to create eventfds: %s", __func__,
+              strerror(errno));
+    shm_ring_free(ring);
+    return NULL;
+  }
+
+  return ring;
+}
+
+shm_ring_t* shm_ring_attach(const int fds[SHM_RING_NUM_FDS]) {
+  CHECK(fds != NULL);
+
+  struct stat st;
+  if (fstat(fds[0], &st) == -1 ||
+      (size_t)st.st_size <= sizeof(shm_ring_header_t)) {
+    LOG_ERROR(LOG_TAG, "%s invalid ring memory", __func__);
+    return NULL;
+  }
+  size_t capacity = st.st_size - sizeof(shm_ring_header_t);
+  if (capacity > SHM_RING_MAX_CAPACITY || (capacity & (capacity - 1)) != 0) {
+    LOG_ERROR(LOG_TAG, "%s invalid ring capacity %zu", __func__, capacity);
+    return NULL;
+  }
+
+  shm_ring_t* ring = ring_map(fds[0], capacity);
+  if (ring == NULL) return NULL;
+
+  if (ring->header->magic != SHM_RING_MAGIC ||
+      ring->header->capacity != capacity) {
+    LOG_ERROR(LOG_TAG, "%s invalid ring header", __func__);
+    munmap(ring->header, ring->map_size);
+    osi_free(ring);
+    return NULL;
+  }
+
+  ring->is_producer = true;
+  ring->position = ring->header->head.load(std::memory_order_relaxed);
+  ring->data_fd = fds[1];
+  ring->space_fd = fds[2];
+  ring->header->attached.store(1, std::memory_order_release);
+  return ring;
+}
+
+void shm_ring_free(shm_ring_t* ring) {
+  if (ring == NULL) return;
+
+  munmap(ring->header, ring->map_size);
+  if (ring->mem_fd != INVALID_FD) close(ring->mem_fd);
+  if (ring->data_fd != INVALID_FD) close(ring->data_fd);
+  if (ring->space_fd != INVALID_FD) close(ring->space_fd);
+  osi_free(ring);
+}
+
+void shm_ring_get_fds(const shm_ring_t* ring, int fds[SHM_RING_NUM_FDS]) {
+  CHECK(ring != NULL);
+  CHECK(fds != NULL);
+
+  fds[0] = ring->mem_fd;
+  fds[1] = ring->data_fd;
+  fds[2] = ring->space_fd;
+}
+
+void shm_ring_close(shm_ring_t* ring) {
+  CHECK(ring != NULL);
+
+  ring->header->closed.store(1);
+  ring_wake(&ring->header->consumer_waiting, ring->data_fd);
+  ring_wake(&ring->header->producer_waiting, ring->space_fd);
+}
+
+bool shm_ring_is_attached(const shm_ring_t* ring) {
+  CHECK(ring != NULL);
+
+  return ring->header->attached.load(std::memory_order_acquire) != 0;
+}
+
+// Returns the number of bytes between the two indices, or a value larger than
+// the capacity if the peer corrupted its index.
+static uint32_t ring_used(const shm_ring_t* ring) {
+  if (ring->is_producer)
+    return ring->position -
+           ring->header->tail.load(std::memory_order_acquire);
+  return ring->header->head.load(std::memory_order_acquire) - ring->position;
+}
+
+bool shm_ring_is_closed(const shm_ring_t* ring) {
+  CHECK(ring != NULL);
+
+  return ring->header->closed.load(std::memory_order_acquire) != 0 ||
+         ring_used(ring) > ring->capacity;
+}
+
+size_t shm_ring_readable(const shm_ring_t* ring) {
+  CHECK(ring != NULL);
+
+  uint32_t used = ring_used(ring);
+  return used > ring->capacity ? 0 : used;
+}
+
+size_t shm_ring_writable(const shm_ring_t* ring) {
+  CHECK(ring != NULL);
+
+  uint32_t used = ring_used(ring);
+  return used > ring->capacity ? 0 : ring->capacity - used;
+}
+
+size_t shm_ring_read(shm_ring_t* ring, void* buffer, size_t length) {
+  CHECK(ring != NULL);
+  CHECK(buffer != NULL);
+  CHECK(!ring->is_producer);
+
+  size_t readable = shm_ring_readable(ring);
+  if (length > readable) length = readable;
+  if (length == 0) return 0;
+
+  uint32_t offset = ring->position & (ring->capacity - 1);
+  size_t first = ring->capacity - offset;
+  if (first > length) first = length;
+  memcpy(buffer, ring->data + offset, first);
+  memcpy((uint8_t*)buffer + first, ring->data, length - first);
+
+  ring->position += length;
+  ring->header->tail.store(ring->position, std::memory_order_release);
+  ring_wake(&ring->header->producer_waiting, ring->space_fd);
+  return length;
+}
+
+void shm_ring_flush(shm_ring_t* ring) {
+  CHECK(ring != NULL);
+  CHECK(!ring->is_producer);
+
+  ring->position += shm_ring_readable(ring);
+  ring->header->tail.store(ring->position, std::memory_order_release);
+  ring_wake(&ring->header->producer_waiting, ring->space_fd);
+}
+
+size_t shm_ring_write(shm_ring_t* ring, const void* buffer, size_t length) {
+  CHECK(ring != NULL);
+  CHECK(buffer != NULL);
+  CHECK(ring->is_producer);
+
+  if (shm_ring_is_closed(ring)) return 0;
+
+  size_t writable = shm_ring_writable(ring);
+  if (length > writable) length = writable;
+  if (length == 0) return 0;
+
+  uint32_t offset = ring->position & (ring->capacity - 1);
+  size_t first = ring->capacity - offset;
+  if (first > length) first = length;
+  memcpy(ring->data + offset, buffer, first);
+  memcpy(ring->data, (const uint8_t*)buffer + first, length - first);
+
+  ring->position += length;
+  ring->header->head.store(ring->position, std::memory_order_release);
+  ring_wake(&ring->header->consumer_waiting, ring->data_fd);
+  return length;
+}
+
+int shm_ring_wait_readable(shm_ring_t* ring, size_t length, int timeout_ms,
+                           int hangup_fd) {
+  CHECK(ring != NULL);
+
+  return ring_wait(ring, true, length, timeout_ms, hangup_fd);
+}
+
+int shm_ring_wait_writable(shm_ring_t* ring, size_t length, int timeout_ms,
+                           int hangup_fd) {
+  CHECK(ring != NULL);
+
+  return ring_wait(ring, false, length, timeout_ms, hangup_fd);
+}
+
+static shm_ring_t* ring_map(int mem_fd, size_t capacity) {
+  size_t map_size = sizeof(shm_ring_header_t) + capacity;
+  void* base =
+      mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, mem_fd, 0);
+  if (base == MAP_FAILED) {
+    LOG_ERROR(LOG_TAG, "%s unable to map ring: %s", __func__, strerror(errno));
+    return NULL;
+  }
+
+  shm_ring_t* ring = static_cast<shm_ring_t*>(osi_calloc(sizeof(shm_ring_t)));
+  ring->header = static_cast<shm_ring_header_t*>(base);
+  ring->data = static_cast<uint8_t*>(base) + sizeof(shm_ring_header_t);
+  ring->map_size = map_size;
+  ring->capacity = capacity;
+  ring->position = 0;
+  ring->is_producer = false;
+  ring->mem_fd = mem_fd;
+  ring->data_fd = INVALID_FD;
+  ring->space_fd = INVALID_FD;
+  return ring;
+}
+
+// The waiting flags pair with the sequentially consistent fences here and in
+// |ring_wait|: either the waker observes the waiter, or the waiter's re-check
+// after raising its flag observes the new index.
+static void ring_wake(std::atomic<uint32_t>* waiting, int fd) {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (waiting->load(std::memory_order_relaxed) != 0 && waiting->exchange(0))
+    eventfd_write(fd, 1ULL);
+}
+
+static int ring_wait(shm_ring_t* ring, bool readable, size_t length,
+                     int timeout_ms, int hangup_fd) {
+  std::atomic<uint32_t>* waiting = readable
+                                       ? &ring->header->consumer_waiting
+                                       : &ring->header->producer_waiting;
+  struct pollfd pfds[2];
+  pfds[0].fd = readable ? ring->data_fd : ring->space_fd;
+  pfds[0].events = POLLIN;
+  pfds[1].fd = hangup_fd;
+  pfds[1].events = 0;
+
+  if (length > ring->capacity) length = ring->capacity;
+  uint32_t deadline = time_get_os_boottime_ms() + timeout_ms;
+
+  for (;;) {
+    size_t available =
+        readable ? shm_ring_readable(ring) : shm_ring_writable(ring);
+    if (available >= length) return 1;
+    if (shm_ring_is_closed(ring)) return -1;
+
+    waiting->store(1);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    available = readable ? shm_ring_readable(ring) : shm_ring_writable(ring);
+    if (available >= length || shm_ring_is_closed(ring)) {
+      waiting->store(0);
+      continue;
+    }
+
+    int remaining = (int)(deadline - time_get_os_boottime_ms());
+    if (remaining <= 0) {
+      waiting->store(0);
+      return 0;
+    }
+
+    pfds[0].revents = 0;
+    pfds[1].revents = 0;
+    int ret;
+    OSI_NO_INTR(ret = poll(pfds, hangup_fd == INVALID_FD ? 1 : 2, remaining));
+    waiting->store(0);
+    if (ret == -1) {
+      LOG_ERROR(LOG_TAG, "%s unable to poll doorbell: %s", __func__,
+                strerror(errno));
+      return -1;
+    }
+    if (pfds[0].revents & POLLIN) {
+      eventfd_t value;
+      eventfd_read(pfds[0].fd, &value);
+    }
+    if (pfds[1].revents & (POLLHUP | POLLERR | POLLNVAL)) return -1;
+  }
+}
@@ -36,6 +36,7 @@
 #include "osi/include/compat.h"
 #include "osi/include/fixed_queue.h"
 #include "osi/include/log.h"
+#include "osi/include/osi.h"
 #include "osi/include/reactor.h"
 #include "osi/include/semaphore.h"
 
@@ -60,9 +61,10 @@ typedef struct {
 } work_item_t;
 
 static void* run_thread(void* start_arg);
-static void work_queue_read_cb(void* context);
+static void work_queue_ready(fixed_queue_t* queue, void* context);
 
 static const size_t DEFAULT_WORK_QUEUE_CAPACITY = 128;
+static const size_t MAX_RING_WORK_QUEUE_CAPACITY = 4096;
 
 thread_t* thread_new_sized(const char* name, size_t work_queue_capacity) {
   CHECK(name != NULL);
@@ -76,7 +78,12 @@ thread_t* thread_new_sized(const char* name, size_t work_queue_capacity) {
   ret->reactor = reactor_new();
   if (!ret->reactor) goto error;
 
-  ret->work_queue = fixed_queue_new(work_queue_capacity);
+  // Unbounded work queues, such as the alarm callback thread's, keep the list
+  // backed queue rather than preallocating a ring for them.
+  if (work_queue_capacity <= MAX_RING_WORK_QUEUE_CAPACITY)
+    ret->work_queue = fixed_queue_new_ring(work_queue_capacity);
+  else
+    ret->work_queue = fixed_queue_new(work_queue_capacity);
   if (!ret->work_queue) goto error;
 
   // Start is on the stack, but we use a semaphore, so it's safe
@@ -216,13 +223,12 @@ static void* run_thread(void* start_arg) {
 
   semaphore_post(start->start_sem);
 
-  int fd = fixed_queue_get_dequeue_fd(thread->work_queue);
-  void* context = thread->work_queue;
-
-  reactor_object_t* work_queue_object =
-      reactor_register(thread->reactor, fd, context, work_queue_read_cb, NULL);
+  // This thread is the only consumer of its work queue, as the ring queue
+  // requires once a reactor is registered on it.
+  fixed_queue_register_dequeue(thread->work_queue, thread->reactor,
+                               work_queue_ready, NULL);
   reactor_start(thread->reactor);
-  reactor_unregister(work_queue_object);
+  fixed_queue_unregister_dequeue(thread->work_queue);
 
   // Make sure we dispatch all queued work items before exiting the thread.
   // This allows a caller to safely tear down by enqueuing a teardown
@@ -246,10 +252,7 @@ static void* run_thread(void* start_arg) {
   return NULL;
 }
 
-static void work_queue_read_cb(void* context) {
-  CHECK(context != NULL);
-
-  fixed_queue_t* queue = (fixed_queue_t*)context;
+static void work_queue_ready(fixed_queue_t* queue, UNUSED_ATTR void* context) {
   work_item_t* item = static_cast<work_item_t*>(fixed_queue_dequeue(queue));
   item->func(item->context);
   osi_free(item);
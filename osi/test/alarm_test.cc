@@ -312,6 +312,38 @@ TEST_F(AlarmTest, test_callback_ordering) {
   EXPECT_FALSE(WakeLockHeld());
 }
 
+// Test whether alarms set in reverse order of their deadlines, spread over
+// several coarse timer slots, still fire in deadline order
+TEST_F(AlarmTest, test_callback_ordering_spread_deadlines) {
+  alarm_t* alarms[50];
+
+  for (int i = 0; i < 50; i++) {
+    const std::string alarm_name =
+        "alarm_test.test_callback_ordering_spread_deadlines[" +
+        std::to_string(i) + "]";
+    alarms[i] = alarm_new(alarm_name.c_str());
+  }
+
+  for (int i = 49; i >= 0; i--) {
+    alarm_set(alarms[i], 10 + i * 13, ordered_cb, INT_TO_PTR(i));
+  }
+
+  // Canceling and re-arming one in the middle must not disturb the others
+  alarm_cancel(alarms[20]);
+  alarm_set(alarms[20], 10 + 20 * 13, ordered_cb, INT_TO_PTR(20));
+
+  for (int i = 1; i <= 50; i++) {
+    semaphore_wait(semaphore);
+    EXPECT_GE(cb_counter, i);
+  }
+  EXPECT_EQ(cb_counter, 50);
+  EXPECT_EQ(cb_misordered_counter, 0);
+
+  for (int i = 0; i < 50; i++) alarm_free(alarms[i]);
+
+  EXPECT_FALSE(WakeLockHeld());
+}
+
 // Test whether the callbacks are involed in the expected order on a
 // message loop.
 TEST_F(AlarmTest, test_callback_ordering_on_mloop) {
@@ -0,0 +1,242 @@
+#include <gtest/gtest.h>
+
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "AllocationTestHarness.h"
+
+#include "osi/include/config.h"
+#include "osi/include/config_journal.h"
+
+static const char JOURNAL_FILE[] = "/data/local/tmp/config_journal_test.journal";
+static const char CONFIG_FILE[] = "/data/local/tmp/config_journal_test.conf";
+
+static std::string read_file(const char* filename) {
+  std::string contents;
+  FILE* fp = fopen(filename, "rb");
+  if (!fp) return contents;
+  char buf[256];
+  size_t len;
+  while ((len = fread(buf, 1, sizeof(buf), fp)) > 0) contents.append(buf, len);
+  fclose(fp);
+  return contents;
+}
+
+static void write_file(const char* filename, const std::string& contents) {
+  FILE* fp = fopen(filename, "wb");
+  fwrite(contents.data(), 1, contents.size(), fp);
+  fclose(fp);
+}
+
+static off_t file_size(const char* filename) {
+  struct stat st;
+  if (stat(filename, &st) < 0) return -1;
+  return st.st_size;
+}
+
+class ConfigJournalTest : public AllocationTestHarness {
+ protected:
+  virtual void SetUp() {
+    AllocationTestHarness::SetUp();
+    unlink(JOURNAL_FILE);
+    unlink(CONFIG_FILE);
+  }
+
+  virtual void TearDown() {
+    unlink(JOURNAL_FILE);
+    unlink(CONFIG_FILE);
+    AllocationTestHarness::TearDown();
+  }
+};
+
+TEST_F(ConfigJournalTest, config_journal_open_new) {
+  config_t* config = config_new_empty();
+  config_journal_t* journal = config_journal_open(JOURNAL_FILE, config);
+  ASSERT_TRUE(journal != NULL);
+  EXPECT_EQ(0u, config_journal_size(journal));
+  EXPECT_FALSE(config_section_begin(config) != config_section_end(config));
+  config_journal_free(journal);
+  config_free(config);
+}
+
+TEST_F(ConfigJournalTest, config_journal_free_null) { config_journal_free(NULL); }
+
+TEST_F(ConfigJournalTest, config_journal_commit_and_replay) {
+  config_t* config = config_new_empty();
+  config_journal_t* journal = config_journal_open(JOURNAL_FILE, config);
+  config_journal_set(journal, "Adapter", "Address", "01:02:03:04:05:06");
+  config_journal_set(journal, "aa:bb:cc:dd:ee:ff", "LinkKey", "0123");
+  config_journal_set(journal, "aa:bb:cc:dd:ee:ff", "Name", "headset");
+  config_journal_remove_key(journal, "aa:bb:cc:dd:ee:ff", "Name");
+  config_journal_set(journal, "aa:bb:cc:dd:ee:ff", "LinkKey", "4567");
+  EXPECT_TRUE(config_journal_commit(journal));
+  EXPECT_GT(config_journal_size(journal), 0u);
+  config_journal_free(journal);
+  config_free(config);
+
+  config = config_new_empty();
+  journal = config_journal_open(JOURNAL_FILE, config);
+  ASSERT_TRUE(journal != NULL);
+  EXPECT_STREQ("01:02:03:04:05:06",
+               config_get_string(config, "Adapter", "Address", NULL));
+  EXPECT_STREQ("4567",
+               config_get_string(config, "aa:bb:cc:dd:ee:ff", "LinkKey", NULL));
+  EXPECT_FALSE(config_has_key(config, "aa:bb:cc:dd:ee:ff", "Name"));
+  config_journal_free(journal);
+  config_free(config);
+}
+
+TEST_F(ConfigJournalTest, config_journal_uncommitted_changes_lost) {
+  config_t* config = config_new_empty();
+  config_journal_t* journal = config_journal_open(JOURNAL_FILE, config);
+  config_journal_set(journal, "Adapter", "Name", "committed");
+  config_journal_commit(journal);
+  config_journal_set(journal, "Adapter", "Name", "pending");
+  config_journal_free(journal);
+  config_free(config);
+
+  config = config_new_empty();
+  journal = config_journal_open(JOURNAL_FILE, config);
+  EXPECT_STREQ("committed", config_get_string(config, "Adapter", "Name", NULL));
+  config_journal_free(journal);
+  config_free(config);
+}
+
+// Simulates a crash at every byte of the last append: the journal must come
+// back with exactly the records committed before it, and take new ones.
+TEST_F(ConfigJournalTest, config_journal_truncated_replay) {
+  config_t* config = config_new_empty();
+  config_journal_t* journal = config_journal_open(JOURNAL_FILE, config);
+  std::vector<off_t> sizes;
+  sizes.push_back(file_size(JOURNAL_FILE));
+  for (int i = 0; i < 3; i++) {
+    config_journal_set(journal, "Adapter", ("Key" + std::to_string(i)).c_str(),
+                       std::to_string(i).c_str());
+    config_journal_commit(journal);
+    sizes.push_back(file_size(JOURNAL_FILE));
+  }
+  config_journal_free(journal);
+  config_free(config);
+
+  const std::string full = read_file(JOURNAL_FILE);
+  ASSERT_EQ((size_t)sizes.back(), full.size());
+  for (size_t len = sizes.front(); len <= full.size(); len++) {
+    write_file(JOURNAL_FILE, full.substr(0, len));
+
+    size_t records = 0;
+    while (records + 1 < sizes.size() && (size_t)sizes[records + 1] <= len)
+      records++;
+
+    config = config_new_empty();
+    journal = config_journal_open(JOURNAL_FILE, config);
+    ASSERT_TRUE(journal != NULL);
+    for (size_t i = 0; i < 3; i++) {
+      EXPECT_EQ(i < records,
+                config_has_key(config, "Adapter",
+                               ("Key" + std::to_string(i)).c_str()))
+          << "truncated to " << len << " bytes";
+    }
+    EXPECT_EQ(sizes[records], file_size(JOURNAL_FILE));
+
+    config_journal_set(journal, "Adapter", "After", "crash");
+    EXPECT_TRUE(config_journal_commit(journal));
+    config_journal_free(journal);
+    config_free(config);
+
+    config = config_new_empty();
+    journal = config_journal_open(JOURNAL_FILE, config);
+    EXPECT_STREQ("crash", config_get_string(config, "Adapter", "After", NULL));
+    config_journal_free(journal);
+    config_free(config);
+  }
+}
+
+TEST_F(ConfigJournalTest, config_journal_corrupt_record) {
+  config_t* config = config_new_empty();
+  config_journal_t* journal = config_journal_open(JOURNAL_FILE, config);
+  config_journal_set(journal, "Adapter", "First", "1");
+  config_journal_commit(journal);
+  off_t first_end = file_size(JOURNAL_FILE);
+  config_journal_set(journal, "Adapter", "Second", "2");
+  config_journal_set(journal, "Adapter", "Third", "3");
+  config_journal_commit(journal);
+  config_journal_free(journal);
+  config_free(config);
+
+  // Flip a bit in the value of the second record.
+  std::string contents = read_file(JOURNAL_FILE);
+  size_t pos = contents.find("Second") + strlen("Second");
+  contents[pos] ^= 1;
+  write_file(JOURNAL_FILE, contents);
+
+  config = config_new_empty();
+  journal = config_journal_open(JOURNAL_FILE, config);
+  EXPECT_TRUE(config_has_key(config, "Adapter", "First"));
+  EXPECT_FALSE(config_has_key(config, "Adapter", "Second"));
+  EXPECT_FALSE(config_has_key(config, "Adapter", "Third"));
+  EXPECT_EQ(first_end, file_size(JOURNAL_FILE));
+  config_journal_free(journal);
+  config_free(config);
+}
+
+TEST_F(ConfigJournalTest, config_journal_unrecognized_file) {
+  write_file(JOURNAL_FILE, "[Adapter]\nAddress = 01:02:03:04:05:06\n");
+
+  config_t* config = config_new_empty();
+  config_journal_t* journal = config_journal_open(JOURNAL_FILE, config);
+  ASSERT_TRUE(journal != NULL);
+  EXPECT_FALSE(config_has_section(config, "Adapter"));
+  EXPECT_EQ(0u, config_journal_size(journal));
+  config_journal_free(journal);
+  config_free(config);
+}
+
+TEST_F(ConfigJournalTest, config_journal_reset_keeps_pending) {
+  config_t* config = config_new_empty();
+  config_journal_t* journal = config_journal_open(JOURNAL_FILE, config);
+  config_journal_set(journal, "Adapter", "Saved", "1");
+  config_journal_commit(journal);
+  config_journal_set(journal, "Adapter", "Pending", "1");
+  EXPECT_TRUE(config_journal_reset(journal));
+  EXPECT_EQ(0u, config_journal_size(journal));
+  config_journal_commit(journal);
+  config_journal_free(journal);
+  config_free(config);
+
+  config = config_new_empty();
+  journal = config_journal_open(JOURNAL_FILE, config);
+  EXPECT_FALSE(config_has_key(config, "Adapter", "Saved"));
+  EXPECT_TRUE(config_has_key(config, "Adapter", "Pending"));
+  config_journal_free(journal);
+  config_free(config);
+}
+
+// A crash after the config was saved but before the journal was reset
+// replays the journal over the saved config, which must change nothing.
+TEST_F(ConfigJournalTest, config_journal_replay_over_saved_config) {
+  config_t* config = config_new_empty();
+  config_journal_t* journal = config_journal_open(JOURNAL_FILE, config);
+  const char* section = "aa:bb:cc:dd:ee:ff";
+  config_set_string(config, section, "Name", "old");
+  config_journal_set(journal, section, "Name", "old");
+  config_remove_key(config, section, "Name");
+  config_journal_remove_key(journal, section, "Name");
+  config_set_string(config, section, "LinkKey", "0123");
+  config_journal_set(journal, section, "LinkKey", "0123");
+  config_journal_commit(journal);
+  config_save(config, CONFIG_FILE);
+  config_journal_free(journal);
+  config_free(config);
+
+  config = config_new(CONFIG_FILE);
+  ASSERT_TRUE(config != NULL);
+  journal = config_journal_open(JOURNAL_FILE, config);
+  EXPECT_FALSE(config_has_key(config, section, "Name"));
+  EXPECT_STREQ("0123", config_get_string(config, section, "LinkKey", NULL));
+  config_journal_free(journal);
+  config_free(config);
+}
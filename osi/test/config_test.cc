@@ -164,6 +164,50 @@ TEST_F(ConfigTest, config_remove_key_missing) {
   config_free(config);
 }
 
+TEST_F(ConfigTest, config_set_after_remove) {
+  config_t* config = config_new(CONFIG_FILE);
+  EXPECT_TRUE(config_remove_key(config, "DID", "productId"));
+  config_set_int(config, "DID", "productId", 0x1300);
+  EXPECT_EQ(config_get_int(config, "DID", "productId", 999), 0x1300);
+
+  EXPECT_TRUE(config_remove_section(config, "DID"));
+  config_set_int(config, "DID", "productId", 0x1400);
+  EXPECT_TRUE(config_has_section(config, "DID"));
+  EXPECT_EQ(config_get_int(config, "DID", "productId", 999), 0x1400);
+  EXPECT_FALSE(config_has_key(config, "DID", "version"));
+  config_free(config);
+}
+
+TEST_F(ConfigTest, config_many_sections) {
+  config_t* config = config_new_empty();
+  char section[32];
+  for (int i = 0; i < 500; i++) {
+    snprintf(section, sizeof(section), "00:11:22:33:%02x:%02x", i >> 8,
+             i & 0xff);
+    config_set_int(config, section, "DevType", i);
+    config_set_string(config, section, "Name", section);
+  }
+
+  for (int i = 0; i < 500; i++) {
+    snprintf(section, sizeof(section), "00:11:22:33:%02x:%02x", i >> 8,
+             i & 0xff);
+    EXPECT_EQ(config_get_int(config, section, "DevType", -1), i);
+    EXPECT_STREQ(config_get_string(config, section, "Name", NULL), section);
+  }
+
+  // Sections are iterated in the order they were added
+  int count = 0;
+  for (const config_section_node_t* node = config_section_begin(config);
+       node != config_section_end(config); node = config_section_next(node)) {
+    snprintf(section, sizeof(section), "00:11:22:33:%02x:%02x", count >> 8,
+             count & 0xff);
+    EXPECT_STREQ(config_section_name(node), section);
+    count++;
+  }
+  EXPECT_EQ(count, 500);
+  config_free(config);
+}
+
 TEST_F(ConfigTest, config_section_begin) {
   config_t* config = config_new(CONFIG_FILE);
   const config_section_node_t* section = config_section_begin(config);
@@ -0,0 +1,22 @@
+#include <gtest/gtest.h>
+
+#include <stdint.h>
+
+#include "osi/include/crc32.h"
+
+TEST(Crc32Test, test_empty) { EXPECT_EQ(0u, crc32_compute(NULL, 0)); }
+
+TEST(Crc32Test, test_check_value) {
+  // The standard check value of CRC-32/ISO-HDLC
+  EXPECT_EQ(0xcbf43926u, crc32_compute("123456789", 9));
+}
+
+TEST(Crc32Test, test_detects_single_bit_flip) {
+  uint8_t data[64] = {};
+  uint32_t crc = crc32_compute(data, sizeof(data));
+  for (size_t i = 0; i < sizeof(data) * 8; i++) {
+    data[i / 8] ^= 1 << (i % 8);
+    EXPECT_NE(crc, crc32_compute(data, sizeof(data))) << "bit " << i;
+    data[i / 8] ^= 1 << (i % 8);
+  }
+}
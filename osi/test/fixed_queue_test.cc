@@ -348,3 +348,149 @@ TEST_F(FixedQueueTest, test_fixed_queue_register_dequeue) {
   thread_free(worker_thread);
   fixed_queue_free(queue, NULL);
 }
+
+TEST_F(FixedQueueTest, test_fixed_queue_dequeue_all) {
+  fixed_queue_t* queue = fixed_queue_new(TEST_QUEUE_SIZE);
+  ASSERT_TRUE(queue != NULL);
+  void* items[TEST_QUEUE_SIZE];
+
+  // Test dequeueing from a NULL and an empty queue
+  EXPECT_EQ((size_t)0, fixed_queue_dequeue_all(NULL, items, TEST_QUEUE_SIZE));
+  EXPECT_EQ((size_t)0, fixed_queue_dequeue_all(queue, items, TEST_QUEUE_SIZE));
+
+  // Test that elements come out in order and |max_items| is honoured
+  fixed_queue_enqueue(queue, (void*)DUMMY_DATA_STRING1);
+  fixed_queue_enqueue(queue, (void*)DUMMY_DATA_STRING2);
+  fixed_queue_enqueue(queue, (void*)DUMMY_DATA_STRING3);
+  EXPECT_EQ((size_t)2, fixed_queue_dequeue_all(queue, items, 2));
+  EXPECT_EQ(DUMMY_DATA_STRING1, items[0]);
+  EXPECT_EQ(DUMMY_DATA_STRING2, items[1]);
+  EXPECT_EQ((size_t)1, fixed_queue_dequeue_all(queue, items, TEST_QUEUE_SIZE));
+  EXPECT_EQ(DUMMY_DATA_STRING3, items[0]);
+  EXPECT_TRUE(fixed_queue_is_empty(queue));
+
+  // Test that the queue accepts elements up to its capacity again
+  for (size_t i = 0; i < TEST_QUEUE_SIZE; i++) {
+    EXPECT_TRUE(fixed_queue_try_enqueue(queue, (void*)DUMMY_DATA_STRING));
+  }
+
+  fixed_queue_free(queue, NULL);
+}
+
+TEST_F(FixedQueueTest, test_fixed_queue_ring_enqueue_dequeue) {
+  fixed_queue_t* queue = fixed_queue_new_ring(TEST_QUEUE_SIZE);
+  ASSERT_TRUE(queue != NULL);
+
+  // Capacity is rounded up to the next power of two
+  size_t capacity = fixed_queue_capacity(queue);
+  EXPECT_EQ((size_t)16, capacity);
+
+  // Test blocking enqueue and blocking dequeue
+  fixed_queue_enqueue(queue, (void*)DUMMY_DATA_STRING);
+  EXPECT_EQ((size_t)1, fixed_queue_length(queue));
+  EXPECT_EQ(DUMMY_DATA_STRING, fixed_queue_dequeue(queue));
+  EXPECT_TRUE(fixed_queue_is_empty(queue));
+
+  // Test peek first/last
+  EXPECT_EQ(NULL, fixed_queue_try_peek_first(queue));
+  EXPECT_EQ(NULL, fixed_queue_try_peek_last(queue));
+  fixed_queue_enqueue(queue, (void*)DUMMY_DATA_STRING1);
+  fixed_queue_enqueue(queue, (void*)DUMMY_DATA_STRING2);
+  EXPECT_EQ(DUMMY_DATA_STRING1, fixed_queue_try_peek_first(queue));
+  EXPECT_EQ(DUMMY_DATA_STRING2, fixed_queue_try_peek_last(queue));
+  fixed_queue_flush(queue, NULL);
+  EXPECT_TRUE(fixed_queue_is_empty(queue));
+
+  // Test non-blocking enqueue beyond queue capacity, wrapping the ring
+  for (int lap = 0; lap < 3; lap++) {
+    for (size_t i = 0; i < capacity; i++) {
+      EXPECT_TRUE(fixed_queue_try_enqueue(queue, (void*)DUMMY_DATA_STRING));
+    }
+    EXPECT_FALSE(fixed_queue_try_enqueue(queue, (void*)DUMMY_DATA_STRING));
+    EXPECT_EQ(capacity, fixed_queue_length(queue));
+    for (size_t i = 0; i < capacity; i++) {
+      EXPECT_EQ(DUMMY_DATA_STRING, fixed_queue_try_dequeue(queue));
+    }
+    EXPECT_EQ(NULL, fixed_queue_try_dequeue(queue));
+  }
+
+  // Test freeing a non-empty ring
+  test_queue_entry_free_counter = 0;
+  fixed_queue_enqueue(queue, (void*)DUMMY_DATA_STRING1);
+  fixed_queue_enqueue(queue, (void*)DUMMY_DATA_STRING2);
+  fixed_queue_free(queue, test_queue_entry_free_cb);
+  EXPECT_EQ(2, test_queue_entry_free_counter);
+}
+
+static void ring_producer(void* context) {
+  fixed_queue_t* queue = static_cast<fixed_queue_t*>(context);
+  for (uintptr_t i = 1; i <= 10000; i++) fixed_queue_enqueue(queue, (void*)i);
+}
+
+TEST_F(FixedQueueTest, test_fixed_queue_ring_blocking_producers) {
+  // A small ring forces both the producers and the consumer to park.
+  fixed_queue_t* queue = fixed_queue_new_ring(4);
+  ASSERT_TRUE(queue != NULL);
+
+  thread_t* producer1 = thread_new("test_fixed_queue_producer1");
+  thread_t* producer2 = thread_new("test_fixed_queue_producer2");
+  thread_post(producer1, ring_producer, queue);
+  thread_post(producer2, ring_producer, queue);
+
+  uintptr_t last1 = 0, last2 = 0, sum = 0;
+  for (int i = 0; i < 20000; i++) {
+    uintptr_t value = (uintptr_t)fixed_queue_dequeue(queue);
+    sum += value;
+    // Each producer's elements must arrive in order.
+    if (value == last1 + 1)
+      last1 = value;
+    else if (value == last2 + 1)
+      last2 = value;
+    else
+      ADD_FAILURE() << "out of order element " << value;
+  }
+  EXPECT_EQ((uintptr_t)10000 * 10001, sum);
+  EXPECT_TRUE(fixed_queue_is_empty(queue));
+
+  thread_free(producer1);
+  thread_free(producer2);
+  fixed_queue_free(queue, NULL);
+}
+
+static int ring_ready_count = 0;
+static void fixed_queue_ring_ready(fixed_queue_t* queue,
+                                   UNUSED_ATTR void* context) {
+  void* msg = fixed_queue_try_dequeue(queue);
+  EXPECT_TRUE(msg != NULL);
+  if (++ring_ready_count == 1000) future_ready(received_message_future, msg);
+}
+
+TEST_F(FixedQueueTest, test_fixed_queue_ring_register_dequeue) {
+  fixed_queue_t* queue = fixed_queue_new_ring(64);
+  ASSERT_TRUE(queue != NULL);
+
+  received_message_future = future_new();
+  ASSERT_TRUE(received_message_future != NULL);
+  ring_ready_count = 0;
+
+  // Elements enqueued before registration must still be delivered
+  fixed_queue_enqueue(queue, (void*)DUMMY_DATA_STRING1);
+
+  thread_t* worker_thread = thread_new("test_fixed_queue_worker_thread");
+  ASSERT_TRUE(worker_thread != NULL);
+
+  fixed_queue_register_dequeue(queue, thread_get_reactor(worker_thread),
+                               fixed_queue_ring_ready, NULL);
+
+  for (int i = 1; i < 999; i++) {
+    fixed_queue_enqueue(queue, (void*)DUMMY_DATA_STRING);
+  }
+  fixed_queue_enqueue(queue, (void*)DUMMY_DATA_STRING2);
+  const char* msg = (const char*)future_await(received_message_future);
+  EXPECT_EQ(DUMMY_DATA_STRING2, msg);
+  EXPECT_EQ(1000, ring_ready_count);
+
+  fixed_queue_unregister_dequeue(queue);
+  thread_free(worker_thread);
+  fixed_queue_free(queue, NULL);
+}
@@ -0,0 +1,125 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2014 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <string.h>
+
+#include <vector>
+
+#include "AllocationTestHarness.h"
+
+#include "osi/include/allocator.h"
+#include "osi/include/pool_allocator.h"
+#include "osi/include/thread.h"
+
+class PoolAllocatorTest : public AllocationTestHarness {
+ protected:
+  void SetUp() override {
+    AllocationTestHarness::SetUp();
+    for (size_t i = 0; i < POOL_ALLOCATOR_NUM_CLASSES; i++)
+      pool_allocator_get_stats(i, &start_stats_[i]);
+  }
+
+  void TearDown() override {
+    // Every pool block handed out during the test must have come back.
+    for (size_t i = 0; i < POOL_ALLOCATOR_NUM_CLASSES; i++) {
+      pool_allocator_stats_t stats;
+      pool_allocator_get_stats(i, &stats);
+      EXPECT_EQ(start_stats_[i].in_use, stats.in_use) << "class " << i;
+    }
+    AllocationTestHarness::TearDown();
+  }
+
+  pool_allocator_stats_t start_stats_[POOL_ALLOCATOR_NUM_CLASSES];
+};
+
+TEST_F(PoolAllocatorTest, test_size_classes) {
+  for (size_t i = 0; i < POOL_ALLOCATOR_NUM_CLASSES; i++) {
+    pool_allocator_stats_t stats;
+    pool_allocator_get_stats(i, &stats);
+
+    // The largest request a class serves still comes from that class
+    void* ptr = pool_allocator_alloc(stats.block_size);
+    EXPECT_TRUE(pool_allocator_owns(ptr));
+    memset(ptr, 0x5a, stats.block_size);
+
+    pool_allocator_stats_t after;
+    pool_allocator_get_stats(i, &after);
+    EXPECT_EQ(stats.hits + 1, after.hits);
+    EXPECT_EQ(stats.in_use + 1, after.in_use);
+    EXPECT_LE(after.in_use, after.high_water);
+
+    osi_free(ptr);
+  }
+
+  // Requests larger than every class come from the heap
+  pool_allocator_stats_t largest;
+  pool_allocator_get_stats(POOL_ALLOCATOR_NUM_CLASSES - 1, &largest);
+  void* ptr = pool_allocator_alloc(largest.block_size + 1);
+  EXPECT_FALSE(pool_allocator_owns(ptr));
+  osi_free(ptr);
+}
+
+TEST_F(PoolAllocatorTest, test_heap_pointers_are_not_owned) {
+  void* ptr = osi_malloc(16);
+  EXPECT_FALSE(pool_allocator_owns(ptr));
+  EXPECT_FALSE(pool_allocator_owns(NULL));
+  osi_free(ptr);
+}
+
+TEST_F(PoolAllocatorTest, test_exhausted_class_falls_back) {
+  pool_allocator_stats_t stats;
+  pool_allocator_get_stats(0, &stats);
+
+  // Take more blocks than the class holds; the excess comes from the heap
+  std::vector<void*> blocks;
+  size_t pooled = 0;
+  for (size_t i = 0; i < stats.block_count + 4; i++) {
+    void* ptr = pool_allocator_alloc(stats.block_size);
+    if (pool_allocator_owns(ptr)) pooled++;
+    blocks.push_back(ptr);
+  }
+  EXPECT_LE(pooled, stats.block_count);
+
+  pool_allocator_stats_t after;
+  pool_allocator_get_stats(0, &after);
+  EXPECT_EQ(stats.misses + (blocks.size() - pooled), after.misses);
+  EXPECT_EQ(after.block_count, after.high_water);
+
+  // Heap and pool blocks are released the same way
+  for (void* ptr : blocks) osi_free(ptr);
+}
+
+static void alloc_on_thread(void* context) {
+  std::vector<void*>* blocks = static_cast<std::vector<void*>*>(context);
+  for (int i = 0; i < 32; i++) blocks->push_back(pool_allocator_alloc(100));
+}
+
+TEST_F(PoolAllocatorTest, test_free_on_other_thread) {
+  std::vector<void*> blocks;
+
+  // Blocks allocated on a thread that has since exited can be freed here
+  thread_t* thread = thread_new("pool_allocator_test");
+  ASSERT_TRUE(thread != NULL);
+  thread_post(thread, alloc_on_thread, &blocks);
+  thread_free(thread);
+
+  EXPECT_EQ(32U, blocks.size());
+  for (void* ptr : blocks) osi_free(ptr);
+}
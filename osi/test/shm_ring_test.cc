@@ -0,0 +1,230 @@
+#include <gtest/gtest.h>
+
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <thread>
+#include <vector>
+
+#include "AllocationTestHarness.h"
+
+#include "osi/include/osi.h"
+#include "osi/include/shm_ring.h"
+
+class ShmRingTest : public AllocationTestHarness {
+ protected:
+  virtual void SetUp() {
+    AllocationTestHarness::SetUp();
+    consumer_ = shm_ring_create(1000);
+    ASSERT_TRUE(consumer_ != NULL);
+    EXPECT_FALSE(shm_ring_is_attached(consumer_));
+
+    // The producer normally lives in another process and gets its own copies
+    // of the descriptors.
+    int fds[SHM_RING_NUM_FDS];
+    shm_ring_get_fds(consumer_, fds);
+    for (int i = 0; i < SHM_RING_NUM_FDS; i++) fds[i] = dup(fds[i]);
+    producer_ = shm_ring_attach(fds);
+    ASSERT_TRUE(producer_ != NULL);
+    EXPECT_TRUE(shm_ring_is_attached(consumer_));
+  }
+
+  virtual void TearDown() {
+    shm_ring_free(producer_);
+    shm_ring_free(consumer_);
+    AllocationTestHarness::TearDown();
+  }
+
+  shm_ring_t* consumer_ = NULL;
+  shm_ring_t* producer_ = NULL;
+};
+
+static std::vector<uint8_t> pattern(size_t length, uint8_t seed) {
+  std::vector<uint8_t> data(length);
+  for (size_t i = 0; i < length; i++) data[i] = (uint8_t)(seed + i * 7);
+  return data;
+}
+
+TEST_F(ShmRingTest, test_capacity_rounded_up) {
+  EXPECT_EQ(1024u, shm_ring_writable(producer_));
+  EXPECT_EQ(1024u, shm_ring_writable(consumer_));
+  EXPECT_EQ(0u, shm_ring_readable(consumer_));
+  EXPECT_FALSE(shm_ring_is_closed(producer_));
+}
+
+TEST_F(ShmRingTest, test_write_read) {
+  std::vector<uint8_t> in = pattern(300, 1);
+  EXPECT_EQ(300u, shm_ring_write(producer_, in.data(), in.size()));
+  EXPECT_EQ(300u, shm_ring_readable(consumer_));
+  EXPECT_EQ(724u, shm_ring_writable(producer_));
+
+  std::vector<uint8_t> out(300);
+  EXPECT_EQ(100u, shm_ring_read(consumer_, out.data(), 100));
+  EXPECT_EQ(200u, shm_ring_read(consumer_, out.data() + 100, 500));
+  EXPECT_EQ(in, out);
+  EXPECT_EQ(0u, shm_ring_read(consumer_, out.data(), out.size()));
+}
+
+TEST_F(ShmRingTest, test_write_full) {
+  std::vector<uint8_t> in = pattern(1500, 2);
+  EXPECT_EQ(1024u, shm_ring_write(producer_, in.data(), in.size()));
+  EXPECT_EQ(0u, shm_ring_write(producer_, in.data(), in.size()));
+  EXPECT_EQ(0u, shm_ring_writable(producer_));
+}
+
+TEST_F(ShmRingTest, test_wraps_around) {
+  std::vector<uint8_t> out(700);
+  for (int i = 0; i < 10; i++) {
+    std::vector<uint8_t> in = pattern(700, i);
+    ASSERT_EQ(700u, shm_ring_write(producer_, in.data(), in.size()));
+    ASSERT_EQ(700u, shm_ring_read(consumer_, out.data(), out.size()));
+    EXPECT_EQ(in, out);
+  }
+}
+
+TEST_F(ShmRingTest, test_flush) {
+  std::vector<uint8_t> in = pattern(500, 3);
+  shm_ring_write(producer_, in.data(), in.size());
+  shm_ring_flush(consumer_);
+  EXPECT_EQ(0u, shm_ring_readable(consumer_));
+  EXPECT_EQ(1024u, shm_ring_writable(producer_));
+}
+
+TEST_F(ShmRingTest, test_wait_readable_timeout) {
+  EXPECT_EQ(0, shm_ring_wait_readable(consumer_, 1, 10, INVALID_FD));
+
+  uint8_t byte = 0;
+  shm_ring_write(producer_, &byte, 1);
+  EXPECT_EQ(1, shm_ring_wait_readable(consumer_, 1, 10, INVALID_FD));
+  EXPECT_EQ(0, shm_ring_wait_readable(consumer_, 2, 10, INVALID_FD));
+}
+
+TEST_F(ShmRingTest, test_wait_readable_woken_by_write) {
+  std::thread writer([this]() {
+    std::vector<uint8_t> in = pattern(64, 4);
+    for (size_t i = 0; i < in.size(); i += 16) {
+      usleep(1000);
+      shm_ring_write(producer_, in.data() + i, 16);
+    }
+  });
+  EXPECT_EQ(1, shm_ring_wait_readable(consumer_, 64, 5000, INVALID_FD));
+  EXPECT_EQ(64u, shm_ring_readable(consumer_));
+  writer.join();
+}
+
+TEST_F(ShmRingTest, test_wait_length_clamped_to_capacity) {
+  std::vector<uint8_t> in = pattern(1024, 5);
+  shm_ring_write(producer_, in.data(), in.size());
+  EXPECT_EQ(1, shm_ring_wait_readable(consumer_, 4096, 10, INVALID_FD));
+}
+
+TEST_F(ShmRingTest, test_close_wakes_producer) {
+  std::vector<uint8_t> in = pattern(1024, 6);
+  shm_ring_write(producer_, in.data(), in.size());
+
+  std::thread closer([this]() {
+    usleep(10000);
+    shm_ring_close(consumer_);
+  });
+  EXPECT_EQ(-1, shm_ring_wait_writable(producer_, 1, 5000, INVALID_FD));
+  closer.join();
+
+  EXPECT_TRUE(shm_ring_is_closed(producer_));
+  EXPECT_EQ(0u, shm_ring_write(producer_, in.data(), 1));
+  // Data written before the close can still be drained.
+  EXPECT_EQ(1024u, shm_ring_readable(consumer_));
+}
+
+TEST_F(ShmRingTest, test_hangup_ends_wait) {
+  int sv[2];
+  ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sv));
+
+  std::thread hangup([&sv]() {
+    usleep(10000);
+    shutdown(sv[1], SHUT_RDWR);
+    close(sv[1]);
+  });
+  EXPECT_EQ(-1, shm_ring_wait_readable(consumer_, 1, 5000, sv[0]));
+  hangup.join();
+  close(sv[0]);
+}
+
+TEST_F(ShmRingTest, test_stream_between_threads) {
+  const size_t total = 1 << 20;
+  std::thread writer([this, total]() {
+    uint8_t chunk[384];
+    size_t sent = 0;
+    while (sent < total) {
+      size_t length = sizeof(chunk);
+      if (length > total - sent) length = total - sent;
+      for (size_t i = 0; i < length; i++) chunk[i] = (uint8_t)(sent + i);
+      size_t offset = 0;
+      while (offset < length) {
+        if (shm_ring_wait_writable(producer_, length - offset, 5000,
+                                   INVALID_FD) != 1)
+          return;
+        offset += shm_ring_write(producer_, chunk + offset, length - offset);
+      }
+      sent += length;
+    }
+  });
+
+  uint8_t chunk[512];
+  size_t received = 0;
+  bool intact = true;
+  while (received < total) {
+    ASSERT_EQ(1, shm_ring_wait_readable(consumer_, 1, 5000, INVALID_FD));
+    size_t length = shm_ring_read(consumer_, chunk, sizeof(chunk));
+    for (size_t i = 0; i < length; i++)
+      intact &= chunk[i] == (uint8_t)(received + i);
+    received += length;
+  }
+  writer.join();
+  EXPECT_TRUE(intact);
+  EXPECT_EQ(total, received);
+}
+
+TEST_F(ShmRingTest, test_stream_between_processes) {
+  int fds[SHM_RING_NUM_FDS];
+  shm_ring_get_fds(consumer_, fds);
+
+  pid_t pid = fork();
+  ASSERT_NE(-1, pid);
+  if (pid == 0) {
+    for (int i = 0; i < SHM_RING_NUM_FDS; i++) fds[i] = dup(fds[i]);
+    shm_ring_t* producer = shm_ring_attach(fds);
+    if (producer == NULL) _exit(1);
+    std::vector<uint8_t> in = pattern(4096, 7);
+    size_t offset = 0;
+    while (offset < in.size()) {
+      if (shm_ring_wait_writable(producer, 1, 5000, INVALID_FD) != 1) _exit(2);
+      offset += shm_ring_write(producer, in.data() + offset, in.size() - offset);
+    }
+    _exit(0);
+  }
+
+  std::vector<uint8_t> out(4096);
+  size_t received = 0;
+  while (received < out.size()) {
+    ASSERT_EQ(1, shm_ring_wait_readable(consumer_, 1, 5000, INVALID_FD));
+    received += shm_ring_read(consumer_, out.data() + received,
+                              out.size() - received);
+  }
+  EXPECT_EQ(pattern(4096, 7), out);
+
+  int status;
+  ASSERT_EQ(pid, waitpid(pid, &status, 0));
+  EXPECT_TRUE(WIFEXITED(status));
+  EXPECT_EQ(0, WEXITSTATUS(status));
+}
+
+TEST_F(ShmRingTest, test_attach_rejects_other_fds) {
+  int fds[SHM_RING_NUM_FDS];
+  fds[0] = eventfd(0, 0);
+  fds[1] = eventfd(0, 0);
+  fds[2] = eventfd(0, 0);
+  EXPECT_TRUE(shm_ring_attach(fds) == NULL);
+  for (int i = 0; i < SHM_RING_NUM_FDS; i++) close(fds[i]);
+}
@@ -33,8 +33,14 @@
 #include "hcimsgs.h"
 
 #include "btm_ble_int.h"
+#include "btm_ble_rpa_cache.h"
+#include "osi/include/time.h"
 #include "stack/crypto_toolbox/crypto_toolbox.h"
 
+/* Recently resolved private addresses, a device keeps advertising with the
+ * same one for minutes */
+static RpaResolutionCache rpa_cache;
+
 /* This function generates Resolvable Private Address (RPA) from Identity
  * Resolving Key |irk| and |random|*/
 RawAddress generate_rpa_from_irk_and_rand(const Octet16& irk,
@@ -175,15 +181,23 @@ bool btm_ble_init_pseudo_addr(tBTM_SEC_DEV_REC* p_dev_rec,
                               const RawAddress& new_pseudo_addr) {
   if (p_dev_rec->ble.pseudo_addr.IsEmpty()) {
     p_dev_rec->ble.pseudo_addr = new_pseudo_addr;
+    btm_sec_index_dev_rec(p_dev_rec);
     return true;
   }
 
   return false;
 }
 
-/* Return true if given Resolvable Privae Address |rpa| matches Identity
- * Resolving Key |irk| */
-static bool rpa_matches_irk(const RawAddress& rpa, const Octet16& irk) {
+/* Return true if given Resolvable Privae Address |rpa| matches the Identity
+ * Resolving Key of |p_ble| */
+static bool rpa_matches_irk(const RawAddress& rpa, tBTM_SEC_BLE* p_ble) {
+  /* expand the IRK once, not for every address resolved with it */
+  if (!p_ble->irk_ksch_valid || p_ble->irk_ksch_key != p_ble->keys.irk) {
+    crypto_toolbox::aes_128_set_key(p_ble->keys.irk, &p_ble->irk_ksch);
+    p_ble->irk_ksch_key = p_ble->keys.irk;
+    p_ble->irk_ksch_valid = true;
+  }
+
   /* use the 3 MSB of bd address as prand */
   uint8_t rand[3];
   rand[0] = rpa.address[2];
@@ -191,7 +205,7 @@ static bool rpa_matches_irk(const RawAddress& rpa, const Octet16& irk) {
   rand[2] = rpa.address[0];
 
   /* generate X = E irk(R0, R1, R2) and R is random address 3 LSO */
-  Octet16 x = crypto_toolbox::aes_128(irk, &rand[0], 3);
+  Octet16 x = crypto_toolbox::aes_128(p_ble->irk_ksch, &rand[0], 3);
 
   rand[0] = rpa.address[5];
   rand[1] = rpa.address[4];
@@ -216,7 +230,7 @@ bool btm_ble_addr_resolvable(const RawAddress& rpa,
       (p_dev_rec->ble.key_type & BTM_LE_KEY_PID)) {
     BTM_TRACE_DEBUG("%s try to resolve", __func__);
 
-    if (rpa_matches_irk(rpa, p_dev_rec->ble.keys.irk)) {
+    if (rpa_matches_irk(rpa, &p_dev_rec->ble)) {
       btm_ble_init_pseudo_addr(p_dev_rec, rpa);
       return true;
     }
@@ -240,7 +254,7 @@ static bool btm_ble_match_random_bda(void* data, void* context) {
       !(p_dev_rec->ble.key_type & BTM_LE_KEY_PID))
     return true;
 
-  if (rpa_matches_irk(*random_bda, p_dev_rec->ble.keys.irk)) {
+  if (rpa_matches_irk(*random_bda, &p_dev_rec->ble)) {
     BTM_TRACE_EVENT("match is found");
     // if it was match, finish iteration, otherwise continue
     return false;
@@ -257,19 +271,33 @@ static bool btm_ble_match_random_bda(void* data, void* context) {
 tBTM_SEC_DEV_REC* btm_ble_resolve_random_addr(const RawAddress& random_bda) {
   BTM_TRACE_EVENT("%s", __func__);
 
+  uint64_t now_ms = time_get_os_boottime_ms();
+  tBTM_SEC_DEV_REC* p_dev_rec = nullptr;
+  if (rpa_cache.Get(random_bda, now_ms, &p_dev_rec) &&
+      (p_dev_rec == nullptr || (p_dev_rec->ble.key_type & BTM_LE_KEY_PID))) {
+    BTM_TRACE_EVENT("%s:  %sresolved from cache", __func__,
+                    (p_dev_rec == nullptr ? "not " : ""));
+    return p_dev_rec;
+  }
+
   /* start to resolve random address */
   /* check for next security record */
 
   list_node_t* n = list_foreach(btm_cb.sec_dev_rec, btm_ble_match_random_bda,
                                 (void*)&random_bda);
-  tBTM_SEC_DEV_REC* p_dev_rec = nullptr;
+  p_dev_rec = nullptr;
   if (n != nullptr) p_dev_rec = static_cast<tBTM_SEC_DEV_REC*>(list_node(n));
+  rpa_cache.Put(random_bda, now_ms, p_dev_rec);
 
   BTM_TRACE_EVENT("%s:  %sresolved", __func__,
                   (p_dev_rec == nullptr ? "not " : ""));
   return p_dev_rec;
 }
 
+/** Forget the random addresses resolved so far, to be called when a security
+ * record is freed or its IRK changes. */
+void btm_ble_clear_rpa_cache(void) { rpa_cache.Clear(); }
+
 /*******************************************************************************
  *  address mapping between pseudo address and real connection address
  ******************************************************************************/
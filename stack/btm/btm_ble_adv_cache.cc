@@ -0,0 +1,176 @@
+/******************************************************************************
+ *
+ *  Copyright 2018 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "btm_ble_adv_cache.h"
+
+#include <algorithm>
+
+/* Legacy advertising data and scan response, 31 bytes each */
+#define ADV_CACHE_PREALLOCATED_DATA_LEN (2 * 31)
+
+AdvertisingCache::AdvertisingCache(size_t capacity) {
+  evictions_ = 0;
+  incomplete_ = 0;
+  SetCapacity(capacity);
+}
+
+void AdvertisingCache::SetCapacity(size_t capacity) {
+  capacity = std::min(std::max(capacity, (size_t)1), kMaxCapacity);
+
+  size_t num_slots = 1;
+  while (num_slots < 2 * capacity) num_slots <<= 1;
+
+  items_.resize(capacity);
+  slots_.assign(num_slots, kNone);
+  for (size_t i = 0; i < capacity; i++) {
+    items_[i].data.clear();
+    items_[i].data.reserve(ADV_CACHE_PREALLOCATED_DATA_LEN);
+    items_[i].prev = kNone;
+    items_[i].next = (i + 1 < capacity) ? i + 1 : kNone;
+  }
+  head_ = tail_ = kNone;
+  free_ = 0;
+  size_ = 0;
+}
+
+const std::vector<uint8_t>& AdvertisingCache::Set(uint8_t addr_type,
+                                                  const RawAddress& addr,
+                                                  const uint8_t* data,
+                                                  size_t len) {
+  Item* item = Get(addr_type, addr);
+  if (!item->data.empty()) incomplete_++;
+  item->data.assign(data, data + len);
+  return item->data;
+}
+
+const std::vector<uint8_t>& AdvertisingCache::Append(uint8_t addr_type,
+                                                     const RawAddress& addr,
+                                                     const uint8_t* data,
+                                                     size_t len) {
+  Item* item = Get(addr_type, addr);
+  item->data.insert(item->data.end(), data, data + len);
+  return item->data;
+}
+
+void AdvertisingCache::Clear(uint8_t addr_type, const RawAddress& addr) {
+  size_t slot = FindSlot(addr_type, addr);
+  if (slots_[slot] != kNone) Remove(slot);
+}
+
+size_t AdvertisingCache::Hash(uint8_t addr_type, const RawAddress& addr) {
+  const uint8_t* a = addr.address;
+  uint32_t h = addr_type;
+  for (int i = 0; i < 6; i++) h = h * 31 + a[i];
+  return h ^ (h >> 16);
+}
+
+size_t AdvertisingCache::FindSlot(uint8_t addr_type,
+                                  const RawAddress& addr) const {
+  size_t mask = slots_.size() - 1;
+  size_t slot = Hash(addr_type, addr) & mask;
+  while (slots_[slot] != kNone) {
+    const Item& item = items_[slots_[slot]];
+    if (item.addr_type == addr_type && item.addr == addr) break;
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+/* Returns the item of |addr_type, addr|, adding it with empty data if it is
+ * not cached. Either way it becomes the most recently updated one. */
+AdvertisingCache::Item* AdvertisingCache::Get(uint8_t addr_type,
+                                              const RawAddress& addr) {
+  size_t slot = FindSlot(addr_type, addr);
+  if (slots_[slot] != kNone) {
+    uint16_t index = slots_[slot];
+    if (index != head_) {
+      Unlink(index);
+      LinkFront(index);
+    }
+    return &items_[index];
+  }
+
+  if (free_ == kNone) {
+    /* The data of the evicted device was incomplete: once data is complete,
+     * btm_ble_process_adv_pkt_cont() clears it whether it reports it or
+     * drops it */
+    const Item& oldest = items_[tail_];
+    Remove(FindSlot(oldest.addr_type, oldest.addr));
+    evictions_++;
+    slot = FindSlot(addr_type, addr);
+  }
+
+  uint16_t index = free_;
+  free_ = items_[index].next;
+
+  Item& item = items_[index];
+  item.addr_type = addr_type;
+  item.addr = addr;
+  item.data.clear();
+  slots_[slot] = index;
+  LinkFront(index);
+  size_++;
+  return &item;
+}
+
+void AdvertisingCache::Remove(size_t slot) {
+  uint16_t index = slots_[slot];
+  Unlink(index);
+  items_[index].data.clear();
+  items_[index].next = free_;
+  free_ = index;
+  size_--;
+
+  /* Shift back the items that probed past the emptied slot, so that no
+   * probe sequence is broken by it */
+  size_t mask = slots_.size() - 1;
+  size_t hole = slot;
+  size_t next = (slot + 1) & mask;
+  while (slots_[next] != kNone) {
+    const Item& item = items_[slots_[next]];
+    size_t home = Hash(item.addr_type, item.addr) & mask;
+    if (((next - home) & mask) >= ((next - hole) & mask)) {
+      slots_[hole] = slots_[next];
+      hole = next;
+    }
+    next = (next + 1) & mask;
+  }
+  slots_[hole] = kNone;
+}
+
+void AdvertisingCache::Unlink(uint16_t index) {
+  Item& item = items_[index];
+  if (item.prev != kNone)
+    items_[item.prev].next = item.next;
+  else
+    head_ = item.next;
+  if (item.next != kNone)
+    items_[item.next].prev = item.prev;
+  else
+    tail_ = item.prev;
+  item.prev = item.next = kNone;
+}
+
+void AdvertisingCache::LinkFront(uint16_t index) {
+  Item& item = items_[index];
+  item.prev = kNone;
+  item.next = head_;
+  if (head_ != kNone) items_[head_].prev = index;
+  head_ = index;
+  if (tail_ == kNone) tail_ = index;
+}
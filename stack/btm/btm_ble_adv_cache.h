@@ -0,0 +1,109 @@
+/******************************************************************************
+ *
+ *  Copyright 2018 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#ifndef BTM_BLE_ADV_CACHE_H
+#define BTM_BLE_ADV_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "raw_address.h"
+
+/* Reassembles the advertising data of devices that are waiting for either a
+ * scan response or chained packets on the secondary channel.
+ *
+ * Devices are found through an open addressing hash table. When the cache is
+ * full the least recently updated device is evicted, losing its partial data.
+ * Each entry keeps its data buffer for the life of the cache: room for legacy
+ * advertising data and scan response is reserved up front, and a buffer that
+ * grew for extended advertising data keeps its size, so reports are
+ * reassembled without allocating. */
+class AdvertisingCache {
+ public:
+  static constexpr size_t kDefaultCapacity = 32;
+  static constexpr size_t kMaxCapacity = 1024;
+
+  explicit AdvertisingCache(size_t capacity = kDefaultCapacity);
+
+  /* Resize the cache to |capacity| devices, clamped to [1, kMaxCapacity].
+   * All cached data is dropped. */
+  void SetCapacity(size_t capacity);
+
+  /* Set the data to |data| for device |addr_type, addr| */
+  const std::vector<uint8_t>& Set(uint8_t addr_type, const RawAddress& addr,
+                                  const uint8_t* data, size_t len);
+
+  /* Append |data| for device |addr_type, addr| */
+  const std::vector<uint8_t>& Append(uint8_t addr_type, const RawAddress& addr,
+                                     const uint8_t* data, size_t len);
+
+  /* Clear data for device |addr_type, addr| */
+  void Clear(uint8_t addr_type, const RawAddress& addr);
+
+  size_t Size() const { return size_; }
+  size_t Capacity() const { return items_.size(); }
+
+  /* Devices evicted to make room before their data was complete */
+  size_t GetEvictions() const { return evictions_; }
+
+  /* Devices whose incomplete data was replaced by a new advertisement, as
+   * when the scan response to the previous one never arrived */
+  size_t GetIncomplete() const { return incomplete_; }
+
+  void ResetCounters() {
+    evictions_ = 0;
+    incomplete_ = 0;
+  }
+
+ private:
+  static constexpr uint16_t kNone = 0xffff;
+
+  struct Item {
+    uint8_t addr_type;
+    RawAddress addr;
+    std::vector<uint8_t> data;
+    /* Links of the least recently updated list, or of the free list */
+    uint16_t prev;
+    uint16_t next;
+  };
+
+  static size_t Hash(uint8_t addr_type, const RawAddress& addr);
+
+  /* Returns the slot holding |addr_type, addr| or the empty slot it would go
+   * to */
+  size_t FindSlot(uint8_t addr_type, const RawAddress& addr) const;
+  Item* Get(uint8_t addr_type, const RawAddress& addr);
+  void Remove(size_t slot);
+  void Unlink(uint16_t index);
+  void LinkFront(uint16_t index);
+
+  std::vector<Item> items_;
+  /* Item index for each slot, kNone if empty. Twice the capacity, rounded up
+   * to a power of two, keeps probe sequences short. */
+  std::vector<uint16_t> slots_;
+  uint16_t head_;
+  uint16_t tail_;
+  uint16_t free_;
+  size_t size_;
+
+  size_t evictions_;
+  size_t incomplete_;
+};
+
+#endif  // BTM_BLE_ADV_CACHE_H
@@ -23,14 +23,17 @@
 #include "bt_types.h"
 #include "bt_utils.h"
 #include "btm_ble_api.h"
+#include "btm_ble_host_filter.h"
 #include "btm_int.h"
 #include "btu.h"
 #include "device/include/controller.h"
 #include "hcidefs.h"
 #include "hcimsgs.h"
+#include "osi/include/properties.h"
 
 #include <string.h>
 #include <algorithm>
+#include <memory>
 #include <vector>
 
 #include <base/bind.h>
@@ -55,8 +58,14 @@ using bluetooth::Uuid;
 
 #define BTM_BLE_PF_BIT_TO_MASK(x) (uint16_t)(1 << (x))
 
+/* Number of filters applied on the host when the controller has no APCF
+ * support, 0 to not filter */
+#define BTM_BLE_HOST_FILTERS_PROPERTY "persist.bluetooth.le_scan.host_filters"
+#define BTM_BLE_HOST_FILTERS_DEFAULT 32
+
 tBTM_BLE_ADV_FILTER_CB btm_ble_adv_filt_cb;
 tBTM_BLE_VSC_CB cmn_ble_vsc_cb;
+static std::unique_ptr<HostAdvFilter> host_filter;
 
 static uint8_t btm_ble_cs_update_pf_counter(tBTM_BLE_SCAN_COND_OP action,
                                             uint8_t cond_type,
@@ -645,9 +654,35 @@ void BTM_LE_PF_tds_data(tBTM_BLE_SCAN_COND_OP action,
   memset(&btm_ble_adv_filt_cb.cur_filter_target, 0, sizeof(tBLE_BD_ADDR));
 }
 
+/* If data is passed, both mask and data have to be the same length */
+static bool apcf_data_mask_valid(const ApcfCommand& cmd) {
+  if (cmd.data.size() != cmd.data_mask.size() && cmd.data.size() != 0 &&
+      cmd.data_mask.size() != 0) {
+    LOG(ERROR) << __func__ << " data(" << cmd.data.size() << ") and mask("
+               << cmd.data_mask.size() << ") are of different size";
+    return false;
+  }
+  return true;
+}
+
 void BTM_LE_PF_set(tBTM_BLE_PF_FILT_INDEX filt_index,
                    std::vector<ApcfCommand> commands,
                    tBTM_BLE_PF_CFG_CBACK cb) {
+  if (host_filter) {
+    /* Drop the commands the controller would not be sent either */
+    commands.erase(std::remove_if(commands.begin(), commands.end(),
+                                  [](const ApcfCommand& cmd) {
+                                    return !apcf_data_mask_valid(cmd);
+                                  }),
+                   commands.end());
+    if (!host_filter->AddConditions(filt_index, commands)) {
+      cb.Run(0, BTM_BLE_PF_ENABLE, 1 /* BTA_FAILURE */);
+      return;
+    }
+    cb.Run(0, 0, 0);
+    return;
+  }
+
   if (!is_filtering_supported()) {
     cb.Run(0, BTM_BLE_PF_ENABLE, 1 /* BTA_FAILURE */);
     return;
@@ -655,13 +690,7 @@ void BTM_LE_PF_set(tBTM_BLE_PF_FILT_INDEX filt_index,
 
   int action = BTM_BLE_SCAN_COND_ADD;
   for (const ApcfCommand& cmd : commands) {
-    /* If data is passed, both mask and data have to be the same length */
-    if (cmd.data.size() != cmd.data_mask.size() && cmd.data.size() != 0 &&
-        cmd.data_mask.size() != 0) {
-      LOG(ERROR) << __func__ << " data(" << cmd.data.size() << ") and mask("
-                 << cmd.data_mask.size() << ") are of different size";
-      continue;
-    }
+    if (!apcf_data_mask_valid(cmd)) continue;
 
     switch (cmd.type) {
       case BTM_BLE_PF_ADDR_FILTER: {
@@ -739,6 +768,12 @@ void BTM_LE_PF_set(tBTM_BLE_PF_FILT_INDEX filt_index,
  */
 void BTM_LE_PF_clear(tBTM_BLE_PF_FILT_INDEX filt_index,
                      tBTM_BLE_PF_CFG_CBACK cb) {
+  if (host_filter) {
+    host_filter->Clear(filt_index);
+    cb.Run(host_filter->NumAvailable(), BTM_BLE_SCAN_COND_CLEAR, HCI_SUCCESS);
+    return;
+  }
+
   if (!is_filtering_supported()) {
     cb.Run(0, BTM_BLE_PF_ENABLE, 1 /* BTA_FAILURE */);
     return;
@@ -820,6 +855,24 @@ void BTM_BleAdvFilterParamSetup(
                 BTM_BLE_ADV_FILT_FEAT_SELN_LEN + BTM_BLE_ADV_FILT_TRACK_NUM;
   uint8_t param[len], *p;
 
+  if (host_filter) {
+    if (BTM_BLE_SCAN_COND_ADD == action) {
+      if (!host_filter->Select(filt_index, p_filt_params->feat_seln,
+                               p_filt_params->list_logic_type,
+                               p_filt_params->filt_logic_type,
+                               (int8_t)p_filt_params->rssi_high_thres)) {
+        cb.Run(0, BTM_BLE_PF_ENABLE, 1 /* BTA_FAILURE */);
+        return;
+      }
+    } else if (BTM_BLE_SCAN_COND_DELETE == action) {
+      host_filter->Deselect(filt_index);
+    } else if (BTM_BLE_SCAN_COND_CLEAR == action) {
+      host_filter->DeselectAll();
+    }
+    cb.Run(host_filter->NumAvailable(), action, HCI_SUCCESS);
+    return;
+  }
+
   if (!is_filtering_supported()) {
     cb.Run(0, BTM_BLE_PF_ENABLE, 1 /* BTA_FAILURE */);
     return;
@@ -938,6 +991,12 @@ void enable_cmpl_cback(tBTM_BLE_PF_STATUS_CBACK p_stat_cback, uint8_t* p,
  ******************************************************************************/
 void BTM_BleEnableDisableFilterFeature(uint8_t enable,
                                        tBTM_BLE_PF_STATUS_CBACK p_stat_cback) {
+  if (host_filter) {
+    host_filter->SetEnabled(enable != 0);
+    if (p_stat_cback) p_stat_cback.Run(enable, HCI_SUCCESS);
+    return;
+  }
+
   if (!is_filtering_supported()) {
     if (p_stat_cback) p_stat_cback.Run(BTM_BLE_PF_ENABLE, 1 /* BTA_FAILURE */);
     return;
@@ -971,7 +1030,21 @@ void btm_ble_adv_filter_init(void) {
 
   BTM_BleGetVendorCapabilities(&cmn_ble_vsc_cb);
 
-  if (!is_filtering_supported()) return;
+  host_filter.reset();
+  if (!is_filtering_supported()) {
+    int32_t max_filters = osi_property_get_int32(BTM_BLE_HOST_FILTERS_PROPERTY,
+                                                 BTM_BLE_HOST_FILTERS_DEFAULT);
+    if (max_filters <= 0) return;
+
+    max_filters = std::min(max_filters, (int32_t)0xff);
+    host_filter.reset(new HostAdvFilter(max_filters));
+
+    /* Report the host filters as the controller ones, so that the scan
+     * filters of the applications are set up through this module */
+    btm_cb.cmn_ble_vsc_cb.filter_support = 1;
+    btm_cb.cmn_ble_vsc_cb.max_filter = max_filters;
+    return;
+  }
 
   if (cmn_ble_vsc_cb.max_filter > 0) {
     btm_ble_adv_filt_cb.p_addr_filter_count = (tBTM_BLE_PF_COUNT*)osi_malloc(
@@ -992,4 +1065,27 @@ void btm_ble_adv_filter_init(void) {
  ******************************************************************************/
 void btm_ble_adv_filter_cleanup(void) {
   osi_free_and_reset((void**)&btm_ble_adv_filt_cb.p_addr_filter_count);
+  host_filter.reset();
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_ble_adv_filter_match
+ *
+ * Description      This function checks an advertising report against the
+ *                  filters applied on the host, when the controller has no
+ *                  APCF support
+ *
+ * Parameters       bda - Advertiser address
+ *                  rssi - RSSI of the report
+ *                  adv_data - Complete advertising data
+ *
+ * Returns          true if the report is to be delivered
+ *
+ ******************************************************************************/
+bool btm_ble_adv_filter_match(const RawAddress& bda, int8_t rssi,
+                              const std::vector<uint8_t>& adv_data) {
+  if (!host_filter) return true;
+
+  return host_filter->Matches(bda, rssi, adv_data.data(), adv_data.size());
 }
@@ -54,15 +54,7 @@ struct BackgroundConnection {
   bool pending_removal;
 };
 
-struct BgConnHash {
-  std::size_t operator()(const RawAddress& x) const {
-    const uint8_t* a = x.address;
-    return a[0] ^ (a[1] << 8) ^ (a[2] << 16) ^ (a[3] << 24) ^ a[4] ^
-           (a[5] << 8);
-  }
-};
-
-static std::unordered_map<RawAddress, BackgroundConnection, BgConnHash>
+static std::unordered_map<RawAddress, BackgroundConnection>
     background_connections;
 
 static void background_connection_add(uint8_t addr_type,
@@ -30,11 +30,11 @@
 #include <stddef.h>
 #include <stdio.h>
 #include <string.h>
-#include <list>
 #include <vector>
 
 #include "bt_types.h"
 #include "bt_utils.h"
+#include "btm_ble_adv_cache.h"
 #include "btm_ble_api.h"
 #include "btm_int.h"
 #include "btu.h"
@@ -43,6 +43,7 @@
 #include "hcimsgs.h"
 #include "stack_config.h"
 #include "osi/include/osi.h"
+#include "osi/include/properties.h"
 #include "osi/include/time.h"
 
 #include "advertise_data_parser.h"
@@ -63,75 +64,11 @@
 #define MIN_ADV_LENGTH 2
 #define BTM_VSC_CHIP_CAPABILITY_RSP_LEN_L_RELEASE 9
 
-namespace {
-
-class AdvertisingCache {
- public:
-  /* Set the data to |data| for device |addr_type, addr| */
-  const std::vector<uint8_t>& Set(uint8_t addr_type, const RawAddress& addr,
-                                  std::vector<uint8_t> data) {
-    auto it = Find(addr_type, addr);
-    if (it != items.end()) {
-      it->data = std::move(data);
-      return it->data;
-    }
-
-    if (items.size() > cache_max) {
-      items.pop_back();
-    }
-
-    items.emplace_front(addr_type, addr, std::move(data));
-    return items.front().data;
-  }
-
-  /* Append |data| for device |addr_type, addr| */
-  const std::vector<uint8_t>& Append(uint8_t addr_type, const RawAddress& addr,
-                                     std::vector<uint8_t> data) {
-    auto it = Find(addr_type, addr);
-    if (it != items.end()) {
-      it->data.insert(it->data.end(), data.begin(), data.end());
-      return it->data;
-    }
-
-    if (items.size() > cache_max) {
-      items.pop_back();
-    }
-
-    items.emplace_front(addr_type, addr, std::move(data));
-    return items.front().data;
-  }
-
-  /* Clear data for device |addr_type, addr| */
-  void Clear(uint8_t addr_type, const RawAddress& addr) {
-    auto it = Find(addr_type, addr);
-    if (it != items.end()) {
-      items.erase(it);
-    }
-  }
-
- private:
-  struct Item {
-    uint8_t addr_type;
-    RawAddress addr;
-    std::vector<uint8_t> data;
-
-    Item(uint8_t addr_type, const RawAddress& addr, std::vector<uint8_t> data)
-        : addr_type(addr_type), addr(addr), data(data) {}
-  };
-
-  std::list<Item>::iterator Find(uint8_t addr_type, const RawAddress& addr) {
-    for (auto it = items.begin(); it != items.end(); it++) {
-      if (it->addr_type == addr_type && it->addr == addr) {
-        return it;
-      }
-    }
-    return items.end();
-  }
+/* Number of devices whose advertising data can be reassembled at once */
+#define BTM_BLE_ADV_CACHE_SIZE_PROPERTY \
+  "persist.bluetooth.le_scan.adv_cache_size"
 
-  /* we keep maximum 7 devices in the cache */
-  const size_t cache_max = 7;
-  std::list<Item> items;
-};
+namespace {
 
 /* Devices in this cache are waiting for eiter scan response, or chained packets
  * on secondary channel */
@@ -507,6 +444,9 @@ static void btm_ble_vendor_capability_vsc_cmpl_cback(
 
   if (status != HCI_SUCCESS) {
     BTM_TRACE_DEBUG("%s: Status = 0x%02x (0 is success)", __func__, status);
+    /* A controller rejecting the vendor capabilities command has no APCF
+     * either, its scan filters have to be applied on the host */
+    btm_ble_adv_filter_init();
     return;
   }
   STREAM_TO_UINT8(btm_cb.cmn_ble_vsc_cb.adv_inst_max, p);
@@ -541,7 +481,8 @@ static void btm_ble_vendor_capability_vsc_cmpl_cback(
 
   btm_ble_adv_init();
 
-  if (btm_cb.cmn_ble_vsc_cb.max_filter > 0) btm_ble_adv_filter_init();
+  /* Without controller filters, they might be applied on the host */
+  btm_ble_adv_filter_init();
 
 #if (BLE_PRIVACY_SPT == TRUE)
   /* VS capability included and non-4.2 device */
@@ -2018,24 +1959,22 @@ static void btm_ble_process_adv_pkt_cont(
   tBTM_INQUIRY_VAR_ST* p_inq = &btm_cb.btm_inq_vars;
   bool update = true;
 
-  std::vector<uint8_t> tmp;
-  if (data_len != 0) tmp.insert(tmp.begin(), data, data + data_len);
-
   bool is_scannable = ble_evt_type_is_scannable(evt_type);
   bool is_scan_resp = ble_evt_type_is_scan_resp(evt_type);
 
   bool is_start =
       ble_evt_type_is_legacy(evt_type) && is_scannable && !is_scan_resp;
 
+  size_t len = data_len;
   if (ble_evt_type_is_legacy(evt_type))
-    AdvertiseDataParser::RemoveTrailingZeros(tmp);
+    len = AdvertiseDataParser::GetLengthWithoutTrailingZeros(data, data_len);
 
   // We might have send scan request to this device before, but didn't get the
   // response. In such case make sure data is put at start, not appended to
   // already existing data.
   std::vector<uint8_t> const& adv_data =
-      is_start ? cache.Set(addr_type, bda, std::move(tmp))
-               : cache.Append(addr_type, bda, std::move(tmp));
+      is_start ? cache.Set(addr_type, bda, data, len)
+               : cache.Append(addr_type, bda, data, len);
 
   bool data_complete = (ble_evt_type_data_status(evt_type) != 0x01);
 
@@ -2053,9 +1992,22 @@ static void btm_ble_process_adv_pkt_cont(
     return;
   }
 
+  /* From here on the data is complete. It is cleared from the cache on every
+   * return, reported or not, so that it does not hold a slot that chains
+   * still being reassembled need. */
   if (!AdvertiseDataParser::IsValid(adv_data)) {
     VLOG(1) << __func__ << "Dropping bad advertisement packet: "
              << base::HexEncode(adv_data.data(), adv_data.size());
+    cache.Clear(addr_type, bda);
+    return;
+  }
+
+  /* Reports rejected by the scan filters applied on the host are not
+   * observed. Unless an inquiry is running, they are dropped right away, as
+   * the controller filters would have. */
+  bool filtered = !btm_ble_adv_filter_match(bda, rssi, adv_data);
+  if (filtered && !BTM_BLE_IS_INQ_ACTIVE(btm_cb.ble_ctr_cb.scan_activity)) {
+    cache.Clear(addr_type, bda);
     return;
   }
 
@@ -2072,6 +2024,7 @@ static void btm_ble_process_adv_pkt_cont(
       update = false;
     } else {
       /* if yes, skip it */
+      cache.Clear(addr_type, bda);
       return; /* assumption: one result per event */
     }
   }
@@ -2081,8 +2034,10 @@ static void btm_ble_process_adv_pkt_cont(
     p_i = btm_inq_db_new(bda);
     if (p_i != NULL) {
       p_inq->inq_cmpl_info.num_resp++;
-    } else
+    } else {
+      cache.Clear(addr_type, bda);
       return;
+    }
   } else if (p_i->inq_count !=
              p_inq->inq_counter) /* first time seen in this inquiry */
   {
@@ -2106,6 +2061,7 @@ static void btm_ble_process_adv_pkt_cont(
   }
 
   if (!update) result &= ~BTM_BLE_INQ_RESULT;
+  if (filtered) result &= ~BTM_BLE_OBS_RESULT;
   /* If the number of responses found and limited, issue a cancel inquiry */
   if (p_inq->inqparms.max_resps &&
       p_inq->inq_cmpl_info.num_resp == p_inq->inqparms.max_resps) {
@@ -2206,6 +2162,15 @@ void btm_ble_stop_scan(void) {
   btm_send_hci_scan_enable(BTM_BLE_SCAN_DISABLE, BTM_BLE_DUPLICATE_DISABLE);
 
   btm_update_scanner_filter_policy(SP_ADV_ALL);
+
+  if (cache.GetEvictions() != 0 || cache.GetIncomplete() != 0) {
+    LOG_INFO(LOG_TAG,
+             "%s: advertising data lost: %zu devices evicted, %zu incomplete "
+             "(cache of %zu)",
+             __func__, cache.GetEvictions(), cache.GetIncomplete(),
+             cache.Capacity());
+    cache.ResetCounters();
+  }
 }
 /*******************************************************************************
  *
@@ -2648,6 +2613,12 @@ void btm_ble_init(void) {
   p_cb->addr_mgnt_cb.refresh_raddr_timer =
       alarm_new("btm_ble_addr.refresh_raddr_timer");
 
+  int32_t cache_size = osi_property_get_int32(
+      BTM_BLE_ADV_CACHE_SIZE_PROPERTY, AdvertisingCache::kDefaultCapacity);
+  /* A size below 1 would wrap around to the largest cache */
+  if (cache_size < 1) cache_size = AdvertisingCache::kDefaultCapacity;
+  cache.SetCapacity(cache_size);
+
 #if (BLE_VND_INCLUDED == FALSE)
   btm_ble_adv_filter_init();
 #endif
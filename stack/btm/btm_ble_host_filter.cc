@@ -0,0 +1,472 @@
+/******************************************************************************
+ *
+ *  Copyright 2018 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "btm_ble_host_filter.h"
+
+#include <base/logging.h>
+#include <algorithm>
+
+#include "bt_types.h"
+#include "btm_ble_api.h"
+
+#define BTM_BLE_AD_TYPE_SOL_SRV_UUID_16 0x14
+#define BTM_BLE_AD_TYPE_SOL_SRV_UUID_128 0x15
+#define BTM_BLE_AD_TYPE_SOL_SRV_UUID_32 0x1F
+#define BTM_BLE_AD_TYPE_TRANSPORT_DISCOVERY 0x26
+
+#define BTM_BLE_PF_BIT_TO_MASK(x) (uint16_t)(1 << (x))
+
+/* Features whose results are combined with the filter logic type, the others
+ * always have to match */
+#define HOST_PF_LOGIC_FEATURES                     \
+  (BTM_BLE_PF_BIT_TO_MASK(BTM_BLE_PF_LOCAL_NAME) | \
+   BTM_BLE_PF_BIT_TO_MASK(BTM_BLE_PF_MANU_DATA) |  \
+   BTM_BLE_PF_BIT_TO_MASK(BTM_BLE_PF_SRVC_DATA_PATTERN))
+
+#define HOST_PF_ALL_FEATURES \
+  (uint16_t)(BTM_BLE_PF_BIT_TO_MASK(BTM_BLE_PF_TDS_DATA + 1) - 1)
+
+/* Features that check the advertising data */
+#define HOST_PF_DATA_FEATURES \
+  (uint16_t)(~BTM_BLE_PF_BIT_TO_MASK(BTM_BLE_PF_ADDR_FILTER))
+
+namespace {
+
+/* 00000000-0000-1000-8000-00805F9B34FB, little endian */
+constexpr std::array<uint8_t, 16> kBaseUuidLE = {
+    0xfb, 0x34, 0x9b, 0x5f, 0x80, 0x00, 0x00, 0x80,
+    0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+
+}  // namespace
+
+struct HostAdvFilter::AdFields {
+  struct Payload {
+    const uint8_t* data;
+    size_t len;
+  };
+
+  static constexpr size_t kMaxUuids = 16;
+  static constexpr size_t kMaxPayloads = 8;
+
+  Uuid128 srvc_uuids[kMaxUuids];
+  size_t num_srvc_uuids = 0;
+  Uuid128 sol_uuids[kMaxUuids];
+  size_t num_sol_uuids = 0;
+  Payload names[2];
+  size_t num_names = 0;
+  Payload manu_data[kMaxPayloads];
+  size_t num_manu_data = 0;
+  Payload srvc_data[kMaxPayloads];
+  size_t num_srvc_data = 0;
+  Payload tds[kMaxPayloads];
+  size_t num_tds = 0;
+
+  /* More entries than room for them, so a condition could be missed */
+  bool overflow = false;
+
+  void AddUuids(Uuid128* uuids, size_t* num, const uint8_t* p, size_t len,
+                size_t uuid_len) {
+    for (; len >= uuid_len; p += uuid_len, len -= uuid_len) {
+      if (*num == kMaxUuids) {
+        overflow = true;
+        return;
+      }
+      Uuid128& uuid = uuids[(*num)++];
+      if (uuid_len == 16) {
+        std::copy(p, p + 16, uuid.begin());
+      } else {
+        uuid = kBaseUuidLE;
+        std::copy(p, p + uuid_len, uuid.begin() + 12);
+      }
+    }
+  }
+
+  void AddPayload(Payload* payloads, size_t* num, size_t max,
+                  const uint8_t* p, size_t len) {
+    if (*num == max) {
+      overflow = true;
+      return;
+    }
+    payloads[(*num)++] = {p, len};
+  }
+};
+
+HostAdvFilter::HostAdvFilter(size_t max_filters)
+    : filters_(max_filters), parse_data_(false), enabled_(false) {
+  CHECK(max_filters > 0 && max_filters <= 0xff);
+  for (Filter& filter : filters_) {
+    filter.srvc_data = false;
+    filter.selected = false;
+  }
+}
+
+HostAdvFilter::Pattern HostAdvFilter::MakePattern(
+    const std::vector<uint8_t>& data, const std::vector<uint8_t>& mask,
+    size_t offset) {
+  Pattern pattern;
+  /* The controller matches up to the first BTM_BLE_PF_STR_LEN_MAX bytes of
+   * the AD structure, |offset| of them taken by other fields */
+  size_t len = std::min(data.size(), (size_t)BTM_BLE_PF_STR_LEN_MAX - offset);
+  for (size_t i = 0; i < len; i++) {
+    uint8_t m = (i < mask.size()) ? mask[i] : 0xff;
+    pattern.mask.push_back(m);
+    pattern.data.push_back(data[i] & m);
+  }
+  return pattern;
+}
+
+bool HostAdvFilter::MatchPattern(const Pattern& pattern,
+                                 const uint8_t* payload, size_t len) {
+  if (len < pattern.data.size()) return false;
+  for (size_t i = 0; i < pattern.data.size(); i++) {
+    if ((payload[i] & pattern.mask[i]) != pattern.data[i]) return false;
+  }
+  return true;
+}
+
+bool HostAdvFilter::AddConditions(uint8_t filt_index,
+                                  const std::vector<ApcfCommand>& commands) {
+  if (filt_index >= filters_.size()) return false;
+
+  Filter& filter = filters_[filt_index];
+  for (const ApcfCommand& cmd : commands) {
+    switch (cmd.type) {
+      case BTM_BLE_PF_ADDR_FILTER:
+        filter.addrs.push_back(cmd.address);
+        break;
+
+      case BTM_BLE_PF_SRVC_DATA:
+        filter.srvc_data = true;
+        break;
+
+      case BTM_BLE_PF_SRVC_UUID:
+      case BTM_BLE_PF_SRVC_SOL_UUID: {
+        UuidCondition cond;
+        if (cmd.uuid_mask.IsEmpty())
+          cond.mask.fill(0xff);
+        else
+          cond.mask = cmd.uuid_mask.To128BitLE();
+        cond.uuid = cmd.uuid.To128BitLE();
+        for (size_t i = 0; i < cond.uuid.size(); i++)
+          cond.uuid[i] &= cond.mask[i];
+        if (cmd.type == BTM_BLE_PF_SRVC_UUID)
+          filter.srvc_uuids.push_back(cond);
+        else
+          filter.sol_uuids.push_back(cond);
+        break;
+      }
+
+      case BTM_BLE_PF_LOCAL_NAME: {
+        size_t len = std::min(cmd.name.size(), (size_t)BTM_BLE_PF_STR_LEN_MAX);
+        filter.names.emplace_back(cmd.name.begin(), cmd.name.begin() + len);
+        break;
+      }
+
+      case BTM_BLE_PF_MANU_DATA: {
+        ManuCondition cond;
+        cond.company_mask = cmd.company_mask ? cmd.company_mask : 0xffff;
+        cond.company = cmd.company & cond.company_mask;
+        /* Like the controller command, data without a mask is ignored */
+        if (!cmd.data_mask.empty())
+          cond.pattern = MakePattern(cmd.data, cmd.data_mask, 2);
+        filter.manu_data.push_back(cond);
+        break;
+      }
+
+      case BTM_BLE_PF_SRVC_DATA_PATTERN:
+        filter.srvc_data_patterns.push_back(
+            MakePattern(cmd.data, cmd.data_mask, 2));
+        break;
+
+      case BTM_BLE_PF_TDS_DATA:
+        filter.tds.push_back(
+            {cmd.org_id, (uint8_t)(cmd.tds_flags & cmd.tds_flags_mask),
+             cmd.tds_flags_mask});
+        break;
+
+      default:
+        LOG(ERROR) << __func__ << ": Unknown filter type: " << +cmd.type;
+        break;
+    }
+  }
+
+  Compile();
+  return true;
+}
+
+void HostAdvFilter::Clear(uint8_t filt_index) {
+  if (filt_index >= filters_.size()) return;
+
+  Filter& filter = filters_[filt_index];
+  filter.addrs.clear();
+  filter.srvc_data = false;
+  filter.srvc_uuids.clear();
+  filter.sol_uuids.clear();
+  filter.names.clear();
+  filter.manu_data.clear();
+  filter.srvc_data_patterns.clear();
+  filter.tds.clear();
+  filter.selected = false;
+  Compile();
+}
+
+bool HostAdvFilter::Select(uint8_t filt_index, uint16_t feat_seln,
+                           uint16_t list_logic_type, uint8_t filt_logic_type,
+                           int8_t rssi_high_thres) {
+  if (filt_index >= filters_.size()) return false;
+
+  Filter& filter = filters_[filt_index];
+  filter.selected = true;
+  filter.feat_seln = feat_seln;
+  filter.list_logic_type = list_logic_type;
+  filter.filt_logic_type = filt_logic_type;
+  filter.rssi_high_thres = rssi_high_thres;
+  Compile();
+  return true;
+}
+
+void HostAdvFilter::Deselect(uint8_t filt_index) {
+  if (filt_index >= filters_.size()) return;
+
+  filters_[filt_index].selected = false;
+  Compile();
+}
+
+void HostAdvFilter::DeselectAll() {
+  for (Filter& filter : filters_) filter.selected = false;
+  Compile();
+}
+
+void HostAdvFilter::Compile() {
+  selected_.clear();
+  parse_data_ = false;
+  for (size_t i = 0; i < filters_.size(); i++) {
+    const Filter& filter = filters_[i];
+    if (!filter.selected) continue;
+
+    selected_.push_back(i);
+    if (filter.feat_seln & HOST_PF_DATA_FEATURES) parse_data_ = true;
+  }
+}
+
+void HostAdvFilter::ParseAdFields(const uint8_t* data, size_t len,
+                                  AdFields* fields) {
+  size_t pos = 0;
+  while (pos < len) {
+    uint8_t ad_len = data[pos];
+    /* Zero length structure, or the significant part is over */
+    if (ad_len == 0 || pos + 1 + ad_len > len) break;
+
+    uint8_t ad_type = data[pos + 1];
+    const uint8_t* p = data + pos + 2;
+    size_t p_len = ad_len - 1;
+    pos += 1 + ad_len;
+
+    switch (ad_type) {
+      case BT_EIR_MORE_16BITS_UUID_TYPE:
+      case BT_EIR_COMPLETE_16BITS_UUID_TYPE:
+        fields->AddUuids(fields->srvc_uuids, &fields->num_srvc_uuids, p, p_len,
+                         2);
+        break;
+      case BT_EIR_MORE_32BITS_UUID_TYPE:
+      case BT_EIR_COMPLETE_32BITS_UUID_TYPE:
+        fields->AddUuids(fields->srvc_uuids, &fields->num_srvc_uuids, p, p_len,
+                         4);
+        break;
+      case BT_EIR_MORE_128BITS_UUID_TYPE:
+      case BT_EIR_COMPLETE_128BITS_UUID_TYPE:
+        fields->AddUuids(fields->srvc_uuids, &fields->num_srvc_uuids, p, p_len,
+                         16);
+        break;
+      case BTM_BLE_AD_TYPE_SOL_SRV_UUID_16:
+        fields->AddUuids(fields->sol_uuids, &fields->num_sol_uuids, p, p_len,
+                         2);
+        break;
+      case BTM_BLE_AD_TYPE_SOL_SRV_UUID_32:
+        fields->AddUuids(fields->sol_uuids, &fields->num_sol_uuids, p, p_len,
+                         4);
+        break;
+      case BTM_BLE_AD_TYPE_SOL_SRV_UUID_128:
+        fields->AddUuids(fields->sol_uuids, &fields->num_sol_uuids, p, p_len,
+                         16);
+        break;
+      case BT_EIR_SHORTENED_LOCAL_NAME_TYPE:
+      case BT_EIR_COMPLETE_LOCAL_NAME_TYPE:
+        fields->AddPayload(fields->names, &fields->num_names, 2, p, p_len);
+        break;
+      case BT_EIR_MANUFACTURER_SPECIFIC_TYPE:
+        fields->AddPayload(fields->manu_data, &fields->num_manu_data,
+                           AdFields::kMaxPayloads, p, p_len);
+        break;
+      case BT_EIR_SERVICE_DATA_16BITS_UUID_TYPE:
+      case BT_EIR_SERVICE_DATA_32BITS_UUID_TYPE:
+      case BT_EIR_SERVICE_DATA_128BITS_UUID_TYPE:
+        fields->AddPayload(fields->srvc_data, &fields->num_srvc_data,
+                           AdFields::kMaxPayloads, p, p_len);
+        break;
+      case BTM_BLE_AD_TYPE_TRANSPORT_DISCOVERY:
+        fields->AddPayload(fields->tds, &fields->num_tds,
+                           AdFields::kMaxPayloads, p, p_len);
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+namespace {
+
+/* Combines the results of the conditions of one feature: any of them has to
+ * match with OR logic, all of them with AND logic */
+template <typename Cond, typename Pred>
+bool MatchList(const std::vector<Cond>& conds, bool and_logic, Pred pred) {
+  for (const Cond& cond : conds) {
+    if (pred(cond) != and_logic) return !and_logic;
+  }
+  return and_logic || conds.empty();
+}
+
+}  // namespace
+
+bool HostAdvFilter::MatchFilter(const Filter& filter, const RawAddress& bda,
+                                const AdFields& fields) const {
+  bool any_logic_feature = false;
+  bool logic_result = (filter.filt_logic_type == BTM_BLE_PF_LOGIC_AND);
+
+  /* Only the selected features, lowest first */
+  for (uint16_t bits = filter.feat_seln & HOST_PF_ALL_FEATURES; bits != 0;
+       bits &= bits - 1) {
+    uint8_t type = __builtin_ctz(bits);
+    uint16_t bit = BTM_BLE_PF_BIT_TO_MASK(type);
+
+    bool and_logic = (filter.list_logic_type & bit) != 0;
+    bool match = true;
+    switch (type) {
+      case BTM_BLE_PF_ADDR_FILTER:
+        match = MatchList(filter.addrs, and_logic,
+                          [&](const RawAddress& addr) { return addr == bda; });
+        break;
+
+      case BTM_BLE_PF_SRVC_DATA:
+        match = !filter.srvc_data || fields.num_srvc_data > 0;
+        break;
+
+      case BTM_BLE_PF_SRVC_UUID:
+      case BTM_BLE_PF_SRVC_SOL_UUID: {
+        bool srvc = (type == BTM_BLE_PF_SRVC_UUID);
+        const Uuid128* uuids = srvc ? fields.srvc_uuids : fields.sol_uuids;
+        size_t num = srvc ? fields.num_srvc_uuids : fields.num_sol_uuids;
+        match = MatchList(srvc ? filter.srvc_uuids : filter.sol_uuids,
+                          and_logic, [&](const UuidCondition& cond) {
+                            for (size_t i = 0; i < num; i++) {
+                              size_t j = 0;
+                              while (j < 16 && (uuids[i][j] & cond.mask[j]) ==
+                                                   cond.uuid[j])
+                                j++;
+                              if (j == 16) return true;
+                            }
+                            return false;
+                          });
+        break;
+      }
+
+      case BTM_BLE_PF_LOCAL_NAME:
+        match = MatchList(filter.names, and_logic,
+                          [&](const std::vector<uint8_t>& name) {
+                            for (size_t i = 0; i < fields.num_names; i++) {
+                              const AdFields::Payload& p = fields.names[i];
+                              if (p.len >= name.size() &&
+                                  std::equal(name.begin(), name.end(), p.data))
+                                return true;
+                            }
+                            return false;
+                          });
+        break;
+
+      case BTM_BLE_PF_MANU_DATA:
+        match = MatchList(
+            filter.manu_data, and_logic, [&](const ManuCondition& cond) {
+              for (size_t i = 0; i < fields.num_manu_data; i++) {
+                const AdFields::Payload& p = fields.manu_data[i];
+                if (p.len < 2) continue;
+                uint16_t company = p.data[0] | (p.data[1] << 8);
+                if ((company & cond.company_mask) == cond.company &&
+                    MatchPattern(cond.pattern, p.data + 2, p.len - 2))
+                  return true;
+              }
+              return false;
+            });
+        break;
+
+      case BTM_BLE_PF_SRVC_DATA_PATTERN:
+        match = MatchList(filter.srvc_data_patterns, and_logic,
+                          [&](const Pattern& pattern) {
+                            for (size_t i = 0; i < fields.num_srvc_data; i++) {
+                              const AdFields::Payload& p = fields.srvc_data[i];
+                              if (MatchPattern(pattern, p.data, p.len))
+                                return true;
+                            }
+                            return false;
+                          });
+        break;
+
+      case BTM_BLE_PF_TDS_DATA:
+        match = MatchList(filter.tds, and_logic, [&](const TdsCondition& cond) {
+          for (size_t i = 0; i < fields.num_tds; i++) {
+            const AdFields::Payload& p = fields.tds[i];
+            if (p.len >= 2 && p.data[0] == cond.org_id &&
+                (p.data[1] & cond.flags_mask) == cond.flags)
+              return true;
+          }
+          return false;
+        });
+        break;
+    }
+
+    if (bit & HOST_PF_LOGIC_FEATURES) {
+      any_logic_feature = true;
+      if (filter.filt_logic_type == BTM_BLE_PF_LOGIC_AND)
+        logic_result = logic_result && match;
+      else
+        logic_result = logic_result || match;
+    } else if (!match) {
+      return false;
+    }
+  }
+
+  return !any_logic_feature || logic_result;
+}
+
+bool HostAdvFilter::Matches(const RawAddress& bda, int8_t rssi,
+                            const uint8_t* data, size_t len) const {
+  if (!enabled_) return true;
+
+  AdFields fields;
+  if (parse_data_) {
+    ParseAdFields(data, len, &fields);
+    /* Rather deliver a report too many than miss one */
+    if (fields.overflow) return true;
+  }
+
+  for (uint8_t index : selected_) {
+    const Filter& filter = filters_[index];
+    if (rssi < filter.rssi_high_thres) continue;
+    if (MatchFilter(filter, bda, fields)) return true;
+  }
+  return false;
+}
@@ -0,0 +1,141 @@
+/******************************************************************************
+ *
+ *  Copyright 2018 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#ifndef BTM_BLE_HOST_FILTER_H
+#define BTM_BLE_HOST_FILTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <array>
+#include <vector>
+
+#include <hardware/bt_common_types.h>
+
+#include "raw_address.h"
+
+/* Filters advertising reports on the host, for controllers without the
+ * advertising packet content filter (APCF) vendor commands.
+ *
+ * Filters are configured like the APCF ones: conditions are added to a filter
+ * index, and the index is then selected with the features to check and how
+ * to combine them. Selected filters are compiled into flat matchers, and the
+ * advertising data of a report is parsed once for all of them. A report is
+ * delivered if it matches any selected filter.
+ *
+ * Delivery modes other than immediate are not emulated: a filter set up for
+ * on found / on lost tracking delivers every matching report. */
+class HostAdvFilter {
+ public:
+  explicit HostAdvFilter(size_t max_filters);
+
+  size_t MaxFilters() const { return filters_.size(); }
+
+  /* Filters not selected yet */
+  size_t NumAvailable() const { return filters_.size() - selected_.size(); }
+
+  /* Add the conditions of |commands| to filter |filt_index|. Returns false
+   * if |filt_index| is out of range. */
+  bool AddConditions(uint8_t filt_index,
+                     const std::vector<ApcfCommand>& commands);
+
+  /* Remove all conditions and the selection of filter |filt_index| */
+  void Clear(uint8_t filt_index);
+
+  /* Select filter |filt_index| with the features of |feat_seln| to check.
+   * Returns false if |filt_index| is out of range. */
+  bool Select(uint8_t filt_index, uint16_t feat_seln, uint16_t list_logic_type,
+              uint8_t filt_logic_type, int8_t rssi_high_thres);
+
+  void Deselect(uint8_t filt_index);
+  void DeselectAll();
+
+  void SetEnabled(bool enabled) { enabled_ = enabled; }
+  bool IsEnabled() const { return enabled_; }
+
+  /* Returns true if the report should be delivered: filtering is disabled,
+   * or the report matches a selected filter. */
+  bool Matches(const RawAddress& bda, int8_t rssi, const uint8_t* data,
+               size_t len) const;
+
+ private:
+  using Uuid128 = std::array<uint8_t, 16>;
+
+  /* A byte string matched against the start of an AD structure payload */
+  struct Pattern {
+    std::vector<uint8_t> data; /* already masked */
+    std::vector<uint8_t> mask;
+  };
+
+  struct UuidCondition {
+    Uuid128 uuid; /* already masked, little endian */
+    Uuid128 mask;
+  };
+
+  struct ManuCondition {
+    uint16_t company;
+    uint16_t company_mask;
+    Pattern pattern;
+  };
+
+  struct TdsCondition {
+    uint8_t org_id;
+    uint8_t flags;
+    uint8_t flags_mask;
+  };
+
+  struct Filter {
+    std::vector<RawAddress> addrs;
+    bool srvc_data;
+    std::vector<UuidCondition> srvc_uuids;
+    std::vector<UuidCondition> sol_uuids;
+    std::vector<std::vector<uint8_t>> names;
+    std::vector<ManuCondition> manu_data;
+    std::vector<Pattern> srvc_data_patterns;
+    std::vector<TdsCondition> tds;
+
+    bool selected;
+    uint16_t feat_seln;
+    uint16_t list_logic_type;
+    uint8_t filt_logic_type;
+    int8_t rssi_high_thres;
+  };
+
+  /* Payloads of the AD structures a filter can check, found in one pass */
+  struct AdFields;
+
+  static Pattern MakePattern(const std::vector<uint8_t>& data,
+                             const std::vector<uint8_t>& mask, size_t offset);
+  static bool MatchPattern(const Pattern& pattern, const uint8_t* payload,
+                           size_t len);
+  static void ParseAdFields(const uint8_t* data, size_t len, AdFields* fields);
+
+  bool MatchFilter(const Filter& filter, const RawAddress& bda,
+                   const AdFields& fields) const;
+
+  /* Rebuild |selected_| after the selection or conditions changed */
+  void Compile();
+
+  std::vector<Filter> filters_;
+  /* Indices of the selected filters, checked in order for every report */
+  std::vector<uint8_t> selected_;
+  /* Whether any selected filter checks the advertising data */
+  bool parse_data_;
+  bool enabled_;
+};
+
+#endif  // BTM_BLE_HOST_FILTER_H
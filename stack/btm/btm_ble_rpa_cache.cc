@@ -0,0 +1,50 @@
+/******************************************************************************
+ *
+ *  Copyright 2018 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "btm_ble_rpa_cache.h"
+
+bool RpaResolutionCache::Get(const RawAddress& rpa, uint64_t now_ms,
+                             tBTM_SEC_DEV_REC** p_dev_rec) const {
+  const Entry& entry = entries_[Slot(rpa)];
+  if (!entry.valid || entry.rpa != rpa ||
+      now_ms - entry.time_ms >= kLifetimeMs)
+    return false;
+
+  *p_dev_rec = entry.p_dev_rec;
+  return true;
+}
+
+void RpaResolutionCache::Put(const RawAddress& rpa, uint64_t now_ms,
+                             tBTM_SEC_DEV_REC* p_dev_rec) {
+  Entry& entry = entries_[Slot(rpa)];
+  entry.valid = true;
+  entry.rpa = rpa;
+  entry.p_dev_rec = p_dev_rec;
+  entry.time_ms = now_ms;
+}
+
+void RpaResolutionCache::Clear() {
+  for (Entry& entry : entries_) entry.valid = false;
+}
+
+size_t RpaResolutionCache::Slot(const RawAddress& rpa) {
+  /* The low 24 bits of a private address are its hash, random enough on
+   * their own */
+  const uint8_t* a = rpa.address;
+  return (a[3] ^ a[4] ^ a[5] ^ (a[0] >> 2)) % kSize;
+}
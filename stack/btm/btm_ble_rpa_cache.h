@@ -0,0 +1,65 @@
+/******************************************************************************
+ *
+ *  Copyright 2018 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#ifndef BTM_BLE_RPA_CACHE_H
+#define BTM_BLE_RPA_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "btm_int_types.h"
+
+/* Remembers the device record that recently resolved private addresses
+ * matched, or that they matched none, so that the advertisements a device
+ * keeps sending with the same address are resolved once against the IRKs.
+ *
+ * Entries expire kLifetimeMs after they were resolved. The cache is direct
+ * mapped: an address only evicts the one sharing its slot. It has to be
+ * cleared when a record is freed or gets a new IRK. */
+class RpaResolutionCache {
+ public:
+  static constexpr size_t kSize = 256;
+  static constexpr uint64_t kLifetimeMs = 10000;
+
+  RpaResolutionCache() { Clear(); }
+
+  /* Returns true if |rpa| was resolved less than kLifetimeMs before |now_ms|,
+   * setting |*p_dev_rec| to the record it matched or nullptr */
+  bool Get(const RawAddress& rpa, uint64_t now_ms,
+           tBTM_SEC_DEV_REC** p_dev_rec) const;
+
+  /* Remember that |rpa| resolved to |p_dev_rec|, nullptr if to none */
+  void Put(const RawAddress& rpa, uint64_t now_ms,
+           tBTM_SEC_DEV_REC* p_dev_rec);
+
+  void Clear();
+
+ private:
+  struct Entry {
+    bool valid;
+    RawAddress rpa;
+    tBTM_SEC_DEV_REC* p_dev_rec;
+    uint64_t time_ms;
+  };
+
+  static size_t Slot(const RawAddress& rpa);
+
+  Entry entries_[kSize];
+};
+
+#endif  // BTM_BLE_RPA_CACHE_H
@@ -61,6 +61,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unordered_map>
 
 #include "bt_common.h"
 #include "bt_types.h"
@@ -72,6 +73,84 @@
 #include "hcimsgs.h"
 #include "l2c_api.h"
 
+/* Lookaside indexes over btm_cb.sec_dev_rec, by address (identity or pseudo
+ * address) and by HCI handle. They are refreshed when a record gets a new
+ * address or handle and every hit is checked against the record, so a stale
+ * entry only falls back to the list walk it replaces. Entries are dropped
+ * before the record they point to is freed. */
+static std::unordered_map<RawAddress, tBTM_SEC_DEV_REC*> dev_rec_by_addr;
+static std::unordered_map<uint16_t, tBTM_SEC_DEV_REC*> dev_rec_by_handle;
+
+static bool dev_rec_has_addr(const tBTM_SEC_DEV_REC* p_dev_rec,
+                             const RawAddress& bd_addr) {
+  return p_dev_rec->bd_addr == bd_addr || p_dev_rec->ble.pseudo_addr == bd_addr;
+}
+
+static bool dev_rec_has_handle(const tBTM_SEC_DEV_REC* p_dev_rec,
+                               uint16_t handle) {
+  return p_dev_rec->hci_handle == handle || p_dev_rec->ble_hci_handle == handle;
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_sec_index_dev_rec
+ *
+ * Description      Point the device record indexes at |p_dev_rec| for its
+ *                  current address, pseudo address and handles. Called after
+ *                  any of them is assigned.
+ *
+ ******************************************************************************/
+void btm_sec_index_dev_rec(tBTM_SEC_DEV_REC* p_dev_rec) {
+  if (!p_dev_rec->bd_addr.IsEmpty())
+    dev_rec_by_addr[p_dev_rec->bd_addr] = p_dev_rec;
+
+  /* An identity address match takes precedence over a pseudo address one */
+  const RawAddress& pseudo_addr = p_dev_rec->ble.pseudo_addr;
+  if (!pseudo_addr.IsEmpty()) {
+    auto it = dev_rec_by_addr.find(pseudo_addr);
+    if (it == dev_rec_by_addr.end() || it->second->bd_addr != pseudo_addr)
+      dev_rec_by_addr[pseudo_addr] = p_dev_rec;
+  }
+
+  if (p_dev_rec->hci_handle != BTM_SEC_INVALID_HANDLE)
+    dev_rec_by_handle[p_dev_rec->hci_handle] = p_dev_rec;
+  if (p_dev_rec->ble_hci_handle != BTM_SEC_INVALID_HANDLE)
+    dev_rec_by_handle[p_dev_rec->ble_hci_handle] = p_dev_rec;
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_sec_clear_dev_rec_index
+ *
+ * Description      Empty the device record indexes along with the list.
+ *
+ ******************************************************************************/
+void btm_sec_clear_dev_rec_index(void) {
+  dev_rec_by_addr.clear();
+  dev_rec_by_handle.clear();
+  btm_ble_clear_rpa_cache();
+}
+
+/* Drop every index entry pointing at |p_dev_rec|, including the ones left
+ * behind by earlier addresses or handles, and free the record. */
+static void btm_sec_remove_dev_rec(tBTM_SEC_DEV_REC* p_dev_rec) {
+  for (auto it = dev_rec_by_addr.begin(); it != dev_rec_by_addr.end();) {
+    if (it->second == p_dev_rec)
+      it = dev_rec_by_addr.erase(it);
+    else
+      ++it;
+  }
+  for (auto it = dev_rec_by_handle.begin(); it != dev_rec_by_handle.end();) {
+    if (it->second == p_dev_rec)
+      it = dev_rec_by_handle.erase(it);
+    else
+      ++it;
+  }
+  btm_ble_clear_rpa_cache();
+
+  list_remove(btm_cb.sec_dev_rec, p_dev_rec);
+}
+
 /*******************************************************************************
  *
  * Function         BTM_SecAddDevice
@@ -109,6 +188,7 @@ bool BTM_SecAddDevice(const RawAddress& bd_addr, DEV_CLASS dev_class,
     p_dev_rec->bd_addr = bd_addr;
 
     p_dev_rec->hci_handle = BTM_GetHCIConnHandle(bd_addr, BT_TRANSPORT_BR_EDR);
+    btm_sec_index_dev_rec(p_dev_rec);
 
     /* use default value for background connection params */
     /* update conn params, use default value for background connection params */
@@ -323,6 +403,7 @@ tBTM_SEC_DEV_REC* btm_sec_alloc_dev(const RawAddress& bd_addr) {
 
   p_dev_rec->ble_hci_handle = BTM_GetHCIConnHandle(bd_addr, BT_TRANSPORT_LE);
   p_dev_rec->hci_handle = BTM_GetHCIConnHandle(bd_addr, BT_TRANSPORT_BR_EDR);
+  btm_sec_index_dev_rec(p_dev_rec);
 
   return (p_dev_rec);
 }
@@ -343,7 +424,7 @@ void btm_sec_free_dev(tBTM_SEC_DEV_REC* p_dev_rec) {
 
   /* Clear out any saved BLE keys */
   btm_sec_clear_ble_keys(p_dev_rec);
-  list_remove(btm_cb.sec_dev_rec, p_dev_rec);
+  btm_sec_remove_dev_rec(p_dev_rec);
 }
 
 /*******************************************************************************
@@ -415,8 +496,19 @@ bool is_handle_equal(void* data, void* context) {
  *
  ******************************************************************************/
 tBTM_SEC_DEV_REC* btm_find_dev_by_handle(uint16_t handle) {
+  /* Any number of disconnected records share the invalid handle */
+  if (handle != BTM_SEC_INVALID_HANDLE) {
+    auto it = dev_rec_by_handle.find(handle);
+    if (it != dev_rec_by_handle.end() && dev_rec_has_handle(it->second, handle))
+      return it->second;
+  }
+
   list_node_t* n = list_foreach(btm_cb.sec_dev_rec, is_handle_equal, &handle);
-  if (n) return static_cast<tBTM_SEC_DEV_REC*>(list_node(n));
+  if (n) {
+    tBTM_SEC_DEV_REC* p_dev_rec = static_cast<tBTM_SEC_DEV_REC*>(list_node(n));
+    if (handle != BTM_SEC_INVALID_HANDLE) dev_rec_by_handle[handle] = p_dev_rec;
+    return p_dev_rec;
+  }
 
   return NULL;
 }
@@ -445,9 +537,21 @@ bool is_address_equal(void* data, void* context) {
  *
  ******************************************************************************/
 tBTM_SEC_DEV_REC* btm_find_dev(const RawAddress& bd_addr) {
+  if (bd_addr.IsEmpty()) return NULL;
+
+  auto it = dev_rec_by_addr.find(bd_addr);
+  if (it != dev_rec_by_addr.end() && dev_rec_has_addr(it->second, bd_addr))
+    return it->second;
+
+  /* Random addresses resolved with an IRK are not indexed */
   list_node_t* n =
       list_foreach(btm_cb.sec_dev_rec, is_address_equal, (void*)&bd_addr);
-  if (n) return static_cast<tBTM_SEC_DEV_REC*>(list_node(n));
+  if (n) {
+    tBTM_SEC_DEV_REC* p_dev_rec = static_cast<tBTM_SEC_DEV_REC*>(list_node(n));
+    if (dev_rec_has_addr(p_dev_rec, bd_addr))
+      dev_rec_by_addr[bd_addr] = p_dev_rec;
+    return p_dev_rec;
+  }
 
   return NULL;
 }
@@ -492,7 +596,7 @@ void btm_consolidate_dev(tBTM_SEC_DEV_REC* p_target_rec) {
       p_target_rec->bond_type = temp_rec.bond_type;
 
       /* remove the combined record */
-      list_remove(btm_cb.sec_dev_rec, p_dev_rec);
+      btm_sec_remove_dev_rec(p_dev_rec);
       //p_dev_rec gets freed in list_remove, we should not  access it further
       continue;
     }
@@ -504,10 +608,13 @@ void btm_consolidate_dev(tBTM_SEC_DEV_REC* p_target_rec) {
         p_target_rec->device_type |= p_dev_rec->device_type;
 
         /* remove the combined record */
-        list_remove(btm_cb.sec_dev_rec, p_dev_rec);
+        btm_sec_remove_dev_rec(p_dev_rec);
       }
     }
   }
+
+  /* the target may have taken over the handles of a combined record */
+  btm_sec_index_dev_rec(p_target_rec);
 }
 
 /*******************************************************************************
@@ -593,7 +700,7 @@ tBTM_SEC_DEV_REC* btm_sec_allocate_dev_rec(void) {
 
   if (list_length(btm_cb.sec_dev_rec) > BTM_SEC_MAX_DEVICE_RECORDS) {
     p_dev_rec = btm_find_oldest_dev_rec();
-    list_remove(btm_cb.sec_dev_rec, p_dev_rec);
+    btm_sec_remove_dev_rec(p_dev_rec);
   }
 
   p_dev_rec =
@@ -26,6 +26,7 @@
 #include "osi/include/alarm.h"
 #include "osi/include/list.h"
 #include "rfcdefs.h"
+#include "stack/crypto_toolbox/aes.h"
 
 typedef char tBTM_LOC_BD_NAME[BTM_MAX_LOC_BD_NAME_LEN + 1];
 
@@ -484,6 +485,12 @@ typedef struct {
 
   tBTM_LE_KEY_TYPE key_type; /* bit mask of valid key types in record */
   tBTM_SEC_BLE_KEYS keys;    /* LE device security info in slave rode */
+
+  /* AES key schedule of keys.irk for resolving private addresses, set up on
+   * first use and again whenever the IRK differs from irk_ksch_key */
+  bool irk_ksch_valid;
+  Octet16 irk_ksch_key;
+  aes_context irk_ksch;
 } tBTM_SEC_BLE;
 
 /* Peering bond type */
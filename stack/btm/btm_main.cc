@@ -84,6 +84,7 @@ void btm_init(void) {
 #endif
 
   btm_cb.sec_dev_rec = list_new(osi_free);
+  btm_sec_clear_dev_rec_index();
 
   btm_dev_init(); /* Device Manager Structures & HCI_Reset */
 }
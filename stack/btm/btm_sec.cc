@@ -2092,6 +2092,7 @@ tBTM_STATUS btm_sec_l2cap_access_req(const RawAddress& bd_addr, uint16_t psm,
   p_dev_rec = btm_find_or_alloc_dev(bd_addr);
 
   p_dev_rec->hci_handle = handle;
+  btm_sec_index_dev_rec(p_dev_rec);
 
   /* Find the service record for the PSM */
   p_serv_rec = btm_sec_find_first_serv(conn_type, psm);
@@ -4648,6 +4649,7 @@ void btm_sec_connected(const RawAddress& bda, uint16_t handle, uint8_t status,
   }
 
   p_dev_rec->hci_handle = handle;
+  btm_sec_index_dev_rec(p_dev_rec);
 
   /* role may not be correct here, it will be updated by l2cap, but we need to
    */
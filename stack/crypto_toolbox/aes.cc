@@ -65,6 +65,19 @@
 
 #include "aes.h"
 
+/*  Use the AES instructions of the CPU for encryption with a precomputed key
+    schedule when they are available: AES-NI, detected at run time, or the
+    ARMv8 Cryptography Extensions when the build targets them.
+*/
+#if defined(__x86_64__) || defined(__i386__)
+#include <wmmintrin.h>
+#define AES_ENC_HW_X86
+#elif defined(__aarch64__) && \
+    (defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_AES))
+#include <arm_neon.h>
+#define AES_ENC_HW_ARM
+#endif
+
 #if defined(HAVE_UINT_32T)
 typedef uint32_t uint_32t;
 #endif
@@ -593,10 +606,69 @@ return_type aes_set_key(const unsigned char key[], length_type keylen,
 
 #if defined(AES_ENC_PREKEYED)
 
+#if defined(AES_ENC_HW_X86)
+
+static int aes_hw_detect(void) {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("aes");
+}
+
+static int aes_hw_supported(void) {
+  static const int supported = aes_hw_detect();
+  return supported;
+}
+
+/*  The key schedule holds the round keys in the byte order the AES-NI
+    instructions take them
+*/
+__attribute__((target("aes,sse2"))) static void aes_encrypt_hw(
+    const unsigned char in[N_BLOCK], unsigned char out[N_BLOCK],
+    const aes_context ctx[1]) {
+  const uint_8t* ksch = ctx->ksch;
+  __m128i s = _mm_xor_si128(_mm_loadu_si128((const __m128i*)in),
+                            _mm_loadu_si128((const __m128i*)ksch));
+  uint_8t r;
+
+  for (r = 1; r < ctx->rnd; ++r)
+    s = _mm_aesenc_si128(s,
+                         _mm_loadu_si128((const __m128i*)(ksch + r * N_BLOCK)));
+  s = _mm_aesenclast_si128(
+      s, _mm_loadu_si128((const __m128i*)(ksch + r * N_BLOCK)));
+  _mm_storeu_si128((__m128i*)out, s);
+}
+
+#elif defined(AES_ENC_HW_ARM)
+
+static int aes_hw_supported(void) { return 1; }
+
+/*  AESE adds the round key before substituting the bytes, so the last round
+    key is added on its own
+*/
+static void aes_encrypt_hw(const unsigned char in[N_BLOCK],
+                           unsigned char out[N_BLOCK],
+                           const aes_context ctx[1]) {
+  uint8x16_t s = vld1q_u8(in);
+  uint_8t r;
+
+  for (r = 0; r + 1 < ctx->rnd; ++r)
+    s = vaesmcq_u8(vaeseq_u8(s, vld1q_u8(ctx->ksch + r * N_BLOCK)));
+  s = vaeseq_u8(s, vld1q_u8(ctx->ksch + r * N_BLOCK));
+  s = veorq_u8(s, vld1q_u8(ctx->ksch + ctx->rnd * N_BLOCK));
+  vst1q_u8(out, s);
+}
+
+#endif
+
 /*  Encrypt a single block of 16 bytes */
 
 return_type aes_encrypt(const unsigned char in[N_BLOCK],
                         unsigned char out[N_BLOCK], const aes_context ctx[1]) {
+#if defined(AES_ENC_HW_X86) || defined(AES_ENC_HW_ARM)
+  if (ctx->rnd && aes_hw_supported()) {
+    aes_encrypt_hw(in, out, ctx);
+    return 0;
+  }
+#endif
   if (ctx->rnd) {
     uint_8t s1[N_BLOCK], r;
     copy_and_key(s1, in, ctx->ksch);
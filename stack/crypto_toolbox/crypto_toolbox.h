@@ -16,11 +16,14 @@
 
 #pragma once
 
+#include "stack/crypto_toolbox/aes.h"
 #include "stack/include/bt_types.h"
 
 namespace crypto_toolbox {
 
 extern Octet16 aes_128(const Octet16& key, const Octet16& message);
+extern void aes_128_set_key(const Octet16& key, aes_context* ctx);
+extern Octet16 aes_128(const aes_context& ctx, const Octet16& message);
 extern Octet16 aes_cmac(const Octet16& key, const uint8_t* message,
                         uint16_t length);
 extern Octet16 f4(uint8_t* u, uint8_t* v, const Octet16& x, uint8_t z);
@@ -45,6 +48,17 @@ inline Octet16 aes_128(const Octet16& key, const uint8_t* message,
   return aes_128(key, msg);
 }
 
+/* This function computes AES_128(key, message) with the key schedule |ctx|
+ * set up by aes_128_set_key(), for keys used on many messages. |message| can
+ * be at most 16 bytes long, it's length in bytes is given in |length| */
+inline Octet16 aes_128(const aes_context& ctx, const uint8_t* message,
+                       const uint8_t length) {
+  CHECK(length <= OCTET16_LEN) << "you tried aes_128 more than 16 bytes!";
+  Octet16 msg{0};
+  std::copy(message, message + length, msg.begin());
+  return aes_128(ctx, msg);
+}
+
 // |tlen| - lenth of mac desired
 // |p_signature| - data pointer to where signed data to be stored, tlen long.
 inline void aes_cmac(const Octet16& key, const uint8_t* message,
@@ -29,6 +29,7 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <algorithm>
 #include "btm_int.h"
 #include "gatt_int.h"
 #include "l2c_api.h"
@@ -260,40 +261,47 @@ tGATT_STATUS gatts_db_read_attr_value_by_type(
   uint16_t len = 0;
   uint8_t* p = (uint8_t*)(p_rsp + 1) + p_rsp->len + L2CAP_MIN_OFFSET;
 
+  const std::vector<uint16_t>* handles = nullptr;
   if (p_db) {
-    for (tGATT_ATTR& attr : p_db->attr_list) {
-      if (attr.handle >= s_handle && type == attr.uuid) {
-        if (*p_len <= 2) {
-          status = GATT_NO_RESOURCES;
-          break;
-        }
+    auto index = p_db->uuid_index.find(type);
+    if (index != p_db->uuid_index.end()) handles = &index->second;
+  }
 
-        UINT16_TO_STREAM(p, attr.handle);
+  if (handles) {
+    for (auto it = std::lower_bound(handles->begin(), handles->end(), s_handle);
+         it != handles->end(); it++) {
+      tGATT_ATTR& attr = *find_attr_by_handle(p_db, *it);
 
-        status = read_attr_value(attr, 0, &p, false, (uint16_t)(*p_len - 2),
-                                 &len, sec_flag, key_size);
+      if (*p_len <= 2) {
+        status = GATT_NO_RESOURCES;
+        break;
+      }
 
-        if (status == GATT_PENDING) {
-          status = gatts_send_app_read_request(tcb, op_code, attr.handle, 0,
-                                               trans_id, attr.gatt_type);
+      UINT16_TO_STREAM(p, attr.handle);
 
-          /* one callback at a time */
-          break;
-        } else if (status == GATT_SUCCESS) {
-          if (p_rsp->offset == 0) p_rsp->offset = len + 2;
-
-          if (p_rsp->offset == len + 2) {
-            p_rsp->len += (len + 2);
-            *p_len -= (len + 2);
-          } else {
-            LOG(ERROR) << "format mismatch";
-            status = GATT_NO_RESOURCES;
-            break;
-          }
+      status = read_attr_value(attr, 0, &p, false, (uint16_t)(*p_len - 2),
+                               &len, sec_flag, key_size);
+
+      if (status == GATT_PENDING) {
+        status = gatts_send_app_read_request(tcb, op_code, attr.handle, 0,
+                                             trans_id, attr.gatt_type);
+
+        /* one callback at a time */
+        break;
+      } else if (status == GATT_SUCCESS) {
+        if (p_rsp->offset == 0) p_rsp->offset = len + 2;
+
+        if (p_rsp->offset == len + 2) {
+          p_rsp->len += (len + 2);
+          *p_len -= (len + 2);
         } else {
-          *p_cur_handle = attr.handle;
+          LOG(ERROR) << "format mismatch";
+          status = GATT_NO_RESOURCES;
           break;
         }
+      } else {
+        *p_cur_handle = attr.handle;
+        break;
       }
     }
   }
@@ -410,14 +418,17 @@ uint16_t gatts_add_char_descr(tGATT_SVC_DB& db, tGATT_PERM perm,
 /* Service Attribute Database Query Utility Functions */
 /******************************************************************************/
 tGATT_ATTR* find_attr_by_handle(tGATT_SVC_DB* p_db, uint16_t handle) {
-  if (!p_db) return nullptr;
+  if (!p_db || p_db->attr_list.empty()) return nullptr;
 
-  for (auto& attr : p_db->attr_list) {
-    if (attr.handle == handle) return &attr;
-    if (attr.handle > handle) return nullptr;
-  }
+  /* Handles are allocated consecutively within a service (see
+   * allocate_attr_in_db), so the list is indexed by handle offset. */
+  uint16_t first_handle = p_db->attr_list.front().handle;
+  if (handle < first_handle ||
+      handle - first_handle >= (int)p_db->attr_list.size())
+    return nullptr;
 
-  return nullptr;
+  tGATT_ATTR& attr = p_db->attr_list[handle - first_handle];
+  return (attr.handle == handle) ? &attr : nullptr;
 }
 
 /*******************************************************************************
@@ -663,6 +674,7 @@ static tGATT_ATTR& allocate_attr_in_db(tGATT_SVC_DB& db, const Uuid& uuid,
   attr.handle = db.next_handle++;
   attr.uuid = uuid;
   attr.permission = perm;
+  db.uuid_index[uuid].push_back(attr.handle);
   return attr;
 }
 
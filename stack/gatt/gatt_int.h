@@ -29,6 +29,7 @@
 #include <base/strings/stringprintf.h>
 #include <string.h>
 #include <list>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -180,6 +181,8 @@ typedef struct {
   std::vector<tGATT_ATTR> attr_list; /* pointer to the attributes */
   uint16_t end_handle;       /* Last handle number           */
   uint16_t next_handle;      /* Next usable handle value     */
+  /* handles of the attributes of each type, in ascending order */
+  std::unordered_map<bluetooth::Uuid, std::vector<uint16_t>> uuid_index;
 } tGATT_SVC_DB;
 
 /* Data Structure used for GATT server */
@@ -573,6 +576,7 @@ extern tGATT_STATUS gatts_read_attr_perm_check(tGATT_SVC_DB* p_db, bool is_long,
                                                uint16_t handle,
                                                tGATT_SEC_FLAG sec_flag,
                                                uint8_t key_size);
+extern tGATT_ATTR* find_attr_by_handle(tGATT_SVC_DB* p_db, uint16_t handle);
 extern bluetooth::Uuid* gatts_get_service_uuid(tGATT_SVC_DB* p_db);
 
 #endif
@@ -528,10 +528,17 @@ static tGATT_STATUS gatt_build_find_info_rsp(tGATT_SRV_LIST_ELEM& el,
 
   uint8_t* p = (uint8_t*)(p_msg + 1) + L2CAP_MIN_OFFSET + p_msg->len;
 
-  for (auto& attr : el.p_db->attr_list) {
-    if (attr.handle > e_hdl) break;
+  std::vector<tGATT_ATTR>& attr_list = el.p_db->attr_list;
+  if (attr_list.empty()) return GATT_NOT_FOUND;
+
+  /* the list is indexed by handle offset, start at |s_hdl| */
+  size_t first = 0;
+  if (s_hdl > attr_list.front().handle)
+    first = s_hdl - attr_list.front().handle;
 
-    if (attr.handle < s_hdl) continue;
+  for (size_t i = first; i < attr_list.size(); i++) {
+    tGATT_ATTR& attr = attr_list[i];
+    if (attr.handle > e_hdl) break;
 
     uint8_t uuid_len = attr.uuid.GetShortestRepresentationSize();
     if (p_msg->offset == 0)
@@ -695,7 +702,10 @@ static void gatts_process_find_info(tGATT_TCB& tcb, uint8_t op_code,
   buf_len = tcb.payload_size - 2;
 
   for (tGATT_SRV_LIST_ELEM& el : *gatt_cb.srv_list_info) {
-    if (el.s_hdl <= e_hdl && el.e_hdl >= s_hdl) {
+    /* services are sorted by start handle */
+    if (el.s_hdl > e_hdl) break;
+
+    if (el.e_hdl >= s_hdl) {
       reason = gatt_build_find_info_rsp(el, p_msg, buf_len, s_hdl, e_hdl);
       if (reason == GATT_NO_RESOURCES) {
         reason = GATT_SUCCESS;
@@ -824,7 +834,10 @@ void gatts_process_read_by_type_req(tGATT_TCB& tcb, uint8_t op_code,
 
   reason = GATT_NOT_FOUND;
   for (tGATT_SRV_LIST_ELEM& el : *gatt_cb.srv_list_info) {
-    if (el.s_hdl <= e_hdl && el.e_hdl >= s_hdl) {
+    /* services are sorted by start handle */
+    if (el.s_hdl > e_hdl) break;
+
+    if (el.e_hdl >= s_hdl) {
       uint8_t sec_flag, key_size;
       gatt_sr_get_sec_info(tcb.peer_bda, tcb.transport, &sec_flag, &key_size);
 
@@ -1039,32 +1052,30 @@ void gatts_process_attribute_req(tGATT_TCB& tcb, uint8_t op_code, uint16_t len,
 #endif
 
   if (GATT_HANDLE_IS_VALID(handle)) {
-    for (auto& el : *gatt_cb.srv_list_info) {
-      if (el.s_hdl <= handle && el.e_hdl >= handle) {
-        for (const auto& attr : el.p_db->attr_list) {
-          if (attr.handle == handle) {
-            switch (op_code) {
-              case GATT_REQ_READ: /* read char/char descriptor value */
-              case GATT_REQ_READ_BLOB:
-                gatts_process_read_req(tcb, el, op_code, handle, len, p);
-                break;
-
-              case GATT_REQ_WRITE: /* write char/char descriptor value */
-              case GATT_CMD_WRITE:
-              case GATT_SIGN_CMD_WRITE:
-              case GATT_REQ_PREPARE_WRITE:
-                gatts_process_write_req(tcb, el, handle, op_code, len, p,
-                                        attr.gatt_type);
-                break;
-              default:
-                break;
-            }
-            status = GATT_SUCCESS;
-            break;
-          }
-        }
-        break;
+    auto it = gatt_sr_find_i_rcb_by_handle(handle);
+    tGATT_ATTR* p_attr = nullptr;
+    if (it != gatt_cb.srv_list_info->end())
+      p_attr = find_attr_by_handle(it->p_db, handle);
+
+    if (p_attr) {
+      tGATT_SRV_LIST_ELEM& el = *it;
+      switch (op_code) {
+        case GATT_REQ_READ: /* read char/char descriptor value */
+        case GATT_REQ_READ_BLOB:
+          gatts_process_read_req(tcb, el, op_code, handle, len, p);
+          break;
+
+        case GATT_REQ_WRITE: /* write char/char descriptor value */
+        case GATT_CMD_WRITE:
+        case GATT_SIGN_CMD_WRITE:
+        case GATT_REQ_PREPARE_WRITE:
+          gatts_process_write_req(tcb, el, handle, op_code, len, p,
+                                  p_attr->gatt_type);
+          break;
+        default:
+          break;
       }
+      status = GATT_SUCCESS;
     }
   }
 
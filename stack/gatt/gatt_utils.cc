@@ -665,12 +665,15 @@ std::list<tGATT_SRV_LIST_ELEM>::iterator gatt_sr_find_i_rcb_by_handle(
   auto it = gatt_cb.srv_list_info->begin();
 
   for (; it != gatt_cb.srv_list_info->end(); it++) {
-    if (it->s_hdl <= handle && it->e_hdl >= handle) {
+    /* services are sorted by start handle */
+    if (it->s_hdl > handle) break;
+
+    if (it->e_hdl >= handle) {
       return it;
     }
   }
 
-  return it;
+  return gatt_cb.srv_list_info->end();
 }
 
 /*******************************************************************************
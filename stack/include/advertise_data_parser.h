@@ -45,9 +45,17 @@ class AdvertiseDataParser {
 
  public:
   static void RemoveTrailingZeros(std::vector<uint8_t>& ad) {
+    ad.resize(GetLengthWithoutTrailingZeros(ad.data(), ad.size()));
+  }
+
+  /**
+   * Return the length of the |ad_len| bytes at |ad| without the zero padding
+   * that RemoveTrailingZeros would cut.
+   */
+  static size_t GetLengthWithoutTrailingZeros(const uint8_t* ad,
+                                              size_t ad_len) {
     size_t position = 0;
 
-    size_t ad_len = ad.size();
     while (position < ad_len) {
       uint8_t len = ad[position];
 
@@ -56,17 +64,13 @@ class AdvertiseDataParser {
       // end of advertisement. If this is the case, cut the zero padding from
       // end of the packet. Otherwise i.e. gluing scan response to advertise
       // data will result in data with zero padding in the middle.
-      if (len == 0) {
-        ad.erase(ad.begin() + position, ad.end());
-        return;
-      }
+      if (len == 0) return position;
 
-      if (position + len >= ad_len) {
-        return;
-      }
+      if (position + len >= ad_len) return ad_len;
 
       position += len + 1;
     }
+    return ad_len;
   }
 
   /**
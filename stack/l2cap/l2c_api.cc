@@ -136,7 +136,7 @@ void L2CA_Deregister(uint16_t psm) {
   p_rcb = l2cu_find_rcb_by_psm(psm);
   if (p_rcb != NULL) {
     p_lcb = &l2cb.lcb_pool[0];
-    for (ii = 0; ii < MAX_L2CAP_LINKS; ii++, p_lcb++) {
+    for (ii = 0; ii < l2cb.max_links; ii++, p_lcb++) {
       if (p_lcb->in_use) {
         p_ccb = p_lcb->ccb_queue.p_first_ccb;
         if ((p_ccb == NULL) || (p_lcb->link_state == LST_DISCONNECTING)) {
@@ -484,7 +484,7 @@ void L2CA_DeregisterLECoc(uint16_t psm) {
   }
 
   tL2C_LCB* p_lcb = &l2cb.lcb_pool[0];
-  for (int i = 0; i < MAX_L2CAP_LINKS; i++, p_lcb++) {
+  for (int i = 0; i < l2cb.max_links; i++, p_lcb++) {
     if (!p_lcb->in_use || p_lcb->transport != BT_TRANSPORT_LE) continue;
 
     tL2C_CCB* p_ccb = p_lcb->ccb_queue.p_first_ccb;
@@ -1164,7 +1164,7 @@ bool L2CA_SetIdleTimeoutByBdAddr(const RawAddress& bd_addr, uint16_t timeout,
     int xx;
     tL2C_LCB* p_lcb = &l2cb.lcb_pool[0];
 
-    for (xx = 0; xx < MAX_L2CAP_LINKS; xx++, p_lcb++) {
+    for (xx = 0; xx < l2cb.max_links; xx++, p_lcb++) {
       if ((p_lcb->in_use) && (p_lcb->link_state == LST_CONNECTED)) {
         p_lcb->idle_timeout = timeout;
 
@@ -1267,7 +1267,7 @@ uint16_t L2CA_LocalLoopbackReq(uint16_t psm, uint16_t handle,
   }
 
   p_lcb->link_state = LST_CONNECTED;
-  p_lcb->handle = handle;
+  l2cu_set_lcb_handle(p_lcb, handle);
 
   /* Allocate a channel control block */
   p_ccb = l2cu_allocate_ccb(p_lcb, 0);
@@ -1523,7 +1523,7 @@ bool L2CA_SetFlushTimeout(const RawAddress& bd_addr, uint16_t flush_tout) {
     int xx;
     p_lcb = &l2cb.lcb_pool[0];
 
-    for (xx = 0; xx < MAX_L2CAP_LINKS; xx++, p_lcb++) {
+    for (xx = 0; xx < l2cb.max_links; xx++, p_lcb++) {
       if ((p_lcb->in_use) && (p_lcb->link_state == LST_CONNECTED)) {
         if (p_lcb->link_flush_tout != flush_tout) {
           p_lcb->link_flush_tout = flush_tout;
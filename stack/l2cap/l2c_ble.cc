@@ -302,7 +302,7 @@ void l2cble_conn_comp(uint16_t handle, uint8_t role, const RawAddress& bda,
   if (role == HCI_ROLE_MASTER) alarm_cancel(p_lcb->l2c_lcb_timer);
 
   /* Save the handle */
-  p_lcb->handle = handle;
+  l2cu_set_lcb_handle(p_lcb, handle);
 
   /* Connected OK. Change state to connected, we were scanning so we are master
    */
@@ -832,7 +832,7 @@ void l2c_ble_link_adjust_allocation(void) {
   }
 
   /* First, count the links */
-  for (yy = 0, p_lcb = &l2cb.lcb_pool[0]; yy < MAX_L2CAP_LINKS; yy++, p_lcb++) {
+  for (yy = 0, p_lcb = &l2cb.lcb_pool[0]; yy < l2cb.max_links; yy++, p_lcb++) {
     if (p_lcb->in_use && p_lcb->transport == BT_TRANSPORT_LE) {
       if (p_lcb->acl_priority == L2CAP_PRIORITY_HIGH)
         num_hipri_links++;
@@ -879,7 +879,7 @@ void l2c_ble_link_adjust_allocation(void) {
       qq);
 
   /* Now, assign the quotas to each link */
-  for (yy = 0, p_lcb = &l2cb.lcb_pool[0]; yy < MAX_L2CAP_LINKS; yy++, p_lcb++) {
+  for (yy = 0, p_lcb = &l2cb.lcb_pool[0]; yy < l2cb.max_links; yy++, p_lcb++) {
     if (p_lcb->in_use && p_lcb->transport == BT_TRANSPORT_LE) {
       if (p_lcb->acl_priority == L2CAP_PRIORITY_HIGH) {
         p_lcb->link_xmit_quota = high_pri_link_quota;
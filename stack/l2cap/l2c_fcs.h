@@ -0,0 +1,56 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2004-2012 Broadcom Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file contains the CRC-16 used for the L2CAP ERTM and streaming mode
+ *  Frame Check Sequence
+ *
+ ******************************************************************************/
+#ifndef L2C_FCS_H
+#define L2C_FCS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*******************************************************************************
+ *
+ * Function         l2c_fcs_crc16
+ *
+ * Description      Continues the FCS CRC |crc| over |len| bytes at |p|,
+ *                  eight bytes at a time.
+ *
+ * Returns          CRC
+ *
+ ******************************************************************************/
+extern uint16_t l2c_fcs_crc16(uint16_t crc, const uint8_t* p, size_t len);
+
+/*******************************************************************************
+ *
+ * Function         l2c_fcs_crc16_bytewise
+ *
+ * Description      Same as l2c_fcs_crc16, one byte at a time. Reference
+ *                  implementation for tests.
+ *
+ * Returns          CRC
+ *
+ ******************************************************************************/
+extern uint16_t l2c_fcs_crc16_bytewise(uint16_t crc, const uint8_t* p,
+                                       size_t len);
+
+#endif
@@ -498,8 +498,15 @@ typedef struct {
 
   bool is_cong_cback_context;
 
-  tL2C_LCB lcb_pool[MAX_L2CAP_LINKS];    /* Link Control Block pool */
-  tL2C_CCB ccb_pool[MAX_L2CAP_CHANNELS]; /* Channel Control Block pool */
+  /* The link and channel control block pools are allocated by l2c_init()
+   * with a size read from system properties. MAX_L2CAP_LINKS and
+   * MAX_L2CAP_CHANNELS remain the upper bounds, as the ACL and per-CID tables
+   * of the other layers are sized by them. */
+  tL2C_LCB* lcb_pool;    /* Link Control Block pool */
+  tL2C_CCB* ccb_pool;    /* Channel Control Block pool */
+  uint16_t max_links;    /* Number of LCBs in lcb_pool */
+  uint16_t max_channels; /* Number of CCBs in ccb_pool */
+  uint8_t* lcb_by_handle; /* lcb_pool index + 1 by HCI handle, 0 if none */
   tL2C_RCB rcb_pool[MAX_L2CAP_CLIENTS];  /* Registration info pool */
 
   tL2C_CCB* p_free_ccb_first; /* Pointer to first free CCB */
@@ -628,6 +635,7 @@ extern void l2cu_release_lcb(tL2C_LCB* p_lcb);
 extern tL2C_LCB* l2cu_find_lcb_by_bd_addr(const RawAddress& p_bd_addr,
                                           tBT_TRANSPORT transport);
 extern tL2C_LCB* l2cu_find_lcb_by_handle(uint16_t handle);
+extern void l2cu_set_lcb_handle(tL2C_LCB* p_lcb, uint16_t handle);
 extern void l2cu_update_lcb_4_bonding(const RawAddress& p_bd_addr,
                                       bool is_bonding);
 
@@ -83,7 +83,7 @@ bool l2c_link_hci_conn_req(const RawAddress& bd_addr) {
     no_links = true;
 
     /* If we already have connection, accept as a master */
-    for (xx = 0, p_lcb_cur = &l2cb.lcb_pool[0]; xx < MAX_L2CAP_LINKS;
+    for (xx = 0, p_lcb_cur = &l2cb.lcb_pool[0]; xx < l2cb.max_links;
          xx++, p_lcb_cur++) {
       if (p_lcb_cur == p_lcb) continue;
 
@@ -201,7 +201,7 @@ bool l2c_link_hci_conn_comp(uint8_t status, uint16_t handle,
   }
 
   /* Save the handle */
-  p_lcb->handle = handle;
+  l2cu_set_lcb_handle(p_lcb, handle);
 
   if (ci.status == HCI_SUCCESS) {
     /* Connected OK. Change state to connected */
@@ -253,7 +253,7 @@ bool l2c_link_hci_conn_comp(uint8_t status, uint16_t handle,
   else if ((ci.status == HCI_ERR_MAX_NUM_OF_CONNECTIONS) &&
            l2cu_lcb_disconnecting()) {
     p_lcb->link_state = LST_CONNECT_HOLDING;
-    p_lcb->handle = HCI_INVALID_HANDLE;
+    l2cu_set_lcb_handle(p_lcb, HCI_INVALID_HANDLE);
   } else {
     /* Just in case app decides to try again in the callback context */
     p_lcb->link_state = LST_DISCONNECTING;
@@ -760,7 +760,7 @@ void l2c_link_adjust_allocation(void) {
   }
 
   /* First, count the links */
-  for (yy = 0, p_lcb = &l2cb.lcb_pool[0]; yy < MAX_L2CAP_LINKS; yy++, p_lcb++) {
+  for (yy = 0, p_lcb = &l2cb.lcb_pool[0]; yy < l2cb.max_links; yy++, p_lcb++) {
     if (p_lcb->in_use &&
         (is_share_buffer || p_lcb->transport != BT_TRANSPORT_LE)) {
       if (p_lcb->acl_priority == L2CAP_PRIORITY_HIGH)
@@ -818,7 +818,7 @@ void l2c_link_adjust_allocation(void) {
       num_hipri_links, num_lowpri_links, low_quota, l2cb.round_robin_quota, qq);
 
   /* Now, assign the quotas to each link */
-  for (yy = 0, p_lcb = &l2cb.lcb_pool[0]; yy < MAX_L2CAP_LINKS; yy++, p_lcb++) {
+  for (yy = 0, p_lcb = &l2cb.lcb_pool[0]; yy < l2cb.max_links; yy++, p_lcb++) {
     if (p_lcb->in_use &&
         (is_share_buffer || p_lcb->transport != BT_TRANSPORT_LE)) {
       if (p_lcb->acl_priority == L2CAP_PRIORITY_HIGH) {
@@ -880,7 +880,7 @@ void l2c_link_adjust_chnl_allocation(void) {
   L2CAP_TRACE_DEBUG("%s", __func__);
 
   /* assign buffer quota to each channel based on its data rate requirement */
-  for (xx = 0; xx < MAX_L2CAP_CHANNELS; xx++) {
+  for (xx = 0; xx < l2cb.max_channels; xx++) {
     tL2C_CCB* p_ccb = l2cb.ccb_pool + xx;
 
     if (!p_ccb->in_use) continue;
@@ -963,7 +963,7 @@ void l2c_link_role_changed(const RawAddress* bd_addr, uint8_t new_role,
   }
 
   /* Check if any LCB was waiting for switch to be completed */
-  for (xx = 0, p_lcb = &l2cb.lcb_pool[0]; xx < MAX_L2CAP_LINKS; xx++, p_lcb++) {
+  for (xx = 0, p_lcb = &l2cb.lcb_pool[0]; xx < l2cb.max_links; xx++, p_lcb++) {
     if ((p_lcb->in_use) && (p_lcb->link_state == LST_CONNECTING_WAIT_SWITCH)) {
       l2cu_create_conn_after_switch(p_lcb);
     }
@@ -1088,9 +1088,9 @@ void l2c_link_check_send_pkts(tL2C_LCB* p_lcb, tL2C_CCB* p_ccb, BT_HDR* p_buf) {
       p_lcb++;
 
     /* Loop through, starting at the next */
-    for (xx = 0; xx < MAX_L2CAP_LINKS; xx++, p_lcb++) {
+    for (xx = 0; xx < l2cb.max_links; xx++, p_lcb++) {
       /* Check for wraparound */
-      if (p_lcb == &l2cb.lcb_pool[MAX_L2CAP_LINKS]) p_lcb = &l2cb.lcb_pool[0];
+      if (p_lcb == &l2cb.lcb_pool[l2cb.max_links]) p_lcb = &l2cb.lcb_pool[0];
 
       /* If controller window is full, nothing to do */
       if (((l2cb.controller_xmit_window == 0 ||
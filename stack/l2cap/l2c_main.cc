@@ -38,6 +38,7 @@
 #include "l2c_api.h"
 #include "l2c_int.h"
 #include "l2cdefs.h"
+#include "osi/include/properties.h"
 #include "stack_config.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
@@ -50,6 +51,13 @@
 /******************************************************************************/
 static void process_l2cap_cmd(tL2C_LCB* p_lcb, uint8_t* p, uint16_t pkt_len);
 
+/* Runtime sizes of the link and channel control block pools */
+#define L2CAP_MAX_LINKS_PROPERTY "persist.bluetooth.l2cap.maxlinks"
+#define L2CAP_MAX_CHANNELS_PROPERTY "persist.bluetooth.l2cap.maxchannels"
+
+/* lcb_by_handle holds 8-bit indexes */
+static_assert(MAX_L2CAP_LINKS < 256, "too many L2CAP links");
+
 /******************************************************************************/
 /*               G L O B A L      L 2 C A P       D A T A                     */
 /******************************************************************************/
@@ -957,16 +965,35 @@ void l2c_init(void) {
   /* the LE PSM is increased by 1 before being used */
   l2cb.le_dyn_psm = LE_DYNAMIC_PSM_START - 1;
 
+  /* Size the control block pools. The pools cannot outgrow the compile time
+   * limits, and a channel pool needs room for at least one channel per link */
+  int32_t max_links =
+      osi_property_get_int32(L2CAP_MAX_LINKS_PROPERTY, MAX_L2CAP_LINKS);
+  if (max_links < 1 || max_links > MAX_L2CAP_LINKS) max_links = MAX_L2CAP_LINKS;
+  int32_t max_channels =
+      osi_property_get_int32(L2CAP_MAX_CHANNELS_PROPERTY, MAX_L2CAP_CHANNELS);
+  if (max_channels < max_links || max_channels > MAX_L2CAP_CHANNELS)
+    max_channels = MAX_L2CAP_CHANNELS;
+
+  l2cb.max_links = max_links;
+  l2cb.max_channels = max_channels;
+  l2cb.lcb_pool =
+      static_cast<tL2C_LCB*>(osi_calloc(max_links * sizeof(tL2C_LCB)));
+  l2cb.ccb_pool =
+      static_cast<tL2C_CCB*>(osi_calloc(max_channels * sizeof(tL2C_CCB)));
+  l2cb.lcb_by_handle =
+      static_cast<uint8_t*>(osi_calloc(HCI_DATA_HANDLE_MASK + 1));
+
   /* start new timers for all lcbs */
   tL2C_LCB* p_lcb = &l2cb.lcb_pool[0];
-  for (xx = 0; xx < MAX_L2CAP_LINKS; xx++, p_lcb++) {
+  for (xx = 0; xx < l2cb.max_links; xx++, p_lcb++) {
     p_lcb->l2c_lcb_timer = alarm_new("l2c_lcb.l2c_lcb_timer");
     p_lcb->info_resp_timer = alarm_new("l2c_lcb.info_resp_timer");
   }
 
   /* Put all the channel control blocks on the free queue */
   /* Start new timers for all ccbs */
-  for (xx = 0; xx < MAX_L2CAP_CHANNELS - 1; xx++) {
+  for (xx = 0; xx < l2cb.max_channels - 1; xx++) {
     l2cb.ccb_pool[xx].p_next_ccb = &l2cb.ccb_pool[xx + 1];
     l2cb.ccb_pool[xx].l2c_ccb_timer = alarm_new("l2c.l2c_ccb_timer");
   }
@@ -977,7 +1004,7 @@ void l2c_init(void) {
 #endif
 
   l2cb.p_free_ccb_first = &l2cb.ccb_pool[0];
-  l2cb.p_free_ccb_last = &l2cb.ccb_pool[MAX_L2CAP_CHANNELS - 1];
+  l2cb.p_free_ccb_last = &l2cb.ccb_pool[l2cb.max_channels - 1];
 
 #ifdef L2CAP_DESIRED_LINK_ROLE
   l2cb.desire_role = L2CAP_DESIRED_LINK_ROLE;
@@ -1025,18 +1052,25 @@ void l2c_free(void) {
 
   int xx;
   tL2C_LCB* p_lcb = &l2cb.lcb_pool[0];
-  for (xx = 0; xx < MAX_L2CAP_LINKS; xx++, p_lcb++) {
+  for (xx = 0; xx < l2cb.max_links; xx++, p_lcb++) {
     alarm_free(p_lcb->l2c_lcb_timer);
     p_lcb->l2c_lcb_timer = NULL;
     alarm_free(p_lcb->info_resp_timer);
     p_lcb->info_resp_timer = NULL;
   }
   /* Free all ccb timers */
-  for (xx = 0; xx < MAX_L2CAP_CHANNELS - 1; xx++) {
+  for (xx = 0; xx < l2cb.max_channels - 1; xx++) {
     alarm_free(l2cb.ccb_pool[xx].l2c_ccb_timer);
     l2cb.ccb_pool[xx].l2c_ccb_timer = NULL;
   }
 
+  /* Leave empty pools behind for any late lookup */
+  l2cb.max_links = 0;
+  l2cb.max_channels = 0;
+  osi_free_and_reset((void**)&l2cb.lcb_pool);
+  osi_free_and_reset((void**)&l2cb.ccb_pool);
+  osi_free_and_reset((void**)&l2cb.lcb_by_handle);
+
   list_free(l2cb.rcv_pending_q);
   l2cb.rcv_pending_q = NULL;
 }
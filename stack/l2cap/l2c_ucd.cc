@@ -282,7 +282,7 @@ bool L2CA_UcdDeregister(uint16_t psm) {
 
   /* delete CCB for UCD */
   p_ccb = l2cb.ccb_pool;
-  for (xx = 0; xx < MAX_L2CAP_CHANNELS; xx++) {
+  for (xx = 0; xx < l2cb.max_channels; xx++) {
     if ((p_ccb->in_use) && (p_ccb->local_cid == L2CAP_CONNECTIONLESS_CID)) {
       l2cu_release_ccb(p_ccb);
     }
@@ -51,7 +51,7 @@
  *
  ******************************************************************************/
 bool l2cu_can_allocate_lcb(void) {
-  for (int i = 0; i < MAX_L2CAP_LINKS; i++) {
+  for (int i = 0; i < l2cb.max_links; i++) {
     if (!l2cb.lcb_pool[i].in_use) return true;
   }
   return false;
@@ -71,7 +71,7 @@ tL2C_LCB* l2cu_allocate_lcb(const RawAddress& p_bd_addr, bool is_bonding,
   int xx;
   tL2C_LCB* p_lcb = &l2cb.lcb_pool[0];
 
-  for (xx = 0; xx < MAX_L2CAP_LINKS; xx++, p_lcb++) {
+  for (xx = 0; xx < l2cb.max_links; xx++, p_lcb++) {
     if (!p_lcb->in_use) {
       alarm_free(p_lcb->l2c_lcb_timer);
       alarm_free(p_lcb->info_resp_timer);
@@ -257,7 +257,7 @@ tL2C_LCB* l2cu_find_lcb_by_bd_addr(const RawAddress& p_bd_addr,
   int xx;
   tL2C_LCB* p_lcb = &l2cb.lcb_pool[0];
 
-  for (xx = 0; xx < MAX_L2CAP_LINKS; xx++, p_lcb++) {
+  for (xx = 0; xx < l2cb.max_links; xx++, p_lcb++) {
     if ((p_lcb->in_use) && p_lcb->transport == transport &&
         (p_lcb->remote_bd_addr == p_bd_addr)) {
       return (p_lcb);
@@ -2134,7 +2134,7 @@ void l2cu_device_reset(void) {
   int xx;
   tL2C_LCB* p_lcb = &l2cb.lcb_pool[0];
 
-  for (xx = 0; xx < MAX_L2CAP_LINKS; xx++, p_lcb++) {
+  for (xx = 0; xx < l2cb.max_links; xx++, p_lcb++) {
     if ((p_lcb->in_use) && (p_lcb->handle != HCI_INVALID_HANDLE)) {
       l2c_link_hci_disc_comp(p_lcb->handle, (uint8_t)-1);
     }
@@ -2180,7 +2180,7 @@ bool l2cu_create_conn(tL2C_LCB* p_lcb, tBT_TRANSPORT transport,
 
   /* If there is a connection where we perform as a slave, try to switch roles
      for this connection */
-  for (xx = 0, p_lcb_cur = &l2cb.lcb_pool[0]; xx < MAX_L2CAP_LINKS;
+  for (xx = 0, p_lcb_cur = &l2cb.lcb_pool[0]; xx < l2cb.max_links;
        xx++, p_lcb_cur++) {
     if (p_lcb_cur == p_lcb) continue;
 
@@ -2237,7 +2237,7 @@ uint8_t l2cu_get_num_hi_priority(void) {
   int xx;
   tL2C_LCB* p_lcb = &l2cb.lcb_pool[0];
 
-  for (xx = 0; xx < MAX_L2CAP_LINKS; xx++, p_lcb++) {
+  for (xx = 0; xx < l2cb.max_links; xx++, p_lcb++) {
     if ((p_lcb->in_use) && (p_lcb->acl_priority == L2CAP_PRIORITY_HIGH)) {
       no_hi++;
     }
@@ -2332,7 +2332,7 @@ tL2C_LCB* l2cu_find_lcb_by_state(tL2C_LINK_STATE state) {
   uint16_t i;
   tL2C_LCB* p_lcb = &l2cb.lcb_pool[0];
 
-  for (i = 0; i < MAX_L2CAP_LINKS; i++, p_lcb++) {
+  for (i = 0; i < l2cb.max_links; i++, p_lcb++) {
     if ((p_lcb->in_use) && (p_lcb->link_state == state)) {
       return (p_lcb);
     }
@@ -2362,7 +2362,7 @@ bool l2cu_lcb_disconnecting(void) {
 
   p_lcb = &l2cb.lcb_pool[0];
 
-  for (i = 0; i < MAX_L2CAP_LINKS; i++, p_lcb++) {
+  for (i = 0; i < l2cb.max_links; i++, p_lcb++) {
     if (p_lcb->in_use) {
       /* no ccbs on lcb, or lcb is in disconnecting state */
       if ((!p_lcb->ccb_queue.p_first_ccb) ||
@@ -2498,7 +2498,7 @@ void l2cu_resubmit_pending_sec_req(const RawAddress* p_bda) {
     }
   } else {
     /* No BDA pasesed in, so check all links */
-    for (xx = 0, p_lcb = &l2cb.lcb_pool[0]; xx < MAX_L2CAP_LINKS;
+    for (xx = 0, p_lcb = &l2cb.lcb_pool[0]; xx < l2cb.max_links;
          xx++, p_lcb++) {
       if (p_lcb->in_use) {
         /* For all channels, send the event through their FSMs */
@@ -3093,19 +3093,42 @@ void l2cu_send_peer_ble_credit_based_disconn_req(tL2C_CCB* p_ccb) {
  *
  ******************************************************************************/
 tL2C_LCB* l2cu_find_lcb_by_handle(uint16_t handle) {
-  int xx;
-  tL2C_LCB* p_lcb = &l2cb.lcb_pool[0];
+  if (l2cb.lcb_by_handle == NULL || handle > HCI_DATA_HANDLE_MASK) return NULL;
 
-  for (xx = 0; xx < MAX_L2CAP_LINKS; xx++, p_lcb++) {
-    if ((p_lcb->in_use) && (p_lcb->handle == handle)) {
-      return (p_lcb);
-    }
+  uint8_t index = l2cb.lcb_by_handle[handle];
+  if (index == 0) return NULL;
+
+  tL2C_LCB* p_lcb = &l2cb.lcb_pool[index - 1];
+  if ((p_lcb->in_use) && (p_lcb->handle == handle)) {
+    return (p_lcb);
   }
 
   /* If here, no match found */
   return (NULL);
 }
 
+/*******************************************************************************
+ *
+ * Function         l2cu_set_lcb_handle
+ *
+ * Description      Set the HCI handle of an LCB and keep the handle lookup
+ *                  table in step. All handle assignments go through here.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void l2cu_set_lcb_handle(tL2C_LCB* p_lcb, uint16_t handle) {
+  uint8_t index = (uint8_t)(p_lcb - l2cb.lcb_pool) + 1;
+
+  if (p_lcb->handle <= HCI_DATA_HANDLE_MASK &&
+      l2cb.lcb_by_handle[p_lcb->handle] == index)
+    l2cb.lcb_by_handle[p_lcb->handle] = 0;
+
+  p_lcb->handle = handle;
+
+  if (handle <= HCI_DATA_HANDLE_MASK) l2cb.lcb_by_handle[handle] = index;
+}
+
 /*******************************************************************************
  *
  * Function         l2cu_find_ccb_by_cid
@@ -3127,7 +3150,7 @@ tL2C_CCB* l2cu_find_ccb_by_cid(tL2C_LCB* p_lcb, uint16_t local_cid) {
     /* find the associated CCB by "index" */
     local_cid -= L2CAP_BASE_APPL_CID;
 
-    if (local_cid >= MAX_L2CAP_CHANNELS) return NULL;
+    if (local_cid >= l2cb.max_channels) return NULL;
 
     p_ccb = l2cb.ccb_pool + local_cid;
 
@@ -3144,14 +3167,14 @@ tL2C_CCB* l2cu_find_ccb_by_cid(tL2C_LCB* p_lcb, uint16_t local_cid) {
   else {
     /* searching fixed channel */
     p_ccb = l2cb.ccb_pool;
-    for (xx = 0; xx < MAX_L2CAP_CHANNELS; xx++) {
+    for (xx = 0; xx < l2cb.max_channels; xx++) {
       if ((p_ccb->local_cid == local_cid) && (p_ccb->in_use) &&
           (p_lcb == p_ccb->p_lcb))
         break;
       else
         p_ccb++;
     }
-    if (xx >= MAX_L2CAP_CHANNELS) return NULL;
+    if (xx >= l2cb.max_channels) return NULL;
   }
 #endif
 
@@ -26,6 +26,7 @@
 
 #include <base/logging.h>
 #include <string.h>
+#include <sys/uio.h>
 
 #include "osi/include/log.h"
 #include "osi/include/mutex.h"
@@ -1519,9 +1520,7 @@ int PORT_WriteDataCO(uint16_t handle, int* p_len) {
 
   mutex_global_unlock();
 
-  // int max_read = length < p_port->peer_mtu ? length : p_port->peer_mtu;
-
-  // max_read = available < max_read ? available : max_read;
+  if (p_port->peer_mtu < length) length = p_port->peer_mtu;
 
   while (available) {
     /* if we're over buffer high water mark, we're done */
@@ -1536,41 +1535,68 @@ int PORT_WriteDataCO(uint16_t handle, int* p_len) {
       break;
     }
 
-    /* continue with rfcomm data write */
-    p_buf = (BT_HDR*)osi_malloc(RFCOMM_DATA_BUF_SIZE);
-    p_buf->offset = L2CAP_MIN_OFFSET + RFCOMM_MIN_OFFSET;
-    p_buf->layer_specific = handle;
-
-    if (p_port->peer_mtu < length) length = p_port->peer_mtu;
-    if (available < (int)length) length = (uint16_t)available;
-    p_buf->len = length;
-    p_buf->event = BT_EVT_TO_BTU_SP_DATA;
-
-    // memcpy ((uint8_t *)(p_buf + 1) + p_buf->offset, p_data, length);
-    // if(recv(fd, (uint8_t *)(p_buf + 1) + p_buf->offset, (int)length, 0) !=
-    // (int)length)
-    if (p_port->p_data_co_callback(
-            handle, (uint8_t*)(p_buf + 1) + p_buf->offset, length,
-            DATA_CO_CALLBACK_TYPE_OUTGOING) == false) {
+    /* Allocate up to PORT_TX_CO_BATCH buffers of one frame each, as long as
+     * they keep the queue within its high water marks, and fill them all
+     * with a single read from the application. */
+    BT_HDR* bufs[PORT_TX_CO_BATCH];
+    struct iovec iov[PORT_TX_CO_BATCH];
+    int count = 0;
+    int batch_len = 0;
+    do {
+      uint16_t len = length;
+      if (available - batch_len < (int)len) len = available - batch_len;
+
+      p_buf = (BT_HDR*)osi_malloc(RFCOMM_DATA_BUF_SIZE);
+      p_buf->offset = L2CAP_MIN_OFFSET + RFCOMM_MIN_OFFSET;
+      p_buf->layer_specific = handle;
+      p_buf->len = len;
+      p_buf->event = BT_EVT_TO_BTU_SP_DATA;
+
+      bufs[count] = p_buf;
+      iov[count].iov_base = (uint8_t*)(p_buf + 1) + p_buf->offset;
+      iov[count].iov_len = len;
+      count++;
+      batch_len += len;
+    } while (count < PORT_TX_CO_BATCH && batch_len < available &&
+             p_port->tx.queue_size + batch_len <= PORT_TX_HIGH_WM &&
+             (int)fixed_queue_length(p_port->tx.queue) + count <=
+                 PORT_TX_BUF_HIGH_WM);
+
+    if (p_port->p_data_co_callback(handle, (uint8_t*)iov, count,
+                                   DATA_CO_CALLBACK_TYPE_OUTGOING_IOV) ==
+        false) {
       error(
-          "p_data_co_callback DATA_CO_CALLBACK_TYPE_OUTGOING failed, length:%d",
-          length);
+          "p_data_co_callback DATA_CO_CALLBACK_TYPE_OUTGOING_IOV failed, "
+          "length:%d",
+          batch_len);
+      for (int i = 0; i < count; i++) osi_free(bufs[i]);
       return (PORT_UNKNOWN_ERROR);
     }
 
-    RFCOMM_TRACE_EVENT("PORT_WriteData %d bytes", length);
+    RFCOMM_TRACE_EVENT("PORT_WriteData %d bytes in %d buffers", batch_len,
+                       count);
 
-    rc = port_write(p_port, p_buf);
+    int i;
+    for (i = 0; i < count; i++) {
+      uint16_t len = bufs[i]->len;
+      rc = port_write(p_port, bufs[i]);
 
-    /* If queue went below the threashold need to send flow control */
-    event |= port_flow_control_user(p_port);
+      /* If queue went below the threashold need to send flow control */
+      event |= port_flow_control_user(p_port);
 
-    if (rc == PORT_SUCCESS) event |= PORT_EV_TXCHAR;
+      if (rc == PORT_SUCCESS) event |= PORT_EV_TXCHAR;
 
-    if ((rc != PORT_SUCCESS) && (rc != PORT_CMD_PENDING)) break;
+      if ((rc != PORT_SUCCESS) && (rc != PORT_CMD_PENDING)) break;
 
-    *p_len += length;
-    available -= (int)length;
+      *p_len += len;
+      available -= (int)len;
+    }
+    if (i < count) {
+      /* The port is closed or its queue overflowed: like the buffer that
+       * failed, the rest of the batch is dropped. */
+      for (i++; i < count; i++) osi_free(bufs[i]);
+      break;
+    }
   }
   if (!available && (rc != PORT_CMD_PENDING) && (rc != PORT_TX_QUEUE_DISABLED))
     event |= PORT_EV_TXEMPTY;
@@ -26,6 +26,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <array>
+#include <vector>
 #include "p_256_multprecision.h"
 
 elliptic_curve_t curve;
@@ -246,6 +248,283 @@ void ECC_PointMult_Bin_NAF(Point* q, Point* p, uint32_t* n,
   multiprecision_mersenns_mult_mod(q->y, q->y, q->z, keyLength);
 }
 
+/*******************************************************************************
+ *
+ *  Constant time point multiplication on 64-bit limbs, with the complete
+ *  projective formulas for a = -3 of Renes, Costello and Batina, which need no
+ *  special case for the point at infinity (0:1:0) or for doubling.
+ *
+ ******************************************************************************/
+
+typedef struct {
+  uint64_t x[KEY_LENGTH_QWORDS_P256];
+  uint64_t y[KEY_LENGTH_QWORDS_P256];
+  uint64_t z[KEY_LENGTH_QWORDS_P256];
+} MontPoint;
+
+typedef struct {
+  uint64_t x[KEY_LENGTH_QWORDS_P256];
+  uint64_t y[KEY_LENGTH_QWORDS_P256];
+} MontAffinePoint;
+
+#define ECC_WINDOW_BITS 4
+#define ECC_WINDOW_SIZE (1 << ECC_WINDOW_BITS)
+#define ECC_NUM_WINDOWS (256 / ECC_WINDOW_BITS)
+
+static const uint64_t* p_256_mont_b(void) {
+  static const struct MontB {
+    uint64_t v[KEY_LENGTH_QWORDS_P256];
+    MontB() {
+      const uint32_t b[KEY_LENGTH_DWORDS_P256] = {
+          0x27d2604b, 0x3bce3c3e, 0xcc53b0f6, 0x651d06b0,
+          0x769886bc, 0xb3ebbd55, 0xaa3a93e7, 0x5ac635d8};
+      p_256_mont_from_dwords(v, b);
+    }
+  } b;
+  return b.v;
+}
+
+static void p_256_mont_init_infinity(MontPoint* q) {
+  memset(q, 0, sizeof(MontPoint));
+  memcpy(q->y, p_256_mont_one, sizeof(q->y));
+}
+
+static void p_256_mont_from_point(MontPoint* q, const Point* p) {
+  p_256_mont_from_dwords(q->x, p->x);
+  p_256_mont_from_dwords(q->y, p->y);
+  memcpy(q->z, p_256_mont_one, sizeof(q->z));
+}
+
+// q = p in affine coordinates, (0, 0) for the point at infinity
+static void p_256_mont_to_point(Point* q, const MontPoint* p) {
+  uint64_t zinv[KEY_LENGTH_QWORDS_P256];
+  uint64_t t[KEY_LENGTH_QWORDS_P256];
+
+  p_256_mont_inv(zinv, p->z);
+  p_256_mont_mult(t, p->x, zinv);
+  p_256_mont_to_dwords(q->x, t);
+  p_256_mont_mult(t, p->y, zinv);
+  p_256_mont_to_dwords(q->y, t);
+  multiprecision_init(q->z, KEY_LENGTH_DWORDS_P256);
+  q->z[0] = 1;
+}
+
+// r = p + q
+static void ECC_Mont_Add(MontPoint* r, const MontPoint* p, const MontPoint* q) {
+  const uint64_t* b = p_256_mont_b();
+  uint64_t t0[KEY_LENGTH_QWORDS_P256], t1[KEY_LENGTH_QWORDS_P256];
+  uint64_t t2[KEY_LENGTH_QWORDS_P256], t3[KEY_LENGTH_QWORDS_P256];
+  uint64_t t4[KEY_LENGTH_QWORDS_P256];
+  uint64_t x3[KEY_LENGTH_QWORDS_P256], y3[KEY_LENGTH_QWORDS_P256];
+  uint64_t z3[KEY_LENGTH_QWORDS_P256];
+
+  p_256_mont_mult(t0, p->x, q->x);  // t0=x1*x2
+  p_256_mont_mult(t1, p->y, q->y);  // t1=y1*y2
+  p_256_mont_mult(t2, p->z, q->z);  // t2=z1*z2
+  p_256_mont_add(t3, p->x, p->y);   // t3=x1+y1
+  p_256_mont_add(t4, q->x, q->y);   // t4=x2+y2
+  p_256_mont_mult(t3, t3, t4);      // t3=t3*t4
+  p_256_mont_add(t4, t0, t1);       // t4=t0+t1
+  p_256_mont_sub(t3, t3, t4);       // t3=t3-t4
+  p_256_mont_add(t4, p->y, p->z);   // t4=y1+z1
+  p_256_mont_add(x3, q->y, q->z);   // x3=y2+z2
+  p_256_mont_mult(t4, t4, x3);      // t4=t4*x3
+  p_256_mont_add(x3, t1, t2);       // x3=t1+t2
+  p_256_mont_sub(t4, t4, x3);       // t4=t4-x3
+  p_256_mont_add(x3, p->x, p->z);   // x3=x1+z1
+  p_256_mont_add(y3, q->x, q->z);   // y3=x2+z2
+  p_256_mont_mult(x3, x3, y3);      // x3=x3*y3
+  p_256_mont_add(y3, t0, t2);       // y3=t0+t2
+  p_256_mont_sub(y3, x3, y3);       // y3=x3-y3
+  p_256_mont_mult(z3, b, t2);       // z3=b*t2
+  p_256_mont_sub(x3, y3, z3);       // x3=y3-z3
+  p_256_mont_add(z3, x3, x3);       // z3=x3+x3
+  p_256_mont_add(x3, x3, z3);       // x3=x3+z3
+  p_256_mont_sub(z3, t1, x3);       // z3=t1-x3
+  p_256_mont_add(x3, t1, x3);       // x3=t1+x3
+  p_256_mont_mult(y3, b, y3);       // y3=b*y3
+  p_256_mont_add(t1, t2, t2);       // t1=t2+t2
+  p_256_mont_add(t2, t1, t2);       // t2=t1+t2
+  p_256_mont_sub(y3, y3, t2);       // y3=y3-t2
+  p_256_mont_sub(y3, y3, t0);       // y3=y3-t0
+  p_256_mont_add(t1, y3, y3);       // t1=y3+y3
+  p_256_mont_add(y3, t1, y3);       // y3=t1+y3
+  p_256_mont_add(t1, t0, t0);       // t1=t0+t0
+  p_256_mont_add(t0, t1, t0);       // t0=t1+t0
+  p_256_mont_sub(t0, t0, t2);       // t0=t0-t2
+  p_256_mont_mult(t1, t4, y3);      // t1=t4*y3
+  p_256_mont_mult(t2, t0, y3);      // t2=t0*y3
+  p_256_mont_mult(y3, x3, z3);      // y3=x3*z3
+  p_256_mont_add(y3, y3, t2);       // y3=y3+t2
+  p_256_mont_mult(x3, t3, x3);      // x3=t3*x3
+  p_256_mont_sub(x3, x3, t1);       // x3=x3-t1
+  p_256_mont_mult(z3, t4, z3);      // z3=t4*z3
+  p_256_mont_mult(t1, t3, t0);      // t1=t3*t0
+  p_256_mont_add(z3, z3, t1);       // z3=z3+t1
+
+  memcpy(r->x, x3, sizeof(x3));
+  memcpy(r->y, y3, sizeof(y3));
+  memcpy(r->z, z3, sizeof(z3));
+}
+
+// r = 2p
+static void ECC_Mont_Double(MontPoint* r, const MontPoint* p) {
+  const uint64_t* b = p_256_mont_b();
+  uint64_t t0[KEY_LENGTH_QWORDS_P256], t1[KEY_LENGTH_QWORDS_P256];
+  uint64_t t2[KEY_LENGTH_QWORDS_P256], t3[KEY_LENGTH_QWORDS_P256];
+  uint64_t x3[KEY_LENGTH_QWORDS_P256], y3[KEY_LENGTH_QWORDS_P256];
+  uint64_t z3[KEY_LENGTH_QWORDS_P256];
+
+  p_256_mont_squa(t0, p->x);        // t0=x^2
+  p_256_mont_squa(t1, p->y);        // t1=y^2
+  p_256_mont_squa(t2, p->z);        // t2=z^2
+  p_256_mont_mult(t3, p->x, p->y);  // t3=x*y
+  p_256_mont_add(t3, t3, t3);       // t3=t3+t3
+  p_256_mont_mult(z3, p->x, p->z);  // z3=x*z
+  p_256_mont_add(z3, z3, z3);       // z3=z3+z3
+  p_256_mont_mult(y3, b, t2);       // y3=b*t2
+  p_256_mont_sub(y3, y3, z3);       // y3=y3-z3
+  p_256_mont_add(x3, y3, y3);       // x3=y3+y3
+  p_256_mont_add(y3, x3, y3);       // y3=x3+y3
+  p_256_mont_sub(x3, t1, y3);       // x3=t1-y3
+  p_256_mont_add(y3, t1, y3);       // y3=t1+y3
+  p_256_mont_mult(y3, x3, y3);      // y3=x3*y3
+  p_256_mont_mult(x3, x3, t3);      // x3=x3*t3
+  p_256_mont_add(t3, t2, t2);       // t3=t2+t2
+  p_256_mont_add(t2, t2, t3);       // t2=t2+t3
+  p_256_mont_mult(z3, b, z3);       // z3=b*z3
+  p_256_mont_sub(z3, z3, t2);       // z3=z3-t2
+  p_256_mont_sub(z3, z3, t0);       // z3=z3-t0
+  p_256_mont_add(t3, z3, z3);       // t3=z3+z3
+  p_256_mont_add(z3, z3, t3);       // z3=z3+t3
+  p_256_mont_add(t3, t0, t0);       // t3=t0+t0
+  p_256_mont_add(t0, t3, t0);       // t0=t3+t0
+  p_256_mont_sub(t0, t0, t2);       // t0=t0-t2
+  p_256_mont_mult(t0, t0, z3);      // t0=t0*z3
+  p_256_mont_add(y3, y3, t0);       // y3=y3+t0
+  p_256_mont_mult(t0, p->y, p->z);  // t0=y*z
+  p_256_mont_add(t0, t0, t0);       // t0=t0+t0
+  p_256_mont_mult(z3, t0, z3);      // z3=t0*z3
+  p_256_mont_sub(x3, x3, z3);       // x3=x3-z3
+  p_256_mont_mult(z3, t0, t1);      // z3=t0*t1
+  p_256_mont_add(z3, z3, z3);       // z3=z3+z3
+  p_256_mont_add(z3, z3, z3);       // z3=z3+z3
+
+  memcpy(r->x, x3, sizeof(x3));
+  memcpy(r->y, y3, sizeof(y3));
+  memcpy(r->z, z3, sizeof(z3));
+}
+
+// all ones if a == b, zero otherwise
+static uint64_t ECC_Mask_Equal(uint32_t a, uint32_t b) {
+  uint64_t d = a ^ b;
+  return 0 - ((d - 1) >> 63);
+}
+
+// window |i| of scalar |n|, counted from the least significant
+static uint32_t ECC_Window(const uint32_t* n, int i) {
+  int bit = i * ECC_WINDOW_BITS;
+  return (n[bit / 32] >> (bit % 32)) & (ECC_WINDOW_SIZE - 1);
+}
+
+// The multiples j*16^i*G for j in 1..15 of every window i, in affine form
+static const MontAffinePoint* ECC_Base_Table(void) {
+  static const struct BaseTable {
+    MontAffinePoint entries[ECC_NUM_WINDOWS][ECC_WINDOW_SIZE - 1];
+
+    BaseTable() {
+      const int num = ECC_NUM_WINDOWS * (ECC_WINDOW_SIZE - 1);
+      std::vector<MontPoint> points(num);
+      MontPoint base;
+
+      p_256_init_curve(KEY_LENGTH_DWORDS_P256);
+      p_256_mont_from_point(&base, &curve_p256.G);
+      for (int i = 0; i < ECC_NUM_WINDOWS; i++) {
+        MontPoint* row = &points[i * (ECC_WINDOW_SIZE - 1)];
+        row[0] = base;
+        for (int j = 1; j < ECC_WINDOW_SIZE - 1; j++)
+          ECC_Mont_Add(&row[j], &row[j - 1], &base);
+        ECC_Mont_Add(&base, &row[ECC_WINDOW_SIZE - 2], &base);
+      }
+
+      // invert all z at the cost of one inversion
+      std::vector<std::array<uint64_t, KEY_LENGTH_QWORDS_P256>> prod(num);
+      uint64_t acc[KEY_LENGTH_QWORDS_P256];
+      uint64_t inv[KEY_LENGTH_QWORDS_P256];
+      memcpy(acc, p_256_mont_one, sizeof(acc));
+      for (int k = 0; k < num; k++) {
+        memcpy(prod[k].data(), acc, sizeof(acc));
+        p_256_mont_mult(acc, acc, points[k].z);
+      }
+      p_256_mont_inv(inv, acc);
+      for (int k = num - 1; k >= 0; k--) {
+        uint64_t zinv[KEY_LENGTH_QWORDS_P256];
+        p_256_mont_mult(zinv, inv, prod[k].data());
+        p_256_mont_mult(inv, inv, points[k].z);
+
+        MontAffinePoint* e = &entries[0][0] + k;
+        p_256_mont_mult(e->x, points[k].x, zinv);
+        p_256_mont_mult(e->y, points[k].y, zinv);
+      }
+    }
+  } table;
+  return &table.entries[0][0];
+}
+
+// Constant time fixed-base point multiplication, q = n*G
+void ECC_PointMult_Base(Point* q, const uint32_t* n) {
+  const MontAffinePoint* table = ECC_Base_Table();
+  MontPoint r;
+  MontPoint t;
+
+  p_256_mont_init_infinity(&r);
+  for (int i = 0; i < ECC_NUM_WINDOWS; i++) {
+    uint32_t w = ECC_Window(n, i);
+    const MontAffinePoint* row = &table[i * (ECC_WINDOW_SIZE - 1)];
+
+    // look at every entry, so that the window does not show in the cache
+    p_256_mont_init_infinity(&t);
+    for (uint32_t j = 1; j < ECC_WINDOW_SIZE; j++) {
+      uint64_t mask = ECC_Mask_Equal(w, j);
+      p_256_mont_select(t.x, row[j - 1].x, mask);
+      p_256_mont_select(t.y, row[j - 1].y, mask);
+      p_256_mont_select(t.z, p_256_mont_one, mask);
+    }
+    ECC_Mont_Add(&r, &r, &t);
+  }
+
+  p_256_mont_to_point(q, &r);
+}
+
+// Constant time point multiplication with a fixed window, q = n*p
+void ECC_PointMult_Window(Point* q, const Point* p, const uint32_t* n) {
+  MontPoint table[ECC_WINDOW_SIZE];
+  MontPoint r;
+  MontPoint t;
+
+  p_256_mont_init_infinity(&table[0]);
+  p_256_mont_from_point(&table[1], p);
+  for (int j = 2; j < ECC_WINDOW_SIZE; j++)
+    ECC_Mont_Add(&table[j], &table[j - 1], &table[1]);
+
+  p_256_mont_init_infinity(&r);
+  for (int i = ECC_NUM_WINDOWS - 1; i >= 0; i--) {
+    for (int k = 0; k < ECC_WINDOW_BITS; k++) ECC_Mont_Double(&r, &r);
+
+    uint32_t w = ECC_Window(n, i);
+    p_256_mont_init_infinity(&t);
+    for (uint32_t j = 0; j < ECC_WINDOW_SIZE; j++) {
+      uint64_t mask = ECC_Mask_Equal(w, j);
+      p_256_mont_select(t.x, table[j].x, mask);
+      p_256_mont_select(t.y, table[j].y, mask);
+      p_256_mont_select(t.z, table[j].z, mask);
+    }
+    ECC_Mont_Add(&r, &r, &t);
+  }
+
+  p_256_mont_to_point(q, &r);
+}
+
 bool ECC_ValidatePoint(const Point& pt) {
   const size_t kl = KEY_LENGTH_DWORDS_P256;
   p_256_init_curve(kl);
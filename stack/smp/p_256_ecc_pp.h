@@ -60,6 +60,12 @@ bool ECC_ValidatePoint(const Point& p);
 
 void ECC_PointMult_Bin_NAF(Point* q, Point* p, uint32_t* n, uint32_t keyLength);
 
+/* Constant time P-256 point multiplications on 64-bit limbs, q = n*G with a
+ * table of multiples of G built on first use and q = n*p with a 4-bit window.
+ * Unlike ECC_PointMult_Bin_NAF they leave |n| untouched. */
+void ECC_PointMult_Base(Point* q, const uint32_t* n);
+void ECC_PointMult_Window(Point* q, const Point* p, const uint32_t* n);
+
 #define ECC_PointMult(q, p, n, keyLength) \
   ECC_PointMult_Bin_NAF(q, p, n, keyLength)
 
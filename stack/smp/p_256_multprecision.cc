@@ -616,3 +616,205 @@ void multiprecision_inv_mod(uint32_t* aminus, uint32_t* u, uint32_t keyLength) {
   else
     multiprecision_copy(aminus, C, keyLength);
 }
+
+/*******************************************************************************
+ *
+ *  P-256 field arithmetic on 64-bit limbs in the Montgomery domain, R = 2^256.
+ *  None of these branch on or index memory with the values they work on.
+ *
+ ******************************************************************************/
+
+static const uint64_t p_256_mont_p[KEY_LENGTH_QWORDS_P256] = {
+    0xFFFFFFFFFFFFFFFF, 0x00000000FFFFFFFF, 0x0000000000000000,
+    0xFFFFFFFF00000001};
+
+// R^2 mod p, to bring values into the Montgomery domain
+static const uint64_t p_256_mont_rr[KEY_LENGTH_QWORDS_P256] = {
+    0x0000000000000003, 0xFFFFFFFBFFFFFFFF, 0xFFFFFFFFFFFFFFFE,
+    0x00000004FFFFFFFD};
+
+// R mod p, 1 in the Montgomery domain
+const uint64_t p_256_mont_one[KEY_LENGTH_QWORDS_P256] = {
+    0x0000000000000001, 0xFFFFFFFF00000000, 0xFFFFFFFFFFFFFFFF,
+    0x00000000FFFFFFFE};
+
+// returns the low half of a*b+c+carry, the high half goes to carry
+static inline uint64_t p_256_mac(uint64_t a, uint64_t b, uint64_t c,
+                                 uint64_t* carry) {
+#if defined(__SIZEOF_INT128__)
+  unsigned __int128 t = (unsigned __int128)a * b + c + *carry;
+  *carry = (uint64_t)(t >> 64);
+  return (uint64_t)t;
+#else
+  uint64_t a_lo = (uint32_t)a, a_hi = a >> 32;
+  uint64_t b_lo = (uint32_t)b, b_hi = b >> 32;
+  uint64_t ll = a_lo * b_lo, lh = a_lo * b_hi;
+  uint64_t hl = a_hi * b_lo, hh = a_hi * b_hi;
+  uint64_t mid = (ll >> 32) + (uint32_t)lh + (uint32_t)hl;
+  uint64_t lo = (mid << 32) | (uint32_t)ll;
+  uint64_t hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+  lo += c;
+  hi += lo < c;
+  lo += *carry;
+  hi += lo < *carry;
+  *carry = hi;
+  return lo;
+#endif
+}
+
+// returns a+b+carry, the carry out goes to carry
+static inline uint64_t p_256_adc(uint64_t a, uint64_t b, uint64_t* carry) {
+  uint64_t t = a + *carry;
+  uint64_t c = t < *carry;
+  t += b;
+  c += t < b;
+  *carry = c;
+  return t;
+}
+
+// returns a-b-borrow, the borrow out goes to borrow
+static inline uint64_t p_256_sbb(uint64_t a, uint64_t b, uint64_t* borrow) {
+  uint64_t t = a - b;
+  uint64_t bo = a < b;
+  uint64_t r = t - *borrow;
+  bo |= t < *borrow;
+  *borrow = bo;
+  return r;
+}
+
+// c = (hi:a) mod p, for (hi:a) < 2p
+static void p_256_mont_reduce_once(uint64_t* c, const uint64_t* a,
+                                   uint64_t hi) {
+  uint64_t s[KEY_LENGTH_QWORDS_P256];
+  uint64_t borrow = 0;
+  for (int i = 0; i < KEY_LENGTH_QWORDS_P256; i++)
+    s[i] = p_256_sbb(a[i], p_256_mont_p[i], &borrow);
+  p_256_sbb(hi, 0, &borrow);
+
+  // keep a if subtracting p went below zero
+  uint64_t keep = 0 - borrow;
+  for (int i = 0; i < KEY_LENGTH_QWORDS_P256; i++)
+    c[i] = (a[i] & keep) | (s[i] & ~keep);
+}
+
+void p_256_mont_add(uint64_t* c, const uint64_t* a, const uint64_t* b) {
+  uint64_t t[KEY_LENGTH_QWORDS_P256];
+  uint64_t carry = 0;
+  for (int i = 0; i < KEY_LENGTH_QWORDS_P256; i++)
+    t[i] = p_256_adc(a[i], b[i], &carry);
+  p_256_mont_reduce_once(c, t, carry);
+}
+
+void p_256_mont_sub(uint64_t* c, const uint64_t* a, const uint64_t* b) {
+  uint64_t t[KEY_LENGTH_QWORDS_P256];
+  uint64_t borrow = 0;
+  for (int i = 0; i < KEY_LENGTH_QWORDS_P256; i++)
+    t[i] = p_256_sbb(a[i], b[i], &borrow);
+
+  // add p back if a < b
+  uint64_t mask = 0 - borrow;
+  uint64_t carry = 0;
+  for (int i = 0; i < KEY_LENGTH_QWORDS_P256; i++)
+    c[i] = p_256_adc(t[i], p_256_mont_p[i] & mask, &carry);
+}
+
+// c = a*b/R mod p, for a*b < 2^256*p. Since p = -1 mod 2^64, the Montgomery
+// factor of every round is the lowest limb itself, and with p[0] = 2^64-1 and
+// p[2] = 0 adding it times p takes two multiplications.
+void p_256_mont_mult(uint64_t* c, const uint64_t* a, const uint64_t* b) {
+  uint64_t t[KEY_LENGTH_QWORDS_P256 + 2] = {0};
+
+  for (int i = 0; i < KEY_LENGTH_QWORDS_P256; i++) {
+    uint64_t carry = 0;
+    for (int j = 0; j < KEY_LENGTH_QWORDS_P256; j++)
+      t[j] = p_256_mac(a[j], b[i], t[j], &carry);
+    uint64_t c2 = 0;
+    t[4] = p_256_adc(t[4], carry, &c2);
+    t[5] = c2;
+
+    // t = (t + m*p) / 2^64, where t[0] + m*p[0] = m*2^64
+    uint64_t m = t[0];
+    carry = m;
+    t[0] = p_256_mac(m, p_256_mont_p[1], t[1], &carry);
+    c2 = 0;
+    t[1] = p_256_adc(t[2], carry, &c2);
+    carry = c2;
+    t[2] = p_256_mac(m, p_256_mont_p[3], t[3], &carry);
+    c2 = 0;
+    t[3] = p_256_adc(t[4], carry, &c2);
+    t[4] = t[5] + c2;
+  }
+
+  p_256_mont_reduce_once(c, t, t[4]);
+}
+
+void p_256_mont_squa(uint64_t* c, const uint64_t* a) {
+  p_256_mont_mult(c, a, a);
+}
+
+// c = a squared n times
+static void p_256_mont_squa_n(uint64_t* c, const uint64_t* a, int n) {
+  p_256_mont_squa(c, a);
+  while (--n > 0) p_256_mont_squa(c, c);
+}
+
+// c = a^-1 = a^(p-2) mod p, with an addition chain of 255 squarings and 12
+// multiplications
+void p_256_mont_inv(uint64_t* c, const uint64_t* a) {
+  uint64_t x3[KEY_LENGTH_QWORDS_P256];
+  uint64_t x6[KEY_LENGTH_QWORDS_P256];
+  uint64_t x15[KEY_LENGTH_QWORDS_P256];
+  uint64_t x32[KEY_LENGTH_QWORDS_P256];
+  uint64_t x47[KEY_LENGTH_QWORDS_P256];
+  uint64_t t[KEY_LENGTH_QWORDS_P256];
+
+  // xn = a^(2^n - 1)
+  p_256_mont_squa(t, a);
+  p_256_mont_mult(t, t, a);  // x2
+  p_256_mont_squa(t, t);
+  p_256_mont_mult(x3, t, a);
+  p_256_mont_squa_n(t, x3, 3);
+  p_256_mont_mult(x6, t, x3);
+  p_256_mont_squa_n(t, x6, 6);
+  p_256_mont_mult(t, t, x6);  // x12
+  p_256_mont_squa_n(t, t, 3);
+  p_256_mont_mult(x15, t, x3);
+  p_256_mont_squa(t, x15);
+  p_256_mont_mult(t, t, a);  // x16
+  p_256_mont_squa_n(x32, t, 16);
+  p_256_mont_mult(x32, x32, t);
+
+  p_256_mont_squa_n(t, x32, 15);
+  p_256_mont_mult(x47, t, x15);
+  p_256_mont_squa_n(t, t, 17);
+  p_256_mont_mult(t, t, a);
+  p_256_mont_squa_n(t, t, 143);
+  p_256_mont_mult(t, t, x47);
+  p_256_mont_squa_n(t, t, 47);
+  p_256_mont_mult(t, t, x47);
+  p_256_mont_squa_n(t, t, 2);
+  p_256_mont_mult(c, t, a);
+}
+
+// c = a if mask is all ones, left alone if zero
+void p_256_mont_select(uint64_t* c, const uint64_t* a, uint64_t mask) {
+  for (int i = 0; i < KEY_LENGTH_QWORDS_P256; i++)
+    c[i] = (a[i] & mask) | (c[i] & ~mask);
+}
+
+void p_256_mont_from_dwords(uint64_t* c, const uint32_t* a) {
+  uint64_t t[KEY_LENGTH_QWORDS_P256];
+  for (int i = 0; i < KEY_LENGTH_QWORDS_P256; i++)
+    t[i] = (uint64_t)a[2 * i] | ((uint64_t)a[2 * i + 1] << 32);
+  p_256_mont_mult(c, t, p_256_mont_rr);
+}
+
+void p_256_mont_to_dwords(uint32_t* c, const uint64_t* a) {
+  uint64_t one[KEY_LENGTH_QWORDS_P256] = {1, 0, 0, 0};
+  uint64_t t[KEY_LENGTH_QWORDS_P256];
+  p_256_mont_mult(t, a, one);
+  for (int i = 0; i < KEY_LENGTH_QWORDS_P256; i++) {
+    c[2 * i] = (uint32_t)t[i];
+    c[2 * i + 1] = (uint32_t)(t[i] >> 32);
+  }
+}
@@ -66,3 +66,19 @@ void multiprecision_mult(uint32_t* c, uint32_t* a, uint32_t* b,
                          uint32_t keyLength);
 void multiprecision_fast_mod(uint32_t* c, uint32_t* a);
 void multiprecision_fast_mod_P256(uint32_t* c, uint32_t* a);
+
+/* P-256 field arithmetic on 64-bit limbs in the Montgomery domain, running
+ * in constant time */
+
+#define KEY_LENGTH_QWORDS_P256 4
+
+extern const uint64_t p_256_mont_one[KEY_LENGTH_QWORDS_P256];
+
+void p_256_mont_add(uint64_t* c, const uint64_t* a, const uint64_t* b);
+void p_256_mont_sub(uint64_t* c, const uint64_t* a, const uint64_t* b);
+void p_256_mont_mult(uint64_t* c, const uint64_t* a, const uint64_t* b);
+void p_256_mont_squa(uint64_t* c, const uint64_t* a);
+void p_256_mont_inv(uint64_t* c, const uint64_t* a);
+void p_256_mont_select(uint64_t* c, const uint64_t* a, uint64_t mask);
+void p_256_mont_from_dwords(uint64_t* c, const uint32_t* a);  // c=a*R mod p
+void p_256_mont_to_dwords(uint32_t* c, const uint64_t* a);    // c=a/R mod p
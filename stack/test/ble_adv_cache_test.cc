@@ -0,0 +1,135 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2018 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <list>
+#include <random>
+#include <vector>
+
+#include "btm_ble_adv_cache.h"
+
+namespace {
+
+RawAddress address(int i) {
+  RawAddress addr = RawAddress::kEmpty;
+  addr.address[4] = i >> 8;
+  addr.address[5] = i;
+  return addr;
+}
+
+const std::vector<uint8_t> kAdv = {0x02, 0x01, 0x06};
+const std::vector<uint8_t> kScanRsp = {0x03, 0x09, 'h', 'i'};
+
+}  // namespace
+
+TEST(AdvertisingCacheTest, ScanResponseIsAppended) {
+  AdvertisingCache cache(4);
+  cache.Set(0, address(1), kAdv.data(), kAdv.size());
+  const std::vector<uint8_t>& data =
+      cache.Append(0, address(1), kScanRsp.data(), kScanRsp.size());
+
+  std::vector<uint8_t> expected = kAdv;
+  expected.insert(expected.end(), kScanRsp.begin(), kScanRsp.end());
+  EXPECT_EQ(expected, data);
+  EXPECT_EQ(1u, cache.Size());
+
+  cache.Clear(0, address(1));
+  EXPECT_EQ(0u, cache.Size());
+  EXPECT_EQ(0u, cache.GetEvictions());
+  EXPECT_EQ(0u, cache.GetIncomplete());
+}
+
+TEST(AdvertisingCacheTest, AddressTypeIsPartOfTheKey) {
+  AdvertisingCache cache(4);
+  cache.Set(0, address(1), kAdv.data(), kAdv.size());
+  EXPECT_EQ(kScanRsp,
+            cache.Append(1, address(1), kScanRsp.data(), kScanRsp.size()));
+  EXPECT_EQ(2u, cache.Size());
+}
+
+TEST(AdvertisingCacheTest, NewAdvertisementRestartsData) {
+  AdvertisingCache cache(4);
+  cache.Set(0, address(1), kAdv.data(), kAdv.size());
+  EXPECT_EQ(kAdv, cache.Set(0, address(1), kAdv.data(), kAdv.size()));
+  EXPECT_EQ(1u, cache.GetIncomplete());
+
+  cache.ResetCounters();
+  EXPECT_EQ(0u, cache.GetIncomplete());
+}
+
+TEST(AdvertisingCacheTest, LeastRecentlyUpdatedIsEvicted) {
+  AdvertisingCache cache(3);
+  for (int i = 0; i < 3; i++)
+    cache.Set(0, address(i), kAdv.data(), kAdv.size());
+
+  // Device 0 gets its scan response, device 1 becomes the oldest.
+  cache.Append(0, address(0), kScanRsp.data(), kScanRsp.size());
+  cache.Set(0, address(3), kAdv.data(), kAdv.size());
+  EXPECT_EQ(3u, cache.Size());
+  EXPECT_EQ(1u, cache.GetEvictions());
+
+  EXPECT_EQ(kScanRsp,
+            cache.Append(0, address(1), kScanRsp.data(), kScanRsp.size()));
+  EXPECT_EQ(kAdv.size() + kScanRsp.size(),
+            cache.Append(0, address(0), nullptr, 0).size());
+}
+
+// Random traffic checked against a list kept in least recently updated
+// order, which exercises the removals from the hash table.
+TEST(AdvertisingCacheTest, MatchesReferenceModel) {
+  const size_t capacity = 16;
+  AdvertisingCache cache(capacity);
+  std::list<std::pair<int, std::vector<uint8_t>>> model;
+  std::mt19937 rng(1);
+
+  for (int i = 0; i < 20000; i++) {
+    int device = rng() % 40;
+    uint8_t byte = rng();
+    auto it = std::find_if(model.begin(), model.end(),
+                           [device](const std::pair<int, std::vector<uint8_t>>&
+                                        item) { return item.first == device; });
+
+    if (rng() % 4 == 0) {
+      cache.Clear(0, address(device));
+      if (it != model.end()) model.erase(it);
+      continue;
+    }
+
+    std::vector<uint8_t> expected;
+    if (it != model.end()) {
+      expected = it->second;
+      model.erase(it);
+    } else if (model.size() == capacity) {
+      model.pop_back();
+    }
+    expected.push_back(byte);
+    model.emplace_front(device, expected);
+
+    EXPECT_EQ(expected, cache.Append(0, address(device), &byte, 1));
+    ASSERT_EQ(model.size(), cache.Size());
+  }
+}
+
+TEST(AdvertisingCacheTest, CapacityIsClamped) {
+  AdvertisingCache cache(0);
+  EXPECT_EQ(1u, cache.Capacity());
+  cache.SetCapacity(AdvertisingCache::kMaxCapacity + 1);
+  EXPECT_EQ(AdvertisingCache::kMaxCapacity, cache.Capacity());
+}
@@ -0,0 +1,226 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2018 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "btm_ble_api.h"
+#include "btm_ble_host_filter.h"
+
+using bluetooth::Uuid;
+
+namespace {
+
+RawAddress address(int i) {
+  RawAddress addr = RawAddress::kEmpty;
+  addr.address[5] = i;
+  return addr;
+}
+
+#define BIT(x) (uint16_t)(1 << (x))
+
+const int8_t kRssi = -60;
+const int8_t kNoRssiThreshold = -128;
+
+/* Flags, 16 bit service UUIDs 0x180d and 0xfeaa, manufacturer data of
+ * company 0x004c, service data of UUID 0xfeaa, complete local name */
+const std::vector<uint8_t> kAdv = {
+    0x02, 0x01, 0x06, 0x05, 0x03, 0x0d, 0x18, 0xaa, 0xfe, 0x06, 0xff,
+    0x4c, 0x00, 0x02, 0x15, 0x01, 0x06, 0x16, 0xaa, 0xfe, 0x10, 0x20,
+    0x30, 0x06, 0x09, 'P',  'i',  'x',  'e',  'l'};
+
+ApcfCommand command(uint8_t type) {
+  ApcfCommand cmd = {};
+  cmd.type = type;
+  cmd.address = RawAddress::kEmpty;
+  cmd.uuid = Uuid::kEmpty;
+  cmd.uuid_mask = Uuid::kEmpty;
+  return cmd;
+}
+
+bool matches(const HostAdvFilter& filter, const RawAddress& bda,
+             const std::vector<uint8_t>& data, int8_t rssi = kRssi) {
+  return filter.Matches(bda, rssi, data.data(), data.size());
+}
+
+}  // namespace
+
+TEST(HostAdvFilterTest, DisabledDeliversEverything) {
+  HostAdvFilter filter(4);
+  EXPECT_TRUE(matches(filter, address(1), kAdv));
+
+  filter.SetEnabled(true);
+  EXPECT_FALSE(matches(filter, address(1), kAdv));
+
+  filter.Select(0, 0, 0, BTM_BLE_PF_LOGIC_AND, kNoRssiThreshold);
+  EXPECT_TRUE(matches(filter, address(1), kAdv));
+  EXPECT_EQ(3u, filter.NumAvailable());
+}
+
+TEST(HostAdvFilterTest, Address) {
+  HostAdvFilter filter(4);
+  filter.SetEnabled(true);
+  ApcfCommand cmd = command(BTM_BLE_PF_ADDR_FILTER);
+  cmd.address = address(1);
+  filter.AddConditions(0, {cmd});
+  filter.Select(0, BIT(BTM_BLE_PF_ADDR_FILTER), 0, BTM_BLE_PF_LOGIC_AND,
+                kNoRssiThreshold);
+
+  EXPECT_TRUE(matches(filter, address(1), kAdv));
+  EXPECT_FALSE(matches(filter, address(2), kAdv));
+}
+
+TEST(HostAdvFilterTest, ServiceUuid) {
+  HostAdvFilter filter(4);
+  filter.SetEnabled(true);
+  ApcfCommand heart_rate = command(BTM_BLE_PF_SRVC_UUID);
+  heart_rate.uuid = Uuid::From16Bit(0x180d);
+  ApcfCommand battery = command(BTM_BLE_PF_SRVC_UUID);
+  battery.uuid = Uuid::From16Bit(0x180f);
+  filter.AddConditions(0, {heart_rate});
+  filter.AddConditions(1, {battery});
+  filter.Select(1, BIT(BTM_BLE_PF_SRVC_UUID), 0, BTM_BLE_PF_LOGIC_AND,
+                kNoRssiThreshold);
+  EXPECT_FALSE(matches(filter, address(1), kAdv));
+
+  filter.Select(0, BIT(BTM_BLE_PF_SRVC_UUID), 0, BTM_BLE_PF_LOGIC_AND,
+                kNoRssiThreshold);
+  EXPECT_TRUE(matches(filter, address(1), kAdv));
+
+  /* Solicitation UUIDs are not service UUIDs */
+  filter.Clear(0);
+  ApcfCommand sol = command(BTM_BLE_PF_SRVC_SOL_UUID);
+  sol.uuid = Uuid::From16Bit(0x180d);
+  filter.AddConditions(0, {sol});
+  filter.Select(0, BIT(BTM_BLE_PF_SRVC_SOL_UUID), 0, BTM_BLE_PF_LOGIC_AND,
+                kNoRssiThreshold);
+  EXPECT_FALSE(matches(filter, address(1), kAdv));
+}
+
+TEST(HostAdvFilterTest, ServiceUuidMask) {
+  HostAdvFilter filter(4);
+  filter.SetEnabled(true);
+  ApcfCommand cmd = command(BTM_BLE_PF_SRVC_UUID);
+  cmd.uuid = Uuid::From16Bit(0x1800);
+  cmd.uuid_mask = Uuid::FromString("0000ff00-0000-0000-0000-000000000000");
+  filter.AddConditions(0, {cmd});
+  filter.Select(0, BIT(BTM_BLE_PF_SRVC_UUID), 0, BTM_BLE_PF_LOGIC_AND,
+                kNoRssiThreshold);
+  EXPECT_TRUE(matches(filter, address(1), kAdv));
+
+  std::vector<uint8_t> other = {0x03, 0x03, 0x0d, 0x19};
+  EXPECT_FALSE(matches(filter, address(1), other));
+}
+
+TEST(HostAdvFilterTest, ListLogic) {
+  HostAdvFilter filter(4);
+  filter.SetEnabled(true);
+  ApcfCommand heart_rate = command(BTM_BLE_PF_SRVC_UUID);
+  heart_rate.uuid = Uuid::From16Bit(0x180d);
+  ApcfCommand battery = command(BTM_BLE_PF_SRVC_UUID);
+  battery.uuid = Uuid::From16Bit(0x180f);
+  filter.AddConditions(0, {heart_rate, battery});
+
+  filter.Select(0, BIT(BTM_BLE_PF_SRVC_UUID), 0, BTM_BLE_PF_LOGIC_AND,
+                kNoRssiThreshold);
+  EXPECT_TRUE(matches(filter, address(1), kAdv));
+
+  filter.Select(0, BIT(BTM_BLE_PF_SRVC_UUID), BIT(BTM_BLE_PF_SRVC_UUID),
+                BTM_BLE_PF_LOGIC_AND, kNoRssiThreshold);
+  EXPECT_FALSE(matches(filter, address(1), kAdv));
+}
+
+TEST(HostAdvFilterTest, ManufacturerData) {
+  HostAdvFilter filter(4);
+  filter.SetEnabled(true);
+  ApcfCommand cmd = command(BTM_BLE_PF_MANU_DATA);
+  cmd.company = 0x004c;
+  cmd.data = {0x02, 0x00, 0x01};
+  cmd.data_mask = {0xff, 0x00, 0xff};
+  filter.AddConditions(0, {cmd});
+  filter.Select(0, BIT(BTM_BLE_PF_MANU_DATA), 0, BTM_BLE_PF_LOGIC_AND,
+                kNoRssiThreshold);
+  EXPECT_TRUE(matches(filter, address(1), kAdv));
+
+  filter.Clear(0);
+  cmd.company = 0x00e0;
+  filter.AddConditions(0, {cmd});
+  filter.Select(0, BIT(BTM_BLE_PF_MANU_DATA), 0, BTM_BLE_PF_LOGIC_AND,
+                kNoRssiThreshold);
+  EXPECT_FALSE(matches(filter, address(1), kAdv));
+}
+
+TEST(HostAdvFilterTest, ServiceDataPattern) {
+  HostAdvFilter filter(4);
+  filter.SetEnabled(true);
+  ApcfCommand cmd = command(BTM_BLE_PF_SRVC_DATA_PATTERN);
+  cmd.data = {0xaa, 0xfe, 0x10};
+  cmd.data_mask = {0xff, 0xff, 0xff};
+  filter.AddConditions(0, {cmd});
+  filter.Select(0, BIT(BTM_BLE_PF_SRVC_DATA_PATTERN), 0, BTM_BLE_PF_LOGIC_AND,
+                kNoRssiThreshold);
+  EXPECT_TRUE(matches(filter, address(1), kAdv));
+
+  cmd.data = {0xaa, 0xfe, 0x11};
+  filter.Clear(0);
+  filter.AddConditions(0, {cmd});
+  filter.Select(0, BIT(BTM_BLE_PF_SRVC_DATA_PATTERN), 0, BTM_BLE_PF_LOGIC_AND,
+                kNoRssiThreshold);
+  EXPECT_FALSE(matches(filter, address(1), kAdv));
+}
+
+TEST(HostAdvFilterTest, LocalNameAndFilterLogic) {
+  HostAdvFilter filter(4);
+  filter.SetEnabled(true);
+  ApcfCommand name = command(BTM_BLE_PF_LOCAL_NAME);
+  name.name = {'P', 'i', 'x'};
+  ApcfCommand manu = command(BTM_BLE_PF_MANU_DATA);
+  manu.company = 0x00e0;
+  filter.AddConditions(0, {name, manu});
+
+  uint16_t feat_seln = BIT(BTM_BLE_PF_LOCAL_NAME) | BIT(BTM_BLE_PF_MANU_DATA);
+  filter.Select(0, feat_seln, 0, BTM_BLE_PF_LOGIC_OR, kNoRssiThreshold);
+  EXPECT_TRUE(matches(filter, address(1), kAdv));
+
+  filter.Select(0, feat_seln, 0, BTM_BLE_PF_LOGIC_AND, kNoRssiThreshold);
+  EXPECT_FALSE(matches(filter, address(1), kAdv));
+}
+
+TEST(HostAdvFilterTest, RssiThreshold) {
+  HostAdvFilter filter(4);
+  filter.SetEnabled(true);
+  filter.Select(0, 0, 0, BTM_BLE_PF_LOGIC_AND, -70);
+
+  EXPECT_TRUE(matches(filter, address(1), kAdv, -70));
+  EXPECT_FALSE(matches(filter, address(1), kAdv, -71));
+}
+
+TEST(HostAdvFilterTest, DeselectAndOutOfRange) {
+  HostAdvFilter filter(2);
+  filter.SetEnabled(true);
+  EXPECT_FALSE(filter.Select(2, 0, 0, BTM_BLE_PF_LOGIC_AND, kNoRssiThreshold));
+  EXPECT_FALSE(filter.AddConditions(2, {command(BTM_BLE_PF_SRVC_DATA)}));
+
+  filter.Select(1, 0, 0, BTM_BLE_PF_LOGIC_AND, kNoRssiThreshold);
+  EXPECT_TRUE(matches(filter, address(1), kAdv));
+
+  filter.Deselect(1);
+  EXPECT_FALSE(matches(filter, address(1), kAdv));
+  EXPECT_EQ(2u, filter.NumAvailable());
+}
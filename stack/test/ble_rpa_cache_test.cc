@@ -0,0 +1,99 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2018 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "btm_ble_rpa_cache.h"
+
+namespace {
+
+/* Resolvable private address ending in |hash| */
+RawAddress rpa(uint32_t hash, uint8_t prand = 0x40) {
+  RawAddress addr = RawAddress::kEmpty;
+  addr.address[0] = prand;
+  addr.address[3] = hash >> 16;
+  addr.address[4] = hash >> 8;
+  addr.address[5] = hash;
+  return addr;
+}
+
+const uint64_t kNowMs = 1000000;
+
+}  // namespace
+
+TEST(RpaResolutionCacheTest, Miss) {
+  RpaResolutionCache cache;
+  tBTM_SEC_DEV_REC* p_dev_rec = nullptr;
+  EXPECT_FALSE(cache.Get(rpa(1), kNowMs, &p_dev_rec));
+}
+
+TEST(RpaResolutionCacheTest, ResolvedAndUnresolved) {
+  RpaResolutionCache cache;
+  tBTM_SEC_DEV_REC dev_rec;
+  cache.Put(rpa(1), kNowMs, &dev_rec);
+  cache.Put(rpa(2), kNowMs, nullptr);
+
+  tBTM_SEC_DEV_REC* p_dev_rec = nullptr;
+  EXPECT_TRUE(cache.Get(rpa(1), kNowMs + 1, &p_dev_rec));
+  EXPECT_EQ(&dev_rec, p_dev_rec);
+  EXPECT_TRUE(cache.Get(rpa(2), kNowMs + 1, &p_dev_rec));
+  EXPECT_EQ(nullptr, p_dev_rec);
+  EXPECT_FALSE(cache.Get(rpa(3), kNowMs + 1, &p_dev_rec));
+}
+
+TEST(RpaResolutionCacheTest, Expiry) {
+  RpaResolutionCache cache;
+  tBTM_SEC_DEV_REC dev_rec;
+  cache.Put(rpa(1), kNowMs, &dev_rec);
+
+  tBTM_SEC_DEV_REC* p_dev_rec = nullptr;
+  uint64_t lifetime = RpaResolutionCache::kLifetimeMs;
+  EXPECT_TRUE(cache.Get(rpa(1), kNowMs + lifetime - 1, &p_dev_rec));
+  EXPECT_FALSE(cache.Get(rpa(1), kNowMs + lifetime, &p_dev_rec));
+
+  /* Resolving the address again renews it */
+  cache.Put(rpa(1), kNowMs + lifetime, &dev_rec);
+  EXPECT_TRUE(cache.Get(rpa(1), kNowMs + lifetime, &p_dev_rec));
+}
+
+TEST(RpaResolutionCacheTest, SameSlotEvicts) {
+  RpaResolutionCache cache;
+  tBTM_SEC_DEV_REC dev_rec;
+  /* Differing only in bits the slot ignores */
+  RawAddress first = rpa(1, 0x40);
+  RawAddress second = rpa(1, 0x41);
+  cache.Put(first, kNowMs, &dev_rec);
+  cache.Put(second, kNowMs, nullptr);
+
+  tBTM_SEC_DEV_REC* p_dev_rec = nullptr;
+  EXPECT_FALSE(cache.Get(first, kNowMs, &p_dev_rec));
+  EXPECT_TRUE(cache.Get(second, kNowMs, &p_dev_rec));
+  EXPECT_EQ(nullptr, p_dev_rec);
+}
+
+TEST(RpaResolutionCacheTest, Clear) {
+  RpaResolutionCache cache;
+  tBTM_SEC_DEV_REC dev_rec;
+  for (uint32_t i = 0; i < RpaResolutionCache::kSize; i++)
+    cache.Put(rpa(i), kNowMs, &dev_rec);
+  cache.Clear();
+
+  tBTM_SEC_DEV_REC* p_dev_rec = nullptr;
+  for (uint32_t i = 0; i < RpaResolutionCache::kSize; i++)
+    EXPECT_FALSE(cache.Get(rpa(i), kNowMs, &p_dev_rec));
+}
@@ -317,6 +317,48 @@ TEST(CryptoToolboxTest, bt_spec_example_d_7_test) {
   EXPECT_EQ(result[2], expected_ah[2]);
 }
 
+// BT Spec 5.0 | Vol 3, Part H D.7, with the key schedule of the IRK set up
+// once
+TEST(CryptoToolboxTest, bt_spec_example_d_7_key_schedule_test) {
+  Octet16 IRK{0xec, 0x02, 0x34, 0xa3, 0x57, 0xc8, 0xad, 0x05,
+              0x34, 0x10, 0x10, 0xa6, 0x0a, 0x39, 0x7d, 0x9b};
+  Octet16 prand{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                0x00, 0x00, 0x00, 0x00, 0x00, 0x70, 0x81, 0x94};
+  Octet16 expected_aes_128{0x15, 0x9d, 0x5f, 0xb7, 0x2e, 0xbe, 0x23, 0x11,
+                           0xa4, 0x8c, 0x1b, 0xdc, 0xc4, 0x0d, 0xfb, 0xaa};
+
+  std::reverse(std::begin(IRK), std::end(IRK));
+  std::reverse(std::begin(prand), std::end(prand));
+  std::reverse(std::begin(expected_aes_128), std::end(expected_aes_128));
+
+  aes_context ctx;
+  aes_128_set_key(IRK, &ctx);
+  EXPECT_EQ(expected_aes_128, aes_128(ctx, prand.data(), 3));
+
+  // The key schedule gives the same result as the key for any message
+  Octet16 message = prand;
+  for (int i = 0; i < 16; i++) {
+    message[i] ^= i * 37;
+    EXPECT_EQ(aes_128(IRK, message), aes_128(ctx, message));
+  }
+}
+
+// FIPS-197 Appendix C.1, through the precomputed key schedule
+TEST(CryptoToolboxTest, aes_encrypt_fips_197_c_1_test) {
+  uint8_t key[] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+                   0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f};
+  uint8_t plaintext[] = {0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+                         0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff};
+  uint8_t expected[] = {0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30,
+                        0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a};
+
+  aes_context ctx;
+  aes_set_key(key, sizeof(key), &ctx);
+  uint8_t output[16];
+  aes_encrypt(plaintext, output, &ctx);
+  EXPECT_THAT(output, ElementsAreArray(expected));
+}
+
 // BT Spec 5.0 | Vol 3, Part H D.8
 TEST(CryptoToolboxTest, bt_spec_example_d_8_test) {
   Octet16 Key{0xec, 0x02, 0x34, 0xa3, 0x57, 0xc8, 0xad, 0x05,
@@ -0,0 +1,65 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2017 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "l2c_fcs.h"
+
+TEST(L2capFcsTest, KnownValues) {
+  // CRC-16 with this polynomial and a zero initial value ("CRC-16/ARC")
+  const uint8_t check[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+  EXPECT_EQ(0xbb3d, l2c_fcs_crc16(0, check, sizeof(check)));
+  EXPECT_EQ(0xbb3d, l2c_fcs_crc16_bytewise(0, check, sizeof(check)));
+
+  EXPECT_EQ(0x1234, l2c_fcs_crc16(0x1234, check, 0));
+}
+
+TEST(L2capFcsTest, ContinuesAcrossCalls) {
+  std::vector<uint8_t> data(1021);
+  for (size_t i = 0; i < data.size(); i++) data[i] = i * 31 + 7;
+
+  uint16_t whole = l2c_fcs_crc16(0, data.data(), data.size());
+  for (size_t split : {1, 3, 8, 13, 500, 1020}) {
+    uint16_t crc = l2c_fcs_crc16(0, data.data(), split);
+    crc = l2c_fcs_crc16(crc, data.data() + split, data.size() - split);
+    EXPECT_EQ(whole, crc) << "split at " << split;
+  }
+}
+
+TEST(L2capFcsTest, MatchesBytewiseOnRandomFrames) {
+  std::mt19937 rng(0x4c32);
+  std::uniform_int_distribution<int> byte(0, 255);
+  std::uniform_int_distribution<int> length(0, 1700);
+  std::uniform_int_distribution<int> alignment(0, 7);
+  std::uniform_int_distribution<int> init(0, 0xffff);
+
+  std::vector<uint8_t> buffer(1700 + 8);
+  for (int i = 0; i < 20000; i++) {
+    size_t len = length(rng);
+    size_t offset = alignment(rng);
+    for (size_t j = 0; j < len; j++) buffer[offset + j] = byte(rng);
+    uint16_t crc = init(rng);
+
+    ASSERT_EQ(l2c_fcs_crc16_bytewise(crc, buffer.data() + offset, len),
+              l2c_fcs_crc16(crc, buffer.data() + offset, len))
+        << "len " << len << " offset " << offset << " init " << crc;
+  }
+}
@@ -0,0 +1,128 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2018 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <string.h>
+#include <random>
+
+#include "stack/smp/p_256_ecc_pp.h"
+
+namespace {
+
+// Debug private key and public key of the Bluetooth Core Specification
+// Vol 3, Part H, 2.3.5.6.1, least significant dword first
+const uint32_t kDebugPrivateKey[KEY_LENGTH_DWORDS_P256] = {
+    0xcd3c1abd, 0x5899b8a6, 0xeb40b799, 0x4aff607b,
+    0xd2103f50, 0x74c9b3e3, 0xa3c55f38, 0x3f49f6d4};
+const uint32_t kDebugPublicKeyX[KEY_LENGTH_DWORDS_P256] = {
+    0x0e359de6, 0xcc030148, 0xacf4fddb, 0xeff49111,
+    0xe9f9a5b9, 0x5e2c83a7, 0xf297be2c, 0x20b003d2};
+const uint32_t kDebugPublicKeyY[KEY_LENGTH_DWORDS_P256] = {
+    0x1589d28b, 0x741c8ed0, 0x8fed3024, 0x766345c2,
+    0x5a52155c, 0x63329abf, 0x652aeb6d, 0xdc809c49};
+
+class SmpEccTest : public ::testing::Test {
+ protected:
+  void SetUp() override { p_256_init_curve(KEY_LENGTH_DWORDS_P256); }
+
+  void RandomScalar(uint32_t* n) {
+    for (int i = 0; i < KEY_LENGTH_DWORDS_P256; i++) n[i] = rng_();
+  }
+
+  // The existing implementation, which consumes its scalar
+  void Reference(Point* q, const Point& p, const uint32_t* n) {
+    Point base = p;
+    uint32_t k[KEY_LENGTH_DWORDS_P256];
+    memcpy(k, n, sizeof(k));
+    ECC_PointMult_Bin_NAF(q, &base, k, KEY_LENGTH_DWORDS_P256);
+  }
+
+  void ExpectSamePoint(const Point& expected, const Point& actual) {
+    EXPECT_EQ(0, memcmp(expected.x, actual.x, sizeof(expected.x)));
+    EXPECT_EQ(0, memcmp(expected.y, actual.y, sizeof(expected.y)));
+  }
+
+  std::mt19937 rng_{1};
+};
+
+}  // namespace
+
+TEST_F(SmpEccTest, DebugKeyPair) {
+  Point q;
+  ECC_PointMult_Base(&q, kDebugPrivateKey);
+  EXPECT_EQ(0, memcmp(kDebugPublicKeyX, q.x, sizeof(q.x)));
+  EXPECT_EQ(0, memcmp(kDebugPublicKeyY, q.y, sizeof(q.y)));
+
+  ECC_PointMult_Window(&q, &curve_p256.G, kDebugPrivateKey);
+  EXPECT_EQ(0, memcmp(kDebugPublicKeyX, q.x, sizeof(q.x)));
+  EXPECT_EQ(0, memcmp(kDebugPublicKeyY, q.y, sizeof(q.y)));
+}
+
+TEST_F(SmpEccTest, BaseMatchesBinNaf) {
+  for (int i = 0; i < 20; i++) {
+    uint32_t n[KEY_LENGTH_DWORDS_P256];
+    RandomScalar(n);
+    Point expected, actual;
+    Reference(&expected, curve_p256.G, n);
+    ECC_PointMult_Base(&actual, n);
+    ExpectSamePoint(expected, actual);
+    EXPECT_TRUE(ECC_ValidatePoint(actual));
+  }
+}
+
+TEST_F(SmpEccTest, DhKeyMatchesBinNaf) {
+  for (int i = 0; i < 20; i++) {
+    uint32_t a[KEY_LENGTH_DWORDS_P256], b[KEY_LENGTH_DWORDS_P256];
+    RandomScalar(a);
+    RandomScalar(b);
+
+    Point peer_key, expected, actual;
+    ECC_PointMult_Base(&peer_key, b);
+    Reference(&expected, peer_key, a);
+    ECC_PointMult_Window(&actual, &peer_key, a);
+    ExpectSamePoint(expected, actual);
+
+    // both sides agree on the DHKey
+    Point local_key, other;
+    ECC_PointMult_Base(&local_key, a);
+    ECC_PointMult_Window(&other, &local_key, b);
+    ExpectSamePoint(actual, other);
+  }
+}
+
+TEST_F(SmpEccTest, SmallScalars) {
+  for (uint32_t k = 1; k < 40; k++) {
+    uint32_t n[KEY_LENGTH_DWORDS_P256] = {k};
+    Point expected, base, window;
+    Reference(&expected, curve_p256.G, n);
+    ECC_PointMult_Base(&base, n);
+    ECC_PointMult_Window(&window, &curve_p256.G, n);
+    ExpectSamePoint(expected, base);
+    ExpectSamePoint(expected, window);
+  }
+}
+
+TEST_F(SmpEccTest, ScalarLeftUntouched) {
+  uint32_t n[KEY_LENGTH_DWORDS_P256];
+  memcpy(n, kDebugPrivateKey, sizeof(n));
+  Point q;
+  ECC_PointMult_Base(&q, n);
+  ECC_PointMult_Window(&q, &curve_p256.G, n);
+  EXPECT_EQ(0, memcmp(kDebugPrivateKey, n, sizeof(n)));
+}
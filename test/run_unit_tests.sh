@@ -8,12 +8,18 @@ known_tests=(
   net_test_btcore_qti
   net_test_bta_qti
   net_test_btif_qti
+  net_test_btif_ble_seen_devices_qti
   net_test_btif_profile_queue_qti
+  net_test_btif_sock_thread_qti
   net_test_device_qti
   net_test_hci_qti
   net_test_stack_qti
   net_test_stack_multi_adv_qti
   net_test_stack_ad_parser_qti
+  net_test_stack_ble_adv_cache_qti
+  net_test_stack_ble_host_filter_qti
+  net_test_stack_ble_rpa_cache_qti
+  net_test_stack_l2cap_fcs_qti
   net_test_stack_smp_qti
   net_test_types_qti
   net_test_btu_message_loop_qti
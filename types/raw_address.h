@@ -60,3 +60,18 @@ inline std::ostream& operator<<(std::ostream& os, const RawAddress& a) {
   os << a.ToString();
   return os;
 }
+
+// Custom std::hash specialization so that RawAddress can be used as a key in
+// std::unordered_map.
+namespace std {
+
+template <>
+struct hash<RawAddress> {
+  std::size_t operator()(const RawAddress& key) const {
+    const uint8_t* a = key.address;
+    return a[0] ^ (a[1] << 8) ^ (a[2] << 16) ^ (a[3] << 24) ^ a[4] ^
+           (a[5] << 8);
+  }
+};
+
+}  // namespace std
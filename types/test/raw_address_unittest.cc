@@ -18,6 +18,8 @@
 
 #include <gtest/gtest.h>
 
+#include <unordered_map>
+
 #include "raw_address.h"
 
 static const char* test_addr = "12:34:56:78:9a:bc";
@@ -153,3 +155,17 @@ TEST(RawAddressTest, BdAddrFromString) {
   const RawAddress result1 = {{0xab, 0x01, 0x4c, 0xd5, 0x21, 0x9f}};
   EXPECT_EQ(0, memcmp(&addr, &result1, sizeof(addr)));
 }
+
+TEST(RawAddressTest, Hash) {
+  RawAddress a, b;
+  RawAddress::FromString("ab:01:4C:d5:21:9f", a);
+  RawAddress::FromString("ab:01:4C:d5:21:9f", b);
+  EXPECT_EQ(std::hash<RawAddress>()(a), std::hash<RawAddress>()(b));
+
+  std::unordered_map<RawAddress, int> map;
+  map[a] = 1;
+  map[RawAddress::kAny] = 2;
+  EXPECT_EQ(1, map[b]);
+  EXPECT_EQ(2, map[RawAddress::kAny]);
+  EXPECT_EQ(0u, map.count(RawAddress::kEmpty));
+}
@@ -123,4 +123,32 @@ uint32_t UIPC_Read(tUIPC_CH_ID ch_id, uint16_t* p_msg_evt, uint8_t* p_buf,
  ******************************************************************************/
 bool UIPC_Ioctl(tUIPC_CH_ID ch_id, uint32_t request, void* param);
 
+/*******************************************************************************
+ *
+ * Function         UIPC_OpenShmRing
+ *
+ * Description      Creates a shared memory ring of |capacity| bytes for an
+ *                  open channel. Once the peer attached to it, UIPC_Read on
+ *                  the channel consumes from the ring instead of the socket.
+ *                  The ring is released when the channel is closed.
+ *
+ * Returns          true in case of success, false in case of failure.
+ *
+ ******************************************************************************/
+bool UIPC_OpenShmRing(tUIPC_CH_ID ch_id, size_t capacity);
+
+/*******************************************************************************
+ *
+ * Function         UIPC_SendShmRing
+ *
+ * Description      Called to transmit a message over UIPC channel |ch_id|,
+ *                  passing the peer the file descriptors of the ring of
+ *                  channel |ring_ch_id|.
+ *
+ * Returns          true in case of success, false in case of failure.
+ *
+ ******************************************************************************/
+bool UIPC_SendShmRing(tUIPC_CH_ID ch_id, tUIPC_CH_ID ring_ch_id,
+                      const uint8_t* p_buf, uint16_t msglen);
+
 #endif /* UIPC_H */
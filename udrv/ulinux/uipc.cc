@@ -52,7 +52,9 @@
 #include "bt_common.h"
 #include "bt_types.h"
 #include "bt_utils.h"
+#include "osi/include/list.h"
 #include "osi/include/osi.h"
+#include "osi/include/shm_ring.h"
 #include "osi/include/socket_utils/sockets.h"
 #include "uipc.h"
 
@@ -91,6 +93,9 @@ typedef struct {
   int read_poll_tmo_ms;
   int task_evt_flags; /* event flags pending to be processed in read task */
   tUIPC_RCV_CBACK* cback;
+  shm_ring_t* ring;         /* shared memory ring replacing the socket data */
+  list_t* retired_rings;    /* closed rings possibly still in use by readers */
+  int ring_readers;
 } tUIPC_CHAN;
 
 typedef struct {
@@ -117,6 +122,7 @@ static tUIPC_MAIN uipc_main;
  *****************************************************************************/
 
 static int uipc_close_ch_locked(tUIPC_CH_ID ch_id);
+static void uipc_release_ring_locked(tUIPC_CH_ID ch_id);
 
 /*****************************************************************************
  *  Externs
@@ -247,6 +253,9 @@ static int uipc_main_init(void) {
     p->fd = UIPC_DISCONNECTED;
     p->task_evt_flags = 0;
     p->cback = NULL;
+    p->ring = NULL;
+    p->retired_rings = NULL;
+    p->ring_readers = 0;
   }
 
   return 0;
@@ -389,6 +398,11 @@ static void uipc_flush_ch_locked(tUIPC_CH_ID ch_id) {
   char buf[UIPC_FLUSH_BUFFER_SIZE];
   struct pollfd pfd;
 
+  /* the peer may have written to the socket before it attached to the ring,
+     so both are flushed */
+  if (uipc_main.ch[ch_id].ring != NULL)
+    shm_ring_flush(uipc_main.ch[ch_id].ring);
+
   pfd.events = POLLIN;
   pfd.fd = uipc_main.ch[ch_id].fd;
 
@@ -461,6 +475,8 @@ static int uipc_close_ch_locked(tUIPC_CH_ID ch_id) {
     wakeup = 1;
   }
 
+  uipc_release_ring_locked(ch_id);
+
   /* notify this connection is closed */
   if (uipc_main.ch[ch_id].cback)
     uipc_main.ch[ch_id].cback(ch_id, UIPC_CLOSE_EVT);
@@ -471,6 +487,26 @@ static int uipc_close_ch_locked(tUIPC_CH_ID ch_id) {
   return 0;
 }
 
+static void uipc_ring_free(void* ring) { shm_ring_free((shm_ring_t*)ring); }
+
+/* closes the ring of a channel. A reader blocked on it is woken up, and the
+   last reader to leave frees all rings closed meanwhile. */
+static void uipc_release_ring_locked(tUIPC_CH_ID ch_id) {
+  tUIPC_CHAN* p = &uipc_main.ch[ch_id];
+
+  if (p->ring == NULL) return;
+
+  BTIF_TRACE_EVENT("RELEASE RING (CH %d)", ch_id);
+  shm_ring_close(p->ring);
+  if (p->ring_readers > 0) {
+    if (p->retired_rings == NULL) p->retired_rings = list_new(uipc_ring_free);
+    list_append(p->retired_rings, p->ring);
+  } else {
+    shm_ring_free(p->ring);
+  }
+  p->ring = NULL;
+}
+
 void uipc_close_locked(tUIPC_CH_ID ch_id) {
   if (uipc_main.ch[ch_id].srvfd == UIPC_DISCONNECTED) {
     BTIF_TRACE_EVENT("CHANNEL %d ALREADY CLOSED", ch_id);
@@ -482,6 +518,54 @@ void uipc_close_locked(tUIPC_CH_ID ch_id) {
   uipc_wakeup_locked();
 }
 
+/* the socket is read until the peer attached to the ring. A reader only
+   touches the ring between uipc_ring_acquire() and uipc_ring_release(), so
+   that closing the channel cannot free it under the reader. */
+static shm_ring_t* uipc_ring_acquire(tUIPC_CH_ID ch_id) {
+  std::lock_guard<std::recursive_mutex> lock(uipc_main.mutex);
+  shm_ring_t* ring = uipc_main.ch[ch_id].ring;
+  if (ring == NULL || !shm_ring_is_attached(ring)) return NULL;
+  uipc_main.ch[ch_id].ring_readers++;
+  return ring;
+}
+
+static void uipc_ring_release(tUIPC_CH_ID ch_id) {
+  std::lock_guard<std::recursive_mutex> lock(uipc_main.mutex);
+  tUIPC_CHAN* p = &uipc_main.ch[ch_id];
+  if (--p->ring_readers == 0 && p->retired_rings != NULL) {
+    list_free(p->retired_rings);
+    p->retired_rings = NULL;
+  }
+}
+
+/* reads from the ring of a channel, with the same timeout and detach handling
+   as the socket */
+static uint32_t uipc_read_ring(tUIPC_CH_ID ch_id, shm_ring_t* ring,
+                               uint8_t* p_buf, uint32_t len) {
+  uint32_t n_read = shm_ring_read(ring, p_buf, len);
+
+  while (n_read < len) {
+    int ret = shm_ring_wait_readable(ring, len - n_read,
+                                     uipc_main.ch[ch_id].read_poll_tmo_ms,
+                                     uipc_main.ch[ch_id].fd);
+    if (ret < 0) {
+      BTIF_TRACE_WARNING("UIPC_Read : ring detached");
+      std::lock_guard<std::recursive_mutex> lock(uipc_main.mutex);
+      uipc_close_locked(ch_id);
+      return 0;
+    }
+
+    n_read += shm_ring_read(ring, p_buf + n_read, len - n_read);
+    if (ret == 0) {
+      BTIF_TRACE_WARNING("ring timeout (%d ms)",
+                         uipc_main.ch[ch_id].read_poll_tmo_ms);
+      break;
+    }
+  }
+
+  return n_read;
+}
+
 static void* uipc_read_task(UNUSED_ATTR void* arg) {
   int ch_id;
   int result;
@@ -684,6 +768,13 @@ uint32_t UIPC_Read(tUIPC_CH_ID ch_id, UNUSED_ATTR uint16_t* p_msg_evt,
     return 0;
   }
 
+  shm_ring_t* ring = uipc_ring_acquire(ch_id);
+  if (ring != NULL) {
+    n_read = uipc_read_ring(ch_id, ring, p_buf, len);
+    uipc_ring_release(ch_id);
+    return n_read;
+  }
+
   while (n_read < (int)len) {
     pfd.fd = fd;
     pfd.events = POLLIN | POLLHUP;
@@ -786,3 +877,89 @@ extern bool UIPC_Ioctl(tUIPC_CH_ID ch_id, uint32_t request, void* param) {
 
   return false;
 }
+
+/*******************************************************************************
+ *
+ * Function         UIPC_OpenShmRing
+ *
+ * Description      Creates a shared memory ring for an open channel.
+ *
+ * Returns          true in case of success, false in case of failure.
+ *
+ ******************************************************************************/
+
+bool UIPC_OpenShmRing(tUIPC_CH_ID ch_id, size_t capacity) {
+  BTIF_TRACE_DEBUG("UIPC_OpenShmRing : ch_id %d, capacity %zu", ch_id,
+                   capacity);
+
+  if (ch_id >= UIPC_CH_NUM) return false;
+
+  std::lock_guard<std::recursive_mutex> lock(uipc_main.mutex);
+
+  if (uipc_main.ch[ch_id].srvfd == UIPC_DISCONNECTED) {
+    BTIF_TRACE_ERROR("UIPC_OpenShmRing : channel %d closed", ch_id);
+    return false;
+  }
+
+  uipc_release_ring_locked(ch_id);
+  uipc_main.ch[ch_id].ring = shm_ring_create(capacity);
+  return uipc_main.ch[ch_id].ring != NULL;
+}
+
+/*******************************************************************************
+ *
+ * Function         UIPC_SendShmRing
+ *
+ * Description      Called to transmit a message over UIPC, along with the
+ *                  file descriptors of the ring of another channel.
+ *
+ * Returns          true in case of success, false in case of failure.
+ *
+ ******************************************************************************/
+
+bool UIPC_SendShmRing(tUIPC_CH_ID ch_id, tUIPC_CH_ID ring_ch_id,
+                      const uint8_t* p_buf, uint16_t msglen) {
+  BTIF_TRACE_DEBUG("UIPC_SendShmRing : ch_id:%d ring ch_id:%d %d bytes", ch_id,
+                   ring_ch_id, msglen);
+
+  if (ch_id >= UIPC_CH_NUM || ring_ch_id >= UIPC_CH_NUM) return false;
+
+  std::lock_guard<std::recursive_mutex> lock(uipc_main.mutex);
+
+  shm_ring_t* ring = uipc_main.ch[ring_ch_id].ring;
+  if (ring == NULL || uipc_main.ch[ch_id].fd == UIPC_DISCONNECTED) {
+    return false;
+  }
+
+  int fds[SHM_RING_NUM_FDS];
+  shm_ring_get_fds(ring, fds);
+
+  struct iovec iov;
+  iov.iov_base = const_cast<uint8_t*>(p_buf);
+  iov.iov_len = msglen;
+
+  char control[CMSG_SPACE(sizeof(fds))];
+  memset(control, 0, sizeof(control));
+
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+  memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+  ssize_t ret;
+  OSI_NO_INTR(ret = sendmsg(uipc_main.ch[ch_id].fd, &msg, MSG_NOSIGNAL));
+  if (ret < 0) {
+    BTIF_TRACE_ERROR("failed to send ring (%s)", strerror(errno));
+    return false;
+  }
+
+  return true;
+}
@@ -31,6 +31,7 @@
 #include "connection.h"
 #include "device.h"
 #include "event_packet.h"
+#include "load_generator.h"
 #include "sco_packet.h"
 #include "test_channel_transport.h"
 
@@ -203,6 +204,11 @@ class DualModeController {
   // Controller commands. For error codes, see the Bluetooth Core Specification,
   // Version 4.2, Volume 2, Part D (page 370).
 
+  // OGF: 0x0001
+  // OCF: 0x0006
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.1.6
+  void HciDisconnect(const std::vector<uint8_t>& args);
+
   // OGF: 0x0003
   // OCF: 0x0003
   // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.3.2
@@ -475,6 +481,14 @@ class DualModeController {
   // List the devices that the controller knows about
   void TestChannelList(const std::vector<std::string>& args) const;
 
+  // Generate load, as selected by args[0]:
+  //   adv <count> [interval_ms] [max_adv_data_length] [seed]
+  //   acl <links> [bytes_per_second] [pdu_size]
+  //   storm <links> [period_ms]
+  //   stats
+  //   stop
+  void TestChannelLoad(const std::vector<std::string>& args);
+
   void Connections();
 
   void LeScan();
@@ -587,6 +601,8 @@ class DualModeController {
 
   std::vector<std::shared_ptr<Connection>> connections_;
 
+  LoadGenerator load_generator_;
+
   AsyncTaskId timer_tick_task_;
   std::chrono::milliseconds timer_period_ = std::chrono::milliseconds(100);
 
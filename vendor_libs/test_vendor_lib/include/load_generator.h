@@ -0,0 +1,114 @@
+//
+// Copyright 2018 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "acl_packet.h"
+#include "bt_address.h"
+#include "event_packet.h"
+#include "load_stats.h"
+
+namespace test_vendor_lib {
+
+// Generate link load against the host: LE links opened by simulated peers,
+// each streaming ATT Write Commands at a configured rate and probing the round
+// trip through the stack with one ATT request at a time. The links can be
+// dropped in scripted disconnect storms.
+class LoadGenerator {
+ public:
+  // Links use the handles from kFirstHandle on, clear of the ones the
+  // controller assigns to regular connections.
+  static const uint16_t kFirstHandle = 0x0100;
+  static const size_t kMaxLinks = 0x0e00;
+
+  // The default ATT MTU, which the host accepts without an exchange.
+  static const size_t kDefaultPduSize = 23;
+
+  LoadGenerator();
+  virtual ~LoadGenerator() = default;
+
+  // Set the callbacks for sending packets to the HCI.
+  void RegisterEventChannel(
+      const std::function<void(std::unique_ptr<EventPacket>)>& send_event);
+
+  void RegisterAclChannel(
+      const std::function<void(std::unique_ptr<AclPacket>)>& send_acl);
+
+  // Connect |count| more links, each sending |bytes_per_second| to the host in
+  // ATT PDUs of |pdu_size| octets.
+  void AddLinks(size_t count, size_t bytes_per_second, size_t pdu_size);
+
+  // Every |period|, reconnect the links dropped by the previous storm and
+  // disconnect |count| others. A zero |period| disconnects them only once.
+  void StartDisconnectStorm(size_t count, std::chrono::milliseconds period);
+
+  // Disconnect and forget every link.
+  void Stop();
+
+  // Handle a packet from the host. Returns false if it is not for a link.
+  bool HandleAcl(const AclPacket& packet);
+
+  // Drop the link with |handle| on request of the host. Returns false if
+  // there is no such link connected. The caller sends the events.
+  bool Disconnect(uint16_t handle);
+
+  // Let the generator know that |elapsed| time has passed.
+  void TimerTick(std::chrono::milliseconds elapsed);
+
+  size_t GetConnectedLinkCount() const;
+
+  LoadStats& GetStats() { return stats_; }
+
+ private:
+  struct Link {
+    uint16_t handle;
+    BtAddress address;
+    bool connected;
+    size_t bytes_per_second;
+    size_t pdu_size;
+    double credit;  // Bytes the link may send now.
+    bool probe_pending;
+    std::chrono::steady_clock::time_point probe_time;
+  };
+
+  void Connect(Link& link);
+  void DisconnectByPeer(Link& link);
+  void SendProbe(Link& link);
+  void SendWrite(Link& link);
+  void SendL2cap(const Link& link, const std::vector<uint8_t>& pdu);
+  Link* FindLink(uint16_t handle);
+
+  std::function<void(std::unique_ptr<EventPacket>)> send_event_;
+  std::function<void(std::unique_ptr<AclPacket>)> send_acl_;
+
+  std::vector<Link> links_;
+
+  size_t storm_count_;
+  std::chrono::milliseconds storm_period_;
+  std::chrono::milliseconds storm_elapsed_;
+  size_t storm_cursor_;
+  std::vector<uint16_t> storm_dropped_;
+
+  LoadStats stats_;
+};
+
+}  // namespace test_vendor_lib
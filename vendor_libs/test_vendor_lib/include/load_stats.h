@@ -0,0 +1,84 @@
+//
+// Copyright 2018 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "event_packet.h"
+
+namespace test_vendor_lib {
+
+// Collect the figures reported for a load run: the HCI traffic exchanged with
+// the host, the round trip latency of the probes sent over the load links and
+// the CPU time used by the process hosting the controller. When the
+// controller is loaded into the Bluetooth process, that includes the stack.
+class LoadStats {
+ public:
+  LoadStats();
+  virtual ~LoadStats() = default;
+
+  // Start a new measurement window.
+  void Reset();
+
+  // Account for packets exchanged with the host.
+  void OnEventSent(const EventPacket& event);
+  void OnAclSent(size_t bytes);
+  void OnAclReceived(size_t bytes);
+
+  // Account for a probe answered after |latency|, or never answered.
+  void OnProbeAnswered(std::chrono::microseconds latency);
+  void OnProbeLost();
+
+  size_t GetEventCount() const { return event_count_; }
+  size_t GetAdvertisingReportCount() const { return advertising_reports_; }
+  size_t GetAclSentCount() const { return acl_sent_; }
+  size_t GetAclReceivedCount() const { return acl_received_; }
+  size_t GetProbesAnswered() const { return latencies_.size(); }
+  size_t GetProbesLost() const { return probes_lost_; }
+
+  // Return the latency below which |percent| percent of the probes of the
+  // window were answered, or zero if none was.
+  std::chrono::microseconds GetLatencyPercentile(int percent) const;
+
+  // Return a one line summary of the window.
+  std::string ToString() const;
+
+ private:
+  // Return the CPU time used by the process so far.
+  static std::chrono::microseconds GetCpuTime();
+
+  std::chrono::steady_clock::time_point start_;
+  std::chrono::microseconds cpu_start_;
+
+  size_t event_count_;
+  size_t event_bytes_;
+  size_t advertising_reports_;
+  size_t acl_sent_;
+  size_t acl_sent_bytes_;
+  size_t acl_received_;
+  size_t acl_received_bytes_;
+  size_t probes_lost_;
+
+  // Kept sorted lazily by GetLatencyPercentile().
+  mutable std::vector<std::chrono::microseconds> latencies_;
+  mutable bool latencies_sorted_;
+};
+
+}  // namespace test_vendor_lib
@@ -0,0 +1,55 @@
+//
+// Copyright 2018 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "bt_address.h"
+#include "device.h"
+#include "stack/include/btm_ble_api.h"
+
+namespace test_vendor_lib {
+
+// A non-connectable advertiser whose manufacturer data changes on every timer
+// tick, so that its reports cannot be filtered as duplicates. Used in numbers
+// to put scanning under load.
+class RandomAdvertiser : public Device {
+ public:
+  RandomAdvertiser();
+  virtual ~RandomAdvertiser() = default;
+
+  // Set the address, advertising interval, maximum advertising data length
+  // and random seed from string args.
+  virtual void Initialize(const std::vector<std::string>& args) override;
+
+  // Return a string representation of the type of device.
+  virtual std::string GetTypeString() const override { return "random_adv"; }
+
+  void TimerTick() override;
+
+ private:
+  // Fill the advertising data with a random amount of random bytes.
+  void Randomize();
+
+  std::minstd_rand random_;
+
+  size_t max_length_;
+};
+
+}  // namespace test_vendor_lib
@@ -0,0 +1,157 @@
+#
+# Copyright 2018 The Android Open Source Project
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+"""Script for running a load profile against the Bluetooth stack.
+
+This script drives the 'load' test channel command of the test vendor library:
+it adds randomized advertisers, opens LE links streaming data to the host,
+optionally drops links in disconnect storms, and prints the statistics the
+controller logs for every sampling window together with the CPU use of the
+Bluetooth process.
+
+Usage:
+  1. Set up the test channel as described in test_channel.py and turn
+  Bluetooth on. Start a scan from the device to receive the advertisements.
+  2. Run this program with the forwarded port and the load profile, e.g.
+    python load_test.py 6111 --advertisers 500 --links 8 --rate 20000 \\
+        --storm 4 --storm-period 5000 --duration 60
+"""
+
+#!/usr/bin/env python
+
+import argparse
+import re
+import subprocess
+import sys
+import time
+
+from test_channel import TestChannel
+
+BLUETOOTH_PROCESS = 'com.android.bluetooth'
+LOAD_STATS_PATTERN = re.compile(r'Load stats: (.*)$')
+
+def adb(args):
+  return subprocess.check_output(['adb', 'shell'] + args).strip()
+
+def read_process_cpu_ticks(pid):
+  """Returns the user and system clock ticks used by |pid| so far."""
+  fields = adb(['cat', '/proc/%s/stat' % pid]).split(')')[-1].split()
+  # utime and stime are fields 14 and 15, the state (field 3) comes first here.
+  return int(fields[11]) + int(fields[12])
+
+class LoadTest(object):
+  """Runs a load profile and reports the statistics of each window.
+
+  Attributes:
+    test_channel: The test channel to the controller.
+    logcat: The logcat process the statistics are read from.
+  """
+
+  def __init__(self, test_channel):
+    self._test_channel = test_channel
+    self._logcat = None
+    self._pid = None
+
+  def start(self, options):
+    subprocess.call(['adb', 'logcat', '-c'])
+    self._logcat = subprocess.Popen(['adb', 'logcat', '-v', 'brief'],
+                                    stdout=subprocess.PIPE)
+    try:
+      self._pid = adb(['pidof', BLUETOOTH_PROCESS]) or None
+    except subprocess.CalledProcessError:
+      self._pid = None
+
+    if options.advertisers > 0:
+      self._send('adv', options.advertisers, options.adv_interval,
+                 options.adv_length, options.seed)
+    if options.links > 0:
+      self._send('acl', options.links, options.rate, options.pdu_size)
+    if options.storm > 0:
+      self._send('storm', options.storm, options.storm_period)
+    # Start the first window once the load is in place.
+    self._send('stats')
+
+  def sample(self, window):
+    """Waits for |window| seconds and prints the statistics of the window."""
+    cpu_start = read_process_cpu_ticks(self._pid) if self._pid else None
+    time.sleep(window)
+    self._send('stats')
+
+    stats = self._read_stats()
+    if cpu_start is not None:
+      ticks = read_process_cpu_ticks(self._pid) - cpu_start
+      # Clock ticks are 1/100 s on Android.
+      stats += ', %s cpu %.1f%%' % (BLUETOOTH_PROCESS, ticks / float(window))
+    print stats
+    sys.stdout.flush()
+
+  def stop(self):
+    self._send('stop')
+    if self._logcat:
+      self._logcat.terminate()
+
+  def _send(self, command, *args):
+    self._test_channel.send_command('load',
+                                    [command] + [str(arg) for arg in args])
+
+  def _read_stats(self):
+    while True:
+      line = self._logcat.stdout.readline()
+      if not line:
+        return 'logcat ended'
+      match = LOAD_STATS_PATTERN.search(line.strip())
+      if match:
+        return match.group(1)
+
+def main(argv):
+  parser = argparse.ArgumentParser(description='Bluetooth stack load test.')
+  parser.add_argument('port', type=int, help='Test channel port.')
+  parser.add_argument('--advertisers', type=int, default=0,
+                      help='Number of randomized advertisers.')
+  parser.add_argument('--adv-interval', type=int, default=100,
+                      help='Advertising interval in ms.')
+  parser.add_argument('--adv-length', type=int, default=31,
+                      help='Maximum advertising data length.')
+  parser.add_argument('--seed', type=int, default=1,
+                      help='Seed of the advertising data.')
+  parser.add_argument('--links', type=int, default=0,
+                      help='Number of LE links streaming to the host.')
+  parser.add_argument('--rate', type=int, default=0,
+                      help='Bytes per second sent on each link.')
+  parser.add_argument('--pdu-size', type=int, default=23,
+                      help='Size of the ATT PDUs sent on the links.')
+  parser.add_argument('--storm', type=int, default=0,
+                      help='Number of links dropped in each disconnect storm.')
+  parser.add_argument('--storm-period', type=int, default=0,
+                      help='Period of the storms in ms, 0 for a single one.')
+  parser.add_argument('--window', type=int, default=5,
+                      help='Sampling window in seconds.')
+  parser.add_argument('--duration', type=int, default=30,
+                      help='Duration of the test in seconds.')
+  options = parser.parse_args(argv[1:])
+
+  test_channel = TestChannel(options.port)
+  load_test = LoadTest(test_channel)
+  try:
+    load_test.start(options)
+    for _ in range(max(1, options.duration / options.window)):
+      load_test.sample(options.window)
+  finally:
+    load_test.stop()
+    test_channel.close()
+
+if __name__ == '__main__':
+  main(sys.argv)
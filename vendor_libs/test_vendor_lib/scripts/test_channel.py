@@ -203,6 +203,17 @@ class TestChannelShell(cmd.Cmd):
     """
     self._test_channel.send_command('list', args.split())
 
+  def do_load(self, args):
+    """
+    Arguments: adv count [interval_ms [max_data_len [seed]]]
+               acl count [bytes_per_sec [pdu_size]]
+               storm count [period_ms]
+               stats
+               stop
+    Generate advertising or link load, or log the load statistics.
+    """
+    self._test_channel.send_command('load', args.split())
+
   def do_quit(self, args):
     """
     Arguments: None.
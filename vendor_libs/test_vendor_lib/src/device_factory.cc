@@ -23,6 +23,7 @@
 #include "classic.h"
 #include "device.h"
 #include "keyboard.h"
+#include "random_advertiser.h"
 
 #include "base/logging.h"
 
@@ -40,6 +41,8 @@ std::shared_ptr<Device> DeviceFactory::Create(const vector<std::string>& args) {
   if (args[0] == "broken_adv") new_device = std::make_shared<BrokenAdv>();
   if (args[0] == "classic") new_device = std::make_shared<Classic>();
   if (args[0] == "keyboard") new_device = std::make_shared<Keyboard>();
+  if (args[0] == "random_adv")
+    new_device = std::make_shared<RandomAdvertiser>();
 
   if (new_device != nullptr) new_device->Initialize(args);
 
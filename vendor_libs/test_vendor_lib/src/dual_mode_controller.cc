@@ -156,6 +156,7 @@ DualModeController::DualModeController()
   SET_HANDLER(HCI_INQUIRY_CANCEL, HciInquiryCancel);
   SET_HANDLER(HCI_DELETE_STORED_LINK_KEY, HciDeleteStoredLinkKey);
   SET_HANDLER(HCI_RMT_NAME_REQUEST, HciRemoteNameRequest);
+  SET_HANDLER(HCI_DISCONNECT, HciDisconnect);
   SET_HANDLER(HCI_BLE_SET_EVENT_MASK, HciLeSetEventMask);
   SET_HANDLER(HCI_BLE_READ_BUFFER_SIZE, HciLeReadBufferSize);
   SET_HANDLER(HCI_BLE_READ_LOCAL_SPT_FEAT, HciLeReadLocalSupportedFeatures);
@@ -187,6 +188,7 @@ DualModeController::DualModeController()
   SET_TEST_HANDLER("add", TestChannelAdd);
   SET_TEST_HANDLER("del", TestChannelDel);
   SET_TEST_HANDLER("list", TestChannelList);
+  SET_TEST_HANDLER("load", TestChannelLoad);
 #undef SET_TEST_HANDLER
 }
 
@@ -215,12 +217,16 @@ void DualModeController::HandleTestChannelCommand(
 }
 
 void DualModeController::HandleAcl(std::unique_ptr<AclPacket> acl_packet) {
+  load_generator_.GetStats().OnAclReceived(acl_packet->GetPacketSize());
+
   if (loopback_mode_ == HCI_LOOPBACK_MODE_LOCAL) {
     uint16_t channel = acl_packet->GetChannel();
     send_acl_(std::move(acl_packet));
     send_event_(EventPacket::CreateNumberOfCompletedPacketsEvent(channel, 1));
     return;
   }
+
+  load_generator_.HandleAcl(*acl_packet);
 }
 
 void DualModeController::HandleSco(std::unique_ptr<ScoPacket> sco_packet) {
@@ -255,12 +261,21 @@ void DualModeController::HandleCommand(
 
 void DualModeController::RegisterEventChannel(
     const std::function<void(std::unique_ptr<EventPacket>)>& callback) {
-  send_event_ = callback;
+  // Account for every event sent to the host.
+  send_event_ = [this, callback](std::unique_ptr<EventPacket> event) {
+    load_generator_.GetStats().OnEventSent(*event);
+    callback(std::move(event));
+  };
+  load_generator_.RegisterEventChannel(send_event_);
 }
 
 void DualModeController::RegisterAclChannel(
     const std::function<void(std::unique_ptr<AclPacket>)>& callback) {
-  send_acl_ = callback;
+  send_acl_ = [this, callback](std::unique_ptr<AclPacket> packet) {
+    load_generator_.GetStats().OnAclSent(packet->GetPacketSize());
+    callback(std::move(packet));
+  };
+  load_generator_.RegisterAclChannel(send_acl_);
 }
 
 void DualModeController::RegisterScoChannel(
@@ -272,6 +287,7 @@ void DualModeController::HandleTimerTick() {
   if (state_ == kInquiry) PageScan();
   if (le_scan_enable_ || le_connect_) LeScan();
   Connections();
+  load_generator_.TimerTick(timer_period_);
   for (size_t dev = 0; dev < devices_.size(); dev++) devices_[dev]->TimerTick();
 }
 
@@ -477,6 +493,63 @@ void DualModeController::TestChannelList(
   }
 }
 
+void DualModeController::TestChannelLoad(const vector<std::string>& args) {
+  LogCommand("TestChannel 'load'");
+
+  if (args.empty()) {
+    LOG_ERROR(LOG_TAG, "TestChannel 'load': missing arguments");
+    return;
+  }
+
+  const std::string& type = args[0];
+  if (type == "adv" && args.size() >= 2) {
+    size_t count = std::stoul(args[1]);
+    std::string interval = args.size() >= 3 ? args[2] : "100";
+    std::string max_length = args.size() >= 4 ? args[3] : "31";
+    uint32_t seed = args.size() >= 5 ? std::stoul(args[4]) : 1;
+    for (size_t i = 0; i < count; i++) {
+      // Static random addresses: the two most significant bits are set.
+      uint32_t index = devices_.size();
+      vector<uint8_t> octets = {static_cast<uint8_t>(index),
+                                static_cast<uint8_t>(index >> 8),
+                                static_cast<uint8_t>(index >> 16),
+                                static_cast<uint8_t>(seed),
+                                0xad,
+                                0xc0};
+      BtAddress address;
+      address.FromVector(octets);
+      TestChannelAdd({"random_adv", address.ToString(), interval, max_length,
+                      std::to_string(seed + i)});
+    }
+    LOG_INFO(LOG_TAG, "%zu devices", devices_.size());
+  } else if (type == "acl" && args.size() >= 2) {
+    size_t pdu_size = args.size() >= 4 ? std::stoul(args[3])
+                                        : LoadGenerator::kDefaultPduSize;
+    // Keep ATT PDUs within a single LE data packet.
+    size_t max_pdu_size = properties_.GetLeDataPacketLength() - 4;
+    if (pdu_size > max_pdu_size) pdu_size = max_pdu_size;
+    load_generator_.AddLinks(std::stoul(args[1]),
+                             args.size() >= 3 ? std::stoul(args[2]) : 0,
+                             pdu_size);
+  } else if (type == "storm" && args.size() >= 2) {
+    load_generator_.StartDisconnectStorm(
+        std::stoul(args[1]),
+        std::chrono::milliseconds(args.size() >= 3 ? std::stoi(args[2]) : 0));
+  } else if (type == "stats") {
+    LOG_INFO(LOG_TAG, "Load stats: %zu links, %zu devices, %s",
+             load_generator_.GetConnectedLinkCount(), devices_.size(),
+             load_generator_.GetStats().ToString().c_str());
+    load_generator_.GetStats().Reset();
+  } else if (type == "stop") {
+    load_generator_.Stop();
+    for (size_t dev = devices_.size(); dev > 0; dev--)
+      if (devices_[dev - 1]->GetTypeString() == "random_adv")
+        devices_.erase(devices_.begin() + dev - 1);
+  } else {
+    LOG_ERROR(LOG_TAG, "TestChannel 'load %s': bad arguments", type.c_str());
+  }
+}
+
 void DualModeController::HciReset(const vector<uint8_t>& args) {
   LogCommand("Reset");
   CHECK(args[0] == 0);  // No arguments
@@ -721,6 +794,29 @@ void DualModeController::HciRemoteNameRequest(
   SendCommandStatusSuccess(HCI_RMT_NAME_REQUEST);
 }
 
+void DualModeController::HciDisconnect(const vector<uint8_t>& args) {
+  LogCommand("Disconnect");
+  CHECK(args.size() == 4);
+  uint16_t handle = (args[1] | (args[2] << 8)) & 0xfff;
+
+  bool found = load_generator_.Disconnect(handle);
+  for (size_t i = 0; i < connections_.size(); i++) {
+    if (*connections_[i] == handle) {
+      connections_[i]->Disconnect();
+      found = true;
+    }
+  }
+
+  if (!found) {
+    SendCommandStatus(HCI_ERR_NO_CONNECTION, HCI_DISCONNECT);
+    return;
+  }
+
+  SendCommandStatusSuccess(HCI_DISCONNECT);
+  send_event_(EventPacket::CreateDisconnectionCompleteEvent(
+      kSuccessStatus, handle, HCI_ERR_CONN_CAUSE_LOCAL_HOST));
+}
+
 void DualModeController::HciLeSetEventMask(const vector<uint8_t>& args) {
   LogCommand("LE SetEventMask");
   le_event_mask_ = args;
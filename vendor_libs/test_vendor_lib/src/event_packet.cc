@@ -277,6 +277,20 @@ std::unique_ptr<EventPacket> EventPacket::CreateConnectionCompleteEvent(
   return evt_ptr;
 }
 
+// Bluetooth Core Specification Version 4.2, Volume 2, Part E, Section 7.7.5
+std::unique_ptr<EventPacket> EventPacket::CreateDisconnectionCompleteEvent(
+    uint8_t status, uint16_t handle, uint8_t reason) {
+  std::unique_ptr<EventPacket> evt_ptr =
+      std::unique_ptr<EventPacket>(new EventPacket(HCI_DISCONNECTION_COMP_EVT));
+
+  CHECK(evt_ptr->AddPayloadOctets1(status));
+  CHECK((handle & 0xf000) == 0);  // Handles are 12-bit values.
+  CHECK(evt_ptr->AddPayloadOctets2(handle));
+  CHECK(evt_ptr->AddPayloadOctets1(reason));
+
+  return evt_ptr;
+}
+
 // Bluetooth Core Specification Version 4.2, Volume 2, Part E, Section 7.7.25
 std::unique_ptr<EventPacket> EventPacket::CreateLoopbackCommandEvent(
     uint16_t opcode, const vector<uint8_t>& payload) {
@@ -0,0 +1,263 @@
+//
+// Copyright 2018 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#define LOG_TAG "load_generator"
+
+#include "load_generator.h"
+
+#include "osi/include/log.h"
+#include "stack/include/hcidefs.h"
+
+using std::vector;
+
+namespace {
+
+// Bluetooth Core Specification Version 4.2, Volume 3, Part A, Section 2.1
+const uint16_t kAttCid = 0x0004;
+
+// Bluetooth Core Specification Version 4.2, Volume 3, Part F, Section 3.4
+const uint8_t kAttErrorRsp = 0x01;
+const uint8_t kAttReadByGroupTypeReq = 0x10;
+const uint8_t kAttReadByGroupTypeRsp = 0x11;
+const uint8_t kAttWriteCmd = 0x52;
+const uint16_t kPrimaryServiceUuid = 0x2800;
+
+// Writes go to a handle no server exposes, so the host drops them silently.
+const uint16_t kUnusedAttHandle = 0xffff;
+
+// A probe that is not answered in time is counted as lost and sent again.
+const std::chrono::seconds kProbeTimeout(2);
+
+// Bluetooth Core Specification Version 4.2, Volume 2, Part E, Section
+// 7.7.65.1
+const uint8_t kRandomAddressType = 0x01;
+
+// Connection parameters reported for the links: 7.5 ms interval, no slave
+// latency, 5 s supervision timeout.
+const uint16_t kConnInterval = 0x0006;
+const uint16_t kConnLatency = 0x0000;
+const uint16_t kSupervisionTimeout = 0x01f4;
+
+}  // namespace
+
+namespace test_vendor_lib {
+
+LoadGenerator::LoadGenerator()
+    : storm_count_(0),
+      storm_period_(0),
+      storm_elapsed_(0),
+      storm_cursor_(0) {}
+
+void LoadGenerator::RegisterEventChannel(
+    const std::function<void(std::unique_ptr<EventPacket>)>& send_event) {
+  send_event_ = send_event;
+}
+
+void LoadGenerator::RegisterAclChannel(
+    const std::function<void(std::unique_ptr<AclPacket>)>& send_acl) {
+  send_acl_ = send_acl;
+}
+
+void LoadGenerator::AddLinks(size_t count, size_t bytes_per_second,
+                             size_t pdu_size) {
+  if (pdu_size < 3) pdu_size = 3;  // Opcode and attribute handle.
+
+  for (size_t i = 0; i < count && links_.size() < kMaxLinks; i++) {
+    Link link;
+    link.handle = kFirstHandle + links_.size();
+    // Static random addresses: the two most significant bits are set.
+    vector<uint8_t> address = {static_cast<uint8_t>(link.handle & 0xff),
+                               static_cast<uint8_t>(link.handle >> 8),
+                               0x00,
+                               0xad,
+                               0x10,
+                               0xc0};
+    link.address.FromVector(address);
+    link.connected = false;
+    link.bytes_per_second = bytes_per_second;
+    link.pdu_size = pdu_size;
+    link.credit = 0;
+    link.probe_pending = false;
+
+    links_.push_back(link);
+    Connect(links_.back());
+  }
+
+  LOG_INFO(LOG_TAG, "%zu links connected", GetConnectedLinkCount());
+}
+
+void LoadGenerator::StartDisconnectStorm(size_t count,
+                                         std::chrono::milliseconds period) {
+  storm_count_ = count;
+  storm_period_ = period;
+  storm_elapsed_ = period;  // Start with the next tick.
+}
+
+void LoadGenerator::Stop() {
+  for (Link& link : links_)
+    if (link.connected) DisconnectByPeer(link);
+
+  links_.clear();
+  storm_count_ = 0;
+  storm_cursor_ = 0;
+  storm_dropped_.clear();
+}
+
+bool LoadGenerator::HandleAcl(const AclPacket& packet) {
+  Link* link = FindLink(packet.GetChannel());
+  if (link == nullptr) return false;
+  if (!link->connected) return true;
+
+  // Complete the packet right away so that the host never runs out of
+  // buffers.
+  send_event_(
+      EventPacket::CreateNumberOfCompletedPacketsEvent(link->handle, 1));
+
+  // Look for the answer to the probe in the first fragment of an ATT PDU:
+  // ACL header (4), L2CAP header (4), ATT opcode and, for errors, the opcode
+  // of the request.
+  const vector<uint8_t>& raw = packet.GetPacket();
+  if (packet.GetPacketBoundaryFlags() == AclPacket::Continuing ||
+      raw.size() < 9 || (raw[6] | (raw[7] << 8)) != kAttCid)
+    return true;
+
+  uint8_t opcode = raw[8];
+  bool answer = opcode == kAttReadByGroupTypeRsp ||
+                (opcode == kAttErrorRsp && raw.size() >= 10 &&
+                 raw[9] == kAttReadByGroupTypeReq);
+  if (answer && link->probe_pending) {
+    link->probe_pending = false;
+    stats_.OnProbeAnswered(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - link->probe_time));
+  }
+  return true;
+}
+
+bool LoadGenerator::Disconnect(uint16_t handle) {
+  Link* link = FindLink(handle);
+  if (link == nullptr || !link->connected) return false;
+
+  link->connected = false;
+  link->probe_pending = false;
+  return true;
+}
+
+void LoadGenerator::TimerTick(std::chrono::milliseconds elapsed) {
+  if (storm_count_ > 0) {
+    storm_elapsed_ += elapsed;
+    if (storm_elapsed_ >= storm_period_) {
+      storm_elapsed_ = std::chrono::milliseconds(0);
+
+      for (uint16_t handle : storm_dropped_) {
+        Link* link = FindLink(handle);
+        if (link != nullptr && !link->connected) Connect(*link);
+      }
+      storm_dropped_.clear();
+
+      for (size_t i = 0;
+           i < links_.size() && storm_dropped_.size() < storm_count_; i++) {
+        Link& link = links_[(storm_cursor_ + i) % links_.size()];
+        if (!link.connected) continue;
+        DisconnectByPeer(link);
+        storm_dropped_.push_back(link.handle);
+      }
+      if (!links_.empty())
+        storm_cursor_ = (storm_cursor_ + storm_count_) % links_.size();
+
+      LOG_INFO(LOG_TAG, "storm dropped %zu links", storm_dropped_.size());
+      if (storm_period_ == std::chrono::milliseconds(0)) storm_count_ = 0;
+    }
+  }
+
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  for (Link& link : links_) {
+    if (!link.connected) continue;
+
+    if (link.probe_pending && now - link.probe_time >= kProbeTimeout) {
+      stats_.OnProbeLost();
+      link.probe_pending = false;
+    }
+    if (!link.probe_pending) SendProbe(link);
+
+    // Never let a link accumulate more than a second of data.
+    link.credit += link.bytes_per_second * elapsed.count() / 1000.0;
+    if (link.credit > link.bytes_per_second)
+      link.credit = link.bytes_per_second;
+    while (link.credit >= link.pdu_size) {
+      SendWrite(link);
+      link.credit -= link.pdu_size;
+    }
+  }
+}
+
+size_t LoadGenerator::GetConnectedLinkCount() const {
+  size_t count = 0;
+  for (const Link& link : links_)
+    if (link.connected) count++;
+  return count;
+}
+
+void LoadGenerator::Connect(Link& link) {
+  send_event_(EventPacket::CreateLeConnectionCompleteEvent(
+      HCI_SUCCESS, link.handle, HCI_ROLE_SLAVE, kRandomAddressType,
+      link.address, kConnInterval, kConnLatency, kSupervisionTimeout));
+  link.connected = true;
+  link.credit = 0;
+  link.probe_pending = false;
+}
+
+void LoadGenerator::DisconnectByPeer(Link& link) {
+  link.connected = false;
+  link.probe_pending = false;
+  send_event_(EventPacket::CreateDisconnectionCompleteEvent(
+      HCI_SUCCESS, link.handle, HCI_ERR_PEER_USER));
+}
+
+void LoadGenerator::SendProbe(Link& link) {
+  // Primary service discovery over the whole handle range.
+  SendL2cap(link, {kAttReadByGroupTypeReq, 0x01, 0x00, 0xff, 0xff,
+                   kPrimaryServiceUuid & 0xff, kPrimaryServiceUuid >> 8});
+  link.probe_pending = true;
+  link.probe_time = std::chrono::steady_clock::now();
+}
+
+void LoadGenerator::SendWrite(Link& link) {
+  vector<uint8_t> pdu(link.pdu_size, 0x5a);
+  pdu[0] = kAttWriteCmd;
+  pdu[1] = kUnusedAttHandle & 0xff;
+  pdu[2] = kUnusedAttHandle >> 8;
+  SendL2cap(link, pdu);
+}
+
+void LoadGenerator::SendL2cap(const Link& link, const vector<uint8_t>& pdu) {
+  std::unique_ptr<AclPacket> packet(new AclPacket(
+      link.handle, AclPacket::FirstAutomaticallyFlushable,
+      AclPacket::PointToPoint));
+  packet->AddPayloadOctets2(pdu.size());
+  packet->AddPayloadOctets2(kAttCid);
+  packet->AddPayloadOctets(pdu.size(), pdu);
+  send_acl_(std::move(packet));
+}
+
+LoadGenerator::Link* LoadGenerator::FindLink(uint16_t handle) {
+  if (handle < kFirstHandle ||
+      static_cast<size_t>(handle - kFirstHandle) >= links_.size())
+    return nullptr;
+  return &links_[handle - kFirstHandle];
+}
+
+}  // namespace test_vendor_lib
@@ -0,0 +1,126 @@
+//
+// Copyright 2018 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#define LOG_TAG "load_stats"
+
+#include "load_stats.h"
+
+#include <sys/resource.h>
+
+#include <algorithm>
+
+#include "stack/include/hcidefs.h"
+
+using std::chrono::microseconds;
+
+namespace test_vendor_lib {
+
+LoadStats::LoadStats() { Reset(); }
+
+void LoadStats::Reset() {
+  start_ = std::chrono::steady_clock::now();
+  cpu_start_ = GetCpuTime();
+
+  event_count_ = 0;
+  event_bytes_ = 0;
+  advertising_reports_ = 0;
+  acl_sent_ = 0;
+  acl_sent_bytes_ = 0;
+  acl_received_ = 0;
+  acl_received_bytes_ = 0;
+  probes_lost_ = 0;
+
+  latencies_.clear();
+  latencies_sorted_ = true;
+}
+
+void LoadStats::OnEventSent(const EventPacket& event) {
+  event_count_++;
+  event_bytes_ += event.GetPacketSize();
+
+  // Count the reports batched in LE Advertising Report events. The payload
+  // starts with its length, then the subevent code and the number of reports.
+  const std::vector<uint8_t>& payload = event.GetPayload();
+  if (event.GetEventCode() == HCI_BLE_EVENT && payload.size() >= 3 &&
+      payload[1] == HCI_BLE_ADV_PKT_RPT_EVT)
+    advertising_reports_ += payload[2];
+}
+
+void LoadStats::OnAclSent(size_t bytes) {
+  acl_sent_++;
+  acl_sent_bytes_ += bytes;
+}
+
+void LoadStats::OnAclReceived(size_t bytes) {
+  acl_received_++;
+  acl_received_bytes_ += bytes;
+}
+
+void LoadStats::OnProbeAnswered(microseconds latency) {
+  latencies_.push_back(latency);
+  latencies_sorted_ = false;
+}
+
+void LoadStats::OnProbeLost() { probes_lost_++; }
+
+microseconds LoadStats::GetLatencyPercentile(int percent) const {
+  if (latencies_.empty()) return microseconds(0);
+
+  if (!latencies_sorted_) {
+    std::sort(latencies_.begin(), latencies_.end());
+    latencies_sorted_ = true;
+  }
+
+  size_t index = (latencies_.size() - 1) * percent / 100;
+  return latencies_[index];
+}
+
+std::string LoadStats::ToString() const {
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start_)
+                       .count();
+  if (seconds <= 0) seconds = 1;
+  double cpu_seconds =
+      std::chrono::duration<double>(GetCpuTime() - cpu_start_).count();
+
+  char buffer[512];
+  snprintf(buffer, sizeof(buffer),
+           "window %.1f s, events %zu (%.0f/s, %zu bytes), "
+           "advertising reports %zu (%.0f/s), "
+           "acl sent %zu (%.0f bytes/s), acl received %zu (%.0f bytes/s), "
+           "latency ms p50 %.2f p90 %.2f p99 %.2f max %.2f "
+           "(%zu probes, %zu lost), cpu %.1f%%",
+           seconds, event_count_, event_count_ / seconds, event_bytes_,
+           advertising_reports_, advertising_reports_ / seconds, acl_sent_,
+           acl_sent_bytes_ / seconds, acl_received_,
+           acl_received_bytes_ / seconds,
+           GetLatencyPercentile(50).count() / 1000.0,
+           GetLatencyPercentile(90).count() / 1000.0,
+           GetLatencyPercentile(99).count() / 1000.0,
+           GetLatencyPercentile(100).count() / 1000.0, latencies_.size(),
+           probes_lost_, 100.0 * cpu_seconds / seconds);
+  return std::string(buffer);
+}
+
+microseconds LoadStats::GetCpuTime() {
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) return microseconds(0);
+
+  return std::chrono::seconds(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+         microseconds(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+}
+
+}  // namespace test_vendor_lib
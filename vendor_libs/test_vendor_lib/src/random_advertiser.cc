@@ -0,0 +1,92 @@
+//
+// Copyright 2018 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#define LOG_TAG "random_advertiser"
+
+#include "random_advertiser.h"
+#include "stack/include/hcidefs.h"
+
+using std::vector;
+
+namespace {
+
+// Bluetooth Core Specification Version 4.2, Volume 3, Part C, Section 11
+const size_t kMaxAdvertisingDataLength = 31;
+
+// The flags structure and the header of the manufacturer specific data.
+const size_t kFixedLength = 3 + 4;
+
+// Company identifier reserved for testing by the Bluetooth SIG.
+const uint16_t kTestCompanyId = 0xFFFF;
+
+}  // namespace
+
+namespace test_vendor_lib {
+
+RandomAdvertiser::RandomAdvertiser() : max_length_(kMaxAdvertisingDataLength) {
+  advertising_interval_ms_ = std::chrono::milliseconds(1280);
+  advertising_type_ = BTM_BLE_NON_CONNECT_EVT;
+  address_type_ = kBtAddressTypeRandom;
+  scan_response_present_ = false;
+  scan_data_.clear();
+  Randomize();
+}
+
+void RandomAdvertiser::Initialize(const vector<std::string>& args) {
+  if (args.size() < 2) return;
+
+  BtAddress addr;
+  if (addr.FromString(args[1])) SetBtAddress(addr);
+
+  if (args.size() < 3) return;
+
+  SetAdvertisementInterval(std::chrono::milliseconds(std::stoi(args[2])));
+
+  if (args.size() < 4) return;
+
+  max_length_ = std::stoul(args[3]);
+  if (max_length_ < kFixedLength) max_length_ = kFixedLength;
+  if (max_length_ > kMaxAdvertisingDataLength)
+    max_length_ = kMaxAdvertisingDataLength;
+
+  if (args.size() < 5) return;
+
+  random_.seed(std::stoul(args[4]));
+
+  // Spread the advertising events of a swarm over the interval.
+  if (advertising_interval_ms_.count() > 0)
+    time_stamp_ -= std::chrono::milliseconds(random_() %
+                                             advertising_interval_ms_.count());
+  Randomize();
+}
+
+void RandomAdvertiser::TimerTick() { Randomize(); }
+
+void RandomAdvertiser::Randomize() {
+  size_t data_length = random_() % (max_length_ - kFixedLength + 1);
+
+  adv_data_ = {0x02,  // Length
+               BTM_BLE_AD_TYPE_FLAG,
+               BTM_BLE_BREDR_NOT_SPT,
+               static_cast<uint8_t>(3 + data_length),  // Length
+               HCI_EIR_MANUFACTURER_SPECIFIC_TYPE,
+               kTestCompanyId & 0xff,
+               kTestCompanyId >> 8};
+  for (size_t i = 0; i < data_length; i++)
+    adv_data_.push_back(static_cast<uint8_t>(random_()));
+}
+
+}  // namespace test_vendor_lib
@@ -0,0 +1,210 @@
+//
+// Copyright 2018 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "load_generator.h"
+#include "acl_packet.h"
+#include "event_packet.h"
+#include "load_stats.h"
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+using std::vector;
+
+#include "stack/include/hcidefs.h"
+
+namespace test_vendor_lib {
+
+class LoadGeneratorTest : public ::testing::Test {
+ public:
+  LoadGeneratorTest() {
+    generator_.RegisterEventChannel(
+        [this](std::unique_ptr<EventPacket> event) {
+          generator_.GetStats().OnEventSent(*event);
+          events_.push_back(std::move(event));
+        });
+    generator_.RegisterAclChannel([this](std::unique_ptr<AclPacket> packet) {
+      generator_.GetStats().OnAclSent(packet->GetPacketSize());
+      acl_.push_back(std::move(packet));
+    });
+  }
+  ~LoadGeneratorTest() {}
+
+ protected:
+  size_t CountEvents(uint8_t event_code, uint8_t subevent_code = 0) {
+    size_t count = 0;
+    for (const auto& event : events_)
+      if (event->GetEventCode() == event_code &&
+          (subevent_code == 0 || event->GetPayload()[1] == subevent_code))
+        count++;
+    return count;
+  }
+
+  // Return the ATT opcodes of the PDUs sent on |handle|.
+  vector<uint8_t> AttOpcodes(uint16_t handle) {
+    vector<uint8_t> opcodes;
+    for (const auto& packet : acl_)
+      if (packet->GetChannel() == handle)
+        opcodes.push_back(packet->GetPacket()[8]);
+    return opcodes;
+  }
+
+  // Build an ATT PDU from the host.
+  std::unique_ptr<AclPacket> HostAtt(uint16_t handle,
+                                     const vector<uint8_t>& pdu) {
+    std::unique_ptr<AclPacket> packet(
+        new AclPacket(handle, AclPacket::FirstNonAutomaticallyFlushable,
+                      AclPacket::PointToPoint));
+    packet->AddPayloadOctets2(pdu.size());
+    packet->AddPayloadOctets2(0x0004);
+    packet->AddPayloadOctets(pdu.size(), pdu);
+    return packet;
+  }
+
+  LoadGenerator generator_;
+  vector<std::unique_ptr<EventPacket>> events_;
+  vector<std::unique_ptr<AclPacket>> acl_;
+};
+
+TEST_F(LoadGeneratorTest, AddLinks) {
+  generator_.AddLinks(3, 0, LoadGenerator::kDefaultPduSize);
+  EXPECT_EQ(3u, generator_.GetConnectedLinkCount());
+  EXPECT_EQ(3u, CountEvents(HCI_BLE_EVENT, HCI_BLE_CONN_COMPLETE_EVT));
+
+  // Handles are consecutive from kFirstHandle. The payload starts with its
+  // length, the subevent code and the status.
+  for (size_t i = 0; i < events_.size(); i++) {
+    const vector<uint8_t>& payload = events_[i]->GetPayload();
+    EXPECT_EQ(LoadGenerator::kFirstHandle + i,
+              static_cast<size_t>(payload[3] | (payload[4] << 8)));
+  }
+}
+
+TEST_F(LoadGeneratorTest, Throughput) {
+  generator_.AddLinks(2, 2300, LoadGenerator::kDefaultPduSize);
+  for (int i = 0; i < 10; i++)
+    generator_.TimerTick(std::chrono::milliseconds(100));
+
+  // One second at 2300 bytes per second is 100 PDUs of 23 bytes, plus the
+  // probe sent on the first tick.
+  for (uint16_t handle = LoadGenerator::kFirstHandle;
+       handle < LoadGenerator::kFirstHandle + 2; handle++) {
+    vector<uint8_t> opcodes = AttOpcodes(handle);
+    ASSERT_EQ(101u, opcodes.size());
+    EXPECT_EQ(0x10, opcodes[0]);
+    for (size_t i = 1; i < opcodes.size(); i++) EXPECT_EQ(0x52, opcodes[i]);
+  }
+  EXPECT_EQ(202u, generator_.GetStats().GetAclSentCount());
+}
+
+TEST_F(LoadGeneratorTest, ProbeAnswered) {
+  generator_.AddLinks(1, 0, LoadGenerator::kDefaultPduSize);
+  generator_.TimerTick(std::chrono::milliseconds(100));
+  generator_.TimerTick(std::chrono::milliseconds(100));
+  ASSERT_EQ(1u, AttOpcodes(LoadGenerator::kFirstHandle).size());
+
+  // An error response to the probe answers it as well as a response would.
+  events_.clear();
+  EXPECT_TRUE(generator_.HandleAcl(
+      *HostAtt(LoadGenerator::kFirstHandle, {0x01, 0x10, 0x01, 0x00, 0x0a})));
+  EXPECT_EQ(1u, CountEvents(HCI_NUM_COMPL_DATA_PKTS_EVT));
+
+  generator_.TimerTick(std::chrono::milliseconds(100));
+  EXPECT_EQ(2u, AttOpcodes(LoadGenerator::kFirstHandle).size());
+  EXPECT_EQ(1u, generator_.GetStats().GetProbesAnswered());
+  EXPECT_EQ(0u, generator_.GetStats().GetProbesLost());
+  // A loopback probe can be answered in under a microsecond.
+  EXPECT_GE(generator_.GetStats().GetLatencyPercentile(100).count(), 0);
+}
+
+TEST_F(LoadGeneratorTest, OtherHandlesIgnored) {
+  generator_.AddLinks(1, 0, LoadGenerator::kDefaultPduSize);
+  EXPECT_FALSE(generator_.HandleAcl(*HostAtt(0x0001, {0x11})));
+  EXPECT_FALSE(
+      generator_.HandleAcl(*HostAtt(LoadGenerator::kFirstHandle + 1, {0x11})));
+}
+
+TEST_F(LoadGeneratorTest, DisconnectStorm) {
+  generator_.AddLinks(4, 0, LoadGenerator::kDefaultPduSize);
+  generator_.StartDisconnectStorm(2, std::chrono::milliseconds(500));
+
+  generator_.TimerTick(std::chrono::milliseconds(100));
+  EXPECT_EQ(2u, CountEvents(HCI_DISCONNECTION_COMP_EVT));
+  EXPECT_EQ(2u, generator_.GetConnectedLinkCount());
+
+  // The next storm brings the dropped links back and drops the others.
+  for (int i = 0; i < 4; i++)
+    generator_.TimerTick(std::chrono::milliseconds(100));
+  EXPECT_EQ(2u, CountEvents(HCI_DISCONNECTION_COMP_EVT));
+  generator_.TimerTick(std::chrono::milliseconds(100));
+  EXPECT_EQ(4u, CountEvents(HCI_DISCONNECTION_COMP_EVT));
+  EXPECT_EQ(6u, CountEvents(HCI_BLE_EVENT, HCI_BLE_CONN_COMPLETE_EVT));
+  EXPECT_EQ(2u, generator_.GetConnectedLinkCount());
+}
+
+TEST_F(LoadGeneratorTest, DisconnectStormOnce) {
+  generator_.AddLinks(4, 0, LoadGenerator::kDefaultPduSize);
+  generator_.StartDisconnectStorm(3, std::chrono::milliseconds(0));
+  for (int i = 0; i < 5; i++)
+    generator_.TimerTick(std::chrono::milliseconds(100));
+  EXPECT_EQ(3u, CountEvents(HCI_DISCONNECTION_COMP_EVT));
+  EXPECT_EQ(1u, generator_.GetConnectedLinkCount());
+}
+
+TEST_F(LoadGeneratorTest, HostDisconnect) {
+  generator_.AddLinks(2, 0, LoadGenerator::kDefaultPduSize);
+  EXPECT_TRUE(generator_.Disconnect(LoadGenerator::kFirstHandle));
+  EXPECT_FALSE(generator_.Disconnect(LoadGenerator::kFirstHandle));
+  EXPECT_FALSE(generator_.Disconnect(0x0001));
+  EXPECT_EQ(1u, generator_.GetConnectedLinkCount());
+
+  generator_.Stop();
+  EXPECT_EQ(0u, generator_.GetConnectedLinkCount());
+  EXPECT_EQ(1u, CountEvents(HCI_DISCONNECTION_COMP_EVT));
+}
+
+TEST_F(LoadGeneratorTest, StatsCountAdvertisingReports) {
+  std::unique_ptr<EventPacket> report =
+      EventPacket::CreateLeAdvertisingReportEvent();
+  BtAddress address;
+  ASSERT_TRUE(
+      report->AddLeAdvertisingReport(0, 0, address, {0x02, 0x01, 0x02}, 0));
+  ASSERT_TRUE(report->AddLeAdvertisingReport(0, 0, address, {}, 0));
+
+  LoadStats stats;
+  stats.OnEventSent(*report);
+  stats.OnEventSent(*EventPacket::CreateCommandStatusEvent(0, HCI_RESET));
+  EXPECT_EQ(2u, stats.GetEventCount());
+  EXPECT_EQ(2u, stats.GetAdvertisingReportCount());
+
+  stats.Reset();
+  EXPECT_EQ(0u, stats.GetEventCount());
+  EXPECT_EQ(0u, stats.GetAdvertisingReportCount());
+}
+
+TEST_F(LoadGeneratorTest, StatsLatencyPercentiles) {
+  LoadStats stats;
+  EXPECT_EQ(0, stats.GetLatencyPercentile(50).count());
+  for (int i = 100; i >= 1; i--)
+    stats.OnProbeAnswered(std::chrono::microseconds(i));
+  EXPECT_EQ(1, stats.GetLatencyPercentile(0).count());
+  EXPECT_EQ(50, stats.GetLatencyPercentile(50).count());
+  EXPECT_EQ(99, stats.GetLatencyPercentile(99).count());
+  EXPECT_EQ(100, stats.GetLatencyPercentile(100).count());
+}
+
+}  // namespace test_vendor_lib